@@ -0,0 +1,307 @@
+/* assembler_bench.c
+ *
+ * Measures how long each phase of assembling a file takes (preprocessing,
+ * first pass, second pass & output generation), and the peak memory, on
+ * synthetic sources of growing sizes.
+ *
+ * The sources are generated from a seed, and their shape is configurable:
+ *   --lines N - Statements (the source's lines, besides macro definitions &
+ *               declarations). Without it, a few sizes are measured.
+ *   --symbols N - Labels defined (default: 1 per 16 statements).
+ *   --macros N - Macros defined (default: 16), used by 1 per 16 statements.
+ *   --extern-ratio R - Fraction of symbol operands which are external
+ *                      (default: 0.1).
+ *   --entry-ratio R - Fraction of labels passed to .entry (default: 0.1).
+ *   --operands I,D,N,R - Relative weights of immediate, direct, indirect
+ *                        register & register operands (default: 1,2,1,2).
+ *   --seed N - Seed of the generator (default: 1).
+ *   --stream - Assemble in streaming mode (see AssembleStream).
+ *   --generate PATH - Only write the source to PATH, e.g. to feed it to main.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* clock_gettime, getrusage */
+
+#include <stdio.h> /* printf, fprintf, sscanf, fopen, remove */
+#include <stdlib.h> /* strtol, strtod */
+#include <string.h> /* strcmp, memset */
+#include <time.h> /* clock_gettime */
+#include <sys/resource.h> /* getrusage */
+#include "assembler.h"
+#include "preprocessing.h"
+#include "test_utils.h" /* The source generator */
+
+#define SOURCE_PATH "./assembler_bench.as"
+#define EXPANDED_PATH "./assembler_bench.am"
+
+/*
+ * Time spent in each phase, in seconds (see TimePhase).
+ */
+
+typedef struct {
+  double preprocessing;
+  double loading; /* Reading the .am file back, in memory mode */
+  double passes[ASSEMBLING_DONE];
+  assembler_phase_t current;
+  double phase_start;
+} phase_times_t;
+
+static result_t RunBenchmark(const source_config_t *config, bool_t stream);
+
+static result_t AssembleInMemory(phase_times_t *times);
+
+static result_t AssembleStreaming(phase_times_t *times);
+
+static void TimePhase(assembler_phase_t phase, void *times);
+
+static double Now(void);
+
+static long PeakMemoryKB(void);
+
+static void RemoveBenchFiles(void);
+
+int main(int argc, char *argv[]) {
+  long lines_nums[] = {10000, 100000, 1000000};
+  source_config_t config = CreateSourceConfig();
+  const char *generate_path = NULL;
+  size_t lines_nums_num = sizeof(lines_nums) / sizeof(lines_nums[0]);
+  bool_t stream = FALSE;
+  size_t i = 0;
+  int arg = 1;
+
+  for (arg = 1; arg < argc; ++arg) {
+    const char *value = (arg + 1 < argc) ? argv[arg + 1] : NULL;
+
+    if (0 == strcmp(argv[arg], "--stream")) {
+      stream = TRUE;
+      continue;
+    }
+
+    if (NULL == value) {
+      fprintf(stderr, "Missing value for '%s'\n", argv[arg]);
+      return 1;
+    }
+    ++arg;
+
+    if (0 == strcmp(argv[arg - 1], "--lines")) {
+      config.lines_num = strtol(value, NULL, 10);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--symbols")) {
+      config.symbols_num = strtol(value, NULL, 10);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--macros")) {
+      config.macros_num = strtol(value, NULL, 10);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--extern-ratio")) {
+      config.extern_ratio = strtod(value, NULL);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--entry-ratio")) {
+      config.entry_ratio = strtod(value, NULL);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--operands") &&
+             4 == sscanf(value, "%ld,%ld,%ld,%ld",
+                         &config.operand_weights[IMMEDIATE_OPERAND],
+                         &config.operand_weights[DIRECT_OPERAND],
+                         &config.operand_weights[INDIRECT_OPERAND],
+                         &config.operand_weights[REGISTER_OPERAND])) {
+      continue;
+    }
+    else if (0 == strcmp(argv[arg - 1], "--seed")) {
+      config.seed = strtol(value, NULL, 10);
+    }
+    else if (0 == strcmp(argv[arg - 1], "--generate")) {
+      generate_path = value;
+    }
+    else {
+      fprintf(stderr, "Invalid option '%s'\n", argv[arg - 1]);
+      return 1;
+    }
+  }
+
+  if (NULL != generate_path) {
+    if (0 >= config.lines_num) {
+      config.lines_num = lines_nums[0];
+    }
+    return (0 > GenerateSource(generate_path, &config)) ? 1 : 0;
+  }
+
+  printf("%10s %12s %10s %10s %10s %10s %10s %14s %10s\n", "lines",
+         "preprocess", "load", "first", "second", "output", "total",
+         "lines/sec", "peak KB");
+
+  /* A single size if one was given. Otherwise, sizes are measured in
+   * increasing order, since the peak memory of the process only grows */
+  if (0 < config.lines_num) {
+    lines_nums[0] = config.lines_num;
+    lines_nums_num = 1;
+  }
+
+  for (i = 0; i < lines_nums_num; ++i) {
+    config.lines_num = lines_nums[i];
+    if (SUCCESS != RunBenchmark(&config, stream)) {
+      fprintf(stderr, "Benchmark failed for %ld lines\n", lines_nums[i]);
+      RemoveBenchFiles();
+      return 1;
+    }
+  }
+
+  RemoveBenchFiles();
+  return 0;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Generates a source, then assembles it & prints a row of timings.
+ *        Times are in milliseconds; lines/sec is of the whole assembling.
+ */
+
+static result_t RunBenchmark(const source_config_t *config, bool_t stream) {
+  phase_times_t times;
+  long source_lines = GenerateSource(SOURCE_PATH, config);
+  double total = 0;
+  result_t res = SUCCESS;
+  int i = 0;
+
+  if (0 > source_lines) {
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  memset(&times, 0, sizeof(times));
+  res = stream ? AssembleStreaming(&times) : AssembleInMemory(&times);
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  total = times.preprocessing + times.loading;
+  for (i = 0; i < ASSEMBLING_DONE; ++i) {
+    total += times.passes[i];
+  }
+
+  printf("%10ld %12.1f %10.1f %10.1f %10.1f %10.1f %10.1f %14.0f %10ld\n",
+         source_lines, times.preprocessing * 1e3, times.loading * 1e3,
+         times.passes[FIRST_PASS_PHASE] * 1e3,
+         times.passes[SECOND_PASS_PHASE] * 1e3,
+         times.passes[OUTPUT_PHASE] * 1e3, total * 1e3,
+         source_lines / total, PeakMemoryKB());
+  return SUCCESS;
+}
+
+/*
+ * @brief Assembles the generated source as main does: preprocessing to a
+ *        .am file, which is loaded & assembled in memory.
+ */
+
+static result_t AssembleInMemory(phase_times_t *times) {
+  assembler_options_t options = CreateAssemblerOptions();
+  macro_table_t *macro_table = NULL;
+  source_buffer_t *source = NULL;
+  double start = Now();
+  result_t res = SUCCESS;
+
+  options.on_phase = TimePhase;
+  options.phase_arg = times;
+
+  macro_table = PreprocessFile(SOURCE_PATH, EXPANDED_PATH);
+  times->preprocessing = Now() - start;
+  if (NULL == macro_table) {
+    return FAILURE;
+  }
+
+  start = Now();
+  source = LoadSourceFile(EXPANDED_PATH);
+  times->loading = Now() - start;
+  if (NULL == source) {
+    DestroyMacroTable(macro_table);
+    return ERROR_OPENING_FILE;
+  }
+
+  res = AssembleSource(EXPANDED_PATH, source, macro_table, &options);
+  DestroySourceBuffer(source);
+  DestroyMacroTable(macro_table);
+  return res;
+}
+
+/*
+ * @brief Same as AssembleInMemory, in streaming mode. The expanded source
+ *        is written to a temporary file.
+ */
+
+static result_t AssembleStreaming(phase_times_t *times) {
+  assembler_options_t options = CreateAssemblerOptions();
+  FILE *expanded_source = tmpfile();
+  macro_table_t *macro_table = NULL;
+  double start = Now();
+  result_t res = SUCCESS;
+
+  if (NULL == expanded_source) {
+    return ERROR_OPENING_FILE;
+  }
+
+  options.on_phase = TimePhase;
+  options.phase_arg = times;
+
+  macro_table = PreprocessStream(SOURCE_PATH, expanded_source, stdout, NULL);
+  times->preprocessing = Now() - start;
+  if (NULL == macro_table) {
+    fclose(expanded_source);
+    return FAILURE;
+  }
+
+  rewind(expanded_source);
+  res = AssembleStream(EXPANDED_PATH, expanded_source, macro_table, &options);
+  DestroyMacroTable(macro_table);
+  fclose(expanded_source);
+  return res;
+}
+
+/*
+ * @brief Adds the time since the previous phase started to it (see
+ *        phase_func_t).
+ */
+
+static void TimePhase(assembler_phase_t phase, void *times) {
+  phase_times_t *phase_times = (phase_times_t *)times;
+  double now = Now();
+
+  if (0 != phase_times->phase_start) {
+    phase_times->passes[phase_times->current] +=
+        now - phase_times->phase_start;
+  }
+
+  phase_times->current = phase;
+  phase_times->phase_start = (ASSEMBLING_DONE == phase) ? 0 : now;
+}
+
+static double Now(void) {
+  struct timespec now;
+
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/*
+ * @brief Returns the peak memory (resident set size) of the process so far.
+ */
+
+static long PeakMemoryKB(void) {
+  struct rusage usage;
+
+  if (0 != getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+  return usage.ru_maxrss;
+}
+
+static void RemoveBenchFiles(void) {
+  const char *extensions[] = {"am", "ob", "ext", "ent"};
+  char path[64];
+  size_t i = 0;
+
+  remove(SOURCE_PATH);
+  for (i = 0; i < sizeof(extensions) / sizeof(extensions[0]); ++i) {
+    sprintf(path, "./assembler_bench.%s", extensions[i]);
+    remove(path);
+  }
+}
@@ -0,0 +1,86 @@
+/* macro_table_bench.c
+ *
+ * Measures the cost of a single FindMacro call as the number of macros in the
+ * table grows. The preprocessor looks up every non-comment source line in the
+ * macro table, so this cost should stay flat regardless of the macro count.
+ */
+
+#include <stdio.h> /* printf, sprintf */
+#include <time.h> /* clock */
+#include "macro_table.h"
+
+#define TOTAL_LOOKUPS (4000000L)
+#define NAME_LENGTH (32)
+#define NUM_OF_KEYS (4096) /* A power of 2 */
+
+static char keys[NUM_OF_KEYS][NAME_LENGTH];
+
+/*
+ * @brief Times TOTAL_LOOKUPS lookups in a table of num_of_macros macros.
+ *        Like source lines, most lookups miss (only 1 in 8 is a macro usage).
+ *
+ * @return Average nanoseconds per lookup, or a negative value upon failure.
+ */
+
+static double TimeLookups(long num_of_macros) {
+  macro_table_t *table = CreateMacroTable();
+  char name[NAME_LENGTH];
+  long i = 0;
+  long found = 0;
+  clock_t start = 0;
+  double elapsed = 0;
+
+  if (NULL == table) {
+    return -1;
+  }
+
+  for (i = 0; i < num_of_macros; ++i) {
+    sprintf(name, "m_macro_%ld", i);
+    if (SUCCESS != AddMacro(table, name, "inc r2\nmov A, r1\n")) {
+      DestroyMacroTable(table);
+      return -1;
+    }
+  }
+
+  /* Keys are prepared in advance, so only the lookups are timed */
+  for (i = 0; i < NUM_OF_KEYS; ++i) {
+    if (0 == i % 8) {
+      sprintf(keys[i], "m_macro_%ld", (i * 7919) % num_of_macros);
+    }
+    else {
+      sprintf(keys[i], "mov r%ld, LABEL%ld", i % 8, i);
+    }
+  }
+
+  start = clock();
+  for (i = 0; i < TOTAL_LOOKUPS; ++i) {
+    if (NULL != FindMacro(table, keys[i & (NUM_OF_KEYS - 1)])) {
+      ++found;
+    }
+  }
+  elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+  DestroyMacroTable(table);
+  if (found != (TOTAL_LOOKUPS + 7) / 8) {
+    return -1;
+  }
+
+  return elapsed * 1e9 / TOTAL_LOOKUPS;
+}
+
+int main(void) {
+  long macro_counts[] = {1, 10, 100, 1000, 10000, 100000};
+  size_t i = 0;
+
+  printf("%10s %16s\n", "macros", "ns/lookup");
+  for (i = 0; i < sizeof(macro_counts) / sizeof(macro_counts[0]); ++i) {
+    double ns_per_lookup = TimeLookups(macro_counts[i]);
+    if (ns_per_lookup < 0) {
+      fprintf(stderr, "Benchmark failed for %ld macros\n", macro_counts[i]);
+      return 1;
+    }
+    printf("%10ld %16.1f\n", macro_counts[i], ns_per_lookup);
+  }
+
+  return 0;
+}
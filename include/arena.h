@@ -0,0 +1,78 @@
+#ifndef __SH_ED_ARENA__
+#define __SH_ED_ARENA__
+
+/*
+ * @brief A region (arena) allocator for per-file assembler state.
+ *
+ *        Allocations are carved sequentially out of large blocks, and are
+ *        never freed one by one. Instead, everything allocated from an arena
+ *        is released at once by ResetArena or DestroyArena.
+ *
+ *        The list, symbol table, macro table & external symbols list can be
+ *        created inside an arena, in which case their nodes, records & names
+ *        are all allocated from it, and their Destroy functions don't free
+ *        them individually.
+ *
+ *        Allocation functions accept a NULL arena, in which case memory is
+ *        taken from the heap, and must be released with ArenaFree (or free).
+ */
+
+#include <stddef.h> /* size_t */
+
+typedef struct arena arena_t;
+
+#define DEFAULT_ARENA_BLOCK_SIZE (64 * 1024)
+
+/*
+ * @brief Creates a new empty arena.
+ * @param block_size - Size in bytes of each block the arena allocates from.
+ *                     Larger requests get a block of their own.
+ * @return Upon success, a pointer to the new arena. Upon failure, NULL.
+ */
+arena_t *CreateArena(size_t block_size);
+
+/*
+ * @brief Releases an arena, along with everything allocated from it.
+ * @param arena - The arena we wish to destroy.
+ */
+void DestroyArena(arena_t *arena);
+
+/*
+ * @brief Releases everything allocated from an arena at once.
+ *        One block is kept, so an arena reused for many files mostly
+ *        doesn't return to malloc.
+ * @param arena - The arena we wish to reset.
+ */
+void ResetArena(arena_t *arena);
+
+/*
+ * @brief Allocates memory from an arena, aligned for any type.
+ * @param arena - The arena to allocate from, or NULL for the heap.
+ *        size - Number of bytes.
+ * @return Upon success, a pointer to the memory. Upon failure, NULL.
+ */
+void *ArenaAlloc(arena_t *arena, size_t size);
+
+/*
+ * @brief Same as ArenaAlloc, but the memory is zeroed.
+ */
+void *ArenaCalloc(arena_t *arena, size_t size);
+
+/*
+ * @brief Copies a string into an arena.
+ * @param arena - The arena to allocate from, or NULL for the heap.
+ *        str - The string to copy.
+ * @return Upon success, a pointer to the copy. Upon failure, NULL.
+ */
+char *ArenaStrDup(arena_t *arena, const char *str);
+
+/*
+ * @brief Releases memory taken by ArenaAlloc, ArenaCalloc or ArenaStrDup.
+ *        Memory from an arena isn't freed individually, so this only frees
+ *        heap memory (i.e. when arena is NULL).
+ * @param arena - The arena the memory was allocated from, or NULL.
+ *        memory - The memory to release.
+ */
+void ArenaFree(arena_t *arena, void *memory);
+
+#endif /* __SH_ED_ARENA__ */
@@ -1,13 +1,124 @@
 #ifndef __SH_ED_ASSEMBLER__
 #define __SH_ED_ASSEMBLER__
 
+#include <stdio.h> /* FILE */
 #include "utils.h"
 #include "vector.h"
 #include "macro_table.h"
+#include "source_buffer.h"
+#include "arena.h"
+#include "word_buffer.h"
 
 /* Starting from the following address the program will be mapped. */
 #define INITIAL_IC_VALUE 100
 
+/* Version of the assembler. Bump it whenever the output produced for some
+ * source may change, so results cached by older versions aren't reused. */
+#define ASSEMBLER_VERSION "1.1"
+
+/*
+ * Results of previous assemblings, by file path, from which a file is
+ * reassembled incrementally (see CreateIncrementalState).
+ */
+
+typedef struct incremental_state incremental_state_t;
+
+/*
+ * An assembling whose expanded source is given a part at a time (see
+ * CreateAssembly).
+ */
+
+typedef struct assembly assembly_t;
+
+/*
+ * Phases of an assembling, in the order they run.
+ */
+
+typedef enum {
+  FIRST_PASS_PHASE,
+  SECOND_PASS_PHASE,
+  OUTPUT_PHASE,
+  ASSEMBLING_DONE
+} assembler_phase_t;
+
+/*
+ * @brief Called as each phase of an assembling starts, and once it's done
+ *        (ASSEMBLING_DONE), e.g. to time the phases.
+ *
+ * @param phase - The phase starting.
+ *        arg - The phase_arg of the options.
+ */
+
+typedef void (*phase_func_t)(assembler_phase_t phase, void *arg);
+
+/*
+ * Options of a single assembling (see CreateAssemblerOptions).
+ * diagnostics - Stream to which syntax errors are printed.
+ * binary_object - Whether to write a binary object file (.obj) as well.
+ * arena - Arena from which the file's symbol table & external symbols are
+ *         allocated, or NULL for the heap. The caller resets it afterwards.
+ * incremental - State from which files are reassembled incrementally, or
+ *               NULL to assemble them from scratch. It's updated by every
+ *               assembling, so it mustn't be used by several threads at once.
+ * threads_num - Threads the passes over a single file, and the writing of
+ *               its .ob file, may use; 1 runs them on the calling thread.
+ *               Sources too small to be worth splitting run on one thread
+ *               regardless, and so do incremental reassembly & the
+ *               streaming & pipelined modes.
+ *               The output & messages are the same for any number.
+ * on_phase - Called with phase_arg as each phase starts, or NULL. Phases
+ *            which don't run (e.g. the output, after errors) are skipped,
+ *            and incremental reassembly reports none but ASSEMBLING_DONE.
+ */
+
+typedef struct {
+  FILE *diagnostics;
+  bool_t binary_object;
+  arena_t *arena;
+  incremental_state_t *incremental;
+  unsigned int threads_num;
+  phase_func_t on_phase;
+  void *phase_arg;
+} assembler_options_t;
+
+/*
+ * A symbol of an assembled program, and the address it refers to.
+ */
+
+typedef struct {
+  const char *name;
+  unsigned int address;
+} program_symbol_t;
+
+/*
+ * A program assembled in memory (see AssembleSourceToProgram).
+ * code - code_size words, mapped starting from INITIAL_IC_VALUE.
+ * data - data_size words, mapped right after the code.
+ * entries - Symbols passed to .entry & their addresses, as in the .ent file.
+ * externals - Every use of an external symbol, with the address of the word
+ *             referring to it, as in the .ext file.
+ * All of it is owned by the program; see DestroyAssembledProgram.
+ */
+
+typedef struct {
+  machine_word_t *code;
+  size_t code_size;
+  machine_word_t *data;
+  size_t data_size;
+  program_symbol_t *entries;
+  size_t entries_num;
+  program_symbol_t *externals;
+  size_t externals_num;
+  void *memory; /* One block holding everything above */
+} assembled_program_t;
+
+/*
+ * @brief Creates the default assembler options: errors are printed to
+ *        stdout, and only the textual output files are written.
+ */
+
+assembler_options_t CreateAssemblerOptions(void);
+
 /*
  * @brief Assembler which takes a .am file and its correspoding macro table 
  *        (both produced by the preprocessor), and produces corresponding:
@@ -25,4 +136,165 @@
 
 result_t AssembleFile(char *file_path,  macro_table_t *macro_list);
 
+/*
+ * @brief Same as AssembleFile, but the expanded source is given in memory
+ *        (e.g. as produced by PreprocessSource), so it's never read from disk.
+ *
+ * @param file_path - Path of the .am file the source corresponds to. It's used
+ *                    for error messages, and output files are named after it.
+ *                    The file itself doesn't have to exist.
+ *        source - The expanded source to assemble.
+ *        macro_list - The macro table produced by preprocessing stage for
+ *                     the given source.
+ *        options - See assembler_options_t (AssembleFile uses the defaults).
+ *
+ * @return Same as AssembleFile.
+ *
+ * The assembler keeps no global state, so several files may be assembled
+ * concurrently, as long as no macro table, arena or output path is shared
+ * between the calls.
+ */
+
+result_t AssembleSource(char *file_path,
+                        const source_buffer_t *source,
+                        macro_table_t *macro_list,
+                        const assembler_options_t *options);
+
+/*
+ * @brief Same as AssembleSource, but for sources too big to be held in
+ *        memory (streaming mode). The expanded source is read a window of
+ *        lines at a time, and the code & data words are spilled to
+ *        temporary files, from which the output files are written a chunk
+ *        at a time.
+ *
+ *        Memory doesn't grow with the size of the source: only the symbol
+ *        table (and the macro table, which the caller holds) stays in
+ *        memory, so it grows with the number of symbols, and of external
+ *        symbols used.
+ *
+ * @param source - Stream of the expanded source (e.g. written by
+ *                 PreprocessStream), read from its current position.
+ *        Rest of the parameters - As in AssembleSource (incremental is
+ *                                 ignored).
+ *
+ * @return Same as AssembleSource.
+ */
+
+result_t AssembleStream(char *file_path,
+                        FILE *source,
+                        macro_table_t *macro_list,
+                        const assembler_options_t *options);
+
+/*
+ * @brief Starts an assembling whose expanded source is given a part at a
+ *        time (see FeedAssembly), e.g. as it's being preprocessed. Once it's
+ *        all given, FinishAssembly completes it just as AssembleSource would
+ *        have, had it been given the whole source at once.
+ *
+ * @param file_path, macro_list, options - As in AssembleSource
+ *                                         (incremental is ignored).
+ *
+ * @return Upon success, a pointer to the assembling, which must be released
+ *         with DestroyAssembly. Upon failure, NULL.
+ */
+
+assembly_t *CreateAssembly(char *file_path,
+                           macro_table_t *macro_list,
+                           const assembler_options_t *options);
+
+/*
+ * @brief Runs the first pass over the next lines of the expanded source.
+ *        Syntax errors are reported as they're found, with the line numbers
+ *        of the whole source.
+ *
+ * @param assembly - The assembling.
+ *        lines - The lines following those given so far. They're no longer
+ *                needed once the function returns.
+ *
+ * @return SUCCESS (even if syntax errors were found), or
+ *         MEM_ALLOCATION_ERROR, after which the assembling can't be
+ *         finished.
+ */
+
+result_t FeedAssembly(assembly_t *assembly, const source_buffer_t *lines);
+
+/*
+ * @brief Completes an assembling once its whole source was given: runs the
+ *        second pass & generates the output files.
+ *
+ * @return Same as AssembleSource.
+ */
+
+result_t FinishAssembly(assembly_t *assembly);
+
+/*
+ * @brief Releases an assembling, whether or not it was finished.
+ */
+
+void DestroyAssembly(assembly_t *assembly);
+
+/*
+ * @brief Same as AssembleSource, but the output is returned in memory
+ *        instead of being written to files.
+ *
+ * @param file_path - Name of the source, used for error messages only.
+ *        program - Upon success, the assembled program is stored in it,
+ *                  and it must be released with DestroyAssembledProgram.
+ *                  Otherwise it's left empty.
+ *        Rest of the parameters - As in AssembleSource (binary_object is
+ *                                 ignored).
+ *
+ * @return SUCCESS, FAILURE if syntax errors were found, or
+ *         MEM_ALLOCATION_ERROR.
+ */
+
+result_t AssembleSourceToProgram(const char *file_path,
+                                 const source_buffer_t *source,
+                                 macro_table_t *macro_list,
+                                 const assembler_options_t *options,
+                                 assembled_program_t *program);
+
+/*
+ * @brief Releases the memory of a program assembled in memory.
+ */
+
+void DestroyAssembledProgram(assembled_program_t *program);
+
+/*
+ * @brief Creates an empty incremental state.
+ *
+ *        Given in the options of AssembleSource or AssembleSourceToProgram,
+ *        it keeps what each line of a successfully assembled source
+ *        produced: its words, its symbols & its references. When the same
+ *        file path is assembled again, only the lines which changed since
+ *        are encoded; the other lines' encodings are reused at their new
+ *        addresses, and only references to symbols which moved are patched.
+ *        The result (output files & messages) is identical to assembling
+ *        from scratch. If the source has errors, it's assembled from
+ *        scratch, so they're reported as usual.
+ *
+ * @param max_files - How many files the state keeps. Once it's full, the
+ *                    file assembled least recently is forgotten, and is
+ *                    assembled from scratch the next time.
+ *
+ * @return Upon success, a pointer to the state. Upon failure, NULL.
+ */
+
+incremental_state_t *CreateIncrementalState(size_t max_files);
+
+/*
+ * @brief Releases an incremental state, and everything kept in it.
+ */
+
+void DestroyIncrementalState(incremental_state_t *state);
+
+/*
+ * @brief Returns how many lines were encoded, and how many were reused,
+ *        by all of the assemblings using a state.
+ */
+
+void GetIncrementalStats(const incremental_state_t *state,
+                         unsigned long *encoded_lines,
+                         unsigned long *reused_lines);
+
 #endif /* __SH_ED_ASSEMBLER__ */
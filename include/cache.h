@@ -0,0 +1,101 @@
+#ifndef __SH_ED_CACHE__
+#define __SH_ED_CACHE__
+
+/*
+ * @brief An on-disk cache of assembling results, keyed by the contents of
+ *        the source (plus the assembler version, and whatever else affects
+ *        the output, e.g. command-line options).
+ *
+ *        Each entry is a directory named after the hash of its key, holding
+ *        the key itself, the messages printed while assembling, and the
+ *        output files (.am, .ob, .ent, .ext, .obj) that were produced.
+ *        The messages name the files they're about, so the output path is
+ *        stored as a placeholder, and the path of the source being restored
+ *        is put in its place: the same source is a hit wherever it's found.
+ *        Entries are written to a temporary directory which is then renamed,
+ *        so concurrent processes & threads never see a partial entry.
+ *
+ *        A cache may be used by several threads at once.
+ */
+
+#include <stdio.h> /* FILE */
+#include <stddef.h> /* size_t */
+#include "utils.h"
+
+typedef struct cache cache_t;
+
+/*
+ * @brief Opens a cache, creating its directory if it doesn't exist.
+ *
+ * @param path - The cache directory.
+ *
+ * @return Upon success, a pointer to the cache. Upon failure, NULL.
+ */
+
+cache_t *OpenCache(const char *path);
+
+/*
+ * @brief Closes a cache (its entries are kept on disk).
+ */
+
+void CloseCache(cache_t *cache);
+
+/*
+ * @brief Looks a source up, and upon a hit, materializes the cached output
+ *        files & prints the cached messages. Counts a hit or a miss.
+ *
+ * @param cache - The cache.
+ *        text - The contents of the source file.
+ *        size - Size of text.
+ *        variant - Anything else affecting the output (e.g. options).
+ *        output_base - The output files' path, without an extension.
+ *        diagnostics - Stream to which the cached messages are printed,
+ *                      naming output_base where they named the stored one.
+ *
+ * @return TRUE upon a hit, in which case the output files were written.
+ *         FALSE upon a miss (or if the cached outputs couldn't be written).
+ */
+
+bool_t RestoreFromCache(cache_t *cache,
+                        const char *text,
+                        size_t size,
+                        unsigned int variant,
+                        const char *output_base,
+                        FILE *diagnostics);
+
+/*
+ * @brief Removes the output files of a source, so outputs it no longer
+ *        produces aren't mistaken for its results (and stored in the cache).
+ *
+ * @param output_base - The output files' path, without an extension.
+ */
+
+void RemoveOutputFiles(const char *output_base);
+
+/*
+ * @brief Stores the results of a successful assembling in the cache.
+ *
+ * @param cache - The cache.
+ *        text, size, variant, output_base - As in RestoreFromCache.
+ *        messages - Stream holding the messages printed while assembling,
+ *                   from its beginning up to its current position. Wherever
+ *                   they contain output_base, it's replaced upon restoring.
+ *
+ * @return SUCCESS, or an error code if the entry couldn't be written (the
+ *         cache is left unchanged then).
+ */
+
+result_t StoreInCache(cache_t *cache,
+                      const char *text,
+                      size_t size,
+                      unsigned int variant,
+                      const char *output_base,
+                      FILE *messages);
+
+/*
+ * @brief Returns the number of hits & misses since the cache was opened.
+ */
+
+void GetCacheStats(cache_t *cache, unsigned long *hits, unsigned long *misses);
+
+#endif /* __SH_ED_CACHE__ */
@@ -1,7 +1,7 @@
 #ifndef __SH_ED_GENERATE_OPCODE__
 #define __SH_ED_GENERATE_OPCODE__
 
-#include "vector.h"
+#include "word_buffer.h"
 #include "language_definitions.h"
 
 typedef enum {
@@ -13,7 +13,7 @@ typedef enum {
 /* 
  * @brief Produce the machine code for an instruction statement.
  *
- * @param code_table - The vector that contains the code segment.
+ * @param code_table - The word buffer that contains the code segment.
  *        instruction - The instruction to encode.
  *        source_operand - Pointer to the source operand, or NULL if the
  *          instruction doesn't take one.
@@ -24,7 +24,7 @@ typedef enum {
  *         or MEM_ALLOCATION_ERROR upon a failure.
  */
 
-result_t InstructionStatementToMachinecode(vector_t *code_table,
+result_t InstructionStatementToMachinecode(word_buffer_t *code_table,
                                            const char *instruction,
                                            operand_t *source_operand,
                                            operand_t *dest_operand);
@@ -33,7 +33,7 @@ result_t InstructionStatementToMachinecode(vector_t *code_table,
  * @brief Produce the memory encoding of an .string directive statement and add 
  *        them to the data segment.
  *
- * @param data_table - The vector that contains the data segment.
+ * @param data_table - The word buffer that contains the data segment.
  *        string - The string to convert to machine code, with quotations marks.
  *                 e.g. "\"hello world!\"". 
  *
@@ -43,13 +43,14 @@ result_t InstructionStatementToMachinecode(vector_t *code_table,
  *         or MEM_ALLOCATION_ERROR upon a failure.
  */
 
-result_t StringDirectiveToMachinecode(vector_t *data_table, char *string);
+result_t StringDirectiveToMachinecode(word_buffer_t *data_table,
+                                      const char *string);
 
 /* 
  * @brief Produce the memory encoding of an .data directive statement and add
  *        them to the data segment.
  *
- * @param data_table - The vector that contains the data segment.
+ * @param data_table - The word buffer that contains the data segment.
  *        params - A string containing the parameters passed to the .data directive.
  *                 e.g. "+13, 18, 0,-1,+333"
  *
@@ -60,6 +61,7 @@ result_t StringDirectiveToMachinecode(vector_t *data_table, char *string);
  *
  */
 
-result_t DataDirectiveToMachinecode(vector_t *data_table, char *params);
+result_t DataDirectiveToMachinecode(word_buffer_t *data_table,
+                                    const char *params);
 
 #endif /* __SH_ED_GENERATE_OPCODE__ */
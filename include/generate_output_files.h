@@ -1,24 +1,92 @@
 #ifndef __SH_ED_GENERATE_OUTPUT_FILES__
 #define __SH_ED_GENERATE_OUTPUT_FILES__
 
+#include <stdio.h> /* FILE */
 #include "utils.h"
 #include "vector.h"
+#include "word_buffer.h"
 #include "symbol_table.h"
 #include "list.h"
+#include "arena.h"
+#include "string_pool.h"
 
 /*
  * @brief All occurrence where an external symbol was used.
  */
 
 typedef struct external_symbol_data {
-  const char *symbol_name;
+  const char *symbol_name; /* Interned in the list's pool */
   vector_t *occurrences;
 } external_symbol_data_t;
 
 typedef struct {
   list_t *external_symbols;
+  arena_t *arena; /* NULL when the list is allocated on the heap */
+  string_pool_t *names;
+  bool_t owns_names; /* Whether the pool was created by the list */
 } ext_symbol_occurrences_t;
 
+/*
+ * @brief The output of a program assembled in streaming mode (see
+ *        AssembleStream), spilled to temporary files rather than held in
+ *        memory.
+ *
+ * code, data - The words of each segment, as arrays of machine_word_t
+ *              (code_size & data_size words).
+ * ext_refs - Every use of an external symbol (spilled_ext_ref_t), in the
+ *            order of the code.
+ * externals - The external symbols used (spilled_external_t), in the order
+ *             of their first use. It grows with the number of symbols only.
+ */
+
+typedef struct {
+  const char *symbol_name; /* Interned in the symbol table's pool */
+  unsigned long references_num;
+} spilled_external_t;
+
+typedef struct {
+  size_t external_index; /* Of the symbol, in 'externals' */
+  unsigned int address;
+} spilled_ext_ref_t;
+
+typedef struct {
+  FILE *code;
+  size_t code_size;
+  FILE *data;
+  size_t data_size;
+  FILE *ext_refs;
+  vector_t *externals;
+} spilled_output_t;
+
+/*
+ * Binary object file (.obj) layout. It's meant to be mmap'd by loaders, so
+ * every section starts 4-byte aligned. All numbers are little-endian.
+ *
+ * Header (32 bytes): 8 uint32 fields
+ *   magic ("SHOB"), version, code_base (address of the first word),
+ *   IC (code words), DC (data words), symbols_num, ext_refs_num,
+ *   strings_size.
+ * Words: IC + DC uint16, code segment then data segment (15 bits each),
+ *   padded with a zero word to a multiple of 4 bytes.
+ * Symbols: symbols_num entries of 12 bytes
+ *   uint32 name_offset, uint32 address, uint8 type (BINARY_SYMBOL_*),
+ *   uint8 memory area (0 code, 1 data), uint16 reserved (0).
+ * External references: ext_refs_num entries of 8 bytes
+ *   uint32 name_offset, uint32 address of the word referencing it.
+ * Strings: strings_size bytes of null-terminated names; name_offset
+ *   fields are offsets into this section.
+ */
+
+#define BINARY_OBJECT_MAGIC "SHOB"
+#define BINARY_OBJECT_VERSION (1)
+#define BINARY_OBJECT_HEADER_SIZE (32)
+#define BINARY_SYMBOL_ENTRY_SIZE (12)
+#define BINARY_EXT_REF_ENTRY_SIZE (8)
+
+#define BINARY_SYMBOL_REGULAR (0)
+#define BINARY_SYMBOL_ENTRY (1)
+#define BINARY_SYMBOL_EXTERN (2)
+
 /* 
 *@brief Creating the obj file, entry file and extern file after the assembling process.
 
@@ -28,15 +96,59 @@ typedef struct {
 *       input_path - The path to the input file.
 *       external_symbol_data_list - list of typedef external_symbol_data that 
 *       contains the occurrences of each external symbol in the machine code
+*       binary_object - If TRUE, a binary object file (.obj) is written as
+*       well, see the layout above.
+*       threads_num - Threads the .ob file may be formatted on; big files
+*       are split between them. The file is the same for any number.
 *       
 *@return SUCCESS if the function finished the job successfullly. Otherwise, FAILURE;
 */
 
-result_t GenerateOutputFiles(vector_t *code_table,
-                             vector_t *data_table,
+result_t GenerateOutputFiles(word_buffer_t *code_table,
+                             word_buffer_t *data_table,
                              symbol_table_t *symbol_table,
                              const char *input_path,
-                             ext_symbol_occurrences_t* ext_symbol_occurrences);
+                             ext_symbol_occurrences_t* ext_symbol_occurrences,
+                             bool_t binary_object,
+                             unsigned int threads_num);
+
+/*
+ * @brief Same as GenerateOutputFiles, but for the output of an assembling
+ *        in streaming mode. The output files are identical, but they're
+ *        written a chunk at a time, so memory doesn't grow with the size of
+ *        the program.
+ *
+ *        The .ext file (and the .obj's external references) list the uses
+ *        of each symbol together, so the spilled references are read in a
+ *        few passes, each gathering the uses of as many symbols as fit in
+ *        a fixed buffer.
+ *
+ * @param output - The spilled output. Its streams are read from the start.
+ *        Rest of the parameters - As in GenerateOutputFiles.
+ *
+ * @return SUCCESS if the function finished the job successfullly.
+ *         Otherwise, FAILURE.
+ */
+
+result_t GenerateOutputFilesFromSpill(spilled_output_t *output,
+                                      symbol_table_t *symbol_table,
+                                      const char *input_path,
+                                      bool_t binary_object);
+
+/*
+ * @brief Spills a use of an external symbol (see spilled_output_t).
+ *
+ * @param output - The spilled output.
+ *        symbol_name - Name of the symbol, interned in the symbol table's
+ *                      pool.
+ *        address - The address of the word referring to it.
+ *
+ * @return SUCCESS, MEM_ALLOCATION_ERROR or ERROR_WRITING_TO_FILE.
+ */
+
+result_t SpillExternalReference(spilled_output_t *output,
+                                const char *symbol_name,
+                                unsigned int address);
 
 /*
  * @brief Initiates external symbol list.
@@ -46,6 +158,22 @@ result_t GenerateOutputFiles(vector_t *code_table,
 
 ext_symbol_occurrences_t *CreateExternalSymbolList(void);
 
+/*
+ * @brief Initiates external symbol list, whose records are allocated from an
+ *        arena. The occurrences vectors are still on the heap, so
+ *        DestroyExternSymbolList must be called for such a list as well.
+ *
+ * @param arena - The arena to allocate from. If NULL, the heap is used.
+ *        names - Pool in which symbol names are interned. Passing the pool
+ *                of the symbol table saves copying the names. If NULL, the
+ *                list creates a pool of its own.
+ *
+ * @return Upon success, return pointer to the list. Otherwise NULL. 
+ */
+
+ext_symbol_occurrences_t *CreateExternalSymbolListInArena(arena_t *arena,
+                                                          string_pool_t *names);
+
 /*
  * @brief  Free all the resources that the external symbol list has used. 
  *
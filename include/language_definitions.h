@@ -113,10 +113,44 @@ typedef enum {
 } directive_t;
   
 
-extern instruction_t reserved_instructions[NUM_OF_INSTRUCTIONS];
+typedef enum {
+  INSTRUCTION_WORD,
+  DIRECTIVE_WORD,
+  REGISTER_WORD,
+  NOT_RESERVED
+} reserved_word_kind_t;
+
+/*
+ * A reserved word, as classified by IdentifyReservedWord.
+ * kind - Whether it's an instruction, a directive or a register name.
+ * index - Its index in reserved_instructions, reserved_directives or
+ *         register_names respectively (i.e. the opcode, directive_t or
+ *         register number). Undefined for NOT_RESERVED.
+ */
+
+typedef struct {
+  reserved_word_kind_t kind;
+  int index;
+} reserved_word_t;
+
+extern const instruction_t reserved_instructions[NUM_OF_INSTRUCTIONS];
 
-extern char *reserved_directives[NUM_OF_DIRECTIVES];
+extern const char *const reserved_directives[NUM_OF_DIRECTIVES];
+
+extern const char *const register_names[NUM_OF_REGISTERS];
+
+/*
+ * @brief Classifies a word as an instruction, directive or register name.
+ *
+ *        Rather than comparing the word against every reserved word, its
+ *        length & first characters select the single reserved word it may
+ *        be, so it's compared at most once.
+ *
+ * @param word - Null-terminated word to classify.
+ *
+ * @return The kind & index of the reserved word, or kind NOT_RESERVED.
+ */
 
-extern char *register_names[NUM_OF_REGISTERS];
+reserved_word_t IdentifyReservedWord(const char *word);
 
 #endif /* __SH_ED_LANGUAGE_DEFINITIONS__ */
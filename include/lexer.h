@@ -0,0 +1,97 @@
+#ifndef __SH_ED_LEXER__
+#define __SH_ED_LEXER__
+
+/*
+ * @brief A lexer splitting a single line of assembly into tokens.
+ *
+ *        Tokens point into the line itself, which isn't modified or copied,
+ *        and each character of the line is scanned once. The line doesn't
+ *        have to be null-terminated, and ends at its length or at a '\n'.
+ *
+ *        Tokens are:
+ *        LABEL_TOKEN - A word ending with ':' (e.g. "LOOP:"), only read by
+ *                      ReadLabel. The token doesn't include the ':'.
+ *        WORD_TOKEN - A sequence of characters other than blanks (' ',
+ *                     '\t', '\r'), commas & newlines (e.g. "mov", "#-3").
+ *        COMMA_TOKEN - A single ','.
+ *        END_TOKEN - The end of the line. Returned again on further calls.
+ */
+
+#include <stddef.h> /* size_t */
+#include "utils.h"  /* bool_t */
+
+typedef enum {
+  LABEL_TOKEN,
+  WORD_TOKEN,
+  COMMA_TOKEN,
+  END_TOKEN
+} token_kind_t;
+
+typedef struct {
+  token_kind_t kind;
+  const char *start;
+  size_t length;
+} token_t;
+
+/* NOTE: The fields are only exposed so a lexer can be declared on the
+ *       stack. Use the functions below to access them. */
+
+typedef struct {
+  const char *cursor;
+  const char *end;
+} lexer_t;
+
+/*
+ * @brief Starts lexing a line.
+ * @param lexer - The lexer to initialize.
+ *        line - The line to split into tokens.
+ *        length - Number of characters in line.
+ */
+void InitLexer(lexer_t *lexer, const char *line, size_t length);
+
+/*
+ * @brief Returns the next token in the line, and advances past it.
+ * @return A WORD_TOKEN, COMMA_TOKEN or END_TOKEN.
+ */
+token_t NextToken(lexer_t *lexer);
+
+/*
+ * @brief Reads a label definition (e.g. "LOOP: ..."), if the line has one
+ *        at the current position. The label's word extends up to a blank,
+ *        so commas in it are reported as part of its name.
+ * @param lexer - The lexer.
+ *        label - If a label is read, its LABEL_TOKEN is stored here.
+ * @return TRUE if a label was read. Otherwise FALSE, and the lexer doesn't
+ *         advance.
+ */
+bool_t ReadLabel(lexer_t *lexer, token_t *label);
+
+/*
+ * @brief Returns the next word in the line, skipping commas.
+ * @return The next WORD_TOKEN, or END_TOKEN if there are no words left.
+ */
+token_t NextWord(lexer_t *lexer);
+
+/*
+ * @brief Copies the rest of the line, without leading blanks & the newline,
+ *        and advances to the end of the line.
+ * @param lexer - The lexer.
+ *        dest - Buffer of at least as many characters as the line, + 1.
+ * @return dest, as a null-terminated string (empty if nothing is left).
+ */
+char *CopyRestOfLine(lexer_t *lexer, char *dest);
+
+/*
+ * @brief Copies a token's text into a null-terminated string.
+ * @param token - The token to copy.
+ *        dest - Buffer of at least token->length + 1 characters.
+ * @return dest.
+ */
+char *CopyToken(const token_t *token, char *dest);
+
+/*
+ * @brief Tells if a token's text starts with a certain character.
+ */
+bool_t TokenStartsWith(const token_t *token, char c);
+
+#endif /* __SH_ED_LEXER__ */
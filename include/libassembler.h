@@ -0,0 +1,52 @@
+#ifndef __SH_ED_LIBASSEMBLER__
+#define __SH_ED_LIBASSEMBLER__
+
+/*
+ * The assembler as a library (libassembler.a / libassembler.so): source text
+ * is taken from memory, and the assembled program is returned in memory, so
+ * nothing is read from or written to disk.
+ *
+ * Usage:
+ *
+  assembled_program_t program;
+  assembler_options_t options = CreateAssemblerOptions();
+
+  if (SUCCESS == AssembleText("snippet", text, strlen(text), &options,
+                              &program)) {
+    ... program.code, program.data, program.entries, program.externals ...
+    DestroyAssembledProgram(&program);
+  }
+
+ * Calls with different options may be made concurrently.
+ */
+
+#include <stddef.h> /* size_t */
+#include "utils.h"
+#include "assembler.h"
+
+/*
+ * @brief Preprocesses & assembles source text (the contents of a .as file).
+ *
+ * @param source_name - Name of the source, used for error messages only.
+ *        text - The source text (doesn't have to be null-terminated).
+ *        length - Number of characters in text.
+ *        options - See assembler_options_t. Syntax errors are printed to
+ *                  its diagnostics stream. If it has an arena, the
+ *                  assembling's tables are allocated from it, and it's reset
+ *                  before returning; reusing one arena for many calls saves
+ *                  most allocations.
+ *        program - Upon success, the assembled program is stored in it, and
+ *                  it must be released with DestroyAssembledProgram.
+ *                  Otherwise it's left empty.
+ *
+ * @return SUCCESS, FAILURE if syntax errors were found, or
+ *         MEM_ALLOCATION_ERROR.
+ */
+
+result_t AssembleText(const char *source_name,
+                      const char *text,
+                      size_t length,
+                      const assembler_options_t *options,
+                      assembled_program_t *program);
+
+#endif /* __SH_ED_LIBASSEMBLER__ */
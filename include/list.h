@@ -5,6 +5,8 @@
  * @brief An impelementation of a singly-linked list.
  */
 
+#include "arena.h"
+
 typedef struct node node_t;
 typedef struct list list_t;
 typedef int (*cmp_func)(void *, void *);
@@ -16,6 +18,16 @@ typedef int (*cmp_func)(void *, void *);
  */
 list_t *CreateList(void);
 
+/*
+ * @brief Creates a new empty list, whose nodes are allocated from an arena.
+ *        DestroyList doesn't free the nodes of such a list; they are released
+ *        along with the arena.
+ * @param arena - The arena to allocate from. If NULL, same as CreateList.
+ * @return Upon success, return a pointer to the newly created list.
+ *         Upon failure, return NULL.
+ */
+list_t *CreateListInArena(arena_t *arena);
+
 /*
  * @brief Deallocates the memory of a list.
  * @param list - the list we wish to deallocate
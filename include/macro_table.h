@@ -20,7 +20,10 @@
  *          mov A, r1'
  */
 
+#include <stddef.h> /* size_t */
 #include "utils.h"
+#include "arena.h"
+
 typedef struct macro_table macro_table_t;
 typedef struct macro_struct macro_t;
 
@@ -30,6 +33,17 @@ typedef struct macro_struct macro_t;
  */
 macro_table_t *CreateMacroTable(void);
 
+/*
+ * @brief Creates a new empty macro table, whose macros, names, definitions &
+ *        index are allocated from an arena (names are interned in a pool of
+ *        the table). DestroyMacroTable doesn't free
+ *        such a table; it is released along with the arena.
+ * @param arena - The arena to allocate from. If NULL, same as
+ *                CreateMacroTable.
+ * @return Upon success, a new macro table. When failure, returns NULL.
+ */
+macro_table_t *CreateMacroTableInArena(arena_t *arena);
+
 /*
  * @brief Adds a new macro, if one with the same name doesn't exist in
  *        the table.
@@ -46,7 +60,9 @@ macro_table_t *CreateMacroTable(void);
  *         Else, if the macro has been written to the table successfully, 
  *         SUCCESS is returned.
  *
- * NOTE: the function performs a deep copy of macro_name & macro_definition.
+ * NOTE: the function copies macro_definition into the table's definitions
+ *       (see AppendToDefinition), and interns macro_name in the table's
+ *       string pool.
  */
 
 result_t AddMacroIfUnique(macro_table_t *table,
@@ -63,6 +79,41 @@ result_t AddMacro(macro_table_t *table,
                   const char *macro_name,
                   const char *macro_definition);
 
+/*
+ * @brief Appends text to the definition being written into the table, for
+ *        a macro which is added once it's complete (see AddDefinedMacro).
+ *        A definition read line by line is thus copied once, straight into
+ *        the table, with no memory allocated for it on its own: the
+ *        definitions of all macros are slices of a single buffer.
+ *
+ * @param table - The table whose definition is written.
+ *        text - The text to append (doesn't have to be null-terminated).
+ *        length - Number of characters to append.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+result_t AppendToDefinition(macro_table_t *table,
+                            const char *text,
+                            size_t length);
+
+/*
+ * @brief Discards the definition being written into the table (e.g. once
+ *        it turns out to have syntax errors). AddMacro discards it as well.
+ */
+
+void DiscardDefinition(macro_table_t *table);
+
+/*
+ * @brief Same as AddMacro, where the macro's definition is what was
+ *        appended to the table (see AppendToDefinition) since the last
+ *        macro was added, or the last definition was discarded.
+ *
+ * @return Same as AddMacro. Upon failure, the definition is discarded.
+ */
+
+result_t AddDefinedMacro(macro_table_t *table, const char *macro_name);
+
 /*
  * @brief Deallocates the memory of a macro table, including macro names &
  *        definitions.
@@ -82,10 +133,16 @@ macro_t *FindMacro(macro_table_t *table,
 
 /*
  * @brief Returns the definition for a given macro 
- * @param macro - The macro whose definition we're looking for.
+ * @param table - The macro table the macro belongs to.
+ *        macro - The macro whose definition we're looking for.
+ *        length - Output parameter, the length of the definition is stored
+ *                 in it (unless it's NULL).
  *
- * @return The macro's definition, or NULL if it cant find the macro.
+ * @return The macro's definition, null-terminated. It's valid until a
+ *         definition is written into the table.
  */
-const char *GetMacroDefinition(macro_t *macro);
+const char *GetMacroDefinition(const macro_table_t *table,
+                               const macro_t *macro,
+                               size_t *length);
 
 #endif /* __SH_ED_MACRO_TABLE__ */
@@ -0,0 +1,74 @@
+#ifndef __SH_ED_NAME_INDEX__
+#define __SH_ED_NAME_INDEX__
+
+/*
+ * @brief An index of values by interned names (see string_pool.h).
+ *
+ *        An open-addressing hash table with linear probing, whose capacity
+ *        is a power of 2 and which is kept at most half full. Names are
+ *        placed by the hash the pool stored along with them, and an
+ *        interned name is matched by its address, without comparing
+ *        characters. Names can't be removed.
+ */
+
+#include <stddef.h> /* size_t */
+#include "utils.h"
+#include "arena.h"
+
+typedef struct name_index name_index_t;
+
+/*
+ * @brief Creates a new empty index.
+ * @param arena - Arena from which the index is allocated. If NULL, the
+ *                heap is used, and the index is released by
+ *                DestroyNameIndex.
+ *        initial_capacity - Number of slots to begin with (a power of 2).
+ * @return Upon success, a pointer to the new index. Upon failure, NULL.
+ */
+name_index_t *CreateNameIndex(arena_t *arena, size_t initial_capacity);
+
+/*
+ * @brief Releases an index allocated from the heap. For an index created
+ *        in an arena, does nothing.
+ */
+void DestroyNameIndex(name_index_t *index);
+
+/*
+ * @brief Makes room for one more name, growing the index if needed, so
+ *        IndexName can't fail.
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR (the index is left unchanged).
+ */
+result_t ReserveName(name_index_t *index);
+
+/*
+ * @brief Adds a name to the index, unless it's indexed already, in which
+ *        case the earlier value is kept. Room must have been reserved (see
+ *        ReserveName).
+ * @param name - An interned string.
+ *        value - Value of the name, which mustn't be NULL.
+ */
+void IndexName(name_index_t *index, const char *name, void *value);
+
+/*
+ * @brief Returns the value of an interned name, or NULL if it isn't indexed.
+ */
+void *FindIndexedName(const name_index_t *index, const char *name);
+
+/*
+ * @brief Looks for an indexed name equal to a string which may not be
+ *        interned, by its characters.
+ * @param str - The string.
+ *        hash, length - Its hash value (see HashString) & length.
+ * @return The indexed name, or NULL if there's none.
+ */
+const char *FindIndexedString(const name_index_t *index,
+                              const char *str,
+                              unsigned long hash,
+                              size_t length);
+
+/*
+ * @brief Returns the number of names in an index.
+ */
+size_t GetNameIndexSize(const name_index_t *index);
+
+#endif /* __SH_ED_NAME_INDEX__ */
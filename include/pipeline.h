@@ -0,0 +1,43 @@
+#ifndef __SH_ED_PIPELINE__
+#define __SH_ED_PIPELINE__
+
+/*
+ * Pipelined mode: the macro expansion & the first pass of a single file run
+ * at once, so a large file keeps two cores busy rather than one.
+ *
+ * Once its macros are read (see ReadMacros), the source is expanded on a
+ * producer thread, a chunk of lines at a time. Each chunk is handed to the
+ * first pass, running on the calling thread, through a bounded lock-free
+ * queue (see spsc_queue.h); chunks the first pass is done with are handed
+ * back through another one, so a fixed number of chunk buffers is reused.
+ * The second pass & the output follow once the whole source was expanded.
+ */
+
+#include "utils.h"
+#include "macro_table.h"
+#include "source_buffer.h"
+#include "assembler.h"
+
+/*
+ * @brief Same as expanding a source with ExpandMacros, then assembling the
+ *        expanded source with AssembleSource, with both running at once.
+ *        The output files & messages are identical.
+ *
+ * @param file_path - Path of the .am file the expanded source corresponds
+ *                    to, as in AssembleSource.
+ *        source - The source, before expansion.
+ *        macro_table - Its macro table, as read by ReadMacros.
+ *        expanded_source - If not NULL, the expanded source is appended to
+ *                          it as well (e.g. to write a .am file).
+ *        options - As in AssembleSource (incremental is ignored).
+ *
+ * @return Same as AssembleSource.
+ */
+
+result_t AssemblePipelined(char *file_path,
+                           const source_buffer_t *source,
+                           macro_table_t *macro_table,
+                           source_buffer_t *expanded_source,
+                           const assembler_options_t *options);
+
+#endif /* __SH_ED_PIPELINE__ */
@@ -17,8 +17,10 @@
  *           space.
  */
 
+#include <stdio.h> /* FILE */
 #include "utils.h"
 #include "macro_table.h"
+#include "source_buffer.h"
 
 /*
  * @brief Performs preprocessing on a .as file:
@@ -47,4 +49,102 @@
  */
 macro_table_t *PreprocessFile(char *input_path, char *output_path);
 
+/*
+ * @brief Same as PreprocessFile, but the expanded source is kept in memory
+ *        instead of being written to a .am file, so it can be handed straight
+ *        to the assembler (see AssembleSource).
+ *
+ * @param input_path - Path to the .as input file to be processed.
+ *        output - A valid empty source buffer, into which the expanded source
+ *                 is written.
+ *        diagnostics - Stream to which syntax errors are printed (stdout for
+ *                      PreprocessFile).
+ *        arena - Arena from which the macro table is allocated, or NULL for
+ *                the heap (see CreateMacroTableInArena).
+ *
+ * @returns Same as PreprocessFile. If NULL is returned, the contents of
+ *          'output' are unspecified.
+ */
+macro_table_t *PreprocessSource(char *input_path,
+                                source_buffer_t *output,
+                                FILE *diagnostics,
+                                arena_t *arena);
+
+/*
+ * @brief Same as PreprocessSource, but the source is given in memory as well
+ *        (e.g. text handed to the library, see AssembleText).
+ *
+ * @param source_name - Name of the source, used for error messages only.
+ *        source - The source to preprocess.
+ *        Rest of the parameters - As in PreprocessSource.
+ *
+ * @returns Same as PreprocessSource.
+ */
+macro_table_t *PreprocessBuffer(const char *source_name,
+                                const source_buffer_t *source,
+                                source_buffer_t *output,
+                                FILE *diagnostics,
+                                arena_t *arena);
+
+/*
+ * @brief The first pass of PreprocessBuffer: reads the macros defined in a
+ *        source, reporting syntax errors in their definitions. The source
+ *        may then be expanded with ExpandMacros (e.g. a part at a time).
+ *
+ * @param source_name - Name of the source, used for error messages only.
+ *        source - The source to read macros from.
+ *        diagnostics - Stream to which syntax errors are printed.
+ *        arena - As in PreprocessSource.
+ *
+ * @returns The source's macro table, or NULL if syntax errors were found
+ *          (or memory couldn't be allocated).
+ */
+macro_table_t *ReadMacros(const char *source_name,
+                          const source_buffer_t *source,
+                          FILE *diagnostics,
+                          arena_t *arena);
+
+/*
+ * @brief The second pass of PreprocessBuffer: appends the expansion of a
+ *        source's lines to an output buffer. Comments, blank lines & macro
+ *        definitions are dropped, and macro usages replaced by definitions.
+ *
+ * @param source - The source to expand.
+ *        table - Its macro table (see ReadMacros). It's only read, so
+ *                several threads may expand sources with it at once.
+ *        line_index - Index of the first line to expand. Upon return, the
+ *                     index of the line after the last one expanded.
+ *        max_lines - Expanding stops once at least this many lines were
+ *                    appended to the output (a macro usage is expanded
+ *                    whole), or 0 to expand the rest of the source.
+ *        output - Source buffer to which the expanded lines are appended.
+ *
+ * @returns SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+result_t ExpandMacros(const source_buffer_t *source,
+                      macro_table_t *table,
+                      size_t *line_index,
+                      size_t max_lines,
+                      source_buffer_t *output);
+
+/*
+ * @brief Same as PreprocessSource, but for sources too big to be held in
+ *        memory: the source is read, and the expanded source written, a
+ *        window of lines at a time. Memory doesn't grow with the size of
+ *        the source, only with its macros (a window is extended to hold
+ *        any macro definition starting in it).
+ *
+ * @param input_path - Path to the .as input file to be processed.
+ *        output - Stream to which the expanded source is written (e.g. a
+ *                 .am file, or a temporary file).
+ *        Rest of the parameters - As in PreprocessSource.
+ *
+ * @returns Same as PreprocessSource. If NULL is returned, what was written
+ *          to 'output' is unspecified.
+ */
+macro_table_t *PreprocessStream(char *input_path,
+                                FILE *output,
+                                FILE *diagnostics,
+                                arena_t *arena);
+
 #endif /* __SH_ED_PREPROCESSING__ */
@@ -0,0 +1,104 @@
+#ifndef __SH_ED_SERVER__
+#define __SH_ED_SERVER__
+
+/*
+ * Server mode: a long running assembler which takes requests over a stream
+ * (stdin, or a connection to a UNIX socket), so the process startup & the
+ * warm up of its allocators are paid for once, rather than for every file.
+ *
+ * Requests are lines of text:
+ *   file <name> [<name> ...]
+ *     Assembles <directory>/<name>.as into output files, exactly as when
+ *     the names are passed in argv. Several names make up a batch, whose
+ *     responses are flushed together.
+ *   source <name> <length>
+ *     Followed by exactly <length> bytes of source text (the contents of a
+ *     .as file), which is assembled in memory. No file is read or written;
+ *     the object is returned in the response instead.
+ *   quit
+ *     Ends the session (as does the end of the stream).
+ *   shutdown
+ *     Ends the session, and stops a socket server.
+ *
+ * Every file or source gets a response, in the order of the requests:
+ *   <ok|error> <name> <messages_length> <object_length>\n
+ * followed by <messages_length> bytes of messages (what the assembler
+ * prints for the file on the command line), and <object_length> bytes of
+ * object. The object is empty, except for a source which was assembled
+ * successfully:
+ *   The .ob file.
+ *   entries <n>\n, followed by n lines as in the .ent file.
+ *   externals <n>\n, followed by n lines as in the .ext file.
+ * A request which can't be parsed gets an "error" response whose name is
+ * "-", and whose messages explain what's wrong. A malformed 'source'
+ * request ends the session as well, since its text can't be skipped.
+ */
+
+#include <stdio.h> /* FILE */
+#include "utils.h"
+#include "assembler.h"
+
+/*
+ * @brief Assembles a file of the given directory to output files (main's
+ *        AssembleOneFile).
+ *
+ * @param arg - The assemble_arg of the server's configuration.
+ *
+ * @return TRUE if the file was assembled successfully, FALSE otherwise.
+ */
+
+typedef bool_t (*assemble_file_func_t)(const char *directory,
+                                       const char *file_name,
+                                       const assembler_options_t *options,
+                                       void *arg);
+
+/*
+ * Configuration of a server (see RunServer).
+ * directory - Directory in which the files of 'file' requests are found.
+ * options - Assembler options for every request. Its diagnostics stream is
+ *           replaced by the server's. An arena should be given, so it's
+ *           reused between requests.
+ * assemble_file - How 'file' requests are assembled.
+ * assemble_arg - Passed to assemble_file as is, e.g. the caller's settings
+ *                of how files are assembled (such as writing .am files).
+ */
+
+typedef struct {
+  const char *directory;
+  assembler_options_t options;
+  assemble_file_func_t assemble_file;
+  void *assemble_arg;
+} server_config_t;
+
+/*
+ * @brief Serves requests from a stream, until it ends or a 'quit' or
+ *        'shutdown' request is read.
+ *
+ * @param requests - Stream from which requests are read.
+ *        responses - Stream to which responses are written.
+ *        config - See server_config_t.
+ *
+ * @return TRUE if the session ended with a 'shutdown' request, FALSE
+ *         otherwise (end of the stream, 'quit' or a failure to write).
+ */
+
+bool_t RunServer(FILE *requests, FILE *responses,
+                 const server_config_t *config);
+
+/*
+ * @brief Listens on a UNIX socket, serving one connection at a time (see
+ *        RunServer), until a 'shutdown' request is read.
+ *
+ * @param socket_path - Path of the socket. A socket left there (e.g. by an
+ *                      earlier server) is replaced, but any other file is
+ *                      kept.
+ *        config - See server_config_t.
+ *
+ * @return SUCCESS once shut down, or FAILURE if the socket couldn't be
+ *         set up (including when the path is taken by another file).
+ */
+
+result_t RunSocketServer(const char *socket_path,
+                         const server_config_t *config);
+
+#endif /* __SH_ED_SERVER__ */
@@ -0,0 +1,149 @@
+#ifndef __SH_ED_SOURCE_BUFFER__
+#define __SH_ED_SOURCE_BUFFER__
+
+/*
+ * @brief A source file held in memory, along with an index of its lines.
+ *
+ *        The whole file is read once, and is then accessed line by line
+ *        without any further I/O.
+ *        A source buffer may also be built in memory (e.g. the preprocessor's
+ *        output, which is handed to the assembler without touching the disk).
+ *        Lines are split exactly like fgets with a buffer of MAX_LINE_LENGTH
+ *        characters would split them: a line ends right after a '\n', or after
+ *        MAX_LINE_LENGTH - 1 characters, whichever comes first.
+ */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h> /* FILE */
+#include "utils.h"
+
+typedef struct source_buffer source_buffer_t;
+
+/*
+ * @brief Creates a new empty source buffer.
+ *
+ * @return Upon success, a pointer to the newly created source buffer.
+ *         Upon failure, NULL.
+ */
+
+source_buffer_t *CreateSourceBuffer(void);
+
+/*
+ * @brief Reads a file into memory and indexes its lines.
+ *
+ * @param path - Path to the file to read.
+ *
+ * @return Upon success, a pointer to the newly created source buffer.
+ *         Upon failure (the file couldn't be read, or a memory allocation
+ *         error occurred), an error is printed and NULL is returned.
+ */
+
+source_buffer_t *LoadSourceFile(const char *path);
+
+/*
+ * @brief Appends text to the end of a source buffer, and indexes its lines.
+ *        Lines are split as if the whole text of the buffer was read at once,
+ *        so text may be appended in any number of pieces.
+ *
+ * @param buffer - The source buffer to append to.
+ *        text - The text to append (doesn't have to be null-terminated).
+ *        length - Number of characters to append.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR upon failure.
+ */
+
+result_t AppendSourceText(source_buffer_t *buffer,
+                          const char *text,
+                          size_t length);
+
+/*
+ * @brief Reads lines from a stream and appends them to a source buffer.
+ *        Lines are split as LoadSourceFile splits them, so a file read in
+ *        any number of calls is indexed as if it was loaded at once.
+ *
+ * @param buffer - The source buffer to append to.
+ *        file - The stream to read from.
+ *        max_lines - Maximal number of lines to read.
+ *
+ * @return SUCCESS (fewer lines are read only at the end of the stream),
+ *         MEM_ALLOCATION_ERROR or FILE_HANDLING_ERROR.
+ */
+
+result_t ReadSourceLines(source_buffer_t *buffer, FILE *file,
+                         size_t max_lines);
+
+/*
+ * @brief Empties a source buffer, keeping its memory for the text which is
+ *        appended next (e.g. the next window of a file read a few lines at
+ *        a time).
+ */
+
+void ClearSourceBuffer(source_buffer_t *buffer);
+
+/*
+ * @brief Writes the whole text of a source buffer to a file.
+ *
+ * @param buffer - The source buffer to write.
+ *        path - Path of the file to write (it's overwritten if it exists).
+ *
+ * @return SUCCESS, ERROR_OPENING_FILE or ERROR_WRITING_TO_FILE.
+ */
+
+result_t WriteSourceFile(const source_buffer_t *buffer, const char *path);
+
+/*
+ * @brief Deallocates the memory of a source buffer.
+ *
+ * @param buffer - The source buffer we wish to destroy.
+ */
+
+void DestroySourceBuffer(source_buffer_t *buffer);
+
+/*
+ * @brief Returns the number of lines in a source buffer.
+ */
+
+size_t GetLineCount(const source_buffer_t *buffer);
+
+/*
+ * @brief Returns the whole text of a source buffer.
+ *
+ * @param buffer - The source buffer.
+ *        size - Output parameter, the size of the text is stored in it.
+ *
+ * @return Pointer to the text. It isn't null-terminated.
+ */
+
+const char *GetSourceText(const source_buffer_t *buffer, size_t *size);
+
+/*
+ * @brief Returns the text of a line.
+ *
+ * @param buffer - The source buffer.
+ *        index - Index of the line (starting from 0).
+ *        length - Output parameter, the length of the line is stored in it
+ *                 (including its '\n', if it has one).
+ *
+ *        NOTE: If index >= GetLineCount(buffer), behaviour is undefined.
+ *
+ * @return Pointer to the start of the line. The line isn't null-terminated.
+ */
+
+const char *GetLine(const source_buffer_t *buffer, size_t index, size_t *length);
+
+/*
+ * @brief Copies a line into a null-terminated string.
+ *
+ * @param buffer - The source buffer.
+ *        index - Index of the line (starting from 0).
+ *        dest - Where the line is copied to. Must be at least MAX_LINE_LENGTH
+ *               characters long.
+ *
+ *        NOTE: If index >= GetLineCount(buffer), behaviour is undefined.
+ *
+ * @return dest.
+ */
+
+char *CopyLine(const source_buffer_t *buffer, size_t index, char *dest);
+
+#endif /* __SH_ED_SOURCE_BUFFER__ */
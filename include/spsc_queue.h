@@ -0,0 +1,71 @@
+#ifndef __SH_ED_SPSC_QUEUE__
+#define __SH_ED_SPSC_QUEUE__
+
+/*
+ * @brief A bounded, lock-free queue of pointers, between a single producer
+ *        thread and a single consumer thread.
+ *
+ *        Elements live in a ring of fixed capacity. The producer only
+ *        writes the tail & the consumer only writes the head, so neither
+ *        takes a lock; the release/acquire order of these writes makes an
+ *        element (& whatever it points to) visible before it's popped.
+ *        Pushing to a full queue, or popping from an empty one, waits by
+ *        yielding the processor until the other side catches up.
+ */
+
+#include <stddef.h> /* size_t */
+#include "utils.h"
+
+typedef struct spsc_queue spsc_queue_t;
+
+/*
+ * @brief Creates a new empty queue.
+ *
+ * @param capacity - Maximal number of elements in the queue. It's rounded
+ *                   up to a power of 2.
+ *
+ * @return Upon success, a pointer to the new queue. Upon failure, NULL.
+ */
+
+spsc_queue_t *CreateSpscQueue(size_t capacity);
+
+/*
+ * @brief Deallocates the memory of a queue. The elements left in it aren't
+ *        touched.
+ */
+
+void DestroySpscQueue(spsc_queue_t *queue);
+
+/*
+ * @brief Pushes an element, if the queue isn't full. Producer only.
+ *
+ * @return TRUE if the element was pushed, FALSE if the queue is full.
+ */
+
+bool_t TryPushSpscQueue(spsc_queue_t *queue, void *element);
+
+/*
+ * @brief Pops the oldest element, if the queue isn't empty. Consumer only.
+ *
+ * @param element - Output parameter, the element is stored in it.
+ *
+ * @return TRUE if an element was popped, FALSE if the queue is empty.
+ */
+
+bool_t TryPopSpscQueue(spsc_queue_t *queue, void **element);
+
+/*
+ * @brief Same as TryPushSpscQueue, waiting while the queue is full.
+ */
+
+void PushSpscQueue(spsc_queue_t *queue, void *element);
+
+/*
+ * @brief Same as TryPopSpscQueue, waiting while the queue is empty.
+ *
+ * @return The oldest element.
+ */
+
+void *PopSpscQueue(spsc_queue_t *queue);
+
+#endif /* __SH_ED_SPSC_QUEUE__ */
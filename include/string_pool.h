@@ -0,0 +1,72 @@
+#ifndef __SH_ED_STRING_POOL__
+#define __SH_ED_STRING_POOL__
+
+/*
+ * @brief A pool of interned strings.
+ *
+ *        Interning a string stores a single copy of it in the pool, and
+ *        returns that copy. Interning an equal string again returns the very
+ *        same pointer, so two interned strings of the same pool are equal
+ *        iff the pointers are equal, and tables keyed by interned names
+ *        compare them as integers instead of with strcmp.
+ *
+ *        The hash & length of an interned string are stored along with it,
+ *        and can be read back without scanning the string.
+ */
+
+#include <stddef.h> /* size_t */
+#include "arena.h"
+
+typedef struct string_pool string_pool_t;
+
+/*
+ * @brief Creates a new empty string pool.
+ * @param arena - Arena from which the pool & its strings are allocated.
+ *                If NULL, the pool allocates from an arena of its own, which
+ *                is released by DestroyStringPool.
+ * @return Upon success, a pointer to the new pool. Upon failure, NULL.
+ */
+string_pool_t *CreateStringPool(arena_t *arena);
+
+/*
+ * @brief Releases a string pool created without an arena, along with all
+ *        its strings. For a pool created in an arena, does nothing.
+ * @param pool - The pool we wish to destroy.
+ */
+void DestroyStringPool(string_pool_t *pool);
+
+/*
+ * @brief Returns the interned copy of a string, adding it to the pool if
+ *        it's not there yet.
+ * @param pool - The pool to intern the string in.
+ *        str - A null-terminated string. May be a string interned already.
+ * @return Upon success, the interned copy of str. Upon failure, NULL.
+ */
+const char *InternString(string_pool_t *pool, const char *str);
+
+/*
+ * @brief Looks for the interned copy of a string, without adding it.
+ * @param pool - The pool to search in.
+ *        str - A null-terminated string.
+ * @return The interned copy of str, or NULL if it isn't in the pool.
+ */
+const char *FindInternedString(string_pool_t *pool, const char *str);
+
+/*
+ * @brief Returns the hash value of an interned string (same as HashString).
+ * @param interned - A string returned by InternString or FindInternedString.
+ */
+unsigned long GetInternedHash(const char *interned);
+
+/*
+ * @brief Returns the length of an interned string (same as strlen).
+ * @param interned - A string returned by InternString or FindInternedString.
+ */
+size_t GetInternedLength(const char *interned);
+
+/*
+ * @brief Returns the number of distinct strings in a pool.
+ */
+size_t GetStringPoolSize(const string_pool_t *pool);
+
+#endif /* __SH_ED_STRING_POOL__ */
@@ -5,6 +5,7 @@
  * Functions for manipulating & analysing strings, which aren't present in <string.h>
  */
 
+#include <stddef.h> /* size_t */
 #include "utils.h" /* bool_t */
 
 /*
@@ -101,4 +102,41 @@ char *StrDup(const char *str);
  */
 int IsBlank(int c);
 
+/*
+ * @brief A reentrant counterpart of 'strtok' (like POSIX 'strtok_r').
+ *        Unlike 'strtok' it keeps no hidden state, so it's safe to use while
+ *        several files are assembled concurrently.
+ *
+ * @param str - The string to tokenize on the first call, NULL afterwards.
+ *        delimiters - Characters separating the tokens.
+ *        save_ptr - Where the position between calls is kept.
+ *
+ * @return Pointer to the next token, or NULL if there are no more tokens.
+ */
+char *TokenizeString(char *str, const char *delimiters, char **save_ptr);
+
+/*
+ * @brief Computes a hash value of a string (32-bit FNV-1a).
+ *
+ * @param str - Null-terminated string to hash.
+ *        length - If not NULL, the length of 'str' is stored in it, so callers
+ *                 that need both don't have to scan the string twice.
+ *
+ * @return The hash value of 'str'.
+ */
+unsigned long HashString(const char *str, size_t *length);
+
+/*
+ * @brief Computes the same hash as HashString, over a block of memory.
+ *        A hash may be computed piece by piece, continuing from the hash of
+ *        the preceding pieces.
+ *
+ * @param data - The memory to hash (may contain '\0').
+ *        size - Number of bytes to hash.
+ *        seed - 0 to start a new hash, or the hash of the preceding pieces.
+ *
+ * @return The hash value of the data.
+ */
+unsigned long HashBytes(const void *data, size_t size, unsigned long seed);
+
 #endif /* __SH_ED_STRING_UTILS__ */
@@ -18,6 +18,7 @@
 
 #include "utils.h"
 #include "list.h"
+#include "string_pool.h"
 
 typedef struct symbol_table symbol_table_t;
 typedef int address_t;
@@ -44,6 +45,20 @@ typedef struct symbol_struct symbol_t;
  */
 symbol_table_t *CreateSymbolTable(void);
 
+/*
+ * @brief Creates a empty symbol table, whose symbols & index are allocated
+ *        from an arena. DestroySymbolTable doesn't free such a table; it is
+ *        released along with the arena.
+ * @param arena - The arena to allocate from. If NULL, the heap is used.
+ *        names - Pool in which symbol names are interned, so they can be
+ *                shared with other tables of the same file. If NULL, the
+ *                table creates a pool of its own.
+ * @return Upon success, return a pointer to the newly created symbol table.
+ *         Upon failure, return NULL.
+ */
+symbol_table_t *CreateSymbolTableInArena(arena_t *arena,
+                                         string_pool_t *names);
+
 /*
  * @brief Deallocates the memory of a symbol table.
  * @param table - the table we wish to destroy.
@@ -107,11 +122,18 @@ symbol_t *FindSymbol(symbol_table_t *table,
 
 /*
  * @brief Get a symbol's name.
- * @return Symbol's name.
+ * @return Symbol's name, interned in the pool of the symbol's table.
  */
 
 const char *GetSymbolName(symbol_t *symbol);
 
+/*
+ * @brief Get the pool in which the names of a table's symbols are interned.
+ *        The pool lives as long as the table.
+ */
+
+string_pool_t *GetSymbolNames(symbol_table_t *table);
+
 /*
  * @brief Get a symbol's type
  * @return Symbol's type.
@@ -1,6 +1,7 @@
 #ifndef __SH_ED_SYNTAX_ERRORS__
 #define __SH_ED_SYNTAX_ERRORS__
 
+#include <stdio.h> /* FILE */
 #include "utils.h"
 #include "language_definitions.h"
 #include "symbol_table.h"
@@ -11,6 +12,7 @@ typedef struct {
   const char *file_name;
   unsigned int line_number;
   bool_t verbose;
+  FILE *stream; /* Where error messages are printed */
 } syntax_check_config_t;
 
 /*
@@ -218,7 +220,7 @@ bool_t SymbolDefinedMoreThanOnce(const char *symbol,
  * @return TRUE if the symbol was already defined as .extern, or FALSE otherwise.
  */
 
-bool_t SymbolAlreadyDefinedAsExtern(char *symbol,
+bool_t SymbolAlreadyDefinedAsExtern(const char *symbol,
                                     symbol_table_t *table,
                                    syntax_check_config_t* config);
 
@@ -383,6 +385,9 @@ bool_t RegisterNameDoesntExist(const char *register_name,
  * @param verbose - Determines whether to print an error or not.
  *        line number - The line number of the checked argument
  *        file name - The file that contains the checked argument.
+ *
+ * Error messages are printed to stdout; set the 'stream' field to redirect
+ * them (e.g. to buffer the messages of one file).
  */
 
 syntax_check_config_t CreateSyntaxCheckConfig(const char *file_name,
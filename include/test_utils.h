@@ -21,6 +21,7 @@
  * See tests under the "tests" directory for examples.
  */
 
+#include <stdio.h> /* FILE */
 #include "utils.h"
 
 typedef enum {
@@ -42,8 +43,120 @@ typedef struct {
         return test_info; \
     } while (0)
 
+/*
+ * Kinds of operands of a generated source, in the order of their weights.
+ */
+
+typedef enum {
+  IMMEDIATE_OPERAND,
+  DIRECT_OPERAND,
+  INDIRECT_OPERAND,
+  REGISTER_OPERAND,
+  NUM_OF_OPERAND_KINDS
+} operand_kind_t;
+
+/*
+ * What's wrong with a generated source, if anything.
+ * SYNTAX_ERRORS - Some statements are invalid.
+ * CLASHING_SYMBOLS - Some statements define a label defined before them,
+ *                    or the name of an external symbol.
+ * UNDEFINED_OPERANDS - Some operands, & an entry, are undefined.
+ * UNDEFINED_ENTRIES - Some entries are undefined or external.
+ */
+
+typedef enum {
+  NO_FLAWS,
+  SYNTAX_ERRORS,
+  CLASHING_SYMBOLS,
+  UNDEFINED_OPERANDS,
+  UNDEFINED_ENTRIES
+} source_flaws_t;
+
+/*
+ * Shape of a generated source (see GenerateSource).
+ */
+
+typedef struct {
+  long lines_num; /* Statements, besides macro definitions & declarations */
+  long symbols_num; /* Labels defined; negative for 1 per 16 statements */
+  long macros_num; /* Macros defined, used by 1 per 16 statements */
+  long late_macros_num; /* Of those, defined after they're used */
+  double extern_ratio; /* Fraction of symbol operands which are external */
+  double entry_ratio; /* Fraction of labels passed to .entry */
+  bool_t labeled_entries; /* 1 per 16 statements is a .entry with a label,
+                             which is warned about */
+  bool_t comments; /* 1 per 16 statements is a comment or an empty line */
+  long operand_weights[NUM_OF_OPERAND_KINDS];
+  source_flaws_t flaws;
+  long flaws_interval; /* Every flaws_interval statements, one is flawed */
+  unsigned long seed;
+} source_config_t;
+
+/*
+ * @brief Assembles a source one way, which a comparison of assemblings
+ *        (see CompareAssemblings) runs.
+ * @param source_path - The source (.as) file.
+ *        am_path - The .am file, naming the output files & the messages.
+ *        diagnostics - Stream messages are written to.
+ *        arg - The way's own argument.
+ * @return The result of assembling.
+ */
+typedef result_t (*assemble_func_t)(char *source_path, char *am_path,
+                                    FILE *diagnostics, void *arg);
+
+typedef struct {
+  assemble_func_t assemble;
+  void *arg;
+} assembling_way_t;
+
 void PrintTestInfo(test_info_t info);
 test_info_t InitTestInfo(const char *test_name);
 bool_t WasTestSuccessful(test_info_t info);
 
+/*
+ * @brief Returns the default shape of a generated source: 16 macros, a
+ *        tenth of the symbol operands external & of the labels entries, and
+ *        operand weights of 1,2,1,2. lines_num is 0, & has to be set.
+ */
+source_config_t CreateSourceConfig(void);
+
+/*
+ * @brief Writes a pseudo-random source of the given shape, the same one for
+ *        the same seed on every platform. Without flaws, it assembles
+ *        successfully.
+ *
+ * @return The number of lines written, or a negative value upon failure.
+ */
+long GenerateSource(const char *path, const source_config_t *config);
+
+/*
+ * @brief Compares two files byte by byte; both must exist.
+ */
+result_t CompareFileBytes(const char *path1, const char *path2);
+
+/*
+ * @brief Compares two streams byte by byte, from their start.
+ */
+result_t CompareStreamBytes(FILE *stream1, FILE *stream2);
+
+/*
+ * @brief Generates a source into base.as (see GenerateSource), assembles
+ *        it both ways & compares them: both must result in expected_res,
+ *        with the same messages in the same order, and the same output
+ *        files (so none for a source with errors). Both use the same .am
+ *        path, as the messages name it. The source & the output files of
+ *        both ways are removed afterwards.
+ */
+result_t CompareAssemblings(const char *base,
+                            const source_config_t *config,
+                            const assembling_way_t *expected,
+                            const assembling_way_t *tested,
+                            result_t expected_res);
+
+/*
+ * @brief Removes the output files (.ob, .obj, .ext & .ent) named after
+ *        base, if they exist.
+ */
+void RemoveAssemblerOutputs(const char *base);
+
 #endif /* __SH_ED_TEST_UTILS__ */
@@ -0,0 +1,110 @@
+#ifndef __SH_ED_WORD_BUFFER__
+#define __SH_ED_WORD_BUFFER__
+
+/*
+ * @brief A growable buffer of machine words, used for the code & data
+ *        segments.
+ *
+ *        Unlike vector_t it's typed: words are stored as 16-bit values
+ *        (a machine word is 15 bits), and appending is done inline by the
+ *        APPEND_WORD macro, so no call or memcpy is made per word.
+ */
+
+#include <stddef.h> /* size_t */
+#include <stdio.h>  /* FILE */
+#include "utils.h"  /* result_t */
+
+typedef unsigned short machine_word_t;
+
+/*
+ * NOTE: The fields are exposed only so APPEND_WORD can be expanded inline.
+ *       Use the functions below to access them.
+ */
+
+typedef struct {
+  machine_word_t *words;
+  size_t size;
+  size_t capacity;
+  size_t spilled; /* Words written out by SpillWords, preceding 'words' */
+} word_buffer_t;
+
+/*
+ * @brief Appends a word to the end of a word buffer, growing it if needed.
+ *
+ * @param buffer - The buffer to append to. It's evaluated several times, so
+ *                 it mustn't have side effects.
+ *        word - The word to append. Only its lower 16 bits are kept.
+ *
+ * @return SUCCESS if the word was added, or MEM_ALLOCATION_ERROR upon a
+ *         failure.
+ */
+
+#define APPEND_WORD(buffer, word)                                         \
+  (((buffer)->size < (buffer)->capacity ||                                \
+    SUCCESS == GrowWordBuffer(buffer))                                    \
+   ? ((buffer)->words[(buffer)->size++] = (machine_word_t)(word), SUCCESS) \
+   : MEM_ALLOCATION_ERROR)
+
+/*
+ * @brief Creates a new empty word buffer.
+ *
+ * @param capacity_hint - How many words are expected. Room for them is
+ *                        allocated upfront, so a good estimate saves
+ *                        reallocations (0 is allowed).
+ *
+ * @return Upon success, returns a pointer to the newly created buffer.
+ *         Upon failure, return NULL.
+ */
+
+word_buffer_t *CreateWordBuffer(size_t capacity_hint);
+
+/*
+ * @brief Deallocates the memory of a word buffer.
+ */
+
+void DestroyWordBuffer(word_buffer_t *buffer);
+
+/*
+ * @brief Increases the capacity of a word buffer geometrically.
+ *        Used by APPEND_WORD when the buffer is full.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR upon a failure.
+ */
+
+result_t GrowWordBuffer(word_buffer_t *buffer);
+
+/*
+ * @brief Returns the number of words in a word buffer.
+ */
+
+size_t GetWordsNum(const word_buffer_t *buffer);
+
+/*
+ * @brief Returns the words of a word buffer as an array of GetWordsNum
+ *        words. The pointer is invalidated by the next append.
+ */
+
+machine_word_t *GetWords(word_buffer_t *buffer);
+
+/*
+ * @brief Writes the words of a word buffer to a stream (as an array of
+ *        machine_word_t), and empties it. They still count as the first
+ *        words of the segment, see GetTotalWordsNum.
+ *
+ *        This lets a segment which is too big for memory be built a chunk
+ *        at a time: GetWords then holds only the words appended since the
+ *        last spill.
+ *
+ * @return SUCCESS, or ERROR_WRITING_TO_FILE.
+ */
+
+result_t SpillWords(word_buffer_t *buffer, FILE *stream);
+
+/*
+ * @brief Returns the number of words in a segment: the words spilled from a
+ *        word buffer, and those it holds. Without spills, it's GetWordsNum.
+ */
+
+size_t GetTotalWordsNum(const word_buffer_t *buffer);
+
+#endif /* __SH_ED_WORD_BUFFER__ */
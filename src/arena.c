@@ -0,0 +1,180 @@
+/* arena.c
+ *
+ * This module implements a region allocator: memory is handed out of large
+ * blocks, and released all at once.
+ */
+
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* memset, memcpy, strlen */
+#include <assert.h> /* assert */
+#include "arena.h"
+
+/* Alignment of every allocation, suitable for any of these types */
+typedef union {
+  long l;
+  double d;
+  void *p;
+  void (*f)(void);
+} alignment_t;
+
+#define ALIGNMENT (sizeof(alignment_t))
+#define ALIGN_UP(size) (((size) + ALIGNMENT - 1) & ~(ALIGNMENT - 1))
+
+typedef struct block block_t;
+
+struct block {
+  block_t *next;
+  size_t size; /* Usable bytes following the header */
+};
+
+/* The block header is padded so the memory following it is aligned */
+#define BLOCK_HEADER_SIZE ALIGN_UP(sizeof(block_t))
+#define BLOCK_MEMORY(block) ((char *)(block) + BLOCK_HEADER_SIZE)
+
+struct arena {
+  block_t *blocks; /* Most recent block first */
+  size_t used;     /* Bytes used in the most recent block */
+  size_t block_size;
+};
+
+static block_t *CreateBlock(size_t size);
+
+arena_t *CreateArena(size_t block_size) {
+  arena_t *arena = (arena_t *)malloc(sizeof(arena_t));
+
+  if (NULL == arena) {
+    return NULL;
+  }
+
+  if (0 == block_size) {
+    block_size = DEFAULT_ARENA_BLOCK_SIZE;
+  }
+
+  arena->blocks = NULL;
+  arena->used = 0;
+  arena->block_size = ALIGN_UP(block_size);
+
+  return arena;
+}
+
+void DestroyArena(arena_t *arena) {
+  if (NULL == arena) {
+    return;
+  }
+
+  ResetArena(arena);
+  free(arena->blocks);
+  free(arena);
+}
+
+void ResetArena(arena_t *arena) {
+  block_t *block = NULL;
+  block_t *kept = NULL;
+
+  assert(arena);
+
+  /* Keep one block of the usual size for the next allocations */
+  block = arena->blocks;
+  while (NULL != block) {
+    block_t *next = block->next;
+
+    if (NULL == kept && arena->block_size == block->size) {
+      kept = block;
+      kept->next = NULL;
+    }
+    else {
+      free(block);
+    }
+    block = next;
+  }
+
+  arena->blocks = kept;
+  arena->used = 0;
+}
+
+void *ArenaAlloc(arena_t *arena, size_t size) {
+  block_t *block = NULL;
+  void *memory = NULL;
+
+  if (NULL == arena) {
+    return malloc(size);
+  }
+
+  size = ALIGN_UP(0 == size ? 1 : size);
+
+  block = arena->blocks;
+  if (NULL != block && arena->used + size <= block->size) {
+    memory = BLOCK_MEMORY(block) + arena->used;
+    arena->used += size;
+    return memory;
+  }
+
+  /* A request larger than a block gets a block of its own, which is put
+   * behind the current block so the space left in it isn't lost */
+  if (size > arena->block_size && NULL != arena->blocks) {
+    block = CreateBlock(size);
+    if (NULL == block) {
+      return NULL;
+    }
+
+    block->next = arena->blocks->next;
+    arena->blocks->next = block;
+    return BLOCK_MEMORY(block);
+  }
+
+  block = CreateBlock(size > arena->block_size ? size : arena->block_size);
+  if (NULL == block) {
+    return NULL;
+  }
+
+  block->next = arena->blocks;
+  arena->blocks = block;
+  arena->used = size;
+
+  return BLOCK_MEMORY(block);
+}
+
+void *ArenaCalloc(arena_t *arena, size_t size) {
+  void *memory = NULL;
+
+  if (NULL == arena) {
+    return calloc(1, size);
+  }
+
+  memory = ArenaAlloc(arena, size);
+  if (NULL != memory) {
+    memset(memory, 0, size);
+  }
+
+  return memory;
+}
+
+char *ArenaStrDup(arena_t *arena, const char *str) {
+  size_t size = strlen(str) + 1;
+  char *copy = (char *)ArenaAlloc(arena, size);
+
+  if (NULL != copy) {
+    memcpy(copy, str, size);
+  }
+
+  return copy;
+}
+
+void ArenaFree(arena_t *arena, void *memory) {
+  if (NULL == arena) {
+    free(memory);
+  }
+}
+
+static block_t *CreateBlock(size_t size) {
+  block_t *block = (block_t *)malloc(BLOCK_HEADER_SIZE + size);
+
+  if (NULL == block) {
+    return NULL;
+  }
+
+  block->next = NULL;
+  block->size = size;
+
+  return block;
+}
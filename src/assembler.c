@@ -6,33 +6,324 @@
  * and finally calls 'generate_output_files' to produce the output.
  */
 
+#define _POSIX_C_SOURCE 200112L /* pthreads */
+
+#include <pthread.h>
 #include "assembler.h"
 #include "generate_opcode.h"
 #include "generate_output_files.h"
 #include "language_definitions.h"
 #include "list.h"
-#include "string_utils.h"
+#include "lexer.h"
+#include "string_pool.h"
 #include "symbol_table.h"
 #include "syntax_errors.h"
 #include <stdio.h>  /* fopen, fclose */
 #include <stdlib.h> /* malloc, free */
-#include <string.h> /* strlen */
+#include <string.h> /* memcpy, memcmp, strlen, strcmp */
+
+/* Lines of the expanded source AssembleStream works on at a time, and
+ * words of the code segment its second pass patches at a time */
+#define STREAM_WINDOW_LINES (4096)
+#define STREAM_CHUNK_WORDS (4096)
+
+/* Lines each thread of a parallel first pass encodes at least, and
+ * references each thread of a parallel second pass resolves at least. With
+ * fewer than twice as many, the pass runs on the calling thread */
+#define PARALLEL_MIN_CHUNK_LINES (4096)
+#define PARALLEL_MIN_CHUNK_REFERENCES (4096)
+
+/* Names a file's pool of an incremental state holds at least before it's
+ * compacted (see CompactNames) */
+#define MIN_NAMES_TO_COMPACT (256)
 
-const char *DELIMITERS = ", \t\n\r";
+/*
+ * A symbol reference recorded by the first pass, to be resolved once all
+ * symbols are known.
+ * OPERAND_REFERENCE - A direct operand; the code word at code_index is
+ *                     patched with the symbol's address.
+ * ENTRY_REFERENCE - A symbol passed to .entry; code_index is unused.
+ * CHECK_REFERENCE - A direct operand of an instruction line with syntax
+ *                   errors, which has no code word; it's only reported if
+ *                   its symbol wasn't defined. code_index is unused.
+ */
+typedef enum {
+  OPERAND_REFERENCE,
+  ENTRY_REFERENCE,
+  CHECK_REFERENCE
+} reference_kind_t;
+
+typedef struct {
+  reference_kind_t kind;
+  size_t code_index;
+  const char *symbol_name; /* Interned in the symbol table's pool */
+  unsigned int line_number;
+} relocation_t;
 
-/* @brief Checks if the first word in a string ends with ':'.
- * @param Line - Line of text to check.
- * @return TRUE if ends with colon, otherwise FALSE.
+/*
+ * What a single line of the source produced, recorded for incremental
+ * reassembly. Its words, symbols & relocations follow those of the lines
+ * before it.
  */
+typedef struct {
+  size_t code_words;
+  size_t data_words;
+  size_t symbols_num;
+  size_t relocations_num;
+  bool_t warned; /* Whether a warning was printed for the line */
+} line_record_t;
 
-static bool_t IsSymbolDefinition(const char *line) {
-  while ('\n' != *(line + 1) && !IsBlank(*(line + 1))) {
-    line++;
-  }
-  if (*line == ':') {
-    return TRUE;
+/*
+ * A symbol defined by a line. The offset of a regular symbol is from the
+ * line's first code or data word (depending on its area), so it doesn't
+ * depend on the lines before it.
+ */
+typedef struct {
+  const char *name; /* Interned in the file's pool */
+  symbol_type_t type; /* REGULAR or EXTERN */
+  symbol_memory_area_t area;
+  size_t offset;
+} line_symbol_t;
+
+/*
+ * The per-line encodings of a source, in the order of its lines.
+ * lines - line_record_t, one per line.
+ * symbols - line_symbol_t, of all lines.
+ * relocations - relocation_t, of all lines. Their code_index is relative to
+ *               their line's first code word, and their names are interned
+ *               in the file's pool.
+ */
+typedef struct {
+  vector_t *lines;
+  vector_t *symbols;
+  vector_t *relocations;
+} line_encodings_t;
+
+/*
+ * The last successful assembling of a file (see incremental_state_t).
+ * source is NULL if there's none (e.g. the file had errors).
+ */
+typedef struct {
+  char *file_path;
+  source_buffer_t *source; /* A copy of the source it was assembled from */
+  line_encodings_t encodings;
+  word_buffer_t *code_table; /* Final words, with references resolved */
+  word_buffer_t *data_table;
+  string_pool_t *names;
+  unsigned long last_used; /* When it was last assembled (see clock) */
+} assembled_file_t;
+
+/*
+ * files - Entries of up to max_files files; beyond that, the one assembled
+ *         least recently is evicted.
+ * clock - Counts the assemblings, to tell which file was assembled last.
+ */
+struct incremental_state {
+  vector_t *files; /* assembled_file_t */
+  size_t max_files;
+  unsigned long clock;
+  unsigned long encoded_lines;
+  unsigned long reused_lines;
+};
+
+/*
+ * Records each line encoded into a context (see RecordLine): the sizes of
+ * the context's tables before the line, and its last symbol.
+ */
+typedef struct {
+  line_encodings_t *encodings;
+  string_pool_t *names;
+  size_t code_words;
+  size_t data_words;
+  size_t relocations;
+  node_t *last_symbol;
+} line_recorder_t;
+
+/*
+ * Everything the assembling of a single file works on. All of the state of
+ * the passes lives here (or on the stack), and nothing is shared between
+ * contexts, so several files may be assembled concurrently.
+ */
+typedef struct {
+  const char *file_path; /* For error messages & naming the output files */
+  const source_buffer_t *source;
+  size_t first_line; /* Lines of the file before those of source */
+  macro_table_t *macro_table;
+  symbol_table_t *symbol_table;
+  word_buffer_t *code_table;
+  word_buffer_t *data_table;
+  vector_t *relocations; /* relocation_t, for the second pass to resolve */
+  ext_symbol_occurrences_t *ext_list; /* Uses of external symbols */
+  const assembler_options_t *options;
+  line_recorder_t *recorder; /* If set, the first pass records each line */
+} assembly_context_t;
+
+/*
+ * A chunk of the source, encoded on a thread of its own into a context of
+ * its own (see FirstPassInParallel). The addresses of its symbols & the
+ * code indexes of its references are relative to the chunk's first code &
+ * data words, as if it were a whole source.
+ * warned_lines - Numbers (unsigned int) of its lines that warrant a warning.
+ * res - FAILURE if any of its lines would be reported.
+ */
+typedef struct {
+  assembly_context_t context;
+  size_t first_line;
+  size_t last_line; /* Excluded */
+  vector_t *warned_lines;
+  pthread_t thread;
+  bool_t started;
+  result_t res;
+} first_pass_chunk_t;
+
+/*
+ * A use of an external symbol, found by a parallel second pass.
+ */
+typedef struct {
+  const char *symbol_name; /* Interned in the symbol table's pool */
+  unsigned int address;
+} external_use_t;
+
+/*
+ * A range of the references recorded by the first pass, whose operands are
+ * resolved on a thread of its own (see SecondPassInParallel).
+ * external_uses - external_use_t, in the order of the references.
+ * res - FAILURE if any of its references would be reported.
+ */
+typedef struct {
+  assembly_context_t *context;
+  size_t first_reference;
+  size_t last_reference; /* Excluded */
+  vector_t *external_uses;
+  pthread_t thread;
+  bool_t started;
+  result_t res;
+} second_pass_chunk_t;
+
+/*
+ * An assembling fed its source a part at a time (see CreateAssembly).
+ * res - MEM_ALLOCATION_ERROR once memory ran out, SUCCESS otherwise.
+ */
+struct assembly {
+  assembly_context_t context;
+  syntax_check_config_t cfg;
+  int total_errors;
+  result_t res;
+};
+
+static result_t InitAssemblyContext(assembly_context_t *context,
+                                    const char *file_path,
+                                    const source_buffer_t *source,
+                                    macro_table_t *macro_table,
+                                    const assembler_options_t *options);
+
+static void DestroyAssemblyContext(assembly_context_t *context);
+
+static result_t RunPasses(assembly_context_t *context);
+
+static result_t FirstPassInParallel(assembly_context_t *context);
+
+static void *EncodeChunk(void *chunk);
+
+static bool_t ChunksClash(first_pass_chunk_t *chunks, size_t chunks_num);
+
+static result_t SecondPassInParallel(assembly_context_t *context);
+
+static void *ResolveOperands(void *chunk);
+
+static bool_t ResolveEntry(const char *name, symbol_table_t *symbol_table,
+                           syntax_check_config_t *cfg);
+
+static result_t MergeChunks(assembly_context_t *context,
+                            first_pass_chunk_t *chunks, size_t chunks_num);
+
+static void EnterPhase(const assembler_options_t *options,
+                       assembler_phase_t phase);
+
+static result_t RunPassesIncrementally(assembly_context_t *context);
+
+static result_t StreamFirstPass(assembly_context_t *context,
+                                source_buffer_t *window,
+                                FILE *source,
+                                FILE *relocations,
+                                spilled_output_t *output);
+
+static result_t StreamSecondPass(assembly_context_t *context,
+                                 FILE *relocations,
+                                 spilled_output_t *output);
+
+static result_t SpillRelocations(vector_t *relocations, FILE *stream);
+
+static result_t BuildProgram(assembly_context_t *context,
+                             assembled_program_t *program);
+
+static result_t RecordLine(assembly_context_t *context,
+                           line_recorder_t *recorder, bool_t warned);
+
+static assembled_file_t *FindAssembledFile(incremental_state_t *state,
+                                           const char *file_path);
+
+static void ClearAssembledFile(assembled_file_t *file);
+
+static void CompactNames(assembled_file_t *file);
+
+static result_t AssembleAndRecord(assembly_context_t *context,
+                                  assembled_file_t *file,
+                                  incremental_state_t *state);
+
+static result_t Reassemble(assembly_context_t *context,
+                           assembled_file_t *file,
+                           incremental_state_t *state);
+
+static result_t EncodeChangedLines(assembly_context_t *scratch,
+                                   size_t first_line, size_t last_line,
+                                   line_recorder_t *recorder);
+
+static result_t ResolveIncrementally(assembly_context_t *context,
+                                     line_encodings_t *encodings);
+
+static result_t CreateLineEncodings(line_encodings_t *encodings);
+
+static void DestroyLineEncodings(line_encodings_t *encodings);
+
+static result_t AppendElements(vector_t *to, vector_t *from, size_t first,
+                               size_t last);
+
+static result_t AppendWords(word_buffer_t *to, const machine_word_t *words,
+                            size_t words_num);
+
+static word_buffer_t *CopyWordBuffer(word_buffer_t *from);
+
+static source_buffer_t *CopySourceBuffer(const source_buffer_t *source);
+
+static bool_t SameLine(const source_buffer_t *source1, size_t index1,
+                       const source_buffer_t *source2, size_t index2);
+
+/*
+ * @brief Records a symbol reference to be resolved in the second pass.
+ *        The name is interned in the symbol table's pool, so it outlives
+ *        the line it was read from.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR if it couldn't be recorded.
+ */
+
+static result_t AddRelocation(vector_t *relocations, reference_kind_t kind,
+                              size_t code_index, const char *symbol_name,
+                              symbol_table_t *symbol_table,
+                              unsigned int line_number) {
+  relocation_t relocation;
+
+  relocation.kind = kind;
+  relocation.code_index = code_index;
+  relocation.symbol_name = InternString(GetSymbolNames(symbol_table),
+                                        symbol_name);
+  relocation.line_number = line_number;
+
+  if (NULL == relocation.symbol_name) {
+    return MEM_ALLOCATION_ERROR;
   }
-  return FALSE;
+
+  return AppendVector(relocations, &relocation);
 }
 
 /*
@@ -85,86 +376,123 @@ static void UpdateDataSymbolsAddresses(symbol_table_t *symbol_table,
 
 /*
  * @brief Read operands passed to an instruction, count them & return the first
- * two.
+ * two. Their names are copied into 'names'.
  */
-static int SplitOperands(char *line, operand_t *operand1, operand_t *operand2) {
+static int SplitOperands(lexer_t *lexer, operand_t *operand1,
+                         operand_t *operand2,
+                         char names[2][MAX_LINE_LENGTH]) {
   int counter = 0;
-  char *current_word = strtok(line, DELIMITERS);
+  token_t token = NextWord(lexer);
 
-  if (NULL != current_word) {
-    operand1->name = StrDup(current_word);
-    if (NULL == operand1->name) {
-      return -1;
-    }
+  if (END_TOKEN != token.kind) {
+    operand1->name = CopyToken(&token, names[0]);
     operand1->addressing_method = DetectAddressingMethod(operand1->name);
     operand1->type = DESTINATION_OPERAND;
     counter++;
   }
 
-  current_word = strtok(NULL, DELIMITERS);
-  if (NULL != current_word) {
-    operand2->name = StrDup(current_word);
-    if (NULL == operand2->name) {
-      free((void *)operand1->name);
-      operand1->name = NULL;
-      return -1;
-    }
+  token = NextWord(lexer);
+  if (END_TOKEN != token.kind) {
+    operand2->name = CopyToken(&token, names[1]);
     operand2->addressing_method = DetectAddressingMethod(operand2->name);
     operand2->type = DESTINATION_OPERAND;
     operand1->type = SOURCE_OPERAND;
     counter++;
 
     /* Count extra parameters */
-    current_word = strtok(NULL, DELIMITERS);
-    while (NULL != current_word) {
+    for (token = NextWord(lexer); END_TOKEN != token.kind;
+         token = NextWord(lexer)) {
       counter++;
-      current_word = strtok(NULL, DELIMITERS);
     }
   }
   return counter;
 }
 
+/*
+ * @brief Records the direct operands of an instruction line with syntax
+ *        errors as CHECK_REFERENCE, so the second pass still reports those
+ *        whose symbols weren't defined, as it does for valid lines.
+ *
+ * @param lexer - Lexer of the line, positioned after the instruction name,
+ *                or before it if skip_instruction is TRUE. It's copied.
+ *        skip_instruction - Whether the instruction name is to be skipped.
+ *                           Nothing is recorded for a directive.
+ *
+ * @return FAILURE (the line has errors), or MEM_ALLOCATION_ERROR.
+ */
+static result_t RecordUnencodedOperands(lexer_t lexer,
+                                        bool_t skip_instruction,
+                                        symbol_table_t *symbol_table,
+                                        vector_t *relocations,
+                                        unsigned int line_number) {
+  char name[MAX_LINE_LENGTH];
+  token_t token;
+  int i = 0;
+
+  if (skip_instruction) {
+    token = NextWord(&lexer);
+    if (END_TOKEN == token.kind || TokenStartsWith(&token, '.')) {
+      return FAILURE;
+    }
+  }
+
+  /* Only the first 2 operands, as an instruction has at most 2 */
+  for (i = 0; i < 2; ++i) {
+    token = NextWord(&lexer);
+    if (END_TOKEN == token.kind) {
+      break;
+    }
+
+    CopyToken(&token, name);
+    if (DIRECT == DetectAddressingMethod(name) &&
+        SUCCESS != AddRelocation(relocations, CHECK_REFERENCE, 0, name,
+                                 symbol_table, line_number)) {
+      return MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  return FAILURE;
+}
+
 /*
  * @param instruction - Instruction name (e.g. "mov")
- *        params - String containing the operands passed to the instruction.
- *                 If NULL, there are 0 parameters (e.g. "#+3, SYM1").
+ *        lexer - Lexer of the line, positioned after the instruction name
+ *                (e.g. at "#+3, SYM1").
+ *        relocations - Direct operands are recorded here, with the index of
+ *                      the code word that holds them.
  */
-static result_t HandleInstructionStatement(char *instruction, char *params,
+static result_t HandleInstructionStatement(const char *instruction,
+                                           lexer_t *lexer,
                                            symbol_table_t *symbol_table,
-                                           char *symbol_name,
-                                           vector_t *code_table,
+                                           const char *symbol_name,
+                                           word_buffer_t *code_table,
+                                           vector_t *relocations,
                                            syntax_check_config_t *cfg) {
 
   int operand_num = 0;
   operand_t operands[2] = {{NULL, INVALID, SOURCE_OPERAND},
                            {NULL, INVALID, SOURCE_OPERAND}};
+  char operand_names[2][MAX_LINE_LENGTH];
 
   bool_t invalid_operands = FALSE;
   operand_t *src_operand = NULL;
   operand_t *dest_operand = NULL;
+  size_t instruction_index = GetTotalWordsNum(code_table);
+  lexer_t operands_lexer = *lexer;
   int i = 0;
 
   if (InstructionDoesntExist(instruction, cfg)) {
-    return FAILURE;
-  }
-
-  if (NULL != params) {
-    operand_num = SplitOperands(params, &operands[0], &operands[1]);
+    return RecordUnencodedOperands(operands_lexer, FALSE, symbol_table,
+                                   relocations, cfg->line_number);
   }
 
-  if (-1 == operand_num) {
-    return MEM_ALLOCATION_ERROR;
-  }
+  operand_num = SplitOperands(lexer, &operands[0], &operands[1],
+                              operand_names);
 
   /* Syntax errors for operands */
   if (WrongNumberOfOperands(instruction, operand_num, cfg)) {
-    if (NULL != operands[0].name) {
-      free((void *)operands[0].name);
-    }
-    if (NULL != operands[1].name) {
-      free((void *)operands[1].name);
-    }
-    return FAILURE;
+    return RecordUnencodedOperands(operands_lexer, FALSE, symbol_table,
+                                   relocations, cfg->line_number);
   }
 
   for (i = 0; i < operand_num; ++i) {
@@ -183,27 +511,15 @@ static result_t HandleInstructionStatement(char *instruction, char *params,
   }
 
   if (invalid_operands) {
-    if (NULL != operands[0].name) {
-      free((void *)operands[0].name);
-    }
-    if (NULL != operands[1].name) {
-      free((void *)operands[1].name);
-    }
-    return FAILURE;
+    return RecordUnencodedOperands(operands_lexer, FALSE, symbol_table,
+                                   relocations, cfg->line_number);
   }
 
   /* Create symbol, if one was defined */
   if (NULL != symbol_name) {
     if (SUCCESS != AddSymbol(symbol_table, symbol_name,
-                             GetSizeVector(code_table) + INITIAL_IC_VALUE,
+                             GetTotalWordsNum(code_table) + INITIAL_IC_VALUE,
                              CODE)) {
-
-      if (NULL != operands[0].name) {
-        free((void *)operands[0].name);
-      }
-      if (NULL != operands[1].name) {
-        free((void *)operands[1].name);
-      }
       return MEM_ALLOCATION_ERROR;
     }
   }
@@ -219,53 +535,48 @@ static result_t HandleInstructionStatement(char *instruction, char *params,
 
   if (SUCCESS != InstructionStatementToMachinecode(code_table, instruction,
                                                    src_operand, dest_operand)) {
-
-    if (NULL != operands[0].name) {
-      free((void *)operands[0].name);
-    }
-    if (NULL != operands[1].name) {
-      free((void *)operands[1].name);
-    }
     return MEM_ALLOCATION_ERROR;
   }
 
-  if (NULL != operands[0].name) {
-    free((void *)operands[0].name);
-  }
-  if (NULL != operands[1].name) {
-    free((void *)operands[1].name);
+  /* A direct operand's word follows the instruction word, and the words of
+   * any operands before it. Its address is filled in by the second pass.
+   */
+  for (i = 0; i < operand_num; ++i) {
+    if (DIRECT == operands[i].addressing_method) {
+      if (SUCCESS != AddRelocation(relocations, OPERAND_REFERENCE,
+                                   instruction_index + 1 + i,
+                                   operands[i].name, symbol_table,
+                                   cfg->line_number)) {
+        return MEM_ALLOCATION_ERROR;
+      }
+    }
   }
 
   return SUCCESS;
 }
 
-static result_t HandleStringOrData(directive_t directive, char *param,
+static result_t HandleStringOrData(directive_t directive, const char *param,
                                    symbol_table_t *symbol_table,
-                                   char *symbol_name, vector_t *data_table,
+                                   const char *symbol_name,
+                                   word_buffer_t *data_table,
                                    syntax_check_config_t *cfg) {
 
   typedef bool_t (*syntax_check_func_t)(const char *, syntax_check_config_t *);
-  typedef result_t (*machine_code_generation_func_t)(vector_t *, char *);
+  typedef result_t (*machine_code_generation_func_t)(word_buffer_t *,
+                                                     const char *);
 
-  size_t to_skip = 0;
   syntax_check_func_t syntax_check_func = NULL;
   machine_code_generation_func_t generate_machine_code = NULL;
 
   if (STRING_DIRECTIVE == directive) {
-    to_skip = strlen(".string") + 1;
     syntax_check_func = IsIllegalString;
     generate_machine_code = StringDirectiveToMachinecode;
   } else if (DATA_DIRECTIVE == directive) {
-    to_skip = strlen(".data") + 1;
     syntax_check_func = IsIllegalDataParameter;
     generate_machine_code = DataDirectiveToMachinecode;
   }
 
-  /* Skip to directive's parameter */
-  param += to_skip;
-
   /* Check syntax errors in parameters */
-  param = strtok(param, "\n");
   if (syntax_check_func(param, cfg)) {
     return FAILURE;
   }
@@ -273,7 +584,8 @@ static result_t HandleStringOrData(directive_t directive, char *param,
   /* Create symbol, if one was defined */
   if (NULL != symbol_name) {
     if (SUCCESS !=
-        AddSymbol(symbol_table, symbol_name, GetSizeVector(data_table), DATA)) {
+        AddSymbol(symbol_table, symbol_name, GetTotalWordsNum(data_table),
+                  DATA)) {
 
       return MEM_ALLOCATION_ERROR;
     }
@@ -287,12 +599,39 @@ static result_t HandleStringOrData(directive_t directive, char *param,
   return SUCCESS;
 }
 
-static result_t HandleDirectiveStatement(char *directive_name, char *params,
+/*
+ * @brief Warns about a label before .extern or .entry, which is ignored.
+ */
+static void WarnLabelBeforeReference(syntax_check_config_t *cfg) {
+  if (cfg->verbose) {
+    fprintf(
+        cfg->stream,
+        BOLD_YELLOW
+        "WARNING: " COLOR_RESET
+        "(file %s, line %u):\n label before .extern or .entry is invalid\n\n",
+        cfg->file_name, cfg->line_number);
+  }
+}
+
+/*
+ * @param directive_name - Directive name (e.g. ".data").
+ *        lexer - Lexer of the line, positioned after the directive name.
+ *        warned - Set to TRUE if a warning was printed for the line.
+ */
+static result_t HandleDirectiveStatement(const char *directive_name,
+                                         lexer_t *lexer,
                                          macro_table_t *macro_table,
                                          symbol_table_t *symbol_table,
-                                         vector_t *data_table,
-                                         char *symbol_name,
-                                         syntax_check_config_t *cfg) {
+                                         word_buffer_t *data_table,
+                                         vector_t *relocations,
+                                         const char *symbol_name,
+                                         syntax_check_config_t *cfg,
+                                         bool_t *warned) {
+  /* The parameters are read both as a whole & word by word */
+  lexer_t words = *lexer;
+  char params[MAX_LINE_LENGTH];
+  char name[MAX_LINE_LENGTH];
+  token_t token;
 
   /*
    * First, check if that directive even exists
@@ -302,12 +641,14 @@ static result_t HandleDirectiveStatement(char *directive_name, char *params,
     return FAILURE;
   }
 
+  CopyRestOfLine(lexer, params);
+
   /*
    * Is it a .string or .data directive?
    * e.g. "SYMBOL: .string ...", ".data ..."
    */
-  else if (STRING_DIRECTIVE == directive || DATA_DIRECTIVE == directive) {
-    return HandleStringOrData(directive, directive_name, symbol_table,
+  if (STRING_DIRECTIVE == directive || DATA_DIRECTIVE == directive) {
+    return HandleStringOrData(directive, params, symbol_table,
                               symbol_name, data_table, cfg);
   }
 
@@ -318,439 +659,2283 @@ static result_t HandleDirectiveStatement(char *directive_name, char *params,
   else {
     /* If symbol was defined, it warrants a warning. */
     if (NULL != symbol_name) {
-      printf(
-          BOLD_YELLOW
-          "WARNING: " COLOR_RESET
-          "(file %s, line %u):\n label before .extern or .entry is invalid\n\n",
-          cfg->file_name, cfg->line_number);
+      WarnLabelBeforeReference(cfg);
+      *warned = TRUE;
     }
 
-    if (EXTERN_DIRECTIVE == directive) {
-      /* Check if commas are misplaced in the parameters passed to .extern */
-      if (AreCommasMisplaced(params, cfg)) {
-        return FAILURE;
-      }
+    /* Check if commas are misplaced in the parameters */
+    if (AreCommasMisplaced(params, cfg)) {
+      return FAILURE;
+    }
+
+    for (token = NextWord(&words); END_TOKEN != token.kind;
+         token = NextWord(&words)) {
+      CopyToken(&token, name);
 
       /* Adding each symbol passed as a parameter to .extern to the symbol
        * table as an external table.
        */
-      params = strtok(params, DELIMITERS);
-      while (NULL != params) {
+      if (EXTERN_DIRECTIVE == directive) {
         /* Check syntax errors for each symbol name */
         if (TRUE ==
-            SymbolNameErrorOccurred(params, macro_table, symbol_table, cfg)) {
+            SymbolNameErrorOccurred(name, macro_table, symbol_table, cfg)) {
           return FAILURE;
         }
 
-        if (SUCCESS != AddExternalSymbol(symbol_table, params)) {
+        if (SUCCESS != AddExternalSymbol(symbol_table, name)) {
           return MEM_ALLOCATION_ERROR;
         }
+      }
 
-        params = strtok(NULL, DELIMITERS);
+      /* Entries are resolved in the 2nd pass, once all symbols are known */
+      else if (SUCCESS != AddRelocation(relocations, ENTRY_REFERENCE, 0,
+                                        name, symbol_table,
+                                        cfg->line_number)) {
+        return MEM_ALLOCATION_ERROR;
       }
     }
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Records what the last line encoded into a context produced, i.e.
+ *        whatever was added to its tables since the previous line.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t RecordLine(assembly_context_t *context,
+                           line_recorder_t *recorder, bool_t warned) {
+  line_encodings_t *encodings = recorder->encodings;
+  line_record_t record;
+  node_t *iter = NULL;
+  size_t i = 0;
+
+  record.code_words = GetWordsNum(context->code_table) - recorder->code_words;
+  record.data_words = GetWordsNum(context->data_table) - recorder->data_words;
+  record.symbols_num = 0;
+  record.relocations_num =
+      GetSizeVector(context->relocations) - recorder->relocations;
+  record.warned = warned;
+
+  iter = (NULL == recorder->last_symbol)
+             ? GetHead(AsList(context->symbol_table))
+             : GetNext(recorder->last_symbol);
+
+  for (; NULL != iter; iter = GetNext(iter)) {
+    symbol_t *symbol = (symbol_t *)GetValue(iter);
+    line_symbol_t line_symbol;
+
+    line_symbol.name = InternString(recorder->names, GetSymbolName(symbol));
+    line_symbol.type = GetSymbolType(symbol);
+    line_symbol.area = GetSymbolMemoryArea(symbol);
+    line_symbol.offset = 0;
+
+    /* Data symbols still hold their offset in the data table */
+    if (REGULAR == line_symbol.type) {
+      line_symbol.offset =
+          (CODE == line_symbol.area)
+              ? GetSymbolAddress(symbol) - INITIAL_IC_VALUE -
+                    recorder->code_words
+              : GetSymbolAddress(symbol) - recorder->data_words;
+    }
+
+    if (NULL == line_symbol.name ||
+        SUCCESS != AppendVector(encodings->symbols, &line_symbol)) {
+      return MEM_ALLOCATION_ERROR;
+    }
+
+    ++record.symbols_num;
+    recorder->last_symbol = iter;
+  }
+
+  for (i = recorder->relocations; i < GetSizeVector(context->relocations);
+       ++i) {
+    relocation_t relocation =
+        *(relocation_t *)GetElementVector(context->relocations, i);
+
+    relocation.symbol_name = InternString(recorder->names,
+                                          relocation.symbol_name);
+    if (OPERAND_REFERENCE == relocation.kind) {
+      relocation.code_index -= recorder->code_words;
+    }
 
-    else if (ENTRY_DIRECTIVE == directive) {
-      /* Do nothing. Entries will be handled in 2nd pass */
+    if (NULL == relocation.symbol_name ||
+        SUCCESS != AppendVector(encodings->relocations, &relocation)) {
+      return MEM_ALLOCATION_ERROR;
     }
   }
 
+  if (SUCCESS != AppendVector(encodings->lines, &record)) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  recorder->code_words += record.code_words;
+  recorder->data_words += record.data_words;
+  recorder->relocations += record.relocations_num;
   return SUCCESS;
 }
 
+/*
+ * @brief Encodes a single line of the source: defines its symbol, appends
+ *        its words to the code or data table, and records its references.
+ *
+ * @param context - The file's context.
+ *        line_index - Index of the line in the context's source.
+ *        cfg - Syntax error configurations; its line number is set.
+ *        warned - Set to TRUE if a warning was printed for the line.
+ *
+ * @return SUCCESS, FAILURE upon a syntax error, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t EncodeLine(assembly_context_t *context, size_t line_index,
+                           syntax_check_config_t *cfg, bool_t *warned) {
+  macro_table_t *macro_table = context->macro_table;
+  symbol_table_t *symbol_table = context->symbol_table;
+  size_t line_length = 0;
+  const char *line = GetLine(context->source, line_index, &line_length);
+  const char *symbol_name = NULL;
+  lexer_t lexer;
+  token_t token;
+  char current_word[MAX_LINE_LENGTH];
+  char symbol_buffer[MAX_LINE_LENGTH];
+
+  InitLexer(&lexer, line, line_length);
+  cfg->line_number = (unsigned int)(context->first_line + line_index) + 1;
+
+  /*
+   * Does the line begin with a symbol definition?
+   * e.g. "SYMBOL: ..."
+   */
+  if (ReadLabel(&lexer, &token)) {
+    /* Check if there's space after : (the check needs the whole line) */
+    if (DefinitionStartsImmediatelyAfterColon(
+            CopyLine(context->source, line_index, current_word), cfg)) {
+      return RecordUnencodedOperands(lexer, TRUE, symbol_table,
+                                     context->relocations, cfg->line_number);
+    }
+
+    symbol_name = CopyToken(&token, symbol_buffer);
+    if (SymbolNameErrorOccurred(symbol_name, macro_table, symbol_table,
+                                cfg)) {
+      return RecordUnencodedOperands(lexer, TRUE, symbol_table,
+                                     context->relocations, cfg->line_number);
+    }
+
+    /* Skip after the label */
+    token = NextToken(&lexer);
+    if (END_TOKEN == token.kind &&
+        NoDefinitionForSymbol(NULL, cfg)) {
+      return FAILURE;
+    }
+  }
+
+  else {
+    /* First word (no symbol definition) */
+    token = NextWord(&lexer);
+  }
+
+  /* Nothing on the line */
+  if (END_TOKEN == token.kind) {
+    return SUCCESS;
+  }
+
+  CopyToken(&token, current_word);
+
+  /*
+   * Handle directives
+   * e.g. "SYMBOL: .string ..."
+   *      ".extern ..."
+   */
+  if (TokenStartsWith(&token, '.')) {
+    return HandleDirectiveStatement(current_word, &lexer, macro_table,
+                                    symbol_table, context->data_table,
+                                    context->relocations, symbol_name, cfg,
+                                    warned);
+  }
+
+  /*
+   * Handle instruction statements.
+   * e.g. "SYMBOL: mov ... "
+   *      "mov ..."
+   */
+  return HandleInstructionStatement(current_word, &lexer, symbol_table,
+                                    symbol_name, context->code_table,
+                                    context->relocations, cfg);
+}
+
 /*
  * @brief Performs a first pass on the code:
  *        1. Creating symbol table from symbol declarations.
  *        2. Creating initial memory mapping, which will be completed in the
  *           second pass.
  *
- * @param file_path - The file to read & perform first pass on.
- *
- *        macro_table - Table of all macros identified in the preprocessing.
- *
- *        symbol_table - A valid empty symbol table object, which will be
- * populated during first pass.
- *
- *        code_table - A valid empty vector which will contain the machine code
- *                     words corresponding to the assembly instruction
- * statements.
- *
- *        data_table - A valid empty vector which will contain the machine code
- *                     encoding of directive statements.
+ * @param context - The file's context. Its source is read, and its symbol
+ *                  table, code & data tables and relocations (all empty
+ *                  beforehand) are populated. If it has a recorder, each
+ *                  line is recorded in it, up to the first error.
  *
  * @return SUCCESS if no syntax error or other fault occurred.
  *         FAILURE if one or more syntax errors occurred.
  *         MEM_ALLOCATION_ERROR if a memory allocataion error occurred.
  */
 
-static result_t FirstPass(char *file_path, macro_table_t *macro_table,
-                          symbol_table_t *symbol_table, vector_t *code_table,
-                          vector_t *data_table) {
+static result_t FirstPass(assembly_context_t *context) {
+  line_recorder_t *recorder = context->recorder;
   int total_errors = 0;
-  char *current_word = NULL;
-  char *current_line = NULL;
-  char *symbol_name = NULL;
-  FILE *input_file = NULL;
-  syntax_check_config_t cfg = CreateSyntaxCheckConfig(file_path, 0, TRUE);
-
-  /* Acquire resources */
-  input_file = fopen(file_path, "r");
-  if (NULL == input_file) {
-    fprintf(stderr, "Couldn't open input file '%s'.\n", file_path);
-    return ERROR_OPENING_FILE;
-  }
+  size_t line_index = 0;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
 
-  current_line = (char *)malloc(MAX_LINE_LENGTH * sizeof(char));
-  if (NULL == current_line) {
-    fclose(input_file);
-    fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
-    return MEM_ALLOCATION_ERROR;
-  }
+  cfg.stream = context->options->diagnostics;
 
   /* ~ * ~ ------------------------------ ~ * ~
    * Performing syntax analysis for each line.
+   * The lines are lexed in place, without copying them.
    * ~ * ~ ------------------------------ ~ * ~
    */
-  while (NULL != fgets(current_line, MAX_LINE_LENGTH, input_file)) {
-    ++cfg.line_number;
-    symbol_name = NULL;
-
-    /*
-     * Does the line begin with a symbol definition?
-     * e.g. "SYMBOL: ..."
-     */
-    if (IsSymbolDefinition(current_line)) {
-      /* Check if there's space after : */
-      if (DefinitionStartsImmediatelyAfterColon(current_line, &cfg)) {
-        total_errors++;
-        continue;
-      }
-
-      /* Extract symbol name */
-      current_word = strtok(current_line, ": \t\n\r");
-      symbol_name = StrDup(current_word);
-
-      if (NULL == symbol_name) {
-        perror("Error: memory allocation error\n");
-        free(current_line);
-        fclose(input_file);
-        return MEM_ALLOCATION_ERROR;
-      }
-
-      if (SymbolNameErrorOccurred(symbol_name, macro_table, symbol_table,
-                                  &cfg)) {
-        total_errors++;
-        free(symbol_name);
-        symbol_name = NULL;
-        continue;
-      }
-
-      /* Skip after the label */
-      current_word = strtok(NULL, ": \t\n");
-      if (NoDefinitionForSymbol(current_word, &cfg)) {
-        total_errors++;
-        free(symbol_name);
-        symbol_name = NULL;
-        continue;
-      }
-    }
-
-    else {
-      /* First word (no symbol definition) */
-      current_word = strtok(current_line, DELIMITERS);
-    }
-
-    /*
-     * Handle directives
-     * e.g. "SYMBOL: .string ..."
-     *      ".extern ..."
-     */
-    if ('.' == *current_word) {
-      char *params = strtok(NULL, "\n\0");
-      result_t res =
-          HandleDirectiveStatement(current_word, params, macro_table,
-                                   symbol_table, data_table, symbol_name, &cfg);
-
-      /* Symbol was added to symbol table, no longer needed */
-      if (NULL != symbol_name) {
-        free(symbol_name);
-      }
+  for (line_index = 0; line_index < GetLineCount(context->source);
+       ++line_index) {
+    bool_t warned = FALSE;
+    result_t res = EncodeLine(context, line_index, &cfg, &warned);
 
-      if (MEM_ALLOCATION_ERROR == res) {
-        perror("Error: memory allocation error\n");
-        free(current_line);
-        fclose(input_file);
-        return MEM_ALLOCATION_ERROR;
-      } else if (FAILURE == res) {
-        ++total_errors;
-      }
+    if (SUCCESS == res && NULL != recorder) {
+      res = RecordLine(context, recorder, warned);
     }
 
-    /*
-     * Handle instruction statements.
-     * e.g. "SYMBOL: mov ... "
-     *      "mov ..."
-     */
-    else {
-      char *params = strtok(NULL, "\n\0");
-      result_t res = HandleInstructionStatement(
-          current_word, params, symbol_table, symbol_name, code_table, &cfg);
-      /* Symbol was added to the symbol table */
-      if (NULL != symbol_name) {
-        free(symbol_name);
-      }
-      if (MEM_ALLOCATION_ERROR == res) {
-        perror("Error: memory allocation error\n");
-        free(current_line);
-        fclose(input_file);
-        return MEM_ALLOCATION_ERROR;
-      } else if (FAILURE == res) {
-        ++total_errors;
-      }
+    if (MEM_ALLOCATION_ERROR == res) {
+      perror("Error: memory allocation error\n");
+      return MEM_ALLOCATION_ERROR;
+    } else if (FAILURE == res) {
+      ++total_errors;
+      recorder = NULL; /* The encodings are of no use anymore */
     }
   }
 
-  free(current_line);
-  fclose(input_file);
-
   if (total_errors) {
     return FAILURE;
   }
 
-  UpdateDataSymbolsAddresses(symbol_table, GetSizeVector(code_table));
+  UpdateDataSymbolsAddresses(context->symbol_table,
+                             GetTotalWordsNum(context->code_table));
   return SUCCESS;
 }
 
-static result_t SecondPass(char *file_path, symbol_table_t *symbol_table,
-                           vector_t *code_table,
-                           ext_symbol_occurrences_t *ext_list) {
+/*
+ * @brief Performs the second pass: resolves the symbol references recorded
+ *        by the first pass, now that all symbols are known.
+ *        1. Patches each direct operand's word with its symbol's address,
+ *           recording uses of external symbols.
+ *        2. Marks symbols passed to .entry as entries.
+ *
+ * @param context - The file's context, after the first pass. Its code
+ *                  table is patched, and its external symbols list populated.
+ *
+ * @return SUCCESS if every reference was resolved, otherwise FAILURE, or
+ *         MEM_ALLOCATION_ERROR if a use of an external symbol couldn't be
+ *         recorded.
+ */
 
-  syntax_check_config_t cfg = CreateSyntaxCheckConfig(file_path, 0, TRUE);
-  unsigned int IC = 0;
+static result_t SecondPass(assembly_context_t *context) {
+  vector_t *relocations = context->relocations;
+  symbol_table_t *symbol_table = context->symbol_table;
+  word_buffer_t *code_table = context->code_table;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
   int total_errors = 0;
-  char *current_word = NULL;
-  char *current_line = NULL;
-  FILE *input_file = NULL;
+  size_t i = 0;
 
-  /* Acquire resources */
-  input_file = fopen(file_path, "r");
-  if (NULL == input_file) {
-    fprintf(stderr, "Couldn't open input file '%s'.\n", file_path);
-    return ERROR_OPENING_FILE;
-  }
+  cfg.stream = context->options->diagnostics;
 
-  current_line = (char *)malloc(MAX_LINE_LENGTH * sizeof(char));
-  if (NULL == current_line) {
-    fclose(input_file);
-    fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
-    return MEM_ALLOCATION_ERROR;
-  }
+  for (i = 0; i < GetSizeVector(relocations); ++i) {
+    relocation_t *relocation = (relocation_t *)GetElementVector(relocations, i);
+    const char *name = relocation->symbol_name;
+    symbol_t *symbol = NULL;
 
-  /* ~ * ~ ------------------------------ ~ * ~
-   * Performing syntax analysis for each line.
-   * ~ * ~ ------------------------------ ~ * ~
-   */
-  while (NULL != fgets(current_line, MAX_LINE_LENGTH, input_file)) {
-    ++cfg.line_number;
-
-    if (IsSymbolDefinition(current_line)) {
-      /* If we have a symbol definition, e.g. "SYMBOL: ...", skip after the
-       * label */
-      current_word = strtok(current_line, ": \t\n\r");
-      current_word = strtok(NULL, ": \t");
-    } else {
-      /* Get the first word */
-      current_word = strtok(current_line, DELIMITERS);
-    }
+    cfg.line_number = relocation->line_number;
 
-    /*
-     * Handle directives.
-     * The only one left to handle is .entry.
+    /* Update each symbol passed as a parameter to .entry as an .entry symbol.
+     * Check syntax errors for each symbol.
      */
-    if ('.' == *current_word) {
-      syntax_check_config_t silent_cfg =
-          CreateSyntaxCheckConfig(NULL, 0, FALSE);
-      if (ENTRY_DIRECTIVE != IdentifyDirective(current_word, &silent_cfg)) {
-        /* Other directive have been handled in FirstPass */
-        continue;
+    if (ENTRY_REFERENCE == relocation->kind) {
+      if (!ResolveEntry(name, symbol_table, &cfg)) {
+        total_errors++;
       }
+      continue;
+    }
 
-      /* Check if commas are misplaced in the parameters passed to .entry*/
-      if (AreCommasMisplaced(strstr(current_line, ".entry") + strlen(".entry "),
-                             &cfg)) {
-        return FAILURE;
+    /* Symbol used but wasn't defined */
+    symbol = FindSymbol(symbol_table, name);
+    if (NULL == symbol) {
+      SymbolWasntDefined(name, symbol_table, &cfg);
+      total_errors++;
+      continue;
+    }
+
+    /* The line has errors, so it has no word to patch */
+    if (CHECK_REFERENCE == relocation->kind) {
+      continue;
+    }
+
+    GetWords(code_table)[relocation->code_index] =
+        (machine_word_t)GetSymbolAddress(symbol);
+
+    /* If its extern add the occurence to the list for the .ext file */
+    if (EXTERN == GetSymbolType(symbol) &&
+        SUCCESS != AddExternalSymbolOccurence(
+                       context->ext_list, GetSymbolName(symbol),
+                       relocation->code_index + INITIAL_IC_VALUE)) {
+      perror("Error: memory allocation error\n");
+      return MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  if (0 == total_errors) {
+    return SUCCESS;
+  }
+  return FAILURE;
+}
+
+/*
+ * @brief Marks a symbol passed to .entry as an entry, unless it's illegal,
+ *        undefined or external, which is reported.
+ *
+ * @return TRUE if it was marked, otherwise FALSE.
+ */
+
+static bool_t ResolveEntry(const char *name, symbol_table_t *symbol_table,
+                           syntax_check_config_t *cfg) {
+  if (SymbolNameIsIllegal(name, cfg) ||
+      SymbolWasntDefined(name, symbol_table, cfg) ||
+      SymbolAlreadyDefinedAsExtern(name, symbol_table, cfg)) {
+    return FALSE;
+  }
+
+  ChangeSymbolToEntry(symbol_table, name);
+  return TRUE;
+}
+
+assembler_options_t CreateAssemblerOptions(void) {
+  assembler_options_t options;
+  options.diagnostics = stdout;
+  options.binary_object = FALSE;
+  options.arena = NULL;
+  options.incremental = NULL;
+  options.threads_num = 1;
+  options.on_phase = NULL;
+  options.phase_arg = NULL;
+
+  return options;
+}
+
+result_t AssembleFile(char *file_path, macro_table_t *macro_table) {
+  result_t res = SUCCESS;
+  assembler_options_t options = CreateAssemblerOptions();
+  source_buffer_t *source = LoadSourceFile(file_path);
+
+  if (NULL == source) {
+    fprintf(stderr, "Couldn't open input file '%s'.\n", file_path);
+    return ERROR_OPENING_FILE;
+  }
+
+  res = AssembleSource(file_path, source, macro_table, &options);
+  DestroySourceBuffer(source);
+  return res;
+}
+
+result_t AssembleSource(char *file_path,
+                        const source_buffer_t *source,
+                        macro_table_t *macro_table,
+                        const assembler_options_t *options) {
+  result_t res = SUCCESS;
+  assembly_context_t context;
+
+  res = InitAssemblyContext(&context, file_path, source, macro_table, options);
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  res = RunPasses(&context);
+
+  /*
+   * Generating output files
+   */
+  if (SUCCESS == res) {
+    EnterPhase(options, OUTPUT_PHASE);
+  }
+  if (SUCCESS == res &&
+      SUCCESS != GenerateOutputFiles(context.code_table, context.data_table,
+                                     context.symbol_table, file_path,
+                                     context.ext_list,
+                                     options->binary_object,
+                                     options->threads_num)) {
+    res = FAILURE;
+  }
+
+  DestroyAssemblyContext(&context);
+  EnterPhase(options, ASSEMBLING_DONE);
+  return res;
+}
+
+result_t AssembleSourceToProgram(const char *file_path,
+                                 const source_buffer_t *source,
+                                 macro_table_t *macro_table,
+                                 const assembler_options_t *options,
+                                 assembled_program_t *program) {
+  result_t res = SUCCESS;
+  assembly_context_t context;
+
+  memset(program, 0, sizeof(assembled_program_t));
+
+  res = InitAssemblyContext(&context, file_path, source, macro_table, options);
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  res = RunPasses(&context);
+  if (SUCCESS == res) {
+    res = BuildProgram(&context, program);
+  }
+
+  DestroyAssemblyContext(&context);
+  EnterPhase(options, ASSEMBLING_DONE);
+  return res;
+}
+
+result_t AssembleStream(char *file_path,
+                        FILE *source,
+                        macro_table_t *macro_table,
+                        const assembler_options_t *options) {
+  result_t res = SUCCESS;
+  assembly_context_t context;
+  spilled_output_t output;
+  source_buffer_t *window = CreateSourceBuffer();
+  FILE *relocations = tmpfile();
+
+  output.code = tmpfile();
+  output.data = tmpfile();
+  output.ext_refs = tmpfile();
+  output.externals = CreateVector(4, sizeof(spilled_external_t));
+  output.code_size = 0;
+  output.data_size = 0;
+
+  if (NULL == window || NULL == output.externals) {
+    fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
+    res = MEM_ALLOCATION_ERROR;
+  }
+  else if (NULL == relocations || NULL == output.code ||
+           NULL == output.data || NULL == output.ext_refs) {
+    perror("Couldn't create temporary files");
+    res = ERROR_OPENING_FILE;
+  }
+  else {
+    res = InitAssemblyContext(&context, file_path, window, macro_table,
+                              options);
+  }
+
+  if (SUCCESS == res) {
+    EnterPhase(options, FIRST_PASS_PHASE);
+    res = StreamFirstPass(&context, window, source, relocations, &output);
+
+    /* The second pass runs regardless, so all of its errors are reported */
+    if (FAILURE == res || SUCCESS == res) {
+      result_t second_pass_res = SUCCESS;
+
+      EnterPhase(options, SECOND_PASS_PHASE);
+      second_pass_res = StreamSecondPass(&context, relocations, &output);
+      if (SUCCESS != second_pass_res && SUCCESS == res) {
+        res = (MEM_ALLOCATION_ERROR == second_pass_res) ? second_pass_res
+                                                          : FAILURE;
+      }
+    }
+
+    if (SUCCESS == res) {
+      EnterPhase(options, OUTPUT_PHASE);
+    }
+    if (SUCCESS == res &&
+        SUCCESS != GenerateOutputFilesFromSpill(&output, context.symbol_table,
+                                                file_path,
+                                                options->binary_object)) {
+      res = FAILURE;
+    }
+
+    DestroyAssemblyContext(&context);
+    EnterPhase(options, ASSEMBLING_DONE);
+  }
+
+  if (NULL != window) {
+    DestroySourceBuffer(window);
+  }
+  if (NULL != output.externals) {
+    DestroyVector(output.externals);
+  }
+  if (NULL != relocations) {
+    fclose(relocations);
+  }
+  if (NULL != output.code) {
+    fclose(output.code);
+  }
+  if (NULL != output.data) {
+    fclose(output.data);
+  }
+  if (NULL != output.ext_refs) {
+    fclose(output.ext_refs);
+  }
+
+  return res;
+}
+
+assembly_t *CreateAssembly(char *file_path,
+                           macro_table_t *macro_table,
+                           const assembler_options_t *options) {
+  assembly_t *assembly = (assembly_t *)malloc(sizeof(assembly_t));
+
+  if (NULL == assembly) {
+    fprintf(stderr, "Memory allocation error: couldn't allocate an "
+                    "assembling\n");
+    return NULL;
+  }
+
+  /* No lines are known yet; the tables grow as they're fed */
+  if (SUCCESS != InitAssemblyContext(&assembly->context, file_path, NULL,
+                                     macro_table, options)) {
+    free(assembly);
+    return NULL;
+  }
+
+  assembly->cfg = CreateSyntaxCheckConfig(file_path, 0, TRUE);
+  assembly->cfg.stream = options->diagnostics;
+  assembly->total_errors = 0;
+  assembly->res = SUCCESS;
+
+  EnterPhase(options, FIRST_PASS_PHASE);
+  return assembly;
+}
+
+result_t FeedAssembly(assembly_t *assembly, const source_buffer_t *lines) {
+  assembly_context_t *context = &assembly->context;
+  size_t line_index = 0;
+
+  if (SUCCESS != assembly->res) {
+    return assembly->res;
+  }
+
+  /* Same as FirstPass, for these lines */
+  context->source = lines;
+  for (line_index = 0; line_index < GetLineCount(lines); ++line_index) {
+    bool_t warned = FALSE;
+    result_t res = EncodeLine(context, line_index, &assembly->cfg, &warned);
+
+    if (MEM_ALLOCATION_ERROR == res) {
+      perror("Error: memory allocation error\n");
+      assembly->res = MEM_ALLOCATION_ERROR;
+      break;
+    } else if (FAILURE == res) {
+      ++assembly->total_errors;
+    }
+  }
+
+  context->first_line += GetLineCount(lines);
+  context->source = NULL;
+  return assembly->res;
+}
+
+result_t FinishAssembly(assembly_t *assembly) {
+  assembly_context_t *context = &assembly->context;
+  const assembler_options_t *options = context->options;
+  result_t res = assembly->res;
+  result_t second_pass_res = SUCCESS;
+
+  if (MEM_ALLOCATION_ERROR == res) {
+    EnterPhase(options, ASSEMBLING_DONE);
+    return res;
+  }
+
+  if (assembly->total_errors) {
+    res = FAILURE;
+  }
+  else {
+    UpdateDataSymbolsAddresses(context->symbol_table,
+                               GetTotalWordsNum(context->code_table));
+  }
+
+  /* The second pass runs regardless, so all of its errors are reported */
+  EnterPhase(options, SECOND_PASS_PHASE);
+  second_pass_res = SecondPass(context);
+  if (MEM_ALLOCATION_ERROR == second_pass_res) {
+    res = MEM_ALLOCATION_ERROR;
+  }
+  else if (SUCCESS != second_pass_res) {
+    res = FAILURE;
+  }
+
+  if (SUCCESS == res) {
+    EnterPhase(options, OUTPUT_PHASE);
+  }
+  if (SUCCESS == res &&
+      SUCCESS != GenerateOutputFiles(context->code_table, context->data_table,
+                                     context->symbol_table,
+                                     context->file_path,
+                                     context->ext_list,
+                                     options->binary_object,
+                                     options->threads_num)) {
+    res = FAILURE;
+  }
+
+  EnterPhase(options, ASSEMBLING_DONE);
+  return res;
+}
+
+void DestroyAssembly(assembly_t *assembly) {
+  DestroyAssemblyContext(&assembly->context);
+  free(assembly);
+}
+
+void DestroyAssembledProgram(assembled_program_t *program) {
+  free(program->memory);
+  memset(program, 0, sizeof(assembled_program_t));
+}
+
+incremental_state_t *CreateIncrementalState(size_t max_files) {
+  incremental_state_t *state =
+      (incremental_state_t *)malloc(sizeof(incremental_state_t));
+
+  if (NULL == state) {
+    perror("Couldn't allocate an incremental state");
+    return NULL;
+  }
+
+  state->files = CreateVector(4, sizeof(assembled_file_t));
+  if (NULL == state->files) {
+    perror("Couldn't allocate an incremental state");
+    free(state);
+    return NULL;
+  }
+
+  state->max_files = (0 == max_files) ? 1 : max_files;
+  state->clock = 0;
+  state->encoded_lines = 0;
+  state->reused_lines = 0;
+  return state;
+}
+
+void DestroyIncrementalState(incremental_state_t *state) {
+  size_t i = 0;
+
+  for (i = 0; i < GetSizeVector(state->files); ++i) {
+    assembled_file_t *file =
+        (assembled_file_t *)GetElementVector(state->files, i);
+
+    ClearAssembledFile(file);
+    free(file->file_path);
+  }
+
+  DestroyVector(state->files);
+  free(state);
+}
+
+void GetIncrementalStats(const incremental_state_t *state,
+                         unsigned long *encoded_lines,
+                         unsigned long *reused_lines) {
+  *encoded_lines = state->encoded_lines;
+  *reused_lines = state->reused_lines;
+}
+
+/*
+ * @brief Assembler performing first & second pass on a file's context.
+ *
+ * @return SUCCESS, FAILURE if syntax errors were found, or
+ *         MEM_ALLOCATION_ERROR.
+ */
+
+static result_t RunPasses(assembly_context_t *context) {
+  result_t res = SUCCESS;
+  result_t second_pass_res = SUCCESS;
+
+  if (NULL != context->options->incremental) {
+    return RunPassesIncrementally(context);
+  }
+
+  EnterPhase(context->options, FIRST_PASS_PHASE);
+  res = FirstPassInParallel(context);
+
+  if (MEM_ALLOCATION_ERROR == res) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* The second pass runs regardless, so all of its errors are reported */
+  EnterPhase(context->options, SECOND_PASS_PHASE);
+  second_pass_res = SecondPassInParallel(context);
+  if (MEM_ALLOCATION_ERROR == second_pass_res) {
+    return MEM_ALLOCATION_ERROR;
+  }
+  if (SUCCESS != second_pass_res) {
+    res = FAILURE;
+  }
+
+  return res;
+}
+
+static void EnterPhase(const assembler_options_t *options,
+                       assembler_phase_t phase) {
+  if (NULL != options->on_phase) {
+    options->on_phase(phase, options->phase_arg);
+  }
+}
+
+/*
+ * @brief Same as FirstPass, with the source split into chunks of
+ *        consecutive lines, each encoded on a thread of its own (see
+ *        first_pass_chunk_t). The chunks are then concatenated in order:
+ *        the words of each follow those of the chunks before it, so its
+ *        symbols & references are shifted by their total sizes.
+ *
+ *        Chunks are encoded silently. If any line would be reported, or
+ *        chunks define the same symbol, FirstPass runs instead, so errors
+ *        are reported exactly as usual. Otherwise, only warnings are due,
+ *        and they're printed in the order of their lines.
+ *
+ * @param context - As in FirstPass. Only the number of threads in its
+ *                  options is used (see assembler_options_t).
+ *
+ * @return Same as FirstPass.
+ */
+
+static result_t FirstPassInParallel(assembly_context_t *context) {
+  const assembler_options_t *options = context->options;
+  assembler_options_t chunk_options = *options;
+  size_t lines_num = GetLineCount(context->source);
+  size_t chunks_num = lines_num / PARALLEL_MIN_CHUNK_LINES;
+  size_t chunks_ready = 0;
+  first_pass_chunk_t *chunks = NULL;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
+  result_t res = SUCCESS;
+  size_t i = 0;
+  size_t j = 0;
+
+  if (chunks_num > options->threads_num) {
+    chunks_num = options->threads_num;
+  }
+  if (2 > chunks_num || NULL != context->recorder) {
+    return FirstPass(context);
+  }
+
+  chunks = (first_pass_chunk_t *)calloc(chunks_num,
+                                        sizeof(first_pass_chunk_t));
+  if (NULL == chunks) {
+    perror("Error: memory allocation error\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* The arena isn't to be shared between threads */
+  chunk_options.arena = NULL;
+
+  for (i = 0; SUCCESS == res && i < chunks_num; ++i) {
+    first_pass_chunk_t *chunk = &chunks[i];
+
+    res = InitAssemblyContext(&chunk->context, context->file_path, NULL,
+                              context->macro_table, &chunk_options);
+    if (SUCCESS == res) {
+      ++chunks_ready;
+      chunk->context.source = context->source;
+      chunk->first_line = lines_num * i / chunks_num;
+      chunk->last_line = lines_num * (i + 1) / chunks_num;
+      chunk->warned_lines = CreateVector(4, sizeof(unsigned int));
+      chunk->started = FALSE;
+      chunk->res = SUCCESS;
+
+      if (NULL == chunk->warned_lines) {
+        res = MEM_ALLOCATION_ERROR;
+      }
+    }
+  }
+
+  if (SUCCESS == res) {
+    for (i = 1; i < chunks_num; ++i) {
+      chunks[i].started = (0 == pthread_create(&chunks[i].thread, NULL,
+                                               EncodeChunk, &chunks[i]));
+    }
+
+    /* The first chunk is encoded on the calling thread, and so is any
+     * chunk whose thread couldn't be started */
+    for (i = 0; i < chunks_num; ++i) {
+      if (!chunks[i].started) {
+        EncodeChunk(&chunks[i]);
+      }
+    }
+
+    for (i = 0; i < chunks_num; ++i) {
+      if (chunks[i].started) {
+        pthread_join(chunks[i].thread, NULL);
+      }
+
+      if (MEM_ALLOCATION_ERROR == chunks[i].res) {
+        res = MEM_ALLOCATION_ERROR;
+      } else if (SUCCESS != chunks[i].res && SUCCESS == res) {
+        res = FAILURE;
+      }
+    }
+  }
+
+  if (SUCCESS == res && ChunksClash(chunks, chunks_num)) {
+    res = FAILURE;
+  }
+
+  if (SUCCESS == res) {
+    res = MergeChunks(context, chunks, chunks_num);
+  }
+
+  if (SUCCESS == res) {
+    cfg.stream = options->diagnostics;
+    for (i = 0; i < chunks_num; ++i) {
+      for (j = 0; j < GetSizeVector(chunks[i].warned_lines); ++j) {
+        cfg.line_number =
+            *(unsigned int *)GetElementVector(chunks[i].warned_lines, j);
+        WarnLabelBeforeReference(&cfg);
+      }
+    }
+  }
+
+  for (i = 0; i < chunks_ready; ++i) {
+    if (NULL != chunks[i].warned_lines) {
+      DestroyVector(chunks[i].warned_lines);
+    }
+    DestroyAssemblyContext(&chunks[i].context);
+  }
+  free(chunks);
+
+  /* Nothing was added to the context, so the lines are encoded anew */
+  if (FAILURE == res) {
+    return FirstPass(context);
+  }
+
+  if (MEM_ALLOCATION_ERROR == res) {
+    perror("Error: memory allocation error\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  UpdateDataSymbolsAddresses(context->symbol_table,
+                             GetTotalWordsNum(context->code_table));
+  return SUCCESS;
+}
+
+/*
+ * @brief Encodes the lines of a chunk into its context, up to the first one
+ *        that would be reported (see first_pass_chunk_t).
+ */
+
+static void *EncodeChunk(void *chunk) {
+  first_pass_chunk_t *state = (first_pass_chunk_t *)chunk;
+  syntax_check_config_t silent_cfg =
+      CreateSyntaxCheckConfig(state->context.file_path, 0, FALSE);
+  size_t i = 0;
+
+  for (i = state->first_line; SUCCESS == state->res && i < state->last_line;
+       ++i) {
+    bool_t warned = FALSE;
+
+    state->res = EncodeLine(&state->context, i, &silent_cfg, &warned);
+    if (SUCCESS == state->res && warned) {
+      unsigned int line_number = silent_cfg.line_number;
+
+      state->res = AppendVector(state->warned_lines, &line_number);
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * @brief Whether a symbol of a chunk is defined by a chunk before it as
+ *        well, which FirstPass would report.
+ */
+
+static bool_t ChunksClash(first_pass_chunk_t *chunks, size_t chunks_num) {
+  size_t i = 0;
+  size_t j = 0;
+
+  for (i = 1; i < chunks_num; ++i) {
+    node_t *iter = GetHead(AsList(chunks[i].context.symbol_table));
+
+    for (; NULL != iter; iter = GetNext(iter)) {
+      const char *name = GetSymbolName((symbol_t *)GetValue(iter));
+
+      for (j = 0; j < i; ++j) {
+        if (NULL != FindSymbol(chunks[j].context.symbol_table, name)) {
+          return TRUE;
+        }
+      }
+    }
+  }
+
+  return FALSE;
+}
+
+/*
+ * @brief Appends the words, symbols & references of encoded chunks to a
+ *        context, in order, as FirstPass would have encoded them (before the
+ *        data symbols are moved after the code).
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t MergeChunks(assembly_context_t *context,
+                            first_pass_chunk_t *chunks, size_t chunks_num) {
+  symbol_table_t *symbol_table = context->symbol_table;
+  size_t code_start = 0;
+  size_t data_start = 0;
+  size_t i = 0;
+  size_t j = 0;
+
+  for (i = 0; i < chunks_num; ++i) {
+    assembly_context_t *chunk = &chunks[i].context;
+    node_t *iter = GetHead(AsList(chunk->symbol_table));
+
+    for (; NULL != iter; iter = GetNext(iter)) {
+      symbol_t *symbol = (symbol_t *)GetValue(iter);
+      result_t res = SUCCESS;
+
+      if (EXTERN == GetSymbolType(symbol)) {
+        res = AddExternalSymbol(symbol_table, GetSymbolName(symbol));
+      } else if (CODE == GetSymbolMemoryArea(symbol)) {
+        res = AddSymbol(symbol_table, GetSymbolName(symbol),
+                        (address_t)(GetSymbolAddress(symbol) + code_start),
+                        CODE);
+      } else {
+        res = AddSymbol(symbol_table, GetSymbolName(symbol),
+                        (address_t)(GetSymbolAddress(symbol) + data_start),
+                        DATA);
+      }
+
+      if (SUCCESS != res) {
+        return MEM_ALLOCATION_ERROR;
+      }
+    }
+
+    for (j = 0; j < GetSizeVector(chunk->relocations); ++j) {
+      relocation_t *relocation =
+          (relocation_t *)GetElementVector(chunk->relocations, j);
+      size_t code_index = relocation->code_index;
+
+      if (OPERAND_REFERENCE == relocation->kind) {
+        code_index += code_start;
+      }
+
+      if (SUCCESS != AddRelocation(context->relocations, relocation->kind,
+                                   code_index, relocation->symbol_name,
+                                   symbol_table, relocation->line_number)) {
+        return MEM_ALLOCATION_ERROR;
+      }
+    }
+
+    if (SUCCESS != AppendWords(context->code_table,
+                               GetWords(chunk->code_table),
+                               GetWordsNum(chunk->code_table)) ||
+        SUCCESS != AppendWords(context->data_table,
+                               GetWords(chunk->data_table),
+                               GetWordsNum(chunk->data_table))) {
+      return MEM_ALLOCATION_ERROR;
+    }
+
+    code_start += GetWordsNum(chunk->code_table);
+    data_start += GetWordsNum(chunk->data_table);
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Same as SecondPass, with the direct operands resolved on several
+ *        threads, each patching the code words of a range of references.
+ *        Once the symbol table is complete, operands don't depend on each
+ *        other, and each patches a word of its own.
+ *
+ *        Uses of external symbols are gathered by each thread, and added to
+ *        the context's list in the order of the ranges, so in the order of
+ *        the code, as SecondPass adds them. Entries are resolved afterwards,
+ *        on the calling thread.
+ *
+ *        Operands are resolved silently. If one would be reported,
+ *        SecondPass runs instead, so errors are reported exactly as usual
+ *        (patching the same words again does no harm). Otherwise only
+ *        entries may be reported, and they're resolved in order.
+ *
+ * @param context - As in SecondPass. Only the number of threads in its
+ *                  options is used (see assembler_options_t).
+ *
+ * @return Same as SecondPass.
+ */
+
+static result_t SecondPassInParallel(assembly_context_t *context) {
+  vector_t *relocations = context->relocations;
+  size_t references_num = GetSizeVector(relocations);
+  size_t chunks_num = references_num / PARALLEL_MIN_CHUNK_REFERENCES;
+  size_t chunks_ready = 0;
+  second_pass_chunk_t *chunks = NULL;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
+  int total_errors = 0;
+  bool_t merge_failed = FALSE;
+  result_t res = SUCCESS;
+  size_t i = 0;
+  size_t j = 0;
+
+  if (chunks_num > context->options->threads_num) {
+    chunks_num = context->options->threads_num;
+  }
+  if (2 > chunks_num) {
+    return SecondPass(context);
+  }
+
+  chunks = (second_pass_chunk_t *)calloc(chunks_num,
+                                         sizeof(second_pass_chunk_t));
+  if (NULL == chunks) {
+    return SecondPass(context);
+  }
+
+  for (i = 0; SUCCESS == res && i < chunks_num; ++i) {
+    second_pass_chunk_t *chunk = &chunks[i];
+
+    chunk->context = context;
+    chunk->first_reference = references_num * i / chunks_num;
+    chunk->last_reference = references_num * (i + 1) / chunks_num;
+    chunk->external_uses = CreateVector(4, sizeof(external_use_t));
+    chunk->started = FALSE;
+    chunk->res = SUCCESS;
+
+    if (NULL == chunk->external_uses) {
+      res = MEM_ALLOCATION_ERROR;
+    } else {
+      ++chunks_ready;
+    }
+  }
+
+  if (SUCCESS == res) {
+    for (i = 1; i < chunks_num; ++i) {
+      chunks[i].started = (0 == pthread_create(&chunks[i].thread, NULL,
+                                               ResolveOperands, &chunks[i]));
+    }
+
+    /* The first range is resolved on the calling thread, and so is any
+     * range whose thread couldn't be started */
+    for (i = 0; i < chunks_num; ++i) {
+      if (!chunks[i].started) {
+        ResolveOperands(&chunks[i]);
+      }
+    }
+
+    for (i = 0; i < chunks_num; ++i) {
+      if (chunks[i].started) {
+        pthread_join(chunks[i].thread, NULL);
       }
 
-      /* Update each symbol passed as a parameter to .entry as an .entry symbol.
-       * Check syntax errors for each symbol.
-       */
+      if (SUCCESS != chunks[i].res) {
+        res = chunks[i].res;
+      }
+    }
+  }
+
+  if (SUCCESS == res) {
+    for (i = 0; !merge_failed && i < chunks_num; ++i) {
+      for (j = 0; !merge_failed && j < GetSizeVector(chunks[i].external_uses);
+           ++j) {
+        external_use_t *use =
+            (external_use_t *)GetElementVector(chunks[i].external_uses, j);
+
+        merge_failed = (SUCCESS != AddExternalSymbolOccurence(
+                                       context->ext_list, use->symbol_name,
+                                       use->address));
+      }
+    }
+  }
+
+  for (i = 0; i < chunks_ready; ++i) {
+    DestroyVector(chunks[i].external_uses);
+  }
+  free(chunks);
+
+  /* Some uses were added already, so the pass can't run anew */
+  if (merge_failed) {
+    perror("Error: memory allocation error\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* Nothing was added to the context's list, so the pass runs anew */
+  if (SUCCESS != res) {
+    return SecondPass(context);
+  }
+
+  cfg.stream = context->options->diagnostics;
+  for (i = 0; i < references_num; ++i) {
+    relocation_t *relocation = (relocation_t *)GetElementVector(relocations, i);
+
+    if (ENTRY_REFERENCE == relocation->kind) {
+      cfg.line_number = relocation->line_number;
+      if (!ResolveEntry(relocation->symbol_name, context->symbol_table,
+                        &cfg)) {
+        total_errors++;
+      }
+    }
+  }
+
+  return total_errors ? FAILURE : SUCCESS;
+}
+
+/*
+ * @brief Patches the words of the direct operands in a range of references
+ *        with their symbols' addresses, up to the first one whose symbol
+ *        wasn't defined (see second_pass_chunk_t). Entries are skipped,
+ *        and so are operands of lines with errors, once found defined.
+ */
+
+static void *ResolveOperands(void *chunk) {
+  second_pass_chunk_t *state = (second_pass_chunk_t *)chunk;
+  vector_t *relocations = state->context->relocations;
+  symbol_table_t *symbol_table = state->context->symbol_table;
+  machine_word_t *code = GetWords(state->context->code_table);
+  size_t i = 0;
+
+  for (i = state->first_reference;
+       SUCCESS == state->res && i < state->last_reference; ++i) {
+    relocation_t *relocation = (relocation_t *)GetElementVector(relocations, i);
+    symbol_t *symbol = NULL;
+
+    if (ENTRY_REFERENCE == relocation->kind) {
+      continue;
+    }
+
+    symbol = FindSymbol(symbol_table, relocation->symbol_name);
+    if (NULL == symbol) {
+      state->res = FAILURE;
+      break;
+    }
+
+    if (CHECK_REFERENCE == relocation->kind) {
+      continue;
+    }
+
+    code[relocation->code_index] = (machine_word_t)GetSymbolAddress(symbol);
+
+    if (EXTERN == GetSymbolType(symbol)) {
+      external_use_t use;
+
+      use.symbol_name = GetSymbolName(symbol);
+      use.address = (unsigned int)(relocation->code_index + INITIAL_IC_VALUE);
+      state->res = AppendVector(state->external_uses, &use);
+    }
+  }
+
+  return NULL;
+}
+
+/*
+ * @brief Copies the output of a successful assembling into a program.
+ *        Everything is allocated in a single block: the entries, then the
+ *        external references, the words and finally the symbol names.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t BuildProgram(assembly_context_t *context,
+                             assembled_program_t *program) {
+  size_t entries_num = 0;
+  size_t externals_num = 0;
+  size_t names_size = 0;
+  size_t i = 0;
+  size_t code_size = GetWordsNum(context->code_table);
+  size_t data_size = GetWordsNum(context->data_table);
+  node_t *iter = NULL;
+  char *names = NULL;
+  char *memory = NULL;
+
+  /* Count the symbols & the size of their names */
+  for (iter = GetHead(AsList(context->symbol_table)); NULL != iter;
+       iter = GetNext(iter)) {
+    symbol_t *symbol = (symbol_t *)GetValue(iter);
+
+    if (ENTRY == GetSymbolType(symbol)) {
+      ++entries_num;
+      names_size += strlen(GetSymbolName(symbol)) + 1;
+    }
+  }
+
+  for (iter = GetHead(context->ext_list->external_symbols); NULL != iter;
+       iter = GetNext(iter)) {
+    external_symbol_data_t *external = (external_symbol_data_t *)GetValue(iter);
+
+    externals_num += GetSizeVector(external->occurrences);
+    names_size += strlen(external->symbol_name) + 1;
+  }
+
+  memory = (char *)malloc((entries_num + externals_num) *
+                              sizeof(program_symbol_t) +
+                          (code_size + data_size) * sizeof(machine_word_t) +
+                          names_size);
+  if (NULL == memory) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate the program\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  program->memory = memory;
+  program->entries = (program_symbol_t *)memory;
+  program->externals = program->entries + entries_num;
+  program->code = (machine_word_t *)(program->externals + externals_num);
+  program->data = program->code + code_size;
+  names = (char *)(program->data + data_size);
+
+  program->code_size = code_size;
+  program->data_size = data_size;
+  memcpy(program->code, GetWords(context->code_table),
+         code_size * sizeof(machine_word_t));
+  memcpy(program->data, GetWords(context->data_table),
+         data_size * sizeof(machine_word_t));
+
+  /* Entries, in the order of the .ent file */
+  for (iter = GetHead(AsList(context->symbol_table)); NULL != iter;
+       iter = GetNext(iter)) {
+    symbol_t *symbol = (symbol_t *)GetValue(iter);
+    size_t length = 0;
+
+    if (ENTRY != GetSymbolType(symbol)) {
+      continue;
+    }
+
+    length = strlen(GetSymbolName(symbol)) + 1;
+    memcpy(names, GetSymbolName(symbol), length);
+    program->entries[program->entries_num].name = names;
+    program->entries[program->entries_num].address =
+        (unsigned int)GetSymbolAddress(symbol);
+    ++program->entries_num;
+    names += length;
+  }
+
+  /* External references, in the order of the .ext file */
+  for (iter = GetHead(context->ext_list->external_symbols); NULL != iter;
+       iter = GetNext(iter)) {
+    external_symbol_data_t *external = (external_symbol_data_t *)GetValue(iter);
+    size_t length = strlen(external->symbol_name) + 1;
+
+    memcpy(names, external->symbol_name, length);
+    for (i = 0; i < GetSizeVector(external->occurrences); ++i) {
+      program->externals[program->externals_num].name = names;
+      program->externals[program->externals_num].address =
+          *(unsigned int *)GetElementVector(external->occurrences, i);
+      ++program->externals_num;
+    }
+    names += length;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Same as FirstPass, for a source read from a stream: it's read into
+ *        the context's source a window of lines at a time, and after each
+ *        window the words & relocations it produced are spilled.
+ *
+ * @param context - The file's context, whose source is 'window'.
+ *        window - Source buffer into which windows are read.
+ *        source - Stream of the expanded source.
+ *        relocations - Stream to which relocations are spilled. Their names
+ *                      point into the symbol table's pool, which is kept.
+ *        output - Code & data words are spilled to its streams, and their
+ *                 total sizes are set.
+ *
+ * @return Same as FirstPass, or FILE_HANDLING_ERROR & ERROR_WRITING_TO_FILE
+ *         if the source couldn't be read or the spills written.
+ */
+
+static result_t StreamFirstPass(assembly_context_t *context,
+                                source_buffer_t *window,
+                                FILE *source,
+                                FILE *relocations,
+                                spilled_output_t *output) {
+  int total_errors = 0;
+  size_t line_index = 0;
+  result_t res = SUCCESS;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
+
+  cfg.stream = context->options->diagnostics;
+
+  while (SUCCESS == res) {
+    ClearSourceBuffer(window);
+    res = ReadSourceLines(window, source, STREAM_WINDOW_LINES);
+    if (SUCCESS != res || 0 == GetLineCount(window)) {
+      break;
+    }
+
+    for (line_index = 0; line_index < GetLineCount(window); ++line_index) {
+      bool_t warned = FALSE;
+      result_t line_res = EncodeLine(context, line_index, &cfg, &warned);
+
+      if (MEM_ALLOCATION_ERROR == line_res) {
+        perror("Error: memory allocation error\n");
+        return MEM_ALLOCATION_ERROR;
+      } else if (FAILURE == line_res) {
+        ++total_errors;
+      }
+    }
+
+    context->first_line += GetLineCount(window);
+    res = SpillWords(context->code_table, output->code);
+    if (SUCCESS == res) {
+      res = SpillWords(context->data_table, output->data);
+    }
+    if (SUCCESS == res) {
+      res = SpillRelocations(context->relocations, relocations);
+    }
+  }
+
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  output->code_size = GetTotalWordsNum(context->code_table);
+  output->data_size = GetTotalWordsNum(context->data_table);
+
+  if (total_errors) {
+    return FAILURE;
+  }
+
+  UpdateDataSymbolsAddresses(context->symbol_table, output->code_size);
+  return SUCCESS;
+}
+
+/*
+ * @brief Same as SecondPass, for relocations & code spilled by
+ *        StreamFirstPass. Relocations are spilled in the order of the code,
+ *        so the code is patched in place, a chunk at a time; uses of
+ *        external symbols are spilled to the output.
+ *
+ * @return SUCCESS if every reference was resolved, FAILURE otherwise, or
+ *         an error code if the spills couldn't be read or written.
+ */
+
+static result_t StreamSecondPass(assembly_context_t *context,
+                                 FILE *relocations,
+                                 spilled_output_t *output) {
+  symbol_table_t *symbol_table = context->symbol_table;
+  machine_word_t chunk[STREAM_CHUNK_WORDS];
+  size_t chunk_start = 0;
+  size_t chunk_size = 0;
+  bool_t chunk_patched = FALSE;
+  relocation_t relocation;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
+  int total_errors = 0;
+  result_t res = SUCCESS;
+
+  cfg.stream = context->options->diagnostics;
+
+  rewind(relocations);
+  while (SUCCESS == res &&
+         1 == fread(&relocation, sizeof(relocation_t), 1, relocations)) {
+    const char *name = relocation.symbol_name;
+    symbol_t *symbol = NULL;
+
+    cfg.line_number = relocation.line_number;
+
+    if (ENTRY_REFERENCE == relocation.kind) {
+      if (!ResolveEntry(name, symbol_table, &cfg)) {
+        total_errors++;
+      }
+      continue;
+    }
+
+    symbol = FindSymbol(symbol_table, name);
+    if (NULL == symbol) {
+      SymbolWasntDefined(name, symbol_table, &cfg);
+      total_errors++;
+      continue;
+    }
+
+    if (CHECK_REFERENCE == relocation.kind) {
+      continue;
+    }
+
+    /* Move on to the chunk of the code holding the word */
+    if (relocation.code_index >= chunk_start + chunk_size) {
+      if (chunk_patched &&
+          (0 != fseek(output->code,
+                      (long)(chunk_start * sizeof(machine_word_t)),
+                      SEEK_SET) ||
+           chunk_size != fwrite(chunk, sizeof(machine_word_t), chunk_size,
+                                output->code))) {
+        res = ERROR_WRITING_TO_FILE;
+        break;
+      }
+
+      chunk_start = relocation.code_index -
+                    relocation.code_index % STREAM_CHUNK_WORDS;
+      chunk_patched = FALSE;
+      if (0 != fseek(output->code,
+                     (long)(chunk_start * sizeof(machine_word_t)),
+                     SEEK_SET)) {
+        res = FILE_HANDLING_ERROR;
+        break;
+      }
+      chunk_size = fread(chunk, sizeof(machine_word_t), STREAM_CHUNK_WORDS,
+                         output->code);
+    }
+
+    chunk[relocation.code_index - chunk_start] =
+        (machine_word_t)GetSymbolAddress(symbol);
+    chunk_patched = TRUE;
+
+    if (EXTERN == GetSymbolType(symbol)) {
+      res = SpillExternalReference(output, GetSymbolName(symbol),
+                                   relocation.code_index + INITIAL_IC_VALUE);
+    }
+  }
+
+  /* The last chunk */
+  if (SUCCESS == res && chunk_patched &&
+      (0 != fseek(output->code, (long)(chunk_start * sizeof(machine_word_t)),
+                  SEEK_SET) ||
+       chunk_size != fwrite(chunk, sizeof(machine_word_t), chunk_size,
+                            output->code))) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  if (SUCCESS != res || ferror(relocations) || ferror(output->code)) {
+    perror("Error accessing temporary files");
+    return SUCCESS != res ? res : FILE_HANDLING_ERROR;
+  }
+
+  return total_errors ? FAILURE : SUCCESS;
+}
+
+/*
+ * @brief Writes the relocations recorded so far to a stream, and empties
+ *        the vector.
+ *
+ * @return SUCCESS, or ERROR_WRITING_TO_FILE.
+ */
+
+static result_t SpillRelocations(vector_t *relocations, FILE *stream) {
+  size_t relocations_num = GetSizeVector(relocations);
+
+  if (0 < relocations_num &&
+      relocations_num != fwrite(GetElementVector(relocations, 0),
+                                sizeof(relocation_t), relocations_num,
+                                stream)) {
+    perror("Error writing to file");
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  while (!IsEmptyVector(relocations)) {
+    RemoveLastVector(relocations);
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Acquires the resources of a file's context. On failure, whatever
+ *        was acquired is released.
+ *
+ * @param context - The context to initialize.
+ *        Rest of the parameters - As in AssembleSource.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t InitAssemblyContext(assembly_context_t *context,
+                                    const char *file_path,
+                                    const source_buffer_t *source,
+                                    macro_table_t *macro_table,
+                                    const assembler_options_t *options) {
+  size_t lines_num = 0;
+
+  context->file_path = file_path;
+  context->source = source;
+  context->first_line = 0;
+  context->macro_table = macro_table;
+  context->options = options;
+  context->symbol_table = NULL;
+  context->code_table = NULL;
+  context->data_table = NULL;
+  context->ext_list = NULL;
+  context->relocations = NULL;
+  context->recorder = NULL;
+
+  /* Symbol table which will be populated with symbols in first pass */
+  context->symbol_table = CreateSymbolTableInArena(options->arena, NULL);
+  if (NULL == context->symbol_table) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate a symbol table\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* External symbols are symbols of the table, so their names are interned
+   * in its pool rather than copied */
+  context->ext_list = CreateExternalSymbolListInArena(
+      options->arena, GetSymbolNames(context->symbol_table));
+  if (NULL == context->ext_list) {
+    fprintf(
+        stderr,
+        "Memory allocation error: couldn't allocate ext. symbol usage list\n");
+    DestroyAssemblyContext(context);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* Most lines are instructions of 1-3 words, or data of a few words */
+  lines_num = (NULL != source) ? GetLineCount(source) : 0;
+  context->code_table = CreateWordBuffer(2 * lines_num);
+  if (NULL == context->code_table) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate a code table\n");
+    DestroyAssemblyContext(context);
+    return MEM_ALLOCATION_ERROR;
+  }
 
-      current_word = strtok(NULL, DELIMITERS);
-      while (NULL != current_word) {
-        if (SymbolNameIsIllegal(current_word, &cfg)) {
-          total_errors++;
-        } else if (SymbolWasntDefined(current_word, symbol_table, &cfg)) {
-          total_errors++;
-        }
+  context->data_table = CreateWordBuffer(lines_num);
+  if (NULL == context->data_table) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate a data table\n");
+    DestroyAssemblyContext(context);
+    return MEM_ALLOCATION_ERROR;
+  }
 
-        else if (SymbolAlreadyDefinedAsExtern(current_word, symbol_table,
-                                              &cfg)) {
-          total_errors++;
-        } else {
-          ChangeSymbolToEntry(symbol_table, current_word);
-        }
-        current_word = strtok(NULL, DELIMITERS);
+  context->relocations = CreateVector(10, sizeof(relocation_t));
+  if (NULL == context->relocations) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate a relocation table\n");
+    DestroyAssemblyContext(context);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Releases the resources of a file's context (some may be NULL).
+ */
+
+static void DestroyAssemblyContext(assembly_context_t *context) {
+  if (NULL != context->ext_list) {
+    DestroyExternSymbolList(context->ext_list);
+  }
+  if (NULL != context->symbol_table) {
+    DestroySymbolTable(context->symbol_table);
+  }
+  if (NULL != context->code_table) {
+    DestroyWordBuffer(context->code_table);
+  }
+  if (NULL != context->data_table) {
+    DestroyWordBuffer(context->data_table);
+  }
+  if (NULL != context->relocations) {
+    DestroyVector(context->relocations);
+  }
+}
+
+/*
+ * @brief Runs the passes on a file's context, reusing the last successful
+ *        assembling of the file (see incremental_state_t), and keeping the
+ *        result for the next one.
+ *
+ * @return Same as RunPasses.
+ */
+
+static result_t RunPassesIncrementally(assembly_context_t *context) {
+  incremental_state_t *state = context->options->incremental;
+  assembled_file_t *file = FindAssembledFile(state, context->file_path);
+  const char *file_path = context->file_path;
+  const source_buffer_t *source = context->source;
+  macro_table_t *macro_table = context->macro_table;
+  const assembler_options_t *options = context->options;
+  result_t res = SUCCESS;
+
+  if (NULL == file) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  if (NULL != file->source) {
+    res = Reassemble(context, file, state);
+    if (FAILURE != res) {
+      return res;
+    }
+
+    /* Some line can't be reused or encoded as it is now. The passes are
+     * run from scratch, so errors are reported exactly as usual. */
+    DestroyAssemblyContext(context);
+    res = InitAssemblyContext(context, file_path, source, macro_table,
+                              options);
+    if (SUCCESS != res) {
+      return res;
+    }
+  }
+
+  return AssembleAndRecord(context, file, state);
+}
+
+/*
+ * @brief Runs both passes on a file's context as usual, recording the
+ *        encoding of each line in the file's entry. If the file has errors,
+ *        its entry is left empty.
+ *
+ * @return Same as RunPasses.
+ */
+
+static result_t AssembleAndRecord(assembly_context_t *context,
+                                  assembled_file_t *file,
+                                  incremental_state_t *state) {
+  line_recorder_t recorder;
+  result_t res = SUCCESS;
+  result_t second_pass_res = SUCCESS;
+
+  /* The pool is replaced as well, so names no longer used are dropped */
+  ClearAssembledFile(file);
+  file->names = CreateStringPool(NULL);
+  if (NULL == file->names || SUCCESS != CreateLineEncodings(&file->encodings)) {
+    ClearAssembledFile(file);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  recorder.encodings = &file->encodings;
+  recorder.names = file->names;
+  recorder.code_words = 0;
+  recorder.data_words = 0;
+  recorder.relocations = 0;
+  recorder.last_symbol = NULL;
+
+  context->recorder = &recorder;
+  res = FirstPass(context);
+  context->recorder = NULL;
+
+  if (MEM_ALLOCATION_ERROR == res) {
+    ClearAssembledFile(file);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  second_pass_res = SecondPass(context);
+  if (MEM_ALLOCATION_ERROR == second_pass_res) {
+    ClearAssembledFile(file);
+    return MEM_ALLOCATION_ERROR;
+  }
+  if (SUCCESS != second_pass_res) {
+    res = FAILURE;
+  }
+
+  state->encoded_lines += GetLineCount(context->source);
+
+  if (SUCCESS == res) {
+    file->source = CopySourceBuffer(context->source);
+    file->code_table = CopyWordBuffer(context->code_table);
+    file->data_table = CopyWordBuffer(context->data_table);
+  }
+
+  /* The next assembling of the file starts from scratch then */
+  if (NULL == file->source || NULL == file->code_table ||
+      NULL == file->data_table) {
+    ClearAssembledFile(file);
+  }
+
+  return res;
+}
+
+/*
+ * @brief Reassembles a file from its last successful assembling. Only the
+ *        lines between the longest common prefix & suffix of the two
+ *        sources are encoded; the words, symbols & references of the rest
+ *        are reused, shifted to their new addresses. Then the symbol table
+ *        is rebuilt, and only references whose symbol moved are patched.
+ *
+ * @param context - The file's context, with empty tables. Upon success, they
+ *                  hold the same as the passes would have produced.
+ *        file - The file's entry, which is updated upon success.
+ *        state - Its statistics are updated upon success.
+ *
+ * @return SUCCESS, MEM_ALLOCATION_ERROR, or FAILURE if any line would be
+ *         reported by the passes (an error, or a clash between lines), in
+ *         which case nothing was printed, and the context must be
+ *         reinitialized.
+ */
+
+static result_t Reassemble(assembly_context_t *context,
+                           assembled_file_t *file,
+                           incremental_state_t *state) {
+  size_t old_lines = GetLineCount(file->source);
+  size_t new_lines = GetLineCount(context->source);
+  size_t prefix = 0;
+  size_t suffix = 0;
+  size_t prefix_code = 0;
+  size_t prefix_data = 0;
+  size_t prefix_symbols = 0;
+  size_t prefix_relocations = 0;
+  size_t suffix_code = 0;
+  size_t suffix_data = 0;
+  size_t suffix_symbols = 0;
+  size_t suffix_relocations = 0;
+  size_t i = 0;
+  line_encodings_t changed = {NULL, NULL, NULL};
+  line_encodings_t encodings = {NULL, NULL, NULL};
+  line_recorder_t recorder;
+  assembly_context_t scratch;
+  source_buffer_t *source_copy = NULL;
+  word_buffer_t *code_copy = NULL;
+  word_buffer_t *data_copy = NULL;
+  syntax_check_config_t cfg =
+      CreateSyntaxCheckConfig(context->file_path, 0, TRUE);
+  result_t res = SUCCESS;
+
+  while (prefix < old_lines && prefix < new_lines &&
+         SameLine(file->source, prefix, context->source, prefix)) {
+    ++prefix;
+  }
+
+  while (suffix < old_lines - prefix && suffix < new_lines - prefix &&
+         SameLine(file->source, old_lines - 1 - suffix, context->source,
+                  new_lines - 1 - suffix)) {
+    ++suffix;
+  }
+
+  /* Where the reused lines' words, symbols & references are */
+  for (i = 0; i < old_lines; ++i) {
+    line_record_t *record =
+        (line_record_t *)GetElementVector(file->encodings.lines, i);
+
+    if (i < prefix) {
+      prefix_code += record->code_words;
+      prefix_data += record->data_words;
+      prefix_symbols += record->symbols_num;
+      prefix_relocations += record->relocations_num;
+    }
+
+    else if (i >= old_lines - suffix) {
+      suffix_code += record->code_words;
+      suffix_data += record->data_words;
+      suffix_symbols += record->symbols_num;
+      suffix_relocations += record->relocations_num;
+    }
+  }
+
+  /* Encode the changed lines on their own, silently */
+  res = InitAssemblyContext(&scratch, context->file_path, context->source,
+                            context->macro_table, context->options);
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  res = CreateLineEncodings(&changed);
+  if (SUCCESS == res) {
+    recorder.encodings = &changed;
+    recorder.names = file->names;
+    recorder.code_words = 0;
+    recorder.data_words = 0;
+    recorder.relocations = 0;
+    recorder.last_symbol = NULL;
+    res = EncodeChangedLines(&scratch, prefix, new_lines - suffix, &recorder);
+  }
+
+  /* Splice them between the reused lines */
+  if (SUCCESS == res) {
+    res = CreateLineEncodings(&encodings);
+  }
+
+  if (SUCCESS == res) {
+    size_t old_code = GetWordsNum(file->code_table);
+    size_t old_data = GetWordsNum(file->data_table);
+    size_t old_symbols = GetSizeVector(file->encodings.symbols);
+    size_t old_relocations = GetSizeVector(file->encodings.relocations);
+
+    if (SUCCESS != AppendWords(context->code_table,
+                               GetWords(file->code_table), prefix_code) ||
+        SUCCESS != AppendWords(context->code_table,
+                               GetWords(scratch.code_table),
+                               GetWordsNum(scratch.code_table)) ||
+        SUCCESS != AppendWords(context->code_table,
+                               GetWords(file->code_table) + old_code -
+                                   suffix_code,
+                               suffix_code) ||
+        SUCCESS != AppendWords(context->data_table,
+                               GetWords(file->data_table), prefix_data) ||
+        SUCCESS != AppendWords(context->data_table,
+                               GetWords(scratch.data_table),
+                               GetWordsNum(scratch.data_table)) ||
+        SUCCESS != AppendWords(context->data_table,
+                               GetWords(file->data_table) + old_data -
+                                   suffix_data,
+                               suffix_data) ||
+        SUCCESS != AppendElements(encodings.lines, file->encodings.lines, 0,
+                                  prefix) ||
+        SUCCESS != AppendElements(encodings.lines, changed.lines, 0,
+                                  GetSizeVector(changed.lines)) ||
+        SUCCESS != AppendElements(encodings.lines, file->encodings.lines,
+                                  old_lines - suffix, old_lines) ||
+        SUCCESS != AppendElements(encodings.symbols, file->encodings.symbols,
+                                  0, prefix_symbols) ||
+        SUCCESS != AppendElements(encodings.symbols, changed.symbols, 0,
+                                  GetSizeVector(changed.symbols)) ||
+        SUCCESS != AppendElements(encodings.symbols, file->encodings.symbols,
+                                  old_symbols - suffix_symbols,
+                                  old_symbols) ||
+        SUCCESS != AppendElements(encodings.relocations,
+                                  file->encodings.relocations, 0,
+                                  prefix_relocations) ||
+        SUCCESS != AppendElements(encodings.relocations,
+                                  changed.relocations, 0,
+                                  GetSizeVector(changed.relocations)) ||
+        SUCCESS != AppendElements(encodings.relocations,
+                                  file->encodings.relocations,
+                                  old_relocations - suffix_relocations,
+                                  old_relocations)) {
+      res = MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  if (SUCCESS == res) {
+    res = ResolveIncrementally(context, &encodings);
+  }
+
+  /* Keep the result for the next time */
+  if (SUCCESS == res) {
+    source_copy = CopySourceBuffer(context->source);
+    code_copy = CopyWordBuffer(context->code_table);
+    data_copy = CopyWordBuffer(context->data_table);
+    if (NULL == source_copy || NULL == code_copy || NULL == data_copy) {
+      res = MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  if (SUCCESS == res) {
+    DestroySourceBuffer(file->source);
+    DestroyWordBuffer(file->code_table);
+    DestroyWordBuffer(file->data_table);
+    DestroyLineEncodings(&file->encodings);
+    file->source = source_copy;
+    file->code_table = code_copy;
+    file->data_table = data_copy;
+    file->encodings = encodings;
+
+    state->encoded_lines += new_lines - prefix - suffix;
+    state->reused_lines += prefix + suffix;
+
+    CompactNames(file);
+
+    /* The warnings of the first pass, which errors would have come with */
+    cfg.stream = context->options->diagnostics;
+    for (i = 0; i < new_lines; ++i) {
+      line_record_t *record =
+          (line_record_t *)GetElementVector(encodings.lines, i);
+
+      if (record->warned) {
+        cfg.line_number = (unsigned int)i + 1;
+        WarnLabelBeforeReference(&cfg);
       }
     }
+  }
 
-    /*
-     * Handle instructions.
-     * Guaranteed to be an instruction statement.
-     */
-    else {
-      unsigned int register_operands_num = 0;
-      int i = 0;
-      ++IC;
+  else {
+    if (NULL != source_copy) {
+      DestroySourceBuffer(source_copy);
+    }
+    if (NULL != code_copy) {
+      DestroyWordBuffer(code_copy);
+    }
+    if (NULL != data_copy) {
+      DestroyWordBuffer(data_copy);
+    }
+    DestroyLineEncodings(&encodings);
+  }
+
+  DestroyLineEncodings(&changed);
+  DestroyAssemblyContext(&scratch);
+  return res;
+}
+
+/*
+ * @brief Encodes lines into a scratch context (see Reassemble), without
+ *        printing anything, and records them.
+ *
+ * @param first_line, last_line - The range of lines, last_line excluded.
+ *
+ * @return SUCCESS, FAILURE if a line has an error, or MEM_ALLOCATION_ERROR.
+ */
 
-      /* Skip the instruction to its operands */
-      current_word = strtok(NULL, DELIMITERS);
+static result_t EncodeChangedLines(assembly_context_t *scratch,
+                                   size_t first_line, size_t last_line,
+                                   line_recorder_t *recorder) {
+  syntax_check_config_t silent_cfg =
+      CreateSyntaxCheckConfig(scratch->file_path, 0, FALSE);
+  size_t i = 0;
 
-      while (NULL != current_word && i < 2) {
-        /* Read the operand */
-        addressing_method_t method = DetectAddressingMethod(current_word);
-        symbol_t *symbol = NULL;
+  for (i = first_line; i < last_line; ++i) {
+    bool_t warned = FALSE;
+    result_t res = EncodeLine(scratch, i, &silent_cfg, &warned);
 
-        if (DIRECT == method) {
-          symbol = FindSymbol(symbol_table, current_word);
-        }
+    if (SUCCESS == res) {
+      res = RecordLine(scratch, recorder, warned);
+    }
 
-        /* Symbol used but wasn't defined */
-        if (DIRECT == method &&
-            SymbolWasntDefined(current_word, symbol_table, &cfg)) {
-          total_errors++;
-        }
+    if (SUCCESS != res) {
+      return res;
+    }
+  }
 
-        /* Check if first operand is a symbol, if so update accordingly */
-        else if (DIRECT == method && NULL != symbol) {
-          bitmap_t *opcode_block = (bitmap_t *)GetElementVector(code_table, IC);
-          *opcode_block = GetSymbolAddress(symbol);
+  return SUCCESS;
+}
 
-          /* If its extern add the occurence to the list for the .ext file */
-          if (EXTERN == GetSymbolType(symbol)) {
-            AddExternalSymbolOccurence(ext_list, GetSymbolName(symbol),
-                                       IC + INITIAL_IC_VALUE);
-          }
-        }
+/*
+ * @brief Builds a context's symbol table from the symbols of its lines, and
+ *        resolves their references, as both passes would. The context's
+ *        code table holds the lines' words, with the references of reused
+ *        lines resolved to where their symbols used to be.
+ *
+ * @return SUCCESS, FAILURE if the passes would report an error, or
+ *         MEM_ALLOCATION_ERROR.
+ */
+
+static result_t ResolveIncrementally(assembly_context_t *context,
+                                     line_encodings_t *encodings) {
+  symbol_table_t *symbol_table = context->symbol_table;
+  machine_word_t *code = GetWords(context->code_table);
+  size_t code_size = GetWordsNum(context->code_table);
+  size_t lines_num = GetSizeVector(encodings->lines);
+  size_t code_start = 0;
+  size_t data_start = 0;
+  size_t symbol_index = 0;
+  size_t relocation_index = 0;
+  size_t i = 0;
+  size_t j = 0;
+  syntax_check_config_t silent_cfg = CreateSyntaxCheckConfig(NULL, 0, FALSE);
+
+  /* Symbols, in the order the first pass would define them */
+  for (i = 0; i < lines_num; ++i) {
+    line_record_t *record =
+        (line_record_t *)GetElementVector(encodings->lines, i);
+
+    for (j = 0; j < record->symbols_num; ++j, ++symbol_index) {
+      line_symbol_t *symbol =
+          (line_symbol_t *)GetElementVector(encodings->symbols, symbol_index);
+      result_t res = SUCCESS;
+
+      /* Clashes with other lines, or with a macro */
+      if (NULL != FindSymbol(symbol_table, symbol->name) ||
+          SymbolUsedAsAMacro(symbol->name, context->macro_table,
+                             &silent_cfg)) {
+        return FAILURE;
+      }
+
+      if (EXTERN == symbol->type) {
+        res = AddExternalSymbol(symbol_table, symbol->name);
+      } else if (CODE == symbol->area) {
+        res = AddSymbol(symbol_table, symbol->name,
+                        (address_t)(INITIAL_IC_VALUE + code_start +
+                                    symbol->offset),
+                        CODE);
+      } else {
+        res = AddSymbol(symbol_table, symbol->name,
+                        (address_t)(INITIAL_IC_VALUE + code_size +
+                                    data_start + symbol->offset),
+                        DATA);
+      }
+
+      if (SUCCESS != res) {
+        return MEM_ALLOCATION_ERROR;
+      }
+    }
+
+    code_start += record->code_words;
+    data_start += record->data_words;
+  }
 
-        else if (DIRECT_REGISTER == method || INDIRECT_REGISTER == method) {
-          ++register_operands_num;
+  /* References */
+  code_start = 0;
+  for (i = 0; i < lines_num; ++i) {
+    line_record_t *record =
+        (line_record_t *)GetElementVector(encodings->lines, i);
+
+    for (j = 0; j < record->relocations_num; ++j, ++relocation_index) {
+      relocation_t *relocation = (relocation_t *)GetElementVector(
+          encodings->relocations, relocation_index);
+      symbol_t *symbol = FindSymbol(symbol_table, relocation->symbol_name);
+      size_t index = code_start + relocation->code_index;
+
+      if (ENTRY_REFERENCE == relocation->kind) {
+        if (NULL == symbol || EXTERN == GetSymbolType(symbol) ||
+            SymbolNameIsIllegal(relocation->symbol_name, &silent_cfg)) {
+          return FAILURE;
         }
 
-        /* Skip to next operand */
-        current_word = strtok(NULL, DELIMITERS);
-        ++i;
-        ++IC;
+        ChangeSymbolToEntry(symbol_table, relocation->symbol_name);
+        continue;
+      }
+
+      if (NULL == symbol) {
+        return FAILURE;
       }
-      if (2 == register_operands_num) {
-        --IC;
+
+      code[index] = (machine_word_t)GetSymbolAddress(symbol);
+
+      if (EXTERN == GetSymbolType(symbol) &&
+          SUCCESS != AddExternalSymbolOccurence(
+                         context->ext_list, GetSymbolName(symbol),
+                         (unsigned int)(index + INITIAL_IC_VALUE))) {
+        return MEM_ALLOCATION_ERROR;
       }
     }
+
+    code_start += record->code_words;
   }
 
-  fclose(input_file);
-  free(current_line);
-  if (0 == total_errors) {
-    return SUCCESS;
+  return SUCCESS;
+}
+
+/*
+ * @brief Returns the entry of a file in an incremental state, adding an
+ *        empty one if it has none. If the state is full, the entry of the
+ *        file assembled least recently is replaced.
+ *
+ * @return The entry, or NULL upon a memory allocation error.
+ */
+
+static assembled_file_t *FindAssembledFile(incremental_state_t *state,
+                                           const char *file_path) {
+  assembled_file_t file;
+  assembled_file_t *oldest = NULL;
+  size_t i = 0;
+
+  ++state->clock;
+
+  for (i = 0; i < GetSizeVector(state->files); ++i) {
+    assembled_file_t *existing =
+        (assembled_file_t *)GetElementVector(state->files, i);
+
+    if (0 == strcmp(existing->file_path, file_path)) {
+      existing->last_used = state->clock;
+      return existing;
+    }
+
+    if (NULL == oldest || existing->last_used < oldest->last_used) {
+      oldest = existing;
+    }
   }
-  return FAILURE;
+
+  memset(&file, 0, sizeof(file));
+  file.file_path = (char *)malloc(strlen(file_path) + 1);
+  if (NULL == file.file_path) {
+    return NULL;
+  }
+  strcpy(file.file_path, file_path);
+  file.last_used = state->clock;
+
+  if (GetSizeVector(state->files) >= state->max_files) {
+    ClearAssembledFile(oldest);
+    free(oldest->file_path);
+    *oldest = file;
+    return oldest;
+  }
+
+  if (SUCCESS != AppendVector(state->files, &file)) {
+    free(file.file_path);
+    return NULL;
+  }
+
+  return (assembled_file_t *)GetElementVector(state->files, i);
 }
 
-result_t AssembleFile(char *file_path, macro_table_t *macro_table) {
-  result_t res = SUCCESS;
-  bool_t no_errors = TRUE;
+/*
+ * @brief Releases the last assembling of a file, leaving an empty entry.
+ */
 
-  /* Symbol table which will be populated with symbols in first pass */
-  symbol_table_t *symbol_table = NULL;
+static void ClearAssembledFile(assembled_file_t *file) {
+  if (NULL != file->source) {
+    DestroySourceBuffer(file->source);
+  }
+  if (NULL != file->code_table) {
+    DestroyWordBuffer(file->code_table);
+  }
+  if (NULL != file->data_table) {
+    DestroyWordBuffer(file->data_table);
+  }
+  if (NULL != file->names) {
+    DestroyStringPool(file->names);
+  }
+  DestroyLineEncodings(&file->encodings);
 
-  /* Two vectors for holding machine code for code & data segments,
-   * respectively. */
-  vector_t *code_table = NULL;
-  vector_t *data_table = NULL;
+  file->source = NULL;
+  file->code_table = NULL;
+  file->data_table = NULL;
+  file->names = NULL;
+}
 
-  /* List which will holds all places where an external symbol is used */
-  ext_symbol_occurrences_t *ext_list = NULL;
+/*
+ * @brief Rebuilds the pool of a file's names once most of its names are no
+ *        longer referred to by its lines (e.g. names of lines edited away),
+ *        so it doesn't grow with every reassembling. If there isn't enough
+ *        memory to rebuild it, the pool is kept as it is.
+ */
 
-  /*
-   * Acquiring resources
-   */
+static void CompactNames(assembled_file_t *file) {
+  size_t symbols_num = GetSizeVector(file->encodings.symbols);
+  size_t relocations_num = GetSizeVector(file->encodings.relocations);
+  size_t names_num = GetStringPoolSize(file->names);
+  string_pool_t *names = NULL;
+  size_t i = 0;
 
-  ext_list = CreateExternalSymbolList();
-  if (NULL == ext_list) {
-    fprintf(
-        stderr,
-        "Memory allocation error: couldn't allocate ext. symbol usage list\n");
-    return MEM_ALLOCATION_ERROR;
+  if (names_num < MIN_NAMES_TO_COMPACT ||
+      names_num <= 2 * (symbols_num + relocations_num)) {
+    return;
   }
 
-  symbol_table = CreateSymbolTable();
-  if (NULL == symbol_table) {
-    fprintf(stderr,
-            "Memory allocation error: couldn't allocate a symbol table\n");
-    DestroyExternSymbolList(ext_list);
-    return MEM_ALLOCATION_ERROR;
+  names = CreateStringPool(NULL);
+  if (NULL == names) {
+    return;
   }
 
-  code_table = CreateVector(10, sizeof(vector_t *));
-  if (NULL == code_table) {
-    fprintf(stderr,
-            "Memory allocation error: couldn't allocate a code table\n");
-    DestroyExternSymbolList(ext_list);
-    DestroySymbolTable(symbol_table);
-    return MEM_ALLOCATION_ERROR;
+  /* Every name is interned before any is replaced, so a failure leaves the
+   * encodings as they are */
+  for (i = 0; i < symbols_num; ++i) {
+    line_symbol_t *symbol =
+        (line_symbol_t *)GetElementVector(file->encodings.symbols, i);
+
+    if (NULL == InternString(names, symbol->name)) {
+      DestroyStringPool(names);
+      return;
+    }
   }
+  for (i = 0; i < relocations_num; ++i) {
+    relocation_t *relocation =
+        (relocation_t *)GetElementVector(file->encodings.relocations, i);
 
-  data_table = CreateVector(10, sizeof(vector_t *));
-  if (NULL == data_table) {
-    fprintf(stderr,
-            "Memory allocation error: couldn't allocate a data table\n");
-    DestroyExternSymbolList(ext_list);
-    DestroySymbolTable(symbol_table);
-    DestroyVector(code_table);
+    if (NULL == InternString(names, relocation->symbol_name)) {
+      DestroyStringPool(names);
+      return;
+    }
+  }
+
+  /* Names which are interned already are found without allocating */
+  for (i = 0; i < symbols_num; ++i) {
+    line_symbol_t *symbol =
+        (line_symbol_t *)GetElementVector(file->encodings.symbols, i);
+
+    symbol->name = FindInternedString(names, symbol->name);
+  }
+  for (i = 0; i < relocations_num; ++i) {
+    relocation_t *relocation =
+        (relocation_t *)GetElementVector(file->encodings.relocations, i);
+
+    relocation->symbol_name = FindInternedString(names,
+                                                 relocation->symbol_name);
+  }
+
+  DestroyStringPool(file->names);
+  file->names = names;
+}
+
+static result_t CreateLineEncodings(line_encodings_t *encodings) {
+  encodings->lines = CreateVector(64, sizeof(line_record_t));
+  encodings->symbols = CreateVector(16, sizeof(line_symbol_t));
+  encodings->relocations = CreateVector(16, sizeof(relocation_t));
+
+  if (NULL == encodings->lines || NULL == encodings->symbols ||
+      NULL == encodings->relocations) {
+    DestroyLineEncodings(encodings);
     return MEM_ALLOCATION_ERROR;
   }
 
-  /*
-   * Assembler performing first & second pass
-   */
-  res = FirstPass(file_path, macro_table, symbol_table, code_table, data_table);
-  if (ERROR_OPENING_FILE == res) {
-    DestroyExternSymbolList(ext_list);
-    DestroySymbolTable(symbol_table);
-    DestroyVector(code_table);
-    DestroyVector(data_table);
-    return ERROR_OPENING_FILE;
+  return SUCCESS;
+}
+
+/*
+ * @brief Releases line encodings (some of whose vectors may be NULL).
+ */
+
+static void DestroyLineEncodings(line_encodings_t *encodings) {
+  if (NULL != encodings->lines) {
+    DestroyVector(encodings->lines);
+  }
+  if (NULL != encodings->symbols) {
+    DestroyVector(encodings->symbols);
+  }
+  if (NULL != encodings->relocations) {
+    DestroyVector(encodings->relocations);
   }
 
-  if (SUCCESS != res) {
-    no_errors = FALSE;
+  encodings->lines = NULL;
+  encodings->symbols = NULL;
+  encodings->relocations = NULL;
+}
+
+/*
+ * @brief Appends the elements of a vector in [first, last) to another.
+ */
+
+static result_t AppendElements(vector_t *to, vector_t *from, size_t first,
+                               size_t last) {
+  for (; first < last; ++first) {
+    if (SUCCESS != AppendVector(to, GetElementVector(from, first))) {
+      return MEM_ALLOCATION_ERROR;
+    }
   }
 
-  if (SUCCESS != SecondPass(file_path, symbol_table, code_table, ext_list)) {
-    no_errors = FALSE;
+  return SUCCESS;
+}
+
+static result_t AppendWords(word_buffer_t *to, const machine_word_t *words,
+                            size_t words_num) {
+  size_t i = 0;
+
+  for (i = 0; i < words_num; ++i) {
+    if (SUCCESS != APPEND_WORD(to, words[i])) {
+      return MEM_ALLOCATION_ERROR;
+    }
   }
 
-  /*
-   * Generating output files
-   */
-  if (no_errors &&
-      SUCCESS != GenerateOutputFiles(code_table, data_table, symbol_table,
-                                     file_path, ext_list)) {
-    no_errors = FALSE;
+  return SUCCESS;
+}
+
+/*
+ * @return A copy of a word buffer, or NULL upon a memory allocation error.
+ */
+
+static word_buffer_t *CopyWordBuffer(word_buffer_t *from) {
+  word_buffer_t *copy = CreateWordBuffer(GetWordsNum(from));
+
+  if (NULL != copy &&
+      SUCCESS != AppendWords(copy, GetWords(from), GetWordsNum(from))) {
+    DestroyWordBuffer(copy);
+    copy = NULL;
+  }
+
+  return copy;
+}
+
+/*
+ * @return A copy of a source buffer, or NULL upon a memory allocation error.
+ */
+
+static source_buffer_t *CopySourceBuffer(const source_buffer_t *source) {
+  size_t size = 0;
+  const char *text = GetSourceText(source, &size);
+  source_buffer_t *copy = CreateSourceBuffer();
+
+  if (NULL != copy && SUCCESS != AppendSourceText(copy, text, size)) {
+    DestroySourceBuffer(copy);
+    copy = NULL;
   }
 
-  DestroyExternSymbolList(ext_list);
-  DestroySymbolTable(symbol_table);
-  DestroyVector(code_table);
-  DestroyVector(data_table);
-  return no_errors ? SUCCESS : FAILURE;
+  return copy;
+}
+
+/*
+ * @brief Tells if a line of one source is the same as a line of another.
+ */
+
+static bool_t SameLine(const source_buffer_t *source1, size_t index1,
+                       const source_buffer_t *source2, size_t index2) {
+  size_t length1 = 0;
+  size_t length2 = 0;
+  const char *line1 = GetLine(source1, index1, &length1);
+  const char *line2 = GetLine(source2, index2, &length2);
+
+  return (length1 == length2 && 0 == memcmp(line1, line2, length1))
+             ? TRUE : FALSE;
 }
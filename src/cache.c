@@ -0,0 +1,498 @@
+/* cache.c
+ *
+ * This module implements the on-disk cache of assembling results (see
+ * cache.h).
+ */
+
+#define _POSIX_C_SOURCE 200112L /* mkdir, getpid, pthreads */
+
+#include <stdio.h> /* fopen, fread, fwrite, rename, remove */
+#include <stdlib.h> /* malloc, free */
+#include <string.h> /* strlen, strcpy, memcmp */
+#include <errno.h>
+#include <unistd.h> /* getpid, rmdir */
+#include <sys/types.h>
+#include <sys/stat.h> /* mkdir */
+#include <pthread.h>
+#include "cache.h"
+#include "assembler.h"
+#include "string_utils.h"
+
+#define MAX_CACHE_PATH_LENGTH (1024)
+/* Leaves room for the name of a file within an entry */
+#define MAX_ENTRY_PATH_LENGTH (MAX_CACHE_PATH_LENGTH - 32)
+#define MAX_KEY_HEADER_LENGTH (128)
+#define KEY_FILE "key"
+#define MESSAGES_FILE "messages"
+
+/* In cached messages, the output path (e.g. in "file /dir/prog.am") is
+ * replaced by the marker followed by 'p', and a marker byte of the messages
+ * themselves is doubled */
+#define PATH_MARKER '\001'
+#define PATH_MARKER_PATH 'p'
+
+/* Output files kept in an entry, named after their extension */
+static const char *output_extensions[] = {".am", ".ob", ".ent", ".ext", ".obj"};
+
+#define OUTPUT_EXTENSIONS_NUM \
+  (sizeof(output_extensions) / sizeof(output_extensions[0]))
+
+struct cache {
+  char *path;
+  unsigned long hits;
+  unsigned long misses;
+  unsigned long temporaries; /* Names temporary entries uniquely */
+  pthread_mutex_t lock;
+};
+
+static size_t FormatKeyHeader(char *header, unsigned int variant,
+                              size_t size);
+
+static void FormatEntryPath(const cache_t *cache, const char *header,
+                            size_t header_length, const char *text,
+                            size_t size, char *entry_path);
+
+static bool_t KeyMatches(const char *key_path, const char *header,
+                         size_t header_length, const char *text,
+                         size_t size);
+
+static result_t CopyFile(const char *from_path, const char *to_path);
+
+static result_t CopyStream(FILE *from, FILE *to, long length);
+
+static result_t StoreMessages(FILE *from, long length, FILE *to,
+                              const char *output_base);
+
+static void RestoreMessages(FILE *from, FILE *to, const char *output_base);
+
+static bool_t FileExists(const char *path);
+
+static void RemoveEntryDirectory(const char *entry_path);
+
+static void CountLookup(cache_t *cache, bool_t hit);
+
+cache_t *OpenCache(const char *path) {
+  cache_t *cache = NULL;
+
+  /* Leaves room for the names of entries & their files */
+  if (MAX_ENTRY_PATH_LENGTH - 32 < strlen(path)) {
+    fprintf(stderr, "Cache path '%s' is too long\n", path);
+    return NULL;
+  }
+
+  if (0 != mkdir(path, 0777) && EEXIST != errno) {
+    perror("Couldn't create the cache directory");
+    return NULL;
+  }
+
+  cache = (cache_t *)malloc(sizeof(cache_t));
+  if (NULL == cache) {
+    perror("Couldn't allocate memory for the cache");
+    return NULL;
+  }
+
+  cache->path = StrDup(path);
+  if (NULL == cache->path) {
+    perror("Couldn't allocate memory for the cache");
+    free(cache);
+    return NULL;
+  }
+
+  cache->hits = 0;
+  cache->misses = 0;
+  cache->temporaries = 0;
+  pthread_mutex_init(&cache->lock, NULL);
+  return cache;
+}
+
+void CloseCache(cache_t *cache) {
+  pthread_mutex_destroy(&cache->lock);
+  free(cache->path);
+  free(cache);
+}
+
+bool_t RestoreFromCache(cache_t *cache,
+                        const char *text,
+                        size_t size,
+                        unsigned int variant,
+                        const char *output_base,
+                        FILE *diagnostics) {
+  char header[MAX_KEY_HEADER_LENGTH];
+  char entry_path[MAX_ENTRY_PATH_LENGTH];
+  char cached_path[MAX_CACHE_PATH_LENGTH];
+  char output_path[MAX_CACHE_PATH_LENGTH];
+  size_t header_length = FormatKeyHeader(header, variant, size);
+  FILE *messages = NULL;
+  size_t i = 0;
+
+  FormatEntryPath(cache, header, header_length, text, size, entry_path);
+
+  sprintf(cached_path, "%s/%s", entry_path, KEY_FILE);
+  if (FALSE == KeyMatches(cached_path, header, header_length, text, size) ||
+      strlen(output_base) + 8 > sizeof(output_path)) {
+    CountLookup(cache, FALSE);
+    return FALSE;
+  }
+
+  /* Materialize exactly the outputs which were cached */
+  RemoveOutputFiles(output_base);
+  for (i = 0; i < OUTPUT_EXTENSIONS_NUM; ++i) {
+    sprintf(cached_path, "%s/%s", entry_path, output_extensions[i] + 1);
+    sprintf(output_path, "%s%s", output_base, output_extensions[i]);
+
+    if (FileExists(cached_path) &&
+        SUCCESS != CopyFile(cached_path, output_path)) {
+      RemoveOutputFiles(output_base);
+      CountLookup(cache, FALSE);
+      return FALSE;
+    }
+  }
+
+  sprintf(cached_path, "%s/%s", entry_path, MESSAGES_FILE);
+  messages = fopen(cached_path, "rb");
+  if (NULL != messages) {
+    RestoreMessages(messages, diagnostics, output_base);
+    fclose(messages);
+  }
+
+  CountLookup(cache, TRUE);
+  return TRUE;
+}
+
+void RemoveOutputFiles(const char *output_base) {
+  char output_path[MAX_CACHE_PATH_LENGTH];
+  size_t i = 0;
+
+  if (strlen(output_base) + 8 > sizeof(output_path)) {
+    return;
+  }
+
+  for (i = 0; i < OUTPUT_EXTENSIONS_NUM; ++i) {
+    sprintf(output_path, "%s%s", output_base, output_extensions[i]);
+    remove(output_path);
+  }
+}
+
+result_t StoreInCache(cache_t *cache,
+                      const char *text,
+                      size_t size,
+                      unsigned int variant,
+                      const char *output_base,
+                      FILE *messages) {
+  char header[MAX_KEY_HEADER_LENGTH];
+  char entry_path[MAX_ENTRY_PATH_LENGTH];
+  char temp_path[MAX_ENTRY_PATH_LENGTH];
+  char path[MAX_CACHE_PATH_LENGTH];
+  char output_path[MAX_CACHE_PATH_LENGTH];
+  size_t header_length = FormatKeyHeader(header, variant, size);
+  unsigned long temporary = 0;
+  long messages_length = ftell(messages);
+  FILE *file = NULL;
+  result_t res = SUCCESS;
+  size_t i = 0;
+
+  if (strlen(output_base) + 8 > sizeof(output_path)) {
+    return FAILURE;
+  }
+
+  FormatEntryPath(cache, header, header_length, text, size, entry_path);
+
+  /* Another process or thread may have stored it meanwhile */
+  if (FileExists(entry_path)) {
+    return SUCCESS;
+  }
+
+  pthread_mutex_lock(&cache->lock);
+  temporary = cache->temporaries++;
+  pthread_mutex_unlock(&cache->lock);
+
+  sprintf(temp_path, "%s/tmp.%ld.%lu", cache->path, (long)getpid(),
+          temporary);
+  if (0 != mkdir(temp_path, 0777)) {
+    perror("Couldn't create a cache entry");
+    return ERROR_OPENING_FILE;
+  }
+
+  /* The key: header & the whole source */
+  sprintf(path, "%s/%s", temp_path, KEY_FILE);
+  file = fopen(path, "wb");
+  if (NULL == file ||
+      header_length != fwrite(header, 1, header_length, file) ||
+      size != fwrite(text, 1, size, file)) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+  if (NULL != file && 0 != fclose(file)) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  /* Messages */
+  sprintf(path, "%s/%s", temp_path, MESSAGES_FILE);
+  file = (SUCCESS == res) ? fopen(path, "wb") : NULL;
+  if (NULL == file) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+  else {
+    rewind(messages);
+    if (SUCCESS != StoreMessages(messages, messages_length, file,
+                                 output_base)) {
+      res = ERROR_WRITING_TO_FILE;
+    }
+    if (0 != fclose(file)) {
+      res = ERROR_WRITING_TO_FILE;
+    }
+  }
+
+  /* Outputs */
+  for (i = 0; SUCCESS == res && i < OUTPUT_EXTENSIONS_NUM; ++i) {
+    sprintf(output_path, "%s%s", output_base, output_extensions[i]);
+    sprintf(path, "%s/%s", temp_path, output_extensions[i] + 1);
+
+    if (FileExists(output_path)) {
+      res = CopyFile(output_path, path);
+    }
+  }
+
+  /* Publish the entry at once. If it exists already, ours is redundant */
+  if (SUCCESS != res || 0 != rename(temp_path, entry_path)) {
+    RemoveEntryDirectory(temp_path);
+  }
+
+  return res;
+}
+
+void GetCacheStats(cache_t *cache, unsigned long *hits, unsigned long *misses) {
+  pthread_mutex_lock(&cache->lock);
+  *hits = cache->hits;
+  *misses = cache->misses;
+  pthread_mutex_unlock(&cache->lock);
+}
+
+/*
+ * @brief Formats the header of a key, which precedes the source in it.
+ *
+ * @return The length of the header.
+ */
+
+static size_t FormatKeyHeader(char *header, unsigned int variant,
+                              size_t size) {
+  sprintf(header, "assembler %s variant %u size %lu\n", ASSEMBLER_VERSION,
+          variant, (unsigned long)size);
+  return strlen(header);
+}
+
+/*
+ * @brief Formats the path of the entry of a key: the cache directory, and
+ *        the key's hash & size.
+ */
+
+static void FormatEntryPath(const cache_t *cache, const char *header,
+                            size_t header_length, const char *text,
+                            size_t size, char *entry_path) {
+  unsigned long hash = HashBytes(header, header_length, 0);
+
+  hash = HashBytes(text, size, hash);
+  sprintf(entry_path, "%s/%08lx-%lx", cache->path, hash,
+          (unsigned long)size);
+}
+
+/*
+ * @brief Tells if the key stored in an entry is exactly the given one, so
+ *        a hash collision is never mistaken for a hit.
+ */
+
+static bool_t KeyMatches(const char *key_path, const char *header,
+                         size_t header_length, const char *text,
+                         size_t size) {
+  char buffer[4096];
+  FILE *key = fopen(key_path, "rb");
+  bool_t matches = TRUE;
+  size_t offset = 0;
+
+  if (NULL == key) {
+    return FALSE;
+  }
+
+  if (header_length != fread(buffer, 1, header_length, key) ||
+      0 != memcmp(buffer, header, header_length)) {
+    matches = FALSE;
+  }
+
+  while (matches && offset < size) {
+    size_t chunk = (size - offset < sizeof(buffer)) ? size - offset
+                                                     : sizeof(buffer);
+
+    if (chunk != fread(buffer, 1, chunk, key) ||
+        0 != memcmp(buffer, text + offset, chunk)) {
+      matches = FALSE;
+    }
+    offset += chunk;
+  }
+
+  /* Nothing may follow */
+  if (matches && EOF != fgetc(key)) {
+    matches = FALSE;
+  }
+
+  fclose(key);
+  return matches;
+}
+
+static result_t CopyFile(const char *from_path, const char *to_path) {
+  FILE *from = fopen(from_path, "rb");
+  FILE *to = NULL;
+  result_t res = SUCCESS;
+
+  if (NULL == from) {
+    return ERROR_OPENING_FILE;
+  }
+
+  to = fopen(to_path, "wb");
+  if (NULL == to) {
+    fclose(from);
+    return ERROR_OPENING_FILE;
+  }
+
+  res = CopyStream(from, to, -1);
+  fclose(from);
+  if (0 != fclose(to)) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  return res;
+}
+
+/*
+ * @brief Copies 'length' bytes (or everything, if it's negative) from the
+ *        current position of a stream to another.
+ */
+
+static result_t CopyStream(FILE *from, FILE *to, long length) {
+  char buffer[4096];
+  size_t read_size = 0;
+
+  while (0 != length) {
+    size_t chunk = (0 > length || (unsigned long)length > sizeof(buffer))
+                   ? sizeof(buffer) : (size_t)length;
+
+    read_size = fread(buffer, 1, chunk, from);
+    if (0 == read_size) {
+      break;
+    }
+    if (read_size != fwrite(buffer, 1, read_size, to)) {
+      return ERROR_WRITING_TO_FILE;
+    }
+    if (0 < length) {
+      length -= (long)read_size;
+    }
+  }
+
+  return (0 < length) ? FAILURE : SUCCESS;
+}
+
+/*
+ * @brief Copies 'length' bytes of messages from the current position of a
+ *        stream to a cached messages file, marking the output path in them
+ *        (see PATH_MARKER).
+ */
+
+static result_t StoreMessages(FILE *from, long length, FILE *to,
+                              const char *output_base) {
+  size_t base_length = strlen(output_base);
+  char *text = NULL;
+  size_t i = 0;
+  result_t res = SUCCESS;
+
+  if (0 >= length) {
+    return SUCCESS;
+  }
+
+  text = (char *)malloc((size_t)length);
+  if (NULL == text) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  if ((size_t)length != fread(text, 1, (size_t)length, from)) {
+    free(text);
+    return FAILURE;
+  }
+
+  while (SUCCESS == res && i < (size_t)length) {
+    if (0 < base_length && base_length <= (size_t)length - i &&
+        0 == memcmp(text + i, output_base, base_length)) {
+      res = (EOF == fputc(PATH_MARKER, to) ||
+             EOF == fputc(PATH_MARKER_PATH, to)) ? ERROR_WRITING_TO_FILE
+                                                 : SUCCESS;
+      i += base_length;
+      continue;
+    }
+
+    if (PATH_MARKER == text[i] && EOF == fputc(PATH_MARKER, to)) {
+      res = ERROR_WRITING_TO_FILE;
+    }
+    if (EOF == fputc(text[i], to)) {
+      res = ERROR_WRITING_TO_FILE;
+    }
+    ++i;
+  }
+
+  free(text);
+  return res;
+}
+
+/*
+ * @brief Copies cached messages to a stream, with the output path of the
+ *        source at hand in place of the markers (see PATH_MARKER).
+ */
+
+static void RestoreMessages(FILE *from, FILE *to, const char *output_base) {
+  int c = 0;
+
+  while (EOF != (c = fgetc(from))) {
+    if (PATH_MARKER == c) {
+      c = fgetc(from);
+      if (PATH_MARKER_PATH == c) {
+        fputs(output_base, to);
+        continue;
+      }
+    }
+
+    if (EOF != c) {
+      fputc(c, to);
+    }
+  }
+}
+
+static bool_t FileExists(const char *path) {
+  struct stat info;
+  return (0 == stat(path, &info)) ? TRUE : FALSE;
+}
+
+/*
+ * @brief Removes an entry's directory, along with any files it may hold.
+ */
+
+static void RemoveEntryDirectory(const char *entry_path) {
+  char path[MAX_CACHE_PATH_LENGTH];
+  size_t i = 0;
+
+  sprintf(path, "%s/%s", entry_path, KEY_FILE);
+  remove(path);
+  sprintf(path, "%s/%s", entry_path, MESSAGES_FILE);
+  remove(path);
+  for (i = 0; i < OUTPUT_EXTENSIONS_NUM; ++i) {
+    sprintf(path, "%s/%s", entry_path, output_extensions[i] + 1);
+    remove(path);
+  }
+
+  rmdir(entry_path);
+}
+
+static void CountLookup(cache_t *cache, bool_t hit) {
+  pthread_mutex_lock(&cache->lock);
+  if (hit) {
+    ++cache->hits;
+  } else {
+    ++cache->misses;
+  }
+  pthread_mutex_unlock(&cache->lock);
+}
@@ -10,9 +10,8 @@
 #include "macro_table.h"
 #include "generate_opcode.h"
 #include "language_definitions.h"
-#include "vector.h"
-
-#define delimiters (", /n/t/r")
+#include "word_buffer.h"
+#include "lexer.h"
 
 static instruction_t FindInstruction(const char *instruction_name,
                                       int *instruction_number);
@@ -26,41 +25,47 @@ static bool_t AreTwoRegitserOperands (operand_t *src_operand, operand_t *dest_op
 #define MOVE_OPCODE_TO_PLACE(X) ((X) << 11)
 #define BIT_MASK_15_BITS (0x7FFF)
 
-result_t DataDirectiveToMachinecode(vector_t *data_table, char *params) {
-  char *current_word = strtok(params, delimiters);
+result_t DataDirectiveToMachinecode(word_buffer_t *data_table,
+                                    const char *params) {
+  lexer_t lexer;
+  token_t token;
+
+  InitLexer(&lexer, params, strlen(params));
 
-  while (NULL != current_word) {
-    bitmap_t data_to_write = atoi(current_word) & BIT_MASK_15_BITS;
-    if (MEM_ALLOCATION_ERROR == AppendVector(data_table, &data_to_write)) {
+  /* atoi stops at the end of the number, so the token needn't be copied */
+  for (token = NextWord(&lexer); END_TOKEN != token.kind;
+       token = NextWord(&lexer)) {
+    bitmap_t data_to_write = atoi(token.start) & BIT_MASK_15_BITS;
+    if (MEM_ALLOCATION_ERROR == APPEND_WORD(data_table, data_to_write)) {
       return MEM_ALLOCATION_ERROR;
     }
-    current_word = strtok (NULL, delimiters);  
   }
 
   return SUCCESS;
 }
 
-result_t StringDirectiveToMachinecode(vector_t *data_table, char *string) {
+result_t StringDirectiveToMachinecode(word_buffer_t *data_table,
+                                      const char *string) {
 
   /* Skip the begining quoation marks */
   string++; 
   while ('\0' != *(string + 1)) { /* Skip the end quoation marks */
     bitmap_t data_to_write = *string & BIT_MASK_15_BITS;
-    if (MEM_ALLOCATION_ERROR == AppendVector(data_table, &data_to_write)) {
+    if (MEM_ALLOCATION_ERROR == APPEND_WORD(data_table, data_to_write)) {
       return MEM_ALLOCATION_ERROR;
     }
     string++;
   }
 
   /* Terminating character (\0) */
-  if (MEM_ALLOCATION_ERROR == AppendVector (data_table, (string + 1))) {
+  if (MEM_ALLOCATION_ERROR == APPEND_WORD(data_table, '\0')) {
     return MEM_ALLOCATION_ERROR;
   }
 
   return SUCCESS;
 }
 
-result_t InstructionStatementToMachinecode(vector_t *code_table,
+result_t InstructionStatementToMachinecode(word_buffer_t *code_table,
                                            const char *instruction,
                                            operand_t *source_operand,
                                            operand_t *dest_operand) {
@@ -80,7 +85,7 @@ result_t InstructionStatementToMachinecode(vector_t *code_table,
   instruction_opcode = SetBitAddressingMethod(instruction_opcode, dest_operand);
   instruction_opcode &= BIT_MASK_15_BITS;
 
-  if (MEM_ALLOCATION_ERROR == AppendVector(code_table, &instruction_opcode)) {
+  if (MEM_ALLOCATION_ERROR == APPEND_WORD(code_table, instruction_opcode)) {
     return MEM_ALLOCATION_ERROR;
   }
 
@@ -94,18 +99,18 @@ result_t InstructionStatementToMachinecode(vector_t *code_table,
       bitmap_t registers_block = UnifyRegisterOpcode(src_operand_opcode, dest_operand_opcode);
       registers_block &= BIT_MASK_15_BITS;
 
-      if (MEM_ALLOCATION_ERROR == AppendVector(code_table, &registers_block)) {
+      if (MEM_ALLOCATION_ERROR == APPEND_WORD(code_table, registers_block)) {
         return MEM_ALLOCATION_ERROR;
       }
     }
     /* At least one isn't a register, we encode two blocks. */
     else {
       src_operand_opcode &= BIT_MASK_15_BITS;
-      if (MEM_ALLOCATION_ERROR == AppendVector (code_table, &src_operand_opcode)) {
+      if (MEM_ALLOCATION_ERROR == APPEND_WORD(code_table, src_operand_opcode)) {
         return MEM_ALLOCATION_ERROR;
       }
       dest_operand_opcode &= BIT_MASK_15_BITS;
-      if (MEM_ALLOCATION_ERROR == AppendVector (code_table, &dest_operand_opcode)) {
+      if (MEM_ALLOCATION_ERROR == APPEND_WORD(code_table, dest_operand_opcode)) {
         return MEM_ALLOCATION_ERROR;
       }
     }
@@ -114,7 +119,7 @@ result_t InstructionStatementToMachinecode(vector_t *code_table,
   /* Handling coding when we have only one operand (always target) */
   else if (NULL != dest_operand) { 
     dest_operand_opcode = OperandToOpcode(dest_operand);
-    if (MEM_ALLOCATION_ERROR == AppendVector (code_table, &dest_operand_opcode)) {
+    if (MEM_ALLOCATION_ERROR == APPEND_WORD(code_table, dest_operand_opcode)) {
         return MEM_ALLOCATION_ERROR;
     }
   }
@@ -164,11 +169,7 @@ static bitmap_t SetBitOfARE (bitmap_t bitmap, encoding_type_t ARE){
 
 static instruction_t FindInstruction(const char *instruction_name,
                                      int *instruction_number) {
-  int i = 0;
-
-  while (0 != strcmp(reserved_instructions[i].name, instruction_name)) {
-    ++i;
-  }
+  int i = IdentifyReservedWord(instruction_name).index;
 
   *instruction_number = i;
 
@@ -9,9 +9,15 @@
  * that holds occurrences of external symbols for the .ext file.
  */
 
+#define _POSIX_C_SOURCE 200112L /* pthreads, mmap & ftruncate */
+
 #include <string.h> 
 #include <stdlib.h>
 #include <stdio.h>
+#include <pthread.h>
+#include <fcntl.h> /* open */
+#include <unistd.h> /* ftruncate, close */
+#include <sys/mman.h> /* mmap, munmap */
 #include "utils.h"
 #include "bitmap.h"
 #include "vector.h"
@@ -24,27 +30,166 @@
 
 #define BIT_MASK_15_BITS (0x7FFF)
 
-static result_t WriteHeader(char *output_path, int IC, int DC);
+/* The .ob file is formatted into a fixed buffer, which is written out
+ * whenever it fills up. A line is never longer than OB_MAX_LINE_LENGTH.
+ */
+#define OB_BUFFER_SIZE (1 << 15)
+#define OB_MAX_LINE_LENGTH (32)
+
+typedef struct {
+  FILE *file;
+  size_t size;
+  char data[OB_BUFFER_SIZE];
+} ob_buffer_t;
+
+/* A line of the .ob file is as long as the address (at least 4 digits), a
+ * space, 5 octal digits & a newline, so the size of the whole file is known
+ * before it's formatted. Big enough files are formatted by several threads,
+ * each writing its own lines straight into the mapped file; below
+ * OB_MIN_CHUNK_WORDS words per thread, starting them isn't worth it. */
+#define OB_LINE_LENGTH(address_digits) ((address_digits) + 7)
+#define OB_MIN_ADDRESS_DIGITS (4)
+#define OB_MIN_CHUNK_WORDS (1 << 15)
+
+/*
+ * Lines of a .ob file formatted by a thread (see GenerateOBJFileInParallel):
+ * those of words first_word to last_word (exclusive), counting the code's
+ * words & then the data's, starting at dest.
+ */
+
+typedef struct {
+  const machine_word_t *code;
+  size_t code_size;
+  const machine_word_t *data;
+  size_t first_word;
+  size_t last_word;
+  char *dest;
+  pthread_t thread;
+  bool_t started;
+} ob_chunk_t;
+
+/* Words of a spilled segment read at a time */
+#define SPILL_CHUNK_WORDS (4096)
+
+/* Uses of external symbols gathered in memory at a time, and spilled uses
+ * read at a time (see ForEachExternalReference) */
+#define EXT_GROUP_SIZE (1 << 16)
+#define EXT_READ_CHUNK (1024)
+
+/* Called for each use of an external symbol, in the order of the .ext file */
+typedef result_t (*ext_ref_func_t)(const spilled_external_t *external,
+                                   unsigned int address,
+                                   void *param);
+
+/* Writes the external references of a binary object file; the offset of
+ * the current symbol's name follows the names of the symbols before it */
+typedef struct {
+  FILE *file;
+  const spilled_external_t *external;
+  unsigned long name_offset;
+} ext_ref_writer_t;
+
+/* Two digit strings, "00" to "99" and octal "00" to "77", indexed by value */
+static const char decimal_pairs[] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+static const char octal_pairs[] =
+  "00010203040506071011121314151617"
+  "20212223242526273031323334353637"
+  "40414243444546475051525354555657"
+  "60616263646566677071727374757677";
+
+static char *FormatDecimal(char *dest, unsigned long value, int min_digits);
+static char *FormatOctalWord(char *dest, machine_word_t word);
+static result_t FlushObBuffer(ob_buffer_t *buffer);
+static result_t GenerateOBJFileInParallel(word_buffer_t *code_table,
+                                          word_buffer_t *data_table,
+                                          char *output_path,
+                                          unsigned int threads_num);
+static size_t ObLinesSize(unsigned long first_address,
+                          unsigned long end_address);
+static void *FormatObChunk(void *chunk);
+static result_t OpenObFile(ob_buffer_t *buffer,
+                           const char *output_path,
+                           size_t code_size,
+                           size_t data_size);
+static result_t CloseObFile(ob_buffer_t *buffer, result_t res);
+static result_t WriteObSegment(ob_buffer_t *buffer,
+                               const machine_word_t *words,
+                               size_t words_num,
+                               unsigned long *address);
+static result_t WriteSpilledObSegment(ob_buffer_t *buffer,
+                                      FILE *segment,
+                                      unsigned long *address);
+static result_t GenerateOBJFileFromSpill(spilled_output_t *output,
+                                         char *output_path);
+static result_t GenerateBinaryObjectFileFromSpill(spilled_output_t *output,
+                                                  symbol_table_t *symbol_table,
+                                                  char *output_path);
+static result_t WriteSpilledBinarySegment(FILE *obj_file, FILE *segment);
+static result_t GenerateExternFileFromSpill(spilled_output_t *output,
+                                            char *output_path);
+static result_t ForEachExternalReference(spilled_output_t *output,
+                                         ext_ref_func_t func,
+                                         void *param);
+static result_t WriteExternLine(const spilled_external_t *external,
+                                unsigned int address,
+                                void *extern_file);
+static result_t WriteBinaryExternalReference(const spilled_external_t *external,
+                                             unsigned int address,
+                                             void *writer);
+static result_t GenerateBinaryObjectFile(word_buffer_t *code_table,
+                                        word_buffer_t *data_table,
+                                        symbol_table_t *symbol_table,
+                                        ext_symbol_occurrences_t *ext_list,
+                                        char *output_path);
+static unsigned char *PutUint16(unsigned char *dest, unsigned long value);
+static unsigned char *PutUint32(unsigned char *dest, unsigned long value);
 static result_t GenerateEntriesFile(symbol_table_t *symbol_table, char *output_path);
-static result_t GenerateOBJFile(vector_t *code_opcode, vector_t *data_opcode, char *output_path);
+static result_t GenerateOBJFile(word_buffer_t *code_opcode, word_buffer_t *data_opcode, char *output_path);
 static result_t GenerateExternFile(char *output_path,ext_symbol_occurrences_t *external_symbol_data_list);
 static int ExternalSymbolCompare(void *value, void *key);
 
 ext_symbol_occurrences_t *CreateExternalSymbolList(void) {
-  ext_symbol_occurrences_t *ext_list = malloc(sizeof(ext_symbol_occurrences_t));
+  return CreateExternalSymbolListInArena(NULL, NULL);
+}
+
+ext_symbol_occurrences_t *CreateExternalSymbolListInArena(arena_t *arena,
+                                                          string_pool_t *names) {
+  ext_symbol_occurrences_t *ext_list =
+    ArenaAlloc(arena, sizeof(ext_symbol_occurrences_t));
 
   if (NULL == ext_list){
     perror ("Error: Couldn't allocate memory for external symbols lists\n");
     return NULL;
   }
 
-  ext_list->external_symbols = CreateList();
+  ext_list->external_symbols = CreateListInArena(arena);
   if (NULL == ext_list->external_symbols) {
     perror ("Error: Couldn't allocate memory for external symbols lists\n");
-    free(ext_list);
+    ArenaFree(arena, ext_list);
     return NULL;
   }
 
+  ext_list->owns_names = FALSE;
+  if (NULL == names) {
+    names = CreateStringPool(arena);
+    if (NULL == names) {
+      perror ("Error: Couldn't allocate memory for external symbols lists\n");
+      DestroyList(ext_list->external_symbols);
+      ArenaFree(arena, ext_list);
+      return NULL;
+    }
+    ext_list->owns_names = TRUE;
+  }
+
+  ext_list->arena = arena;
+  ext_list->names = names;
+
   return ext_list;
 }
 
@@ -52,39 +197,43 @@ result_t AddExternalSymbolOccurence(ext_symbol_occurrences_t *ext_symbol_occurre
                                     const char *symbol_name,
                                     unsigned int line) {
 
+  arena_t *arena = ext_symbol_occurrences->arena;
   external_symbol_data_t *external_symbol_data = NULL;
-  node_t *node = Find(ext_symbol_occurrences->external_symbols,
-                      ExternalSymbolCompare,
-                      (void *)symbol_name);
+  node_t *node = NULL;
+
+  /* Names are interned, so the list is searched by address. If symbol_name
+   * is interned in the same pool already (e.g. it's from the symbol table),
+   * it's found without comparing characters. */
+  symbol_name = InternString(ext_symbol_occurrences->names, symbol_name);
+  if (NULL == symbol_name) {
+    perror("Error interning name");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  node = Find(ext_symbol_occurrences->external_symbols,
+              ExternalSymbolCompare,
+              (void *)symbol_name);
 
   /* If this is the first occurrence */
   if (NULL == node) {
-    external_symbol_data = malloc(sizeof(external_symbol_data_t));
+    external_symbol_data = ArenaAlloc(arena, sizeof(external_symbol_data_t));
     if (NULL == external_symbol_data) {
       return MEM_ALLOCATION_ERROR;
     }
 
-    external_symbol_data->symbol_name = StrDup(symbol_name);
-    if (NULL == external_symbol_data->symbol_name) {
-      perror("Error duplicating name");
-      free(external_symbol_data);
-      return MEM_ALLOCATION_ERROR;
-    }
-
+    external_symbol_data->symbol_name = symbol_name;
     external_symbol_data->occurrences = CreateVector(3, sizeof(unsigned int));
     if (NULL == external_symbol_data->occurrences) {
       perror ("Error creating vector");
-      free((void *)external_symbol_data->symbol_name);
-      free(external_symbol_data);
+      ArenaFree(arena, external_symbol_data);
       return MEM_ALLOCATION_ERROR;
     }
 
     if (NULL == AddNode (ext_symbol_occurrences->external_symbols,
                          external_symbol_data)) {
       perror ("Error creating vector");
-      free((void *)external_symbol_data->symbol_name);
-      free(external_symbol_data->occurrences);
-      free(external_symbol_data);
+      DestroyVector(external_symbol_data->occurrences);
+      ArenaFree(arena, external_symbol_data);
       return MEM_ALLOCATION_ERROR;
     }
   }
@@ -103,26 +252,32 @@ result_t AddExternalSymbolOccurence(ext_symbol_occurrences_t *ext_symbol_occurre
 }
 
 void DestroyExternSymbolList(ext_symbol_occurrences_t *ext_symbol_occurrences) {
+  arena_t *arena = ext_symbol_occurrences->arena;
   external_symbol_data_t *external_symbol_data = NULL;
   node_t *node = GetHead(ext_symbol_occurrences->external_symbols);
 
   while (NULL != node) {
     external_symbol_data = GetValue(node);
     DestroyVector(external_symbol_data->occurrences);
-    free((void *)external_symbol_data->symbol_name);
-    free(external_symbol_data);
+    ArenaFree(arena, external_symbol_data);
     node = GetNext(node);
   }
 
+  if (ext_symbol_occurrences->owns_names) {
+    DestroyStringPool(ext_symbol_occurrences->names);
+  }
+
   DestroyList(ext_symbol_occurrences->external_symbols);
-  free(ext_symbol_occurrences);
+  ArenaFree(arena, ext_symbol_occurrences);
 }
 
-result_t GenerateOutputFiles(vector_t *code_table,
-                             vector_t *data_table,
+result_t GenerateOutputFiles(word_buffer_t *code_table,
+                             word_buffer_t *data_table,
                              symbol_table_t *symbol_table,
                              const char *input_path,
-                             ext_symbol_occurrences_t* ext_symbol_occurrences) {
+                             ext_symbol_occurrences_t* ext_symbol_occurrences,
+                             bool_t binary_object,
+                             unsigned int threads_num) {
 
   bool_t error_occurred = FALSE;
   char *path = NULL;
@@ -141,7 +296,16 @@ result_t GenerateOutputFiles(vector_t *code_table,
   /* Generate .ob file */
   strcpy(path + (length - 2), "ob");
 
-  if (SUCCESS != GenerateOBJFile(code_table, data_table, path)) {
+  if (SUCCESS != GenerateOBJFileInParallel(code_table, data_table, path,
+                                           threads_num)) {
+    error_occurred = TRUE;
+  }
+
+  /* Generate .obj file */
+  strcpy(path + (length - 2), "obj");
+  if (binary_object &&
+      SUCCESS != GenerateBinaryObjectFile(code_table, data_table, symbol_table,
+                                          ext_symbol_occurrences, path)) {
     error_occurred = TRUE;
   }
 
@@ -161,87 +325,790 @@ result_t GenerateOutputFiles(vector_t *code_table,
   return error_occurred ? FAILURE :SUCCESS;
 }
 
-static result_t GenerateOBJFile (vector_t *code_table,
-                                 vector_t *data_table,
+result_t GenerateOutputFilesFromSpill(spilled_output_t *output,
+                                      symbol_table_t *symbol_table,
+                                      const char *input_path,
+                                      bool_t binary_object) {
+  bool_t error_occurred = FALSE;
+  char *path = NULL;
+  size_t length = strlen(input_path);
+
+  /* Allocate memory for path + 4 extra bytes for extensions and \0 */
+  path = (char *)malloc((length + 4) * sizeof(char));
+  if (NULL == path) {
+    perror("Couldn't allocate string for output paths\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* Copy path except file extension */
+  strncpy(path, input_path, length - 2);
+
+  strcpy(path + (length - 2), "ob");
+  if (SUCCESS != GenerateOBJFileFromSpill(output, path)) {
+    error_occurred = TRUE;
+  }
+
+  strcpy(path + (length - 2), "obj");
+  if (binary_object &&
+      SUCCESS != GenerateBinaryObjectFileFromSpill(output, symbol_table,
+                                                   path)) {
+    error_occurred = TRUE;
+  }
+
+  strcpy(path + (length - 2), "ext");
+  if (SUCCESS != GenerateExternFileFromSpill(output, path)) {
+    error_occurred = TRUE;
+  }
+
+  /* The symbol table is in memory anyway */
+  strcpy(path + (length - 2), "ent");
+  if (SUCCESS != GenerateEntriesFile(symbol_table, path)) {
+    error_occurred = TRUE;
+  }
+
+  free(path);
+  return error_occurred ? FAILURE : SUCCESS;
+}
+
+result_t SpillExternalReference(spilled_output_t *output,
+                                const char *symbol_name,
+                                unsigned int address) {
+  spilled_external_t *external = NULL;
+  spilled_ext_ref_t reference;
+  size_t i = 0;
+
+  /* Names are interned, so they're compared by address */
+  for (i = 0; i < GetSizeVector(output->externals); ++i) {
+    external = (spilled_external_t *)GetElementVector(output->externals, i);
+    if (external->symbol_name == symbol_name) {
+      break;
+    }
+  }
+
+  /* If this is the first occurrence */
+  if (GetSizeVector(output->externals) == i) {
+    spilled_external_t new_external;
+
+    new_external.symbol_name = symbol_name;
+    new_external.references_num = 0;
+    if (SUCCESS != AppendVector(output->externals, &new_external)) {
+      perror("Error appending vector");
+      return MEM_ALLOCATION_ERROR;
+    }
+    external = (spilled_external_t *)GetElementVector(output->externals, i);
+  }
+
+  ++external->references_num;
+  reference.external_index = i;
+  reference.address = address;
+
+  if (1 != fwrite(&reference, sizeof(reference), 1, output->ext_refs)) {
+    perror("Error writing to file");
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  return SUCCESS;
+}
+
+static result_t GenerateOBJFile (word_buffer_t *code_table,
+                                 word_buffer_t *data_table,
                                  char *output_path) {
-  int cur_mem_address = INITIAL_IC_VALUE;
+  unsigned long address = INITIAL_IC_VALUE;
+  ob_buffer_t buffer;
+  result_t res = OpenObFile(&buffer, output_path, GetWordsNum(code_table),
+                            GetWordsNum(data_table));
+
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  /* First comes the code segment, then the data segment */
+  res = WriteObSegment(&buffer, GetWords(code_table), GetWordsNum(code_table),
+                       &address);
+  if (SUCCESS == res) {
+    res = WriteObSegment(&buffer, GetWords(data_table),
+                         GetWordsNum(data_table), &address);
+  }
+
+  return CloseObFile(&buffer, res);
+}
+
+/*
+ * @brief Same as GenerateOBJFile, with the lines split into chunks of
+ *        consecutive words, each formatted on a thread of its own (see
+ *        ob_chunk_t). The file is sized up front & mapped, so every chunk
+ *        writes at the offset of its first line, which follows from the
+ *        number of lines before it.
+ *
+ *        For too few words, a single thread, or if the file can't be
+ *        mapped, GenerateOBJFile runs instead.
+ *
+ * @param threads_num - Maximal number of threads to use.
+ */
+
+static result_t GenerateOBJFileInParallel(word_buffer_t *code_table,
+                                          word_buffer_t *data_table,
+                                          char *output_path,
+                                          unsigned int threads_num) {
+  size_t code_size = GetWordsNum(code_table);
+  size_t data_size = GetWordsNum(data_table);
+  size_t words_num = code_size + data_size;
+  size_t chunks_num = words_num / OB_MIN_CHUNK_WORDS;
+  ob_chunk_t *chunks = NULL;
+  char header[2 * 24];
+  size_t header_size = 0;
+  size_t file_size = 0;
+  char *mapping = NULL;
+  int fd = -1;
+  result_t res = SUCCESS;
   size_t i = 0;
-  /* .ob format is mainly 2 columns:
-   * (1) address - memory address, one word at a time */
-  char *address = (char *) malloc (15 * sizeof(char));
 
-  /* (2) bitmap - content of that memory address */
-  char *bitmap =  (char *) malloc (15 * sizeof(char));
-  char *str_to_write = (char *) malloc (15 * sizeof(char));
-  FILE *obj_file = NULL;
-  bitmap_t opcode_line = 0;
+  if (chunks_num > threads_num) {
+    chunks_num = threads_num;
+  }
+  if (2 > chunks_num) {
+    return GenerateOBJFile(code_table, data_table, output_path);
+  }
 
-  /* Before the 2 columns, we write total code & data symbols. */
-  if (SUCCESS != WriteHeader(output_path,
-                             GetSizeVector(code_table),
-                             GetSizeVector(data_table))) {
-    free (address);
-    free (bitmap);
-    free (str_to_write);
-    return FAILURE;
+  chunks = (ob_chunk_t *)calloc(chunks_num, sizeof(ob_chunk_t));
+  if (NULL == chunks) {
+    return GenerateOBJFile(code_table, data_table, output_path);
   }
 
-  obj_file = fopen(output_path, "a");
-  if (NULL == obj_file) {
-    free(address);
-    free(bitmap);
-    free(str_to_write);
+  /* Same first line as OpenObFile's */
+  header_size = FormatDecimal(header, code_size, 1) - header;
+  header[header_size++] = ' ';
+  header_size = FormatDecimal(header + header_size, data_size, 1) - header;
+  header[header_size++] = '\n';
+  file_size = header_size + ObLinesSize(INITIAL_IC_VALUE,
+                                        INITIAL_IC_VALUE + words_num);
+
+  fd = open(output_path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (0 <= fd && 0 == ftruncate(fd, (off_t)file_size)) {
+    mapping = (char *)mmap(NULL, file_size, PROT_READ | PROT_WRITE,
+                           MAP_SHARED, fd, 0);
+  }
+  if (NULL == mapping || MAP_FAILED == (void *)mapping) {
+    if (0 <= fd) {
+      close(fd);
+    }
+    free(chunks);
+    return GenerateOBJFile(code_table, data_table, output_path);
+  }
+
+  memcpy(mapping, header, header_size);
+  for (i = 0; i < chunks_num; ++i) {
+    ob_chunk_t *chunk = &chunks[i];
+
+    chunk->code = GetWords(code_table);
+    chunk->code_size = code_size;
+    chunk->data = GetWords(data_table);
+    chunk->first_word = words_num * i / chunks_num;
+    chunk->last_word = words_num * (i + 1) / chunks_num;
+    chunk->dest = mapping + header_size +
+                  ObLinesSize(INITIAL_IC_VALUE,
+                              INITIAL_IC_VALUE + chunk->first_word);
+  }
+
+  for (i = 1; i < chunks_num; ++i) {
+    chunks[i].started = (0 == pthread_create(&chunks[i].thread, NULL,
+                                             FormatObChunk, &chunks[i]));
+  }
+
+  /* The first chunk is formatted on the calling thread, and so is any
+   * chunk whose thread couldn't be started */
+  for (i = 0; i < chunks_num; ++i) {
+    if (!chunks[i].started) {
+      FormatObChunk(&chunks[i]);
+    }
+  }
+
+  for (i = 0; i < chunks_num; ++i) {
+    if (chunks[i].started) {
+      pthread_join(chunks[i].thread, NULL);
+    }
+  }
+
+  if (0 != munmap(mapping, file_size) || 0 != close(fd)) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  free(chunks);
+  return res;
+}
+
+/*
+ * @brief Returns the total length of the .ob lines of the addresses from
+ *        first_address up to end_address (exclusive).
+ */
+
+static size_t ObLinesSize(unsigned long first_address,
+                          unsigned long end_address) {
+  unsigned long digits_end = 10000; /* First address of 5 digits */
+  int digits = OB_MIN_ADDRESS_DIGITS;
+  size_t size = 0;
+
+  while (first_address < end_address) {
+    unsigned long last = end_address < digits_end ? end_address : digits_end;
+
+    if (first_address < last) {
+      size += (last - first_address) * OB_LINE_LENGTH(digits);
+      first_address = last;
+    }
+    digits_end *= 10;
+    ++digits;
+  }
+
+  return size;
+}
+
+/*
+ * @brief Formats the lines of a chunk (see ob_chunk_t), as WriteObSegment
+ *        does. Runs on a thread of its own.
+ */
+
+static void *FormatObChunk(void *chunk) {
+  ob_chunk_t *ob_chunk = (ob_chunk_t *)chunk;
+  char *cursor = ob_chunk->dest;
+  size_t i = 0;
+
+  for (i = ob_chunk->first_word; i < ob_chunk->last_word; ++i) {
+    machine_word_t word = i < ob_chunk->code_size ?
+                          ob_chunk->code[i] :
+                          ob_chunk->data[i - ob_chunk->code_size];
+
+    cursor = FormatDecimal(cursor, INITIAL_IC_VALUE + i,
+                           OB_MIN_ADDRESS_DIGITS);
+    *cursor++ = ' ';
+    cursor = FormatOctalWord(cursor, word);
+    *cursor++ = '\n';
+  }
+
+  return NULL;
+}
+
+static result_t GenerateOBJFileFromSpill(spilled_output_t *output,
+                                         char *output_path) {
+  unsigned long address = INITIAL_IC_VALUE;
+  ob_buffer_t buffer;
+  result_t res = OpenObFile(&buffer, output_path, output->code_size,
+                            output->data_size);
+
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  res = WriteSpilledObSegment(&buffer, output->code, &address);
+  if (SUCCESS == res) {
+    res = WriteSpilledObSegment(&buffer, output->data, &address);
+  }
+
+  return CloseObFile(&buffer, res);
+}
+
+/*
+ * @brief Opens a .ob file, and writes its first line (the total code &
+ *        data words) to its buffer.
+ *
+ * @return SUCCESS, or ERROR_OPENING_FILE.
+ */
+
+static result_t OpenObFile(ob_buffer_t *buffer,
+                           const char *output_path,
+                           size_t code_size,
+                           size_t data_size) {
+  char *cursor = buffer->data;
+
+  buffer->file = fopen(output_path, "w");
+  if (NULL == buffer->file) {
     perror("Couldn't open obj file");
     return ERROR_OPENING_FILE; 
   }
 
-  /* First comes the code segment... */
-  for (i = 0; i < GetSizeVector(code_table); i++) {
-    opcode_line = *(bitmap_t *)GetElementVector(code_table, i);
-    /* Ignoring bits bigger than word size */
-    opcode_line &= BIT_MASK_15_BITS;
-    sprintf(address, "%04d", cur_mem_address);
-    sprintf(bitmap, "%05o", (unsigned int)opcode_line);
-    sprintf(str_to_write, "%s %s\n", address, bitmap);
-    if (EOF == fputs(str_to_write, obj_file)) {
-      perror("Error writing to file");
-      fclose(obj_file);
-      free(address);
-      free(bitmap);
-      free(str_to_write);
+  /* Data is only written from our own buffer, skip stdio's */
+  setvbuf(buffer->file, NULL, _IONBF, 0);
+
+  /* Before the 2 columns, we write total code & data symbols. */
+  cursor = FormatDecimal(cursor, code_size, 1);
+  *cursor++ = ' ';
+  cursor = FormatDecimal(cursor, data_size, 1);
+  *cursor++ = '\n';
+  buffer->size = cursor - buffer->data;
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Flushes (unless writing already failed) & closes a .ob file.
+ *
+ * @param res - Result of writing the file so far.
+ *
+ * @return res, or ERROR_WRITING_TO_FILE if the rest couldn't be written.
+ */
+
+static result_t CloseObFile(ob_buffer_t *buffer, result_t res) {
+  if (SUCCESS == res) {
+    res = FlushObBuffer(buffer);
+  }
+
+  if (0 != fclose(buffer->file) && SUCCESS == res) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  return res;
+}
+
+/*
+ * @brief Appends a line for each word in a segment to the .ob buffer:
+ *        its address (decimal, at least 4 digits) & content (5 octal digits).
+ *
+ * @param address - Address of the first word; advanced past the segment.
+ */
+
+static result_t WriteObSegment(ob_buffer_t *buffer,
+                               const machine_word_t *words,
+                               size_t words_num,
+                               unsigned long *address) {
+  size_t i = 0;
+
+  for (i = 0; i < words_num; i++) {
+    char *cursor = NULL;
+
+    if (OB_BUFFER_SIZE - buffer->size < OB_MAX_LINE_LENGTH &&
+        SUCCESS != FlushObBuffer(buffer)) {
       return ERROR_WRITING_TO_FILE;
     }
 
-    cur_mem_address++;
+    cursor = buffer->data + buffer->size;
+    cursor = FormatDecimal(cursor, *address, OB_MIN_ADDRESS_DIGITS);
+    *cursor++ = ' ';
+    /* Ignoring bits bigger than word size */
+    cursor = FormatOctalWord(cursor, words[i]);
+    *cursor++ = '\n';
+
+    buffer->size = cursor - buffer->data;
+    ++*address;
   }
 
-  /* ... then comes data segment */
-  for (i = 0; i < GetSizeVector(data_table); i++) {
-    opcode_line = *(bitmap_t *)GetElementVector(data_table, i);
-    /* Ignoring bits bigger than word size */
-    opcode_line &= BIT_MASK_15_BITS;
-    sprintf(address, "%04d", cur_mem_address);
-    sprintf(bitmap, "%05o", (unsigned int)opcode_line);
-    sprintf(str_to_write, "%s %s\n", address, bitmap);
-    if (EOF == fputs(str_to_write, obj_file)) {
-      perror("Error writing to file");
-      fclose(obj_file);
-      free(address);
-      free(bitmap);
-      free(str_to_write);
-      return ERROR_WRITING_TO_FILE;
+  return SUCCESS;
+}
+
+/*
+ * @brief Same as WriteObSegment, for a segment spilled to a stream, which
+ *        is read a chunk at a time.
+ */
+
+static result_t WriteSpilledObSegment(ob_buffer_t *buffer,
+                                      FILE *segment,
+                                      unsigned long *address) {
+  machine_word_t words[SPILL_CHUNK_WORDS];
+  size_t words_num = 0;
+  result_t res = SUCCESS;
+
+  rewind(segment);
+  while (SUCCESS == res &&
+         0 < (words_num = fread(words, sizeof(machine_word_t),
+                                SPILL_CHUNK_WORDS, segment))) {
+    res = WriteObSegment(buffer, words, words_num, address);
+  }
+
+  if (ferror(segment)) {
+    perror("Error reading from file");
+    return FILE_HANDLING_ERROR;
+  }
+
+  return res;
+}
+
+static result_t FlushObBuffer(ob_buffer_t *buffer) {
+  if (buffer->size != fwrite(buffer->data, 1, buffer->size, buffer->file)) {
+    perror("Error writing to file");
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  buffer->size = 0;
+  return SUCCESS;
+}
+
+/*
+ * @brief Writes a number in decimal, two digits at a time (like "%0*lu").
+ *
+ * @param dest - Where to write; isn't null-terminated.
+ *        value - The number to write.
+ *        min_digits - Pads with leading zeros up to this many digits (<= 20).
+ *
+ * @return Pointer right after the last written character.
+ */
+
+static char *FormatDecimal(char *dest, unsigned long value, int min_digits) {
+  char digits[24];
+  int position = sizeof(digits);
+
+  while (100 <= value) {
+    const char *pair = decimal_pairs + (value % 100) * 2;
+    digits[--position] = pair[1];
+    digits[--position] = pair[0];
+    value /= 100;
+  }
+
+  if (10 <= value) {
+    digits[--position] = decimal_pairs[value * 2 + 1];
+    digits[--position] = decimal_pairs[value * 2];
+  }
+  else {
+    digits[--position] = (char)('0' + value);
+  }
+
+  while ((int)sizeof(digits) - position < min_digits) {
+    digits[--position] = '0';
+  }
+
+  memcpy(dest, digits + position, sizeof(digits) - position);
+  return dest + (sizeof(digits) - position);
+}
+
+/*
+ * @brief Writes the lower 15 bits of a word as 5 octal digits (like "%05o").
+ *
+ * @return Pointer right after the last written character.
+ */
+
+static char *FormatOctalWord(char *dest, machine_word_t word) {
+  const char *high = octal_pairs + ((word >> 6) & 077) * 2;
+  const char *low = octal_pairs + (word & 077) * 2;
+
+  dest[0] = (char)('0' + ((word >> 12) & 07));
+  dest[1] = high[0];
+  dest[2] = high[1];
+  dest[3] = low[0];
+  dest[4] = low[1];
+  return dest + 5;
+}
+
+
+/*
+ * @brief Writes the binary object file (see layout in generate_output_files.h).
+ *        The whole image is built in memory & written at once.
+ */
+
+static result_t GenerateBinaryObjectFile(word_buffer_t *code_table,
+                                        word_buffer_t *data_table,
+                                        symbol_table_t *symbol_table,
+                                        ext_symbol_occurrences_t *ext_list,
+                                        char *output_path) {
+  size_t words_num = GetWordsNum(code_table) + GetWordsNum(data_table);
+  size_t symbols_num = 0;
+  size_t ext_refs_num = 0;
+  size_t strings_size = 0;
+  size_t image_size = 0;
+  size_t i = 0;
+  unsigned char *image = NULL;
+  unsigned char *cursor = NULL;
+  unsigned char *symbols = NULL;
+  unsigned char *ext_refs = NULL;
+  unsigned char *strings = NULL;
+  node_t *iter = NULL;
+  FILE *obj_file = NULL;
+  result_t res = SUCCESS;
+
+  /* Size every section */
+  for (iter = GetHead(AsList(symbol_table)); NULL != iter; iter = GetNext(iter)) {
+    ++symbols_num;
+    strings_size += strlen(GetSymbolName((symbol_t *)GetValue(iter))) + 1;
+  }
+
+  for (iter = GetHead(ext_list->external_symbols);
+       NULL != iter;
+       iter = GetNext(iter)) {
+    external_symbol_data_t *external_symbol = GetValue(iter);
+    ext_refs_num += GetSizeVector(external_symbol->occurrences);
+    strings_size += strlen(external_symbol->symbol_name) + 1;
+  }
+
+  image_size = BINARY_OBJECT_HEADER_SIZE +
+               (words_num + words_num % 2) * 2 +
+               symbols_num * BINARY_SYMBOL_ENTRY_SIZE +
+               ext_refs_num * BINARY_EXT_REF_ENTRY_SIZE +
+               strings_size;
+
+  image = (unsigned char *)calloc(image_size, 1);
+  if (NULL == image) {
+    fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  /* Header */
+  memcpy(image, BINARY_OBJECT_MAGIC, 4);
+  cursor = PutUint32(image + 4, BINARY_OBJECT_VERSION);
+  cursor = PutUint32(cursor, INITIAL_IC_VALUE);
+  cursor = PutUint32(cursor, GetWordsNum(code_table));
+  cursor = PutUint32(cursor, GetWordsNum(data_table));
+  cursor = PutUint32(cursor, symbols_num);
+  cursor = PutUint32(cursor, ext_refs_num);
+  cursor = PutUint32(cursor, strings_size);
+
+  /* Words: code segment, then data segment (padding is already zeroed) */
+  for (i = 0; i < GetWordsNum(code_table); ++i) {
+    cursor = PutUint16(cursor, GetWords(code_table)[i] & BIT_MASK_15_BITS);
+  }
+  for (i = 0; i < GetWordsNum(data_table); ++i) {
+    cursor = PutUint16(cursor, GetWords(data_table)[i] & BIT_MASK_15_BITS);
+  }
+
+  symbols = image + BINARY_OBJECT_HEADER_SIZE + (words_num + words_num % 2) * 2;
+  ext_refs = symbols + symbols_num * BINARY_SYMBOL_ENTRY_SIZE;
+  strings = ext_refs + ext_refs_num * BINARY_EXT_REF_ENTRY_SIZE;
+  cursor = strings;
+
+  /* Symbols */
+  for (iter = GetHead(AsList(symbol_table)); NULL != iter; iter = GetNext(iter)) {
+    symbol_t *symbol = (symbol_t *)GetValue(iter);
+    const char *name = GetSymbolName(symbol);
+    size_t name_size = strlen(name) + 1;
+
+    symbols = PutUint32(symbols, cursor - strings);
+    symbols = PutUint32(symbols, GetSymbolAddress(symbol));
+    switch (GetSymbolType(symbol)) {
+      case ENTRY:
+        *symbols = BINARY_SYMBOL_ENTRY;
+        break;
+      case EXTERN:
+        *symbols = BINARY_SYMBOL_EXTERN;
+        break;
+      default:
+        *symbols = BINARY_SYMBOL_REGULAR;
+        break;
     }
+    symbols[1] = (DATA == GetSymbolMemoryArea(symbol)) ? 1 : 0;
+    symbols += 4;
 
-    cur_mem_address++;
+    memcpy(cursor, name, name_size);
+    cursor += name_size;
+  }
+
+  /* External references */
+  for (iter = GetHead(ext_list->external_symbols);
+       NULL != iter;
+       iter = GetNext(iter)) {
+    external_symbol_data_t *external_symbol = GetValue(iter);
+    size_t name_size = strlen(external_symbol->symbol_name) + 1;
+
+    for (i = 0; i < GetSizeVector(external_symbol->occurrences); ++i) {
+      ext_refs = PutUint32(ext_refs, cursor - strings);
+      ext_refs = PutUint32(ext_refs,
+          *(unsigned int *)GetElementVector(external_symbol->occurrences, i));
+    }
+
+    memcpy(cursor, external_symbol->symbol_name, name_size);
+    cursor += name_size;
+  }
+
+  obj_file = fopen(output_path, "wb");
+  if (NULL == obj_file) {
+    free(image);
+    perror("Couldn't open binary obj file");
+    return ERROR_OPENING_FILE;
+  }
+
+  if (image_size != fwrite(image, 1, image_size, obj_file)) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  if (0 != fclose(obj_file) && SUCCESS == res) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  free(image);
+  return res;
+}
+
+/*
+ * @brief Same as GenerateBinaryObjectFile, for a spilled output: rather than
+ *        building the image in memory, each section is written as it's
+ *        read.
+ */
+
+static result_t GenerateBinaryObjectFileFromSpill(spilled_output_t *output,
+                                                  symbol_table_t *symbol_table,
+                                                  char *output_path) {
+  size_t words_num = output->code_size + output->data_size;
+  unsigned long symbols_num = 0;
+  unsigned long ext_refs_num = 0;
+  unsigned long strings_size = 0;
+  unsigned char header[BINARY_OBJECT_HEADER_SIZE];
+  unsigned char entry[BINARY_SYMBOL_ENTRY_SIZE];
+  unsigned char *cursor = NULL;
+  ext_ref_writer_t writer;
+  node_t *iter = NULL;
+  size_t i = 0;
+  FILE *obj_file = NULL;
+  result_t res = SUCCESS;
+
+  /* Size every section */
+  for (iter = GetHead(AsList(symbol_table)); NULL != iter; iter = GetNext(iter)) {
+    ++symbols_num;
+    strings_size += strlen(GetSymbolName((symbol_t *)GetValue(iter))) + 1;
+  }
+
+  writer.name_offset = strings_size;
+  for (i = 0; i < GetSizeVector(output->externals); ++i) {
+    spilled_external_t *external =
+        (spilled_external_t *)GetElementVector(output->externals, i);
+    ext_refs_num += external->references_num;
+    strings_size += strlen(external->symbol_name) + 1;
+  }
+
+  obj_file = fopen(output_path, "wb");
+  if (NULL == obj_file) {
+    perror("Couldn't open binary obj file");
+    return ERROR_OPENING_FILE;
+  }
+
+  /* Header */
+  memcpy(header, BINARY_OBJECT_MAGIC, 4);
+  cursor = PutUint32(header + 4, BINARY_OBJECT_VERSION);
+  cursor = PutUint32(cursor, INITIAL_IC_VALUE);
+  cursor = PutUint32(cursor, output->code_size);
+  cursor = PutUint32(cursor, output->data_size);
+  cursor = PutUint32(cursor, symbols_num);
+  cursor = PutUint32(cursor, ext_refs_num);
+  PutUint32(cursor, strings_size);
+  fwrite(header, 1, sizeof(header), obj_file);
+
+  /* Words: code segment, then data segment, padded to 4 bytes */
+  res = WriteSpilledBinarySegment(obj_file, output->code);
+  if (SUCCESS == res) {
+    res = WriteSpilledBinarySegment(obj_file, output->data);
+  }
+  if (words_num % 2) {
+    memset(entry, 0, 2);
+    fwrite(entry, 1, 2, obj_file);
+  }
+
+  /* Symbols */
+  writer.file = obj_file;
+  writer.external = NULL;
+  strings_size = 0;
+  for (iter = GetHead(AsList(symbol_table)); NULL != iter; iter = GetNext(iter)) {
+    symbol_t *symbol = (symbol_t *)GetValue(iter);
+
+    memset(entry, 0, sizeof(entry));
+    cursor = PutUint32(entry, strings_size);
+    cursor = PutUint32(cursor, GetSymbolAddress(symbol));
+    switch (GetSymbolType(symbol)) {
+      case ENTRY:
+        *cursor = BINARY_SYMBOL_ENTRY;
+        break;
+      case EXTERN:
+        *cursor = BINARY_SYMBOL_EXTERN;
+        break;
+      default:
+        *cursor = BINARY_SYMBOL_REGULAR;
+        break;
+    }
+    cursor[1] = (DATA == GetSymbolMemoryArea(symbol)) ? 1 : 0;
+
+    fwrite(entry, 1, sizeof(entry), obj_file);
+    strings_size += strlen(GetSymbolName(symbol)) + 1;
+  }
+
+  /* External references */
+  if (SUCCESS == res) {
+    res = ForEachExternalReference(output, WriteBinaryExternalReference,
+                                   &writer);
+  }
+
+  /* Strings */
+  for (iter = GetHead(AsList(symbol_table)); NULL != iter; iter = GetNext(iter)) {
+    const char *name = GetSymbolName((symbol_t *)GetValue(iter));
+    fwrite(name, 1, strlen(name) + 1, obj_file);
+  }
+
+  for (i = 0; i < GetSizeVector(output->externals); ++i) {
+    const char *name = ((spilled_external_t *)GetElementVector(
+                            output->externals, i))->symbol_name;
+    fwrite(name, 1, strlen(name) + 1, obj_file);
+  }
+
+  if (ferror(obj_file) && SUCCESS == res) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  if (0 != fclose(obj_file) && SUCCESS == res) {
+    perror("Error writing to file");
+    res = ERROR_WRITING_TO_FILE;
+  }
+
+  return res;
+}
+
+/*
+ * @brief Writes the words of a spilled segment to a binary object file.
+ */
+
+static result_t WriteSpilledBinarySegment(FILE *obj_file, FILE *segment) {
+  machine_word_t words[SPILL_CHUNK_WORDS];
+  unsigned char bytes[SPILL_CHUNK_WORDS * 2];
+  size_t words_num = 0;
+  size_t i = 0;
+
+  rewind(segment);
+  while (0 < (words_num = fread(words, sizeof(machine_word_t),
+                                SPILL_CHUNK_WORDS, segment))) {
+    unsigned char *cursor = bytes;
+
+    for (i = 0; i < words_num; ++i) {
+      cursor = PutUint16(cursor, words[i] & BIT_MASK_15_BITS);
+    }
+    fwrite(bytes, 1, cursor - bytes, obj_file);
+  }
+
+  if (ferror(segment)) {
+    perror("Error reading from file");
+    return FILE_HANDLING_ERROR;
+  }
+
+  return SUCCESS;
+}
+
+static result_t WriteBinaryExternalReference(const spilled_external_t *external,
+                                             unsigned int address,
+                                             void *writer) {
+  ext_ref_writer_t *ext_writer = (ext_ref_writer_t *)writer;
+  unsigned char entry[BINARY_EXT_REF_ENTRY_SIZE];
+
+  /* The uses of each symbol come together, in the order of the names */
+  if (external != ext_writer->external) {
+    if (NULL != ext_writer->external) {
+      ext_writer->name_offset +=
+          strlen(ext_writer->external->symbol_name) + 1;
+    }
+    ext_writer->external = external;
+  }
+
+  PutUint32(PutUint32(entry, ext_writer->name_offset), address);
+  if (sizeof(entry) != fwrite(entry, 1, sizeof(entry), ext_writer->file)) {
+    return ERROR_WRITING_TO_FILE;
   }
 
-  free (address);
-  free (bitmap);
-  free (str_to_write);
-  fclose(obj_file);
   return SUCCESS;
 }
 
+static unsigned char *PutUint16(unsigned char *dest, unsigned long value) {
+  dest[0] = (unsigned char)(value & 0xFF);
+  dest[1] = (unsigned char)((value >> 8) & 0xFF);
+  return dest + 2;
+}
+
+static unsigned char *PutUint32(unsigned char *dest, unsigned long value) {
+  dest = PutUint16(dest, value & 0xFFFF);
+  return PutUint16(dest, (value >> 16) & 0xFFFF);
+}
 
 static result_t GenerateEntriesFile (symbol_table_t *symbol_table, char *output_path){
   FILE *entry_file = NULL;
@@ -352,36 +1219,155 @@ static result_t GenerateExternFile(char *output_path,
   return SUCCESS;
 }
 
-static result_t WriteHeader (char *output_path, int IC, int DC){
-  FILE *obj_file;
-  char *str_to_write = NULL;  
+static result_t GenerateExternFileFromSpill(spilled_output_t *output,
+                                            char *output_path) {
+  FILE *extern_file = NULL;
+  result_t res = SUCCESS;
 
-  str_to_write = (char *) malloc (MAX_LINE_LENGTH*sizeof(char));
-  if (NULL == str_to_write){
-      fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
-      return MEM_ALLOCATION_ERROR;   
+  /* No external symbols, and thus no need to write a file */
+  if (IsEmptyVector(output->externals)) {
+    return SUCCESS;
+  }
+
+  extern_file = fopen(output_path, "w");
+  if (NULL == extern_file) {
+    perror("Couldn't open extern file");
+    return ERROR_OPENING_FILE;
   }
-  sprintf(str_to_write, "%d %d\n", IC, DC);
-  obj_file = fopen(output_path, "w");
-  if (obj_file == NULL) {
-      free (str_to_write);
-      return ERROR_OPENING_FILE;
+
+  res = ForEachExternalReference(output, WriteExternLine, extern_file);
+
+  if (0 != fclose(extern_file) && SUCCESS == res) {
+    res = ERROR_WRITING_TO_FILE;
+  }
+  if (ERROR_WRITING_TO_FILE == res) {
+    perror("Error writing to file");
   }
 
-  if (fputs(str_to_write, obj_file) == EOF) {
-      free (str_to_write);
-      fclose(obj_file);
-      return ERROR_WRITING_TO_FILE;
+  return res;
+}
+
+static result_t WriteExternLine(const spilled_external_t *external,
+                                unsigned int address,
+                                void *extern_file) {
+  if (0 > fprintf((FILE *)extern_file, "%s %04u\n", external->symbol_name,
+                  address)) {
+    return ERROR_WRITING_TO_FILE;
   }
-  free (str_to_write);
-  fclose(obj_file);
 
   return SUCCESS;
 }
 
+/*
+ * @brief Calls a function for each spilled use of an external symbol, the
+ *        uses of each symbol together (in the order of the symbols' first
+ *        use), as in the .ext file.
+ *
+ *        Symbols are taken in groups whose uses fit in a buffer of
+ *        EXT_GROUP_SIZE addresses: each group's uses are gathered in a pass
+ *        over the spilled uses. A symbol with more uses than that is a group
+ *        of its own, whose uses are passed on as they're read.
+ *
+ * @return SUCCESS, or the first error returned by the function (or of
+ *         reading the spilled uses).
+ */
+
+static result_t ForEachExternalReference(spilled_output_t *output,
+                                         ext_ref_func_t func,
+                                         void *param) {
+  size_t externals_num = GetSizeVector(output->externals);
+  spilled_ext_ref_t references[EXT_READ_CHUNK];
+  unsigned long *positions = NULL;
+  unsigned int *addresses = NULL;
+  size_t first = 0;
+  result_t res = SUCCESS;
+
+  if (0 == externals_num) {
+    return SUCCESS;
+  }
+
+  positions = (unsigned long *)malloc(externals_num * sizeof(unsigned long));
+  addresses = (unsigned int *)malloc(EXT_GROUP_SIZE * sizeof(unsigned int));
+  if (NULL == positions || NULL == addresses) {
+    fprintf(stderr, "Memory allocation error: couldn't allocate a buffer\n");
+    free(positions);
+    free(addresses);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  while (SUCCESS == res && first < externals_num) {
+    size_t last = first;
+    unsigned long group_size = 0;
+    size_t references_num = 0;
+    size_t i = 0;
+
+    /* Each symbol's uses start where the previous symbol's end */
+    while (last < externals_num) {
+      spilled_external_t *external =
+          (spilled_external_t *)GetElementVector(output->externals, last);
+
+      if (last != first &&
+          group_size + external->references_num > EXT_GROUP_SIZE) {
+        break;
+      }
+      positions[last++] = group_size;
+      group_size += external->references_num;
+    }
+
+    rewind(output->ext_refs);
+    while (SUCCESS == res &&
+           0 < (references_num = fread(references, sizeof(spilled_ext_ref_t),
+                                       EXT_READ_CHUNK, output->ext_refs))) {
+      for (i = 0; SUCCESS == res && i < references_num; ++i) {
+        size_t index = references[i].external_index;
+
+        if (index < first || index >= last) {
+          continue;
+        }
+
+        if (EXT_GROUP_SIZE < group_size) {
+          res = func((spilled_external_t *)GetElementVector(output->externals,
+                                                            index),
+                     references[i].address, param);
+        } else {
+          addresses[positions[index]++] = references[i].address;
+        }
+      }
+    }
+
+    if (ferror(output->ext_refs)) {
+      perror("Error reading from file");
+      res = FILE_HANDLING_ERROR;
+    }
+
+    /* The group's uses are in place, pass them on */
+    if (EXT_GROUP_SIZE >= group_size) {
+      size_t symbol = first;
+      unsigned long used = 0;
+
+      for (i = 0; SUCCESS == res && i < group_size; ++i) {
+        spilled_external_t *external =
+            (spilled_external_t *)GetElementVector(output->externals, symbol);
+
+        res = func(external, addresses[i], param);
+        if (++used == external->references_num) {
+          ++symbol;
+          used = 0;
+        }
+      }
+    }
+
+    first = last;
+  }
+
+  free(positions);
+  free(addresses);
+  return res;
+}
+
 static int ExternalSymbolCompare (void *value, void *key) {
-  char *symbol_name = (char *)key;
   external_symbol_data_t *external_symbol_data = (external_symbol_data_t *)value;
 
-  return (0 == strcmp(external_symbol_data->symbol_name, symbol_name));
+  /* Both names are interned in the same pool */
+  return (external_symbol_data->symbol_name == (const char *)key);
 }
@@ -6,11 +6,17 @@
 
 
 #include "language_definitions.h"
-#include <string.h> /* strlen */
-#include <ctype.h> /* isdigit */
+#include <string.h> /* strcmp */
 
+/* No reserved word is longer than this */
+#define MAX_RESERVED_WORD_LENGTH (7)
 
-instruction_t reserved_instructions [NUM_OF_INSTRUCTIONS] = {
+static reserved_word_t MatchReservedWord(const char *word,
+                                         reserved_word_kind_t kind,
+                                         int index);
+
+
+const instruction_t reserved_instructions[NUM_OF_INSTRUCTIONS] = {
   {"mov", 959},  /* 0b1110111111 */ 
   {"cmp", 1023}, /* 0b1111111111 */ 
   {"add", 959},  /* 0b1110111111 */ 
@@ -29,14 +35,14 @@ instruction_t reserved_instructions [NUM_OF_INSTRUCTIONS] = {
   {"stop", 0}   /* 0b0000000000 */  
 };
 
-char *reserved_directives[NUM_OF_DIRECTIVES] = {
+const char *const reserved_directives[NUM_OF_DIRECTIVES] = {
   ".string",
   ".data",
   ".extern",
   ".entry"
 };
 
-char *register_names[NUM_OF_REGISTERS] = {
+const char *const register_names[NUM_OF_REGISTERS] = {
   "r0",
   "r1",
   "r2",
@@ -46,3 +52,78 @@ char *register_names[NUM_OF_REGISTERS] = {
   "r6",
   "r7"
 };
+
+reserved_word_t IdentifyReservedWord(const char *word) {
+  reserved_word_t not_reserved;
+  size_t length = 0;
+
+  not_reserved.kind = NOT_RESERVED;
+  not_reserved.index = 0;
+
+  /* Longer words can't be reserved, so there's no need for a full strlen */
+  while (length <= MAX_RESERVED_WORD_LENGTH && '\0' != word[length]) {
+    ++length;
+  }
+
+  switch (length) {
+    /* r0 - r7 */
+    case 2:
+      if ('r' == word[0] && '0' <= word[1] &&
+          '0' + NUM_OF_REGISTERS > word[1]) {
+        not_reserved.kind = REGISTER_WORD;
+        not_reserved.index = word[1] - '0';
+      }
+      return not_reserved;
+
+    /* Every instruction but stop. Indices are the opcodes. */
+    case 3:
+      switch (word[0]) {
+        case 'm': return MatchReservedWord(word, INSTRUCTION_WORD, 0); /* mov */
+        case 'c': return MatchReservedWord(word, INSTRUCTION_WORD,
+                                           'm' == word[1] ? 1 : 5); /* cmp, clr */
+        case 'a': return MatchReservedWord(word, INSTRUCTION_WORD, 2); /* add */
+        case 's': return MatchReservedWord(word, INSTRUCTION_WORD, 3); /* sub */
+        case 'l': return MatchReservedWord(word, INSTRUCTION_WORD, 4); /* lea */
+        case 'n': return MatchReservedWord(word, INSTRUCTION_WORD, 6); /* not */
+        case 'i': return MatchReservedWord(word, INSTRUCTION_WORD, 7); /* inc */
+        case 'd': return MatchReservedWord(word, INSTRUCTION_WORD, 8); /* dec */
+        case 'j': return MatchReservedWord(word, INSTRUCTION_WORD,
+                                           'm' == word[1] ? 9 : 13); /* jmp, jsr */
+        case 'b': return MatchReservedWord(word, INSTRUCTION_WORD, 10); /* bne */
+        case 'r': return MatchReservedWord(word, INSTRUCTION_WORD,
+                                           'e' == word[1] ? 11 : 14); /* red, rts */
+        case 'p': return MatchReservedWord(word, INSTRUCTION_WORD, 12); /* prn */
+        default: return not_reserved;
+      }
+
+    case 4: return MatchReservedWord(word, INSTRUCTION_WORD, 15); /* stop */
+    case 5: return MatchReservedWord(word, DIRECTIVE_WORD, DATA_DIRECTIVE);
+    case 6: return MatchReservedWord(word, DIRECTIVE_WORD, ENTRY_DIRECTIVE);
+    case 7: return MatchReservedWord(word, DIRECTIVE_WORD,
+                                     's' == word[1] ? STRING_DIRECTIVE
+                                                    : EXTERN_DIRECTIVE);
+    default: return not_reserved;
+  }
+}
+
+/*
+ * @brief Compares a word with the only reserved word it may be, as found in
+ *        the tables above.
+ *
+ * @return The reserved word (kind & index) if they're equal, otherwise
+ *         kind NOT_RESERVED.
+ */
+
+static reserved_word_t MatchReservedWord(const char *word,
+                                         reserved_word_kind_t kind,
+                                         int index) {
+  reserved_word_t reserved_word;
+  const char *candidate = INSTRUCTION_WORD == kind ?
+                          reserved_instructions[index].name :
+                          reserved_directives[index];
+
+  reserved_word.kind = 0 == strcmp(word, candidate) ? kind : NOT_RESERVED;
+  reserved_word.index = index;
+
+  return reserved_word;
+}
@@ -0,0 +1,131 @@
+/* lexer.c
+ *
+ * This module implements a lexer which splits a line into tokens that
+ * point into the line, without copying or modifying it.
+ */
+
+#include <string.h> /* memcpy */
+#include <assert.h> /* assert */
+#include "lexer.h"
+
+#define IS_LEXER_BLANK(c) (' ' == (c) || '\t' == (c) || '\r' == (c))
+#define IS_WORD_END(c) (IS_LEXER_BLANK(c) || ',' == (c) || '\n' == (c))
+
+static token_t MakeToken(token_kind_t kind, const char *start, size_t length);
+static void SkipBlanks(lexer_t *lexer);
+
+void InitLexer(lexer_t *lexer, const char *line, size_t length) {
+  const char *newline = NULL;
+
+  assert(lexer); assert(line);
+
+  /* The line ends at its first newline */
+  newline = (const char *)memchr(line, '\n', length);
+
+  lexer->cursor = line;
+  lexer->end = NULL == newline ? line + length : newline;
+}
+
+token_t NextToken(lexer_t *lexer) {
+  const char *start = NULL;
+  const char *ptr = NULL;
+
+  assert(lexer);
+
+  SkipBlanks(lexer);
+  start = lexer->cursor;
+
+  if (start == lexer->end) {
+    return MakeToken(END_TOKEN, start, 0);
+  }
+
+  if (',' == *start) {
+    ++lexer->cursor;
+    return MakeToken(COMMA_TOKEN, start, 1);
+  }
+
+  for (ptr = start; ptr != lexer->end && !IS_WORD_END(*ptr); ++ptr) {
+    /* Only looking for the end of the word */
+  }
+
+  lexer->cursor = ptr;
+  return MakeToken(WORD_TOKEN, start, ptr - start);
+}
+
+bool_t ReadLabel(lexer_t *lexer, token_t *label) {
+  const char *start = NULL;
+  const char *ptr = NULL;
+
+  assert(lexer); assert(label);
+
+  SkipBlanks(lexer);
+  start = lexer->cursor;
+
+  for (ptr = start; ptr != lexer->end && !IS_LEXER_BLANK(*ptr); ++ptr) {
+    /* Only looking for the end of the word */
+  }
+
+  if (ptr == start || ':' != *(ptr - 1)) {
+    return FALSE;
+  }
+
+  lexer->cursor = ptr;
+  *label = MakeToken(LABEL_TOKEN, start, ptr - 1 - start);
+  return TRUE;
+}
+
+token_t NextWord(lexer_t *lexer) {
+  token_t token = NextToken(lexer);
+
+  while (COMMA_TOKEN == token.kind) {
+    token = NextToken(lexer);
+  }
+
+  return token;
+}
+
+char *CopyRestOfLine(lexer_t *lexer, char *dest) {
+  size_t length = 0;
+
+  assert(lexer); assert(dest);
+
+  SkipBlanks(lexer);
+  length = lexer->end - lexer->cursor;
+
+  memcpy(dest, lexer->cursor, length);
+  dest[length] = '\0';
+
+  lexer->cursor = lexer->end;
+
+  return dest;
+}
+
+char *CopyToken(const token_t *token, char *dest) {
+  assert(token); assert(dest);
+
+  memcpy(dest, token->start, token->length);
+  dest[token->length] = '\0';
+
+  return dest;
+}
+
+bool_t TokenStartsWith(const token_t *token, char c) {
+  assert(token);
+  return (0 < token->length && c == token->start[0]) ? TRUE : FALSE;
+}
+
+static token_t MakeToken(token_kind_t kind, const char *start, size_t length) {
+  token_t token;
+
+  token.kind = kind;
+  token.start = start;
+  token.length = length;
+
+  return token;
+}
+
+static void SkipBlanks(lexer_t *lexer) {
+  while (lexer->cursor != lexer->end && IS_LEXER_BLANK(*lexer->cursor)) {
+    ++lexer->cursor;
+  }
+}
@@ -0,0 +1,58 @@
+/* libassembler.c
+ *
+ * The library entry point: runs preprocessing & assembling on source text
+ * held in memory, without writing the .am or output files.
+ */
+
+#include <string.h> /* memset */
+#include "libassembler.h"
+#include "preprocessing.h"
+#include "source_buffer.h"
+
+result_t AssembleText(const char *source_name,
+                      const char *text,
+                      size_t length,
+                      const assembler_options_t *options,
+                      assembled_program_t *program) {
+  result_t res = SUCCESS;
+  source_buffer_t *source = CreateSourceBuffer();
+  source_buffer_t *expanded_source = CreateSourceBuffer();
+  macro_table_t *macro_table = NULL;
+
+  memset(program, 0, sizeof(assembled_program_t));
+
+  if (NULL == source || NULL == expanded_source ||
+      SUCCESS != AppendSourceText(source, text, length)) {
+    res = MEM_ALLOCATION_ERROR;
+  }
+
+  if (SUCCESS == res) {
+    macro_table = PreprocessBuffer(source_name, source, expanded_source,
+                                   options->diagnostics, options->arena);
+    if (NULL == macro_table) {
+      res = FAILURE;
+    }
+  }
+
+  if (SUCCESS == res) {
+    res = AssembleSourceToProgram(source_name, expanded_source, macro_table,
+                                  options, program);
+  }
+
+  if (NULL != macro_table) {
+    DestroyMacroTable(macro_table);
+  }
+  if (NULL != expanded_source) {
+    DestroySourceBuffer(expanded_source);
+  }
+  if (NULL != source) {
+    DestroySourceBuffer(source);
+  }
+
+  /* The program was copied out of the arena */
+  if (NULL != options->arena) {
+    ResetArena(options->arena);
+  }
+
+  return res;
+}
@@ -15,13 +15,16 @@ char *CleanLine(char *line) {
   char *last_non_blank = NULL;
   bool_t in_whitespace = FALSE;
   bool_t inside_string = FALSE;
+  bool_t has_newline = FALSE;
 
   if (IsBlankLine(line)) {
     return src;
   }
 
-  /* Collapse multiple whitespaces between words */
-  while ('\n' != *src) {
+  /* Collapse multiple whitespaces between words. The last line of a file
+   * may lack its '\n', so stop at the terminator as well.
+   */
+  while ('\n' != *src && '\0' != *src) {
     if (*src == '"'){
       if (FALSE == inside_string){
         inside_string = TRUE;
@@ -44,9 +47,20 @@ char *CleanLine(char *line) {
     ++src;
   }
 
+  has_newline = ('\n' == *src);
+  if (NULL == last_non_blank) {
+    *line = '\0';
+    return line;
+  }
+
   /* Restore terminating characters */
-  *(last_non_blank + 1) = '\n';
-  *(last_non_blank + 2) = '\0';
+  if (has_newline) {
+    *(last_non_blank + 1) = '\n';
+    *(last_non_blank + 2) = '\0';
+  }
+  else {
+    *(last_non_blank + 1) = '\0';
+  }
   
   return line;
 }
@@ -6,7 +6,8 @@
 
 
 #include "list.h"
-#include <stdlib.h> /* malloc, free */
+#include <stdlib.h> /* free */
+#include "arena.h"
 
 struct node {
   void *value; 
@@ -16,33 +17,39 @@ struct node {
 struct list {
   node_t *head;
   node_t *tail;
+  arena_t *arena; /* NULL when the list is allocated on the heap */
 };
 
-static node_t *CreateDummy(void);
-static node_t *CreateNode(node_t *next, void *value);
+static node_t *CreateDummy(arena_t *arena);
+static node_t *CreateNode(arena_t *arena, node_t *next, void *value);
 
 list_t *CreateList(void) {
-  list_t *new_list = (list_t *)malloc(sizeof(list_t));
+  return CreateListInArena(NULL);
+}
+
+list_t *CreateListInArena(arena_t *arena) {
+  list_t *new_list = (list_t *)ArenaAlloc(arena, sizeof(list_t));
   node_t *dummy_node = NULL;
 
   if (NULL == new_list) {
     return NULL;
   }
 
-  dummy_node = CreateDummy();
+  dummy_node = CreateDummy(arena);
   if (NULL == dummy_node) {
-    free(new_list);
+    ArenaFree(arena, new_list);
     return NULL;
   }
 
   new_list->head = dummy_node;
   new_list->tail = dummy_node;
+  new_list->arena = arena;
 
   return new_list;
 }
 
 node_t *AddNode(list_t *list, void *value) {
-  node_t *new_node = CreateNode(NULL, value);
+  node_t *new_node = CreateNode(list->arena, NULL, value);
 
   if (NULL == new_node) {
     return NULL;
@@ -70,6 +77,11 @@ void DestroyList(list_t *list) {
   node_t *cur_node = list->head;
   node_t *next_node = NULL;
 
+  /* The nodes are released along with the arena */
+  if (NULL != list->arena) {
+    return;
+  }
+
   while (NULL != cur_node) {
     next_node = cur_node->next;    
     free(cur_node);
@@ -91,12 +103,12 @@ void *GetValue(node_t *node) {
   return node->value;
 }
 
-static node_t *CreateDummy(void) {
-  return CreateNode(NULL, (void *)(0xDEADBEEF));
+static node_t *CreateDummy(arena_t *arena) {
+  return CreateNode(arena, NULL, (void *)(0xDEADBEEF));
 }
 
-static node_t *CreateNode(node_t *next, void *value) {
-  node_t *node = (node_t *)malloc(sizeof(node_t));
+static node_t *CreateNode(arena_t *arena, node_t *next, void *value) {
+  node_t *node = (node_t *)ArenaAlloc(arena, sizeof(node_t));
   if (NULL == node) {
     return NULL;
   }
@@ -2,39 +2,102 @@
  *
  * This module implements the macro_table data structure along with its associated utilities, 
  * which are similar to those of the list data structure.
+ *
+ * Macros are kept in a list, and indexed by their names (see name_index.h).
+ * Macro names are interned in a string pool, so the index compares names by
+ * address, and reuses the hash stored by the pool.
+ * Definitions are slices of a single text buffer of the table, into which
+ * each definition is written once, as it's read (see AppendToDefinition).
  */
 
-#include <stdlib.h> /* malloc, free */
-#include <string.h> /* strlen, strcpy */
+#include <stdlib.h> /* realloc, free */
 #include <stdio.h> /* fprintf */
+#include <string.h> /* memcpy, strlen */
 #include "macro_table.h"
 #include "list.h"
-#include "string_utils.h"
+#include "string_pool.h"
+#include "arena.h"
+#include "name_index.h"
+
+#define INITIAL_INDEX_CAPACITY (32)
+
+#define INITIAL_DEFINITIONS_CAPACITY (1024)
 
 struct macro_struct {
-  const char *macro_name;
-  const char *macro_definition;
+  const char *macro_name; /* Interned in the table's pool */
+  size_t definition_offset; /* In the table's definitions */
+  size_t definition_length;
 };
 
+/*
+ * definitions - The text of all definitions, each followed by a '\0'. The
+ *               text from pending_definition onwards is the definition
+ *               being written, which no macro refers to yet.
+ */
 struct macro_table {
   list_t *list;
+  name_index_t *index;
+  arena_t *arena; /* NULL when the table is allocated on the heap */
+  string_pool_t *names;
+  char *definitions;
+  size_t definitions_size;
+  size_t definitions_capacity;
+  size_t pending_definition;
 };
 
-static macro_t *CreateMacro(const char *macro_name, const char *macro_definition);
-static int CmpMacro(void *macro, void *key);
+static macro_t *CreateMacro(arena_t *arena,
+                            const char *macro_name,
+                            size_t definition_offset,
+                            size_t definition_length);
+static result_t ReserveDefinitions(macro_table_t *table, size_t size);
 
 macro_table_t *CreateMacroTable(void) {
-  macro_table_t *new_macro_table = (macro_table_t *)malloc(sizeof(macro_table_t));
+  return CreateMacroTableInArena(NULL);
+}
+
+macro_table_t *CreateMacroTableInArena(arena_t *arena) {
+  macro_table_t *new_macro_table =
+    (macro_table_t *)ArenaAlloc(arena, sizeof(macro_table_t));
   if (NULL == new_macro_table) {
     return NULL;
   }
 
-  new_macro_table->list = CreateList();
+  new_macro_table->list = CreateListInArena(arena);
   if (NULL == new_macro_table->list) {
-    free(new_macro_table);
+    ArenaFree(arena, new_macro_table);
+    return NULL;
+  }
+
+  new_macro_table->index = CreateNameIndex(arena, INITIAL_INDEX_CAPACITY);
+  if (NULL == new_macro_table->index) {
+    DestroyList(new_macro_table->list);
+    ArenaFree(arena, new_macro_table);
+    return NULL;
+  }
+
+  new_macro_table->names = CreateStringPool(arena);
+  if (NULL == new_macro_table->names) {
+    DestroyList(new_macro_table->list);
+    DestroyNameIndex(new_macro_table->index);
+    ArenaFree(arena, new_macro_table);
     return NULL;
   }
 
+  new_macro_table->definitions =
+    (char *)ArenaAlloc(arena, INITIAL_DEFINITIONS_CAPACITY);
+  if (NULL == new_macro_table->definitions) {
+    DestroyStringPool(new_macro_table->names);
+    DestroyList(new_macro_table->list);
+    DestroyNameIndex(new_macro_table->index);
+    ArenaFree(arena, new_macro_table);
+    return NULL;
+  }
+
+  new_macro_table->arena = arena;
+  new_macro_table->definitions_size = 0;
+  new_macro_table->definitions_capacity = INITIAL_DEFINITIONS_CAPACITY;
+  new_macro_table->pending_definition = 0;
+
   return new_macro_table;
 }
 
@@ -50,52 +113,123 @@ result_t AddMacroIfUnique(macro_table_t *table,
 }
 
 void DestroyMacroTable(macro_table_t *table) {
-  node_t *node = GetHead(table->list);
+  node_t *node = NULL;
+
+  DestroyStringPool(table->names);
+
+  /* Everything else is released along with the arena */
+  if (NULL != table->arena) {
+    return;
+  }
+
+  node = GetHead(table->list);
   while (NULL != node) {
-    macro_t *macro = GetValue(node);
-    free((void *)(macro->macro_name));
-    free((void *)(macro->macro_definition));
-    free(macro);
+    free(GetValue(node));
     node = GetNext(node);
   }
 
   DestroyList(table->list);
+  free(table->definitions);
+  DestroyNameIndex(table->index);
   free(table);
 }
 
 result_t AddMacro(macro_table_t *table,
                   const char *macro_name,
                   const char *macro_definition) {
+  DiscardDefinition(table);
+  if (SUCCESS != AppendToDefinition(table, macro_definition,
+                                    strlen(macro_definition))) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  return AddDefinedMacro(table, macro_name);
+}
+
+result_t AppendToDefinition(macro_table_t *table,
+                            const char *text,
+                            size_t length) {
+  /* Room for the '\0' which ends the definition as well */
+  if (SUCCESS != ReserveDefinitions(table,
+                                    table->definitions_size + length + 1)) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  memcpy(table->definitions + table->definitions_size, text, length);
+  table->definitions_size += length;
+  return SUCCESS;
+}
+
+void DiscardDefinition(macro_table_t *table) {
+  table->definitions_size = table->pending_definition;
+}
 
-  macro_t *macro = CreateMacro(StrDup (macro_name), StrDup (macro_definition));
+result_t AddDefinedMacro(macro_table_t *table, const char *macro_name) {
+  macro_t *macro = NULL;
+  const char *interned_name = NULL;
+  size_t offset = table->pending_definition;
 
+  if (SUCCESS != ReserveDefinitions(table, table->definitions_size + 1) ||
+      SUCCESS != ReserveName(table->index)) {
+    DiscardDefinition(table);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  interned_name = InternString(table->names, macro_name);
+  if (NULL == interned_name) {
+    DiscardDefinition(table);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  macro = CreateMacro(table->arena, interned_name, offset,
+                      table->definitions_size - offset);
   if (NULL == macro) {
+    DiscardDefinition(table);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  if (NULL == AddNode(table->list, macro)) {
+    ArenaFree(table->arena, macro);
+    DiscardDefinition(table);
     return MEM_ALLOCATION_ERROR;
   }
 
-  AddNode(table->list, macro);
+  /* The definition is the macro's now, the next one follows it */
+  table->definitions[table->definitions_size++] = '\0';
+  table->pending_definition = table->definitions_size;
+
+  /* If the name is already indexed, the earlier definition is kept */
+  IndexName(table->index, interned_name, macro);
+
   return SUCCESS;
 }
 
-const char *GetMacroDefinition(macro_t *macro) {
-  return macro->macro_definition;
+const char *GetMacroDefinition(const macro_table_t *table,
+                               const macro_t *macro,
+                               size_t *length) {
+  if (NULL != length) {
+    *length = macro->definition_length;
+  }
+  return table->definitions + macro->definition_offset;
 }
 
 macro_t *FindMacro(macro_table_t *table,
                    const char *macro_name) {
-  node_t *node = Find(table->list, CmpMacro, (void *)macro_name);
-  if (node) {
-    macro_t *macro = GetValue(node);
-    return macro;
-  }
-  else {
+  /* A name which isn't in the pool was never added */
+  const char *interned_name = FindInternedString(table->names, macro_name);
+
+  if (NULL == interned_name) {
     return NULL;
   }
+
+  return (macro_t *)FindIndexedName(table->index, interned_name);
 }
 
-static macro_t *CreateMacro(const char *macro_name,
-                            const char *macro_definition) {
-  macro_t *macro = (macro_t *)malloc(sizeof(macro_t));
+static macro_t *CreateMacro(arena_t *arena,
+                            const char *macro_name,
+                            size_t definition_offset,
+                            size_t definition_length) {
+  macro_t *macro = (macro_t *)ArenaAlloc(arena, sizeof(macro_t));
 
   if (NULL == macro) {
     fprintf(stderr,
@@ -104,13 +238,49 @@ static macro_t *CreateMacro(const char *macro_name,
     return NULL;
   }
 
-  macro->macro_definition = macro_definition;
   macro->macro_name = macro_name;
+  macro->definition_offset = definition_offset;
+  macro->definition_length = definition_length;
 
   return macro;
 }
 
-static int CmpMacro(void *value, void *key) {
-  macro_t *macro = (macro_t *)value;
-  return (0 == strcmp(macro->macro_name, (const char *)key));
+/*
+ * @brief Grows the definitions' buffer (doubling it), so it holds at least
+ *        size characters. Definitions are referred to by offset, so they
+ *        may move.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR (the table is left unchanged).
+ */
+
+static result_t ReserveDefinitions(macro_table_t *table, size_t size) {
+  size_t new_capacity = table->definitions_capacity;
+  char *new_definitions = NULL;
+
+  if (size <= new_capacity) {
+    return SUCCESS;
+  }
+
+  while (new_capacity < size) {
+    new_capacity *= 2;
+  }
+
+  /* In an arena the old buffer is simply abandoned, as the index is */
+  if (NULL == table->arena) {
+    new_definitions = (char *)realloc(table->definitions, new_capacity);
+  }
+  else {
+    new_definitions = (char *)ArenaAlloc(table->arena, new_capacity);
+    if (NULL != new_definitions) {
+      memcpy(new_definitions, table->definitions, table->definitions_size);
+    }
+  }
+
+  if (NULL == new_definitions) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  table->definitions = new_definitions;
+  table->definitions_capacity = new_capacity;
+  return SUCCESS;
 }
@@ -3,13 +3,94 @@
  * The main module that processes command-line arguments and initiates the assembling process.
  */
 
-#include <stdio.h> /* fopen, close */
-#include <stdlib.h>
-#include <unistd.h>
+#define _POSIX_C_SOURCE 200112L /* getcwd, pthreads */
+
+#include <stdio.h> /* printf, tmpfile */
+#include <stdlib.h> /* calloc, free, strtol */
+#include <string.h> /* strcmp, strncmp, strlen */
+#include <unistd.h> /* getcwd */
+#include <pthread.h>
 #include "macro_table.h"
 #include "utils.h"
 #include "assembler.h"
 #include "preprocessing.h"
+#include "arena.h"
+#include "server.h"
+#include "cache.h"
+#include "pipeline.h"
+
+/* Files a server keeps the last assembling of, with --incremental */
+#define MAX_INCREMENTAL_FILES (64)
+
+/*
+ * How main assembles each file, beyond the assembler's own options.
+ * keep_am - Whether to write the expanded source into a .am file.
+ * cache - Cache of whole-file results, consulted before a file is
+ *         preprocessed, or NULL (see cache.h).
+ * streaming - Whether files are assembled in streaming mode, for sources
+ *             too big for memory (see AssembleStream). The cache isn't
+ *             consulted for them.
+ * pipelined - Whether the macros of each file are expanded on another
+ *             thread while it's assembled (see AssemblePipelined). It's
+ *             ignored for incremental reassembly.
+ */
+typedef struct {
+  bool_t keep_am;
+  cache_t *cache;
+  bool_t streaming;
+  bool_t pipelined;
+} driver_config_t;
+
+/* Assembling of a single file passed in argv, in '-j' mode */
+typedef struct {
+  const char *file_name;
+  FILE *diagnostics; /* Messages printed while assembling the file */
+  bool_t failed;
+  bool_t done;
+} assembling_job_t;
+
+/* State shared between the worker threads in '-j' mode */
+typedef struct {
+  assembling_job_t *jobs;
+  int jobs_num;
+  int next_job;
+  const char *directory;
+  driver_config_t driver;
+  assembler_options_t options;
+  pthread_mutex_t lock;
+  pthread_cond_t job_done;
+} job_queue_t;
+
+static bool_t AssembleOneFile(const char *directory,
+                              const char *file_name,
+                              const driver_config_t *driver,
+                              const assembler_options_t *options);
+
+static bool_t AssembleStreaming(const char *directory,
+                                const char *file_name,
+                                bool_t keep_am,
+                                const assembler_options_t *options);
+
+static bool_t AssembleInParallel(char *file_names[],
+                                 int files_num,
+                                 const char *directory,
+                                 const driver_config_t *driver,
+                                 const assembler_options_t *options,
+                                 int threads_num);
+
+static void *AssemblerWorker(void *queue);
+
+static int Serve(const char *directory,
+                 const driver_config_t *driver,
+                 const assembler_options_t *options,
+                 const char *socket_path);
+
+static bool_t AssembleRequestedFile(const char *directory,
+                                    const char *file_name,
+                                    const assembler_options_t *options,
+                                    void *driver);
+
+static void EmitDiagnostics(FILE *diagnostics, FILE *destination);
 
 static const char *ProduceFilePath(const char *dir_path,
                                    const char *file_name,
@@ -17,55 +98,601 @@ static const char *ProduceFilePath(const char *dir_path,
                                    char *full_path);
 
 int main(int argc, char *argv[]) {
-  char input_path[200];
-  char assembler_input_path[200];
   char directory[150];
-  macro_table_t *macro_table = NULL;
   int i = 0;
+  int first_file = 1;
+  int threads_num = 1;
+  driver_config_t driver;
   bool_t assembling_error = FALSE;
+  bool_t server = FALSE;
+  bool_t incremental = FALSE;
+  const char *socket_path = NULL;
+  const char *cache_path = NULL;
+  assembler_options_t options = CreateAssemblerOptions();
+  arena_t *arena = NULL;
+
+  driver.keep_am = FALSE;
+  driver.cache = NULL;
+  driver.streaming = FALSE;
+  driver.pipelined = FALSE;
 
   if (NULL == getcwd(directory, sizeof(directory))) {
     perror ("Error getting the current working directory path");
     return 1;
   }
 
-  printf("dir: %s\n", directory);
+  /* Read options:
+   * --keep-am - The expanded .am file is only written to disk when asked for.
+   * --binary - Write a binary object file (.obj) alongside the .ob file.
+   * -j N - Assemble up to N files at once. A single file is assembled on
+   *        up to N threads instead (see assembler_options_t).
+   * --server - Serve requests from stdin instead (see server.h).
+   * --socket PATH - Serve requests from a UNIX socket instead.
+   * --cache DIR - Reuse the results of unchanged sources (see cache.h).
+   * --incremental - In server mode, reassemble files from their previous
+   *                 assembling (see CreateIncrementalState).
+   * --stream - Assemble sources too big for memory (see AssembleStream).
+   * --pipeline - Expand each file's macros while it's assembled (see
+   *              pipeline.h).
+   */
+  for (first_file = 1; first_file < argc && '-' == argv[first_file][0];
+       ++first_file) {
+    if (0 == strcmp(argv[first_file], "--keep-am")) {
+      driver.keep_am = TRUE;
+    }
+
+    else if (0 == strcmp(argv[first_file], "--server")) {
+      server = TRUE;
+    }
+
+    else if (0 == strcmp(argv[first_file], "--socket") &&
+             first_file + 1 < argc) {
+      socket_path = argv[++first_file];
+    }
+
+    else if (0 == strcmp(argv[first_file], "--cache") &&
+             first_file + 1 < argc) {
+      cache_path = argv[++first_file];
+    }
+
+    else if (0 == strcmp(argv[first_file], "--incremental")) {
+      incremental = TRUE;
+    }
+
+    else if (0 == strcmp(argv[first_file], "--binary")) {
+      options.binary_object = TRUE;
+    }
+
+    else if (0 == strcmp(argv[first_file], "--stream")) {
+      driver.streaming = TRUE;
+    }
+
+    else if (0 == strcmp(argv[first_file], "--pipeline")) {
+      driver.pipelined = TRUE;
+    }
+
+    else if (0 == strncmp(argv[first_file], "-j", 2)) {
+      const char *value = argv[first_file] + 2;
+      char *end = NULL;
+
+      if ('\0' == *value && first_file + 1 < argc) {
+        value = argv[++first_file];
+      }
+
+      threads_num = (int)strtol(value, &end, 10);
+      if (end == value || '\0' != *end || 1 > threads_num) {
+        fprintf(stderr, "Invalid number of jobs '%s'\n", value);
+        return 1;
+      }
+    }
+
+    else {
+      break;
+    }
+  }
 
   /* Handle no arguments passed */
-  if (1 >= argc) {
-    fprintf(stderr, "Usage: %s file_name1 [...]\n", argv[0]);
+  if (first_file >= argc && !server && NULL == socket_path) {
+    fprintf(stderr, "Usage: %s [--keep-am] [--binary] [--cache dir] [--stream] [--pipeline] [-j jobs] file_name1 [...]\n"
+                    "       %s [--keep-am] [--binary] [--cache dir] [--stream] [--pipeline] [--incremental] --server | --socket path\n",
+            argv[0], argv[0]);
     return 1;
   }
 
-  /* For each input file, run the assembler */
-  for (i = 1; i < argc; ++i) {
-    int total_failures = 0; 
-    ProduceFilePath(directory, argv[i], ".as", input_path);
-    ProduceFilePath(directory, argv[i], ".am", assembler_input_path);
+  /* Without a usable cache, every file is assembled */
+  if (NULL != cache_path) {
+    driver.cache = OpenCache(cache_path);
+  }
+
+  if (server || NULL != socket_path) {
+    /* The same files are assembled over & over, mostly with small edits */
+    if (incremental) {
+      options.incremental = CreateIncrementalState(MAX_INCREMENTAL_FILES);
+    }
+
+    assembling_error = Serve(directory, &driver, &options, socket_path);
+
+    if (NULL != options.incremental) {
+      DestroyIncrementalState(options.incremental);
+    }
+  }
+
+  else if (1 < threads_num && 1 < argc - first_file) {
+    printf("dir: %s\n", directory);
+    assembling_error = AssembleInParallel(argv + first_file,
+                                          argc - first_file, directory,
+                                          &driver, &options, threads_num);
+  }
+
+  else {
+    printf("dir: %s\n", directory);
+    options.threads_num = (unsigned int)threads_num;
+
+    /* The state of each file is allocated from one arena, reset in between.
+     * If it can't be created, the heap is used instead. */
+    arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+    options.arena = arena;
 
-    /* Run preprocessing */
-    macro_table = PreprocessFile(input_path, assembler_input_path);
+    /* For each input file, run the assembler */
+    for (i = first_file; i < argc; ++i) {
+      if (FALSE == AssembleOneFile(directory, argv[i], &driver, &options)) {
+        assembling_error = TRUE;
+      }
+    }
+
+    DestroyArena(arena);
+  }
+
+  if (NULL != driver.cache) {
+    unsigned long hits = 0;
+    unsigned long misses = 0;
+
+    GetCacheStats(driver.cache, &hits, &misses);
+    fprintf(server || NULL != socket_path ? stderr : stdout,
+            "Cache: %lu hits, %lu misses\n", hits, misses);
+    CloseCache(driver.cache);
+  }
+
+  return assembling_error;
+}
+
+/*
+ * @brief Preprocesses & assembles a single file. With a cache, the outputs
+ *        of a source that was already assembled are copied from it instead.
+ *
+ * @param directory - The directory in which the file is found.
+ *        file_name - The file's name, without the .as extension.
+ *        driver - How the file is assembled (see driver_config_t).
+ *        options - Assembler options; error messages & status are printed
+ *                  to its diagnostics stream. Its arena (if any) is reset
+ *                  once the file is done.
+ *
+ * @return TRUE if the file was assembled successfully, FALSE otherwise.
+ */
+
+static bool_t AssembleOneFile(const char *directory,
+                              const char *file_name,
+                              const driver_config_t *driver,
+                              const assembler_options_t *options) {
+  bool_t keep_am = driver->keep_am;
+  FILE *diagnostics = options->diagnostics;
+  FILE *captured = NULL;
+  char input_path[200];
+  char assembler_input_path[200];
+  char output_base[200];
+  macro_table_t *macro_table = NULL;
+  source_buffer_t *source = NULL;
+  source_buffer_t *expanded_source = NULL;
+  const char *text = NULL;
+  size_t text_size = 0;
+  unsigned int variant = 0;
+  int total_failures = 0;
+
+  /* The source isn't loaded into memory at all */
+  if (driver->streaming) {
+    return AssembleStreaming(directory, file_name, keep_am, options);
+  }
+
+  ProduceFilePath(directory, file_name, ".as", input_path);
+  ProduceFilePath(directory, file_name, ".am", assembler_input_path);
+  ProduceFilePath(directory, file_name, "", output_base);
+
+  source = LoadSourceFile(input_path);
+  if (NULL == source) {
+    fprintf(diagnostics, BOLD_RED "Assmbler error" COLOR_RESET " for %s\n", file_name);
+    return FALSE;
+  }
+
+  if (NULL != driver->cache) {
+    /* Messages naming the file are restored with its own path, so only
+     * the contents & the options affecting the output make up the key */
+    text = GetSourceText(source, &text_size);
+    variant = (keep_am ? 1 : 0) | (options->binary_object ? 2 : 0);
+
+    if (RestoreFromCache(driver->cache, text, text_size, variant,
+                         output_base, diagnostics)) {
+      fprintf(diagnostics, BOLD_GREEN "Assembler successfully finished" COLOR_RESET " for %s\n", file_name);
+      DestroySourceBuffer(source);
+      return TRUE;
+    }
+
+    /* Messages are captured, to be stored along with the outputs */
+    RemoveOutputFiles(output_base);
+    captured = tmpfile();
+    if (NULL != captured) {
+      diagnostics = captured;
+    }
+  }
+
+  expanded_source = CreateSourceBuffer();
+  if (NULL == expanded_source) {
+    DestroySourceBuffer(source);
+    if (NULL != captured) {
+      fclose(captured);
+    }
+    return FALSE;
+  }
+
+  /* Macros are read first, then expanded while the file is assembled */
+  if (driver->pipelined && NULL == options->incremental) {
+    assembler_options_t file_options = *options;
+    result_t res = SUCCESS;
+
+    file_options.diagnostics = diagnostics;
+    macro_table = ReadMacros(input_path, source, diagnostics, options->arena);
     if (NULL == macro_table) {
       total_failures++;
-      assembling_error = TRUE;
     }
 
-    /* Run assembler */
-    else if (SUCCESS != AssembleFile(assembler_input_path,macro_table)) {
+    else {
+      res = AssemblePipelined(assembler_input_path, source, macro_table,
+                              keep_am ? expanded_source : NULL,
+                              &file_options);
+      if (SUCCESS != res) {
+        total_failures++;
+      }
+
+      /* The expanded source is whole, unless memory ran out */
+      if (keep_am && MEM_ALLOCATION_ERROR != res &&
+          SUCCESS != WriteSourceFile(expanded_source, assembler_input_path)) {
+        total_failures++;
+      }
+    }
+  }
+
+  /* Run preprocessing */
+  else if (NULL == (macro_table = PreprocessBuffer(input_path, source,
+                                                   expanded_source,
+                                                   diagnostics,
+                                                   options->arena))) {
+    total_failures++;
+  }
+
+  else if (keep_am &&
+           SUCCESS != WriteSourceFile(expanded_source, assembler_input_path)) {
+    total_failures++;
+  }
+
+  /* Run assembler */
+  else {
+    assembler_options_t file_options = *options;
+
+    file_options.diagnostics = diagnostics;
+    if (SUCCESS != AssembleSource(assembler_input_path,
+                                  expanded_source,
+                                  macro_table,
+                                  &file_options)) {
+      total_failures++;
+    }
+  }
+
+  if (NULL != macro_table) {
+    DestroyMacroTable(macro_table);
+  }
+  DestroySourceBuffer(expanded_source);
+
+  if (NULL != options->arena) {
+    ResetArena(options->arena);
+  }
+
+  /* Only successful results are cached, failures are assembled again. The
+   * status line names the file, so it's printed anew upon a hit instead */
+  if (NULL != captured && 0 == total_failures) {
+    StoreInCache(driver->cache, text, text_size, variant, output_base,
+                 captured);
+  }
+
+  if (0 == total_failures) {
+    fprintf(diagnostics, BOLD_GREEN "Assembler successfully finished" COLOR_RESET " for %s\n", file_name);
+  }
+  else {
+    fprintf(diagnostics, BOLD_RED "Assmbler error" COLOR_RESET " for %s\n", file_name);
+  }
+
+  if (NULL != captured) {
+    EmitDiagnostics(captured, options->diagnostics);
+    fclose(captured);
+  }
+
+  DestroySourceBuffer(source);
+  return 0 == total_failures ? TRUE : FALSE;
+}
+
+/*
+ * @brief Same as AssembleOneFile, in streaming mode: the expanded source is
+ *        written to the .am file (or a temporary file, unless keep_am), and
+ *        assembled from there (see PreprocessStream & AssembleStream).
+ */
+
+static bool_t AssembleStreaming(const char *directory,
+                                const char *file_name,
+                                bool_t keep_am,
+                                const assembler_options_t *options) {
+  FILE *diagnostics = options->diagnostics;
+  char input_path[200];
+  char assembler_input_path[200];
+  macro_table_t *macro_table = NULL;
+  FILE *expanded_source = NULL;
+  int total_failures = 0;
+
+  ProduceFilePath(directory, file_name, ".as", input_path);
+  ProduceFilePath(directory, file_name, ".am", assembler_input_path);
+
+  expanded_source = keep_am ? fopen(assembler_input_path, "w+") : tmpfile();
+  if (NULL == expanded_source) {
+    perror("Couldn't open a file for the expanded source");
+    total_failures++;
+  }
+
+  /* Run preprocessing */
+  else if (NULL == (macro_table = PreprocessStream(input_path,
+                                                   expanded_source,
+                                                   diagnostics,
+                                                   options->arena))) {
+    total_failures++;
+  }
+
+  /* Run assembler */
+  else {
+    rewind(expanded_source);
+    if (SUCCESS != AssembleStream(assembler_input_path, expanded_source,
+                                  macro_table, options)) {
       total_failures++;
-      assembling_error = TRUE;
     }
+  }
+
+  if (NULL != expanded_source) {
+    fclose(expanded_source);
 
-    if (0 == total_failures) {
-      printf(BOLD_GREEN "Assembler successfully finished" COLOR_RESET " for %s\n", argv[i]);
+    /* As in AssembleOneFile, there's no .am file for a source whose
+     * preprocessing failed */
+    if (keep_am && NULL == macro_table) {
+      remove(assembler_input_path);
     }
-    else {
-      printf(BOLD_RED "Assmbler error" COLOR_RESET " for %s\n", argv[i]);
+  }
+
+  if (NULL != macro_table) {
+    DestroyMacroTable(macro_table);
+  }
+
+  if (NULL != options->arena) {
+    ResetArena(options->arena);
+  }
+
+  if (0 == total_failures) {
+    fprintf(diagnostics, BOLD_GREEN "Assembler successfully finished" COLOR_RESET " for %s\n", file_name);
+  }
+  else {
+    fprintf(diagnostics, BOLD_RED "Assmbler error" COLOR_RESET " for %s\n", file_name);
+  }
+
+  return 0 == total_failures ? TRUE : FALSE;
+}
+
+/*
+ * @brief Assembles several files at once on a pool of worker threads.
+ *        Each file's messages are buffered, and printed in the order the
+ *        files were given, so the output doesn't depend on scheduling.
+ *
+ * @param file_names - The files to assemble, without the .as extension.
+ *        files_num - Number of files in file_names.
+ *        directory - The directory in which the files are found.
+ *        driver - How the files are assembled (see driver_config_t).
+ *        options - Assembler options, applied to every file.
+ *        threads_num - Maximal number of worker threads.
+ *
+ * @return FALSE if all files were assembled successfully, TRUE otherwise.
+ */
+
+static bool_t AssembleInParallel(char *file_names[],
+                                 int files_num,
+                                 const char *directory,
+                                 const driver_config_t *driver,
+                                 const assembler_options_t *options,
+                                 int threads_num) {
+  job_queue_t queue;
+  pthread_t *threads = NULL;
+  int threads_started = 0;
+  bool_t assembling_error = FALSE;
+  int i = 0;
+
+  queue.jobs = (assembling_job_t *)calloc(files_num, sizeof(assembling_job_t));
+  threads = (pthread_t *)calloc(threads_num, sizeof(pthread_t));
+  if (NULL == queue.jobs || NULL == threads) {
+    perror("Error allocating memory for assembling jobs");
+    free(queue.jobs);
+    free(threads);
+    return TRUE;
+  }
+
+  queue.jobs_num = files_num;
+  queue.next_job = 0;
+  queue.directory = directory;
+  queue.driver = *driver;
+  queue.options = *options;
+  pthread_mutex_init(&queue.lock, NULL);
+  pthread_cond_init(&queue.job_done, NULL);
+
+  for (i = 0; i < files_num; ++i) {
+    queue.jobs[i].file_name = file_names[i];
+    queue.jobs[i].diagnostics = tmpfile();
+    if (NULL == queue.jobs[i].diagnostics) {
+      perror("Couldn't create a buffer for error messages");
+      queue.jobs[i].diagnostics = stdout;
     }
   }
+
+  if (threads_num > files_num) {
+    threads_num = files_num;
+  }
+
+  for (i = 0; i < threads_num; ++i) {
+    if (0 != pthread_create(&threads[threads_started], NULL,
+                            AssemblerWorker, &queue)) {
+      break;
+    }
+    ++threads_started;
+  }
+
+  /* Couldn't start any thread, do the work here instead */
+  if (0 == threads_started) {
+    AssemblerWorker(&queue);
+  }
+
+  /* Print the output of each file once it's done, in argv order */
+  for (i = 0; i < files_num; ++i) {
+    assembling_job_t *job = &queue.jobs[i];
+
+    pthread_mutex_lock(&queue.lock);
+    while (FALSE == job->done) {
+      pthread_cond_wait(&queue.job_done, &queue.lock);
+    }
+    pthread_mutex_unlock(&queue.lock);
+
+    if (stdout != job->diagnostics) {
+      EmitDiagnostics(job->diagnostics, stdout);
+      fclose(job->diagnostics);
+    }
+
+    if (job->failed) {
+      assembling_error = TRUE;
+    }
+  }
+
+  for (i = 0; i < threads_started; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  pthread_cond_destroy(&queue.job_done);
+  pthread_mutex_destroy(&queue.lock);
+  free(threads);
+  free(queue.jobs);
   return assembling_error;
 }
 
+/*
+ * @brief Worker thread: takes files from the queue & assembles them, until
+ *        none are left.
+ *
+ * @param queue - The job_queue_t shared by all workers.
+ */
+
+static void *AssemblerWorker(void *queue) {
+  job_queue_t *jobs = (job_queue_t *)queue;
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE); /* Per worker */
+
+  for (;;) {
+    assembling_job_t *job = NULL;
+    assembler_options_t options = jobs->options;
+
+    pthread_mutex_lock(&jobs->lock);
+    if (jobs->next_job < jobs->jobs_num) {
+      job = &jobs->jobs[jobs->next_job];
+      ++jobs->next_job;
+    }
+    pthread_mutex_unlock(&jobs->lock);
+
+    if (NULL == job) {
+      DestroyArena(arena);
+      return NULL;
+    }
+
+    options.diagnostics = job->diagnostics;
+    options.arena = arena;
+    job->failed = AssembleOneFile(jobs->directory, job->file_name,
+                                  &jobs->driver, &options)
+                  ? FALSE : TRUE;
+
+    pthread_mutex_lock(&jobs->lock);
+    job->done = TRUE;
+    pthread_cond_broadcast(&jobs->job_done);
+    pthread_mutex_unlock(&jobs->lock);
+  }
+}
+
+/*
+ * @brief Runs the server mode, on stdin & stdout or on a UNIX socket.
+ *        A single arena serves all requests, reset in between.
+ *
+ * @param socket_path - Path of the socket, or NULL for stdin & stdout.
+ *        Rest of the parameters - As in AssembleOneFile.
+ *
+ * @return The exit status of the program.
+ */
+
+static int Serve(const char *directory,
+                 const driver_config_t *driver,
+                 const assembler_options_t *options,
+                 const char *socket_path) {
+  server_config_t config;
+  driver_config_t file_driver = *driver;
+  int status = 0;
+
+  config.directory = directory;
+  config.options = *options;
+  config.options.arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+  config.assemble_file = AssembleRequestedFile;
+  config.assemble_arg = &file_driver;
+
+  if (NULL != socket_path) {
+    status = (SUCCESS == RunSocketServer(socket_path, &config)) ? 0 : 1;
+  }
+  else {
+    RunServer(stdin, stdout, &config);
+  }
+
+  DestroyArena(config.options.arena);
+  return status;
+}
+
+/*
+ * @brief Assembles the file of a 'file' request (see assemble_file_func_t).
+ *
+ * @param driver - The server's driver_config_t.
+ */
+
+static bool_t AssembleRequestedFile(const char *directory,
+                                    const char *file_name,
+                                    const assembler_options_t *options,
+                                    void *driver) {
+  return AssembleOneFile(directory, file_name,
+                         (const driver_config_t *)driver, options);
+}
+
+/*
+ * @brief Copies the buffered messages of a file to another stream.
+ */
+
+static void EmitDiagnostics(FILE *diagnostics, FILE *destination) {
+  char buffer[4096];
+  size_t read_size = 0;
+
+  rewind(diagnostics);
+  while (0 < (read_size = fread(buffer, 1, sizeof(buffer), diagnostics))) {
+    fwrite(buffer, 1, read_size, destination);
+  }
+}
+
 static const char *ProduceFilePath(const char *dir_path,
                                    const char *file_name,
                                    const char *extension,
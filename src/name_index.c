@@ -0,0 +1,164 @@
+/* name_index.c
+ *
+ * This module implements an index of values by interned names, shared by
+ * the string pool (whose names index themselves) and the symbol & macro
+ * tables.
+ */
+
+#include <stdlib.h> /* free */
+#include <string.h> /* memcmp */
+#include <assert.h> /* assert */
+#include "name_index.h"
+#include "string_pool.h"
+
+/* Capacity is kept at least twice the number of names */
+#define MAX_LOAD_FACTOR_INVERSE (2)
+
+typedef struct {
+  const char *name; /* NULL for an empty slot */
+  void *value;
+} name_slot_t;
+
+struct name_index {
+  name_slot_t *slots;
+  size_t capacity;
+  size_t size;
+  arena_t *arena; /* NULL when the index is allocated on the heap */
+};
+
+static name_slot_t *FindNameSlot(name_slot_t *slots,
+                                 size_t capacity,
+                                 const char *name);
+
+name_index_t *CreateNameIndex(arena_t *arena, size_t initial_capacity) {
+  name_index_t *index =
+    (name_index_t *)ArenaAlloc(arena, sizeof(name_index_t));
+
+  assert(0 < initial_capacity &&
+         0 == (initial_capacity & (initial_capacity - 1)));
+
+  if (NULL == index) {
+    return NULL;
+  }
+
+  index->slots = (name_slot_t *)ArenaCalloc(
+    arena, initial_capacity * sizeof(name_slot_t));
+  if (NULL == index->slots) {
+    ArenaFree(arena, index);
+    return NULL;
+  }
+
+  index->capacity = initial_capacity;
+  index->size = 0;
+  index->arena = arena;
+
+  return index;
+}
+
+void DestroyNameIndex(name_index_t *index) {
+  /* Everything is released along with the arena */
+  if (NULL == index || NULL != index->arena) {
+    return;
+  }
+
+  free(index->slots);
+  free(index);
+}
+
+result_t ReserveName(name_index_t *index) {
+  size_t new_capacity = index->capacity * 2;
+  name_slot_t *new_slots = NULL;
+  size_t i = 0;
+
+  if ((index->size + 1) * MAX_LOAD_FACTOR_INVERSE <= index->capacity) {
+    return SUCCESS;
+  }
+
+  new_slots = (name_slot_t *)ArenaCalloc(index->arena,
+                                         new_capacity * sizeof(name_slot_t));
+  if (NULL == new_slots) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  for (i = 0; i < index->capacity; ++i) {
+    if (NULL != index->slots[i].name) {
+      *FindNameSlot(new_slots, new_capacity, index->slots[i].name) =
+        index->slots[i];
+    }
+  }
+
+  /* In an arena the old slots are simply abandoned */
+  ArenaFree(index->arena, index->slots);
+  index->slots = new_slots;
+  index->capacity = new_capacity;
+
+  return SUCCESS;
+}
+
+void IndexName(name_index_t *index, const char *name, void *value) {
+  name_slot_t *slot = NULL;
+
+  assert(index); assert(name); assert(value);
+  assert((index->size + 1) * MAX_LOAD_FACTOR_INVERSE <= index->capacity);
+
+  slot = FindNameSlot(index->slots, index->capacity, name);
+  if (NULL == slot->name) {
+    slot->name = name;
+    slot->value = value;
+    ++index->size;
+  }
+}
+
+void *FindIndexedName(const name_index_t *index, const char *name) {
+  assert(index); assert(name);
+  return FindNameSlot(index->slots, index->capacity, name)->value;
+}
+
+const char *FindIndexedString(const name_index_t *index,
+                              const char *str,
+                              unsigned long hash,
+                              size_t length) {
+  size_t mask = index->capacity - 1;
+  size_t i = hash & mask;
+
+  assert(index); assert(str);
+
+  while (NULL != index->slots[i].name) {
+    const char *name = index->slots[i].name;
+
+    if (hash == GetInternedHash(name) &&
+        length == GetInternedLength(name) &&
+        (str == name || 0 == memcmp(name, str, length))) {
+      return name;
+    }
+    i = (i + 1) & mask;
+  }
+
+  return NULL;
+}
+
+size_t GetNameIndexSize(const name_index_t *index) {
+  assert(index);
+  return index->size;
+}
+
+/*
+ * @brief Finds the slot which holds an interned name, or the empty slot
+ *        where it should be placed. Names are matched by address.
+ */
+
+static name_slot_t *FindNameSlot(name_slot_t *slots,
+                                 size_t capacity,
+                                 const char *name) {
+  size_t mask = capacity - 1;
+  size_t i = GetInternedHash(name) & mask;
+
+  while (NULL != slots[i].name) {
+    if (name == slots[i].name) {
+      break;
+    }
+    i = (i + 1) & mask;
+  }
+
+  return &slots[i];
+}
@@ -0,0 +1,163 @@
+/* pipeline.c
+ *
+ * This module runs the macro expansion of a file on a producer thread, and
+ * its first pass on the calling thread, handing chunks of expanded lines
+ * from one to the other (see pipeline.h).
+ */
+
+#define _POSIX_C_SOURCE 200112L /* pthreads */
+
+#include <stdio.h> /* fprintf, perror */
+#include <pthread.h>
+#include "pipeline.h"
+#include "preprocessing.h"
+#include "spsc_queue.h"
+
+/* Expanded lines in a chunk, and chunks in flight. A chunk is about as big
+ * as a window of the streaming mode: enough for the threads to rarely wait
+ * on each other, and small enough to stay in the cache. */
+#define PIPELINE_CHUNK_LINES (1024)
+#define PIPELINE_CHUNKS_NUM (8)
+
+/*
+ * State shared by the threads of a pipeline.
+ * expanded - Chunks of expanded lines, in order, for the first pass. An
+ *            empty chunk ends the source.
+ * free_chunks - Chunks the first pass is done with, to be expanded into.
+ * res - Result of the expansion, written by the producer. It's read once
+ *       the producer is joined.
+ */
+
+typedef struct {
+  const source_buffer_t *source;
+  macro_table_t *macro_table;
+  spsc_queue_t *expanded;
+  spsc_queue_t *free_chunks;
+  result_t res;
+} pipeline_t;
+
+static void *ExpandSource(void *pipeline);
+
+result_t AssemblePipelined(char *file_path,
+                           const source_buffer_t *source,
+                           macro_table_t *macro_table,
+                           source_buffer_t *expanded_source,
+                           const assembler_options_t *options) {
+  source_buffer_t *chunks[PIPELINE_CHUNKS_NUM] = {NULL};
+  assembly_t *assembly = CreateAssembly(file_path, macro_table, options);
+  pipeline_t pipeline;
+  pthread_t producer;
+  result_t res = SUCCESS;
+  size_t i = 0;
+
+  pipeline.source = source;
+  pipeline.macro_table = macro_table;
+  pipeline.expanded = CreateSpscQueue(PIPELINE_CHUNKS_NUM);
+  pipeline.free_chunks = CreateSpscQueue(PIPELINE_CHUNKS_NUM);
+  pipeline.res = SUCCESS;
+
+  if (NULL == assembly || NULL == pipeline.expanded ||
+      NULL == pipeline.free_chunks) {
+    res = MEM_ALLOCATION_ERROR;
+  }
+
+  for (i = 0; SUCCESS == res && i < PIPELINE_CHUNKS_NUM; ++i) {
+    chunks[i] = CreateSourceBuffer();
+    if (NULL == chunks[i]) {
+      res = MEM_ALLOCATION_ERROR;
+    }
+    else {
+      PushSpscQueue(pipeline.free_chunks, chunks[i]);
+    }
+  }
+
+  if (SUCCESS == res &&
+      0 != pthread_create(&producer, NULL, ExpandSource, &pipeline)) {
+    fprintf(stderr, "Couldn't start the preprocessing thread\n");
+    res = FAILURE;
+  }
+
+  /* The first pass, as chunks are expanded. After a failure, chunks are
+   * still consumed, so the producer is never left waiting */
+  if (SUCCESS == res) {
+    for (;;) {
+      source_buffer_t *chunk =
+          (source_buffer_t *)PopSpscQueue(pipeline.expanded);
+      const char *text = NULL;
+      size_t text_size = 0;
+
+      if (0 == GetLineCount(chunk)) {
+        break;
+      }
+
+      if (SUCCESS == res) {
+        res = FeedAssembly(assembly, chunk);
+      }
+
+      text = GetSourceText(chunk, &text_size);
+      if (SUCCESS == res && NULL != expanded_source &&
+          SUCCESS != AppendSourceText(expanded_source, text, text_size)) {
+        perror("Error writing to output buffer");
+        res = MEM_ALLOCATION_ERROR;
+      }
+
+      PushSpscQueue(pipeline.free_chunks, chunk);
+    }
+
+    pthread_join(producer, NULL);
+
+    if (SUCCESS == res) {
+      res = pipeline.res;
+    }
+    if (SUCCESS == res) {
+      res = FinishAssembly(assembly);
+    }
+  }
+
+  for (i = 0; i < PIPELINE_CHUNKS_NUM; ++i) {
+    if (NULL != chunks[i]) {
+      DestroySourceBuffer(chunks[i]);
+    }
+  }
+  if (NULL != pipeline.free_chunks) {
+    DestroySpscQueue(pipeline.free_chunks);
+  }
+  if (NULL != pipeline.expanded) {
+    DestroySpscQueue(pipeline.expanded);
+  }
+  if (NULL != assembly) {
+    DestroyAssembly(assembly);
+  }
+
+  return res;
+}
+
+/*
+ * @brief The producer: expands the source into free chunks, and hands them
+ *        to the first pass in order. Once the source is expanded (or memory
+ *        ran out), an empty chunk is handed over.
+ */
+
+static void *ExpandSource(void *pipeline) {
+  pipeline_t *state = (pipeline_t *)pipeline;
+  size_t line_index = 0;
+  bool_t done = FALSE;
+
+  while (!done) {
+    source_buffer_t *chunk = (source_buffer_t *)PopSpscQueue(
+        state->free_chunks);
+
+    ClearSourceBuffer(chunk);
+    state->res = ExpandMacros(state->source, state->macro_table,
+                              &line_index, PIPELINE_CHUNK_LINES, chunk);
+    if (SUCCESS != state->res) {
+      ClearSourceBuffer(chunk);
+    }
+
+    /* The chunk is the first pass's once it's pushed */
+    done = (0 == GetLineCount(chunk));
+    PushSpscQueue(state->expanded, chunk);
+  }
+
+  return NULL;
+}
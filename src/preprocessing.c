@@ -15,112 +15,249 @@
 #include "syntax_errors.h"
 #include "string_utils.h"
 #include "linting.h"
+#include "source_buffer.h"
+
+/* Lines of the source PreprocessStream works on at a time */
+#define STREAM_WINDOW_LINES (4096)
 
 static bool_t IsComment(const char *line);
 
 static bool_t IsNewMacro(const char *line);
 
-static result_t ParseMacro(FILE *file,
+static result_t ParseMacro(const source_buffer_t *source,
+                           size_t *line_index,
                            macro_table_t *table,
                            char *line,
                            syntax_check_config_t *config);
 
-static result_t ReadMacrosInFile(FILE *file,
-                                 macro_table_t *table,
-                                 char *buffer,
-                                 syntax_check_config_t *cfg,
-                                 bool_t *error_occurred);
-
-static char *ReadMacroDefinition(FILE *file,
-                                 char *line,
-                                 syntax_check_config_t *cfg);
-
-static result_t PerformPreprocessing(FILE *input_file,
-                                   FILE *output_file,
+static result_t ReadMacrosInSource(const source_buffer_t *source,
                                    macro_table_t *table,
-                                   char *buffer);
+                                   char *buffer,
+                                   syntax_check_config_t *cfg,
+                                   bool_t *error_occurred);
+
+static result_t ReadMacroDefinition(const source_buffer_t *source,
+                                    size_t *line_index,
+                                    macro_table_t *table,
+                                    char *line,
+                                    syntax_check_config_t *cfg);
+
+static result_t PerformPreprocessing(const source_buffer_t *source,
+                                     size_t *line_index,
+                                     size_t max_lines,
+                                     source_buffer_t *output,
+                                     macro_table_t *table,
+                                     char *buffer);
+
+static result_t ReadSourceWindow(FILE *input,
+                                 source_buffer_t *window,
+                                 char *line);
 
 /* ~~--~~--~~--~~--~~
   Preprocessor
   ~~--~~--~~--~~--~~ */
 
 macro_table_t *PreprocessFile(char *input_path, char *output_path) {
-  bool_t error_occurred = FALSE;
-  char *line = NULL;
-  FILE *input_file = NULL;
-  FILE *output_file = NULL;
-  macro_table_t *table = CreateMacroTable();
-  syntax_check_config_t cfg = CreateSyntaxCheckConfig(input_path, 1, TRUE);
+  macro_table_t *table = NULL;
+  source_buffer_t *output = CreateSourceBuffer();
 
-  /* Acquire resources */
-  line = (char *)malloc(MAX_LINE_LENGTH * sizeof(char));
-  if (NULL == line) {
-    fprintf(stderr,
-            "Memory allocation error: couldn't allocate a buffer\n");
-    return NULL;
-  }
-  if (NULL == table) {
+  if (NULL == output) {
     fprintf(stderr,
-            "Memory allocation error: couldn't allocate a macro table\n");
-    free(line);
+            "Memory allocation error: couldn't allocate an output buffer\n");
     return NULL;
   }
 
-  input_file = fopen(input_path, "r");
-  if (NULL == input_file) {
-    perror("Couldn't open input file");
-    free(line);
+  table = PreprocessSource(input_path, output, stdout, NULL);
+  if (NULL != table && SUCCESS != WriteSourceFile(output, output_path)) {
     DestroyMacroTable(table);
+    table = NULL;
+  }
+
+  DestroySourceBuffer(output);
+  return table;
+}
+
+macro_table_t *PreprocessSource(char *input_path,
+                                source_buffer_t *output,
+                                FILE *diagnostics,
+                                arena_t *arena) {
+  macro_table_t *table = NULL;
+
+  /* The input file is read once, both passes work on it in memory */
+  source_buffer_t *source = LoadSourceFile(input_path);
+  if (NULL == source) {
     return NULL;
   }
 
+  table = PreprocessBuffer(input_path, source, output, diagnostics, arena);
+  DestroySourceBuffer(source);
+  return table;
+}
+
+macro_table_t *PreprocessBuffer(const char *source_name,
+                                const source_buffer_t *source,
+                                source_buffer_t *output,
+                                FILE *diagnostics,
+                                arena_t *arena) {
+  size_t line_index = 0;
+
   /*
    * First pass:
    * Parse macros, populating the macro table.
    * Check for syntax errors in macro definitions.
    */
 
-  if (FILE_HANDLING_ERROR == 
-    ReadMacrosInFile(input_file, table, line, &cfg, &error_occurred)) {
+  macro_table_t *table = ReadMacros(source_name, source, diagnostics, arena);
+  if (NULL == table) {
+    return NULL;
+  }
+
+  /*
+   * Second pass:
+   * Since no errors occurred, write to the output buffer.
+   * Expand macros to their definitions.
+   */
+
+  if (SUCCESS != ExpandMacros(source, table, &line_index, 0, output)) {
+    DestroyMacroTable(table);
+    return NULL;
+  }
+
+  return table;
+}
+
+macro_table_t *ReadMacros(const char *source_name,
+                          const source_buffer_t *source,
+                          FILE *diagnostics,
+                          arena_t *arena) {
+  bool_t error_occurred = FALSE;
+  char line[MAX_LINE_LENGTH];
+  macro_table_t *table = CreateMacroTableInArena(arena);
+  syntax_check_config_t cfg = CreateSyntaxCheckConfig(source_name, 1, TRUE);
+
+  cfg.stream = diagnostics;
+
+  if (NULL == table) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate a macro table\n");
+    return NULL;
+  }
+
+  if (MEM_ALLOCATION_ERROR == 
+    ReadMacrosInSource(source, table, line, &cfg, &error_occurred)) {
       perror("Error parsing file to macros");
       error_occurred = TRUE;
   }
 
-  /* Syntax error reading macros or file handling error */
+  /* Syntax error reading macros or memory allocation error */
   if (TRUE == error_occurred) {
     DestroyMacroTable(table); 
-    free(line);
-    fclose(input_file);
-    return NULL;
+    table = NULL;
+  }
+
+  return table;
+}
+
+result_t ExpandMacros(const source_buffer_t *source,
+                      macro_table_t *table,
+                      size_t *line_index,
+                      size_t max_lines,
+                      source_buffer_t *output) {
+  char line[MAX_LINE_LENGTH];
+
+  return PerformPreprocessing(source, line_index, max_lines, output, table,
+                              line);
+}
+
+macro_table_t *PreprocessStream(char *input_path,
+                                FILE *output,
+                                FILE *diagnostics,
+                                arena_t *arena) {
+  bool_t error_occurred = FALSE;
+  result_t res = SUCCESS;
+  char *line = (char *)malloc(MAX_LINE_LENGTH * sizeof(char));
+  source_buffer_t *window = CreateSourceBuffer();
+  source_buffer_t *expanded = CreateSourceBuffer();
+  macro_table_t *table = CreateMacroTableInArena(arena);
+  FILE *input = NULL;
+  syntax_check_config_t cfg = CreateSyntaxCheckConfig(input_path, 1, TRUE);
+
+  cfg.stream = diagnostics;
+
+  if (NULL == line || NULL == window || NULL == expanded || NULL == table) {
+    fprintf(stderr,
+            "Memory allocation error: couldn't allocate preprocessing buffers\n");
+    res = MEM_ALLOCATION_ERROR;
+  }
+
+  else if (NULL == (input = fopen(input_path, "r"))) {
+    perror("Couldn't open input file");
+    res = ERROR_OPENING_FILE;
   }
 
   /*
-   * Second pass:
-   * Since no errors occurred, write to file.
-   * Expand macros to their definitions.
+   * First pass:
+   * Parse macros, a window at a time.
    */
+  while (SUCCESS == res) {
+    res = ReadSourceWindow(input, window, line);
+    if (SUCCESS != res || 0 == GetLineCount(window)) {
+      break;
+    }
 
-  output_file = fopen(output_path, "w");
-  if (NULL == output_file) {
-    perror("Couldn't open output file");
-    free(line);
-    fclose(input_file);
-    DestroyMacroTable(table);
-    return NULL;
+    if (MEM_ALLOCATION_ERROR ==
+        ReadMacrosInSource(window, table, line, &cfg, &error_occurred)) {
+      perror("Error parsing file to macros");
+      res = MEM_ALLOCATION_ERROR;
+    }
   }
 
-  if (FALSE == error_occurred) {
-    if (fseek(input_file, 0, SEEK_SET)) {
-      perror("Error changing file position");
+  /*
+   * Second pass:
+   * Read the source again, writing each window once it's expanded.
+   */
+  if (SUCCESS == res && FALSE == error_occurred) {
+    rewind(input);
+  }
+
+  while (SUCCESS == res && FALSE == error_occurred) {
+    const char *text = NULL;
+    size_t text_size = 0;
+    size_t line_index = 0;
+
+    res = ReadSourceWindow(input, window, line);
+    if (SUCCESS != res || 0 == GetLineCount(window)) {
+      break;
     }
-    else {
-      PerformPreprocessing(input_file, output_file, table, line);
+
+    ClearSourceBuffer(expanded);
+    line_index = 0;
+    res = PerformPreprocessing(window, &line_index, 0, expanded, table, line);
+
+    text = GetSourceText(expanded, &text_size);
+    if (SUCCESS == res && text_size != fwrite(text, 1, text_size, output)) {
+      perror("Error writing to output file");
+      res = ERROR_WRITING_TO_FILE;
     }
   }
-  
+
+  if (SUCCESS != res || TRUE == error_occurred) {
+    if (NULL != table) {
+      DestroyMacroTable(table);
+    }
+    table = NULL;
+  }
+
+  if (NULL != input) {
+    fclose(input);
+  }
+  if (NULL != expanded) {
+    DestroySourceBuffer(expanded);
+  }
+  if (NULL != window) {
+    DestroySourceBuffer(window);
+  }
   free(line);
-  fclose(input_file);
-  fclose(output_file);
   return table;
 }
 
@@ -157,62 +294,52 @@ static bool_t IsNewMacro(const char *line) {
 
 
 /**
- * @brief Reads macros from a given file and populates the macro table.
+ * @brief Reads macros from a given source and populates the macro table.
  *
- * This function reads through the provided file line by line, using the 
- * provided buffer, and adds any detected macros to the specified macro table.
+ * This function goes over the lines of the source, using the provided buffer,
+ * and adds any detected macros to the specified macro table.
  * The buffer must have a size of at least MAX_LINE_LENGTH.
  *
- * The function analyzes the entire file and, upon completion, returns whether
- * the operation was successful.
+ * The function analyzes the entire source and, upon completion, returns
+ * whether the operation was successful.
  * Additionally, it sets the `error_occurred` flag to indicate if any syntax 
- * errors were encountered during the file analysis.
+ * errors were encountered during the analysis.
  *
- * @param file - A valid pointer to a file object to be read. This file should 
- *             be opened for reading prior to calling this function.
+ * @param source - The source file, loaded into memory.
  *        table - A pointer to the macro table where detected macros will be added.
  *        buffer - A pointer to a pre-allocated buffer with a size of at least 
- *                 MAX_LINE_LENGTH used for reading lines from the file.
+ *                 MAX_LINE_LENGTH into which lines are copied.
  *        error_occurred - A pointer to a boolean flag that will be set to TRUE 
  *                       if any syntax errors occur during the file analysis; 
  *                       otherwise, it will be set to FALSE.
  *        cfg - A pointer to a syntax error analysis configurations object for verbose
  *              error printing.
  * 
- * @return Returns SUCCESS if the entire file was analyzed.
- *         If an error occurred while handling the file, FILE_HANDLING_ERROR is returned.
+ * @return Returns SUCCESS if the entire source was analyzed.
+ *         If a memory allocation error occurred, MEM_ALLOCATION_ERROR is returned.
  */
 
-static result_t ReadMacrosInFile(FILE *file,
-                                 macro_table_t *table,
-                                 char *buffer,
-                                 syntax_check_config_t *cfg,
-                                 bool_t *error_occurred) {
-  long pos = ftell(file);
-
-  if (-1 == pos) {
-    perror("Error getting file position");
-    return FILE_HANDLING_ERROR;
-  }
+static result_t ReadMacrosInSource(const source_buffer_t *source,
+                                   macro_table_t *table,
+                                   char *buffer,
+                                   syntax_check_config_t *cfg,
+                                   bool_t *error_occurred) {
+  size_t i = 0;
 
-  while (NULL != fgets(buffer, MAX_LINE_LENGTH, file)) {
-    buffer = StripWhitespaces(buffer);
+  for (i = 0; i < GetLineCount(source); ++i) {
+    buffer = StripWhitespaces(CopyLine(source, i, buffer));
 
     if (IsNewMacro(buffer)) {
-      if (fseek(file, pos, SEEK_SET)) {
-        perror("Error changing file position");
-        return FILE_HANDLING_ERROR;
+      result_t res = ParseMacro(source, &i, table, buffer, cfg);
+
+      if (MEM_ALLOCATION_ERROR == res) {
+        return MEM_ALLOCATION_ERROR;
       }
-      if (SUCCESS != ParseMacro(file, table, buffer, cfg)) {
+      if (SUCCESS != res) {
         *error_occurred = TRUE;
       }
     }
 
-    pos = ftell(file);
-    if (-1 == pos) {
-      perror("Error getting file position");
-      return FAILURE;
-    }
     ++cfg->line_number;
   }
 
@@ -220,12 +347,12 @@ static result_t ReadMacrosInFile(FILE *file,
 }
 
 /*
- * @brief Reads a single macro definition from a file and adds it to a macro 
- *        table.
+ * @brief Reads a single macro definition from the source and adds it to a
+ *        macro table.
  * 
- * This function processes a macro definition starting from the current file 
- * pointer. 
- * 'file' is updated to point to the next line after the macro definition, and
+ * This function processes a macro definition starting from the line at
+ * 'line_index'.
+ * 'line_index' is updated to the 'endmacr' line of the macro definition, and
  * 'line_number' would be update accordingly.
  *
  * We macros are defined in the format:
@@ -244,14 +371,16 @@ static result_t ReadMacrosInFile(FILE *file,
  *    "endmacrqwe" is illegal.
  * 2. Macro name isn't a reserved name by the language.
  * 
- * @param file - Pointer to a FILE object positioned at the start of a macro
- *               definition. e.g.:
- *               macr m_name <-- file
+ * @param source - The source file, loaded into memory.
+ *
+ *        line_index - Index of the line at the start of a macro definition.
+ *               e.g.:
+ *               macr m_name <-- line_index
  *               ...
  *               endmacr
  *
- *               On successful completion, this will point to the line immediately
- *               following the 'endmacr' directive of the macro definition.
+ *               On completion, this will be the index of the 'endmacr' line
+ *               of the macro definition.
  *
  *        table - Pointer to a macro_table_t structure where the macro will be
  *                added if the macro definition is valid.
@@ -269,12 +398,10 @@ static result_t ReadMacrosInFile(FILE *file,
  *
  *         MEM_ALLOCATION_ERROR if the macro definition was valid but a memory 
  *         allocation error occurred while adding the macro to the table.
- *
- *         FAIL_HANDLING_ERROR if there was an error with the file, e.g. reading 
- *         from it.
  */
 
-static result_t ParseMacro(FILE *file,
+static result_t ParseMacro(const source_buffer_t *source,
+                           size_t *line_index,
                            macro_table_t *table,
                            char *line,
                            syntax_check_config_t *cfg) {
@@ -282,20 +409,16 @@ static result_t ParseMacro(FILE *file,
   result_t res = SUCCESS;
   char *macro_name_start = NULL;
   char *macro_name_end = NULL;
-  char *macro_name = NULL;
-  char *macro_definition = NULL;
+  char macro_name[MAX_LINE_LENGTH];
+  char *save_ptr = NULL;
   bool_t was_error = FALSE;
 
   /*
    * Reading macro name
    */ 
-  if (NULL == fgets(line, MAX_LINE_LENGTH, file)) {
-    perror("Error reading from file");
-    return FILE_HANDLING_ERROR;
-  }
 
   /* Finding where the name starts & ends */
-  line = CleanLine(line); 
+  line = CleanLine(CopyLine(source, *line_index, line)); 
 
   /* Skipping "macr " in the beginning, and "\n\0" in the end. */
   macro_name_start = line + 5; /* strlen("macr "); */
@@ -313,15 +436,12 @@ static result_t ParseMacro(FILE *file,
     was_error = TRUE;
   }
 
-  macro_name = (char *)malloc(macro_name_end - macro_name_start + 1);
-  if (NULL == macro_name) {
-    perror("Error allocating memory for macro name");
-    return MEM_ALLOCATION_ERROR;
-  }
-
-  macro_name = CopySubstring(macro_name_start, macro_name_end, macro_name);
+  /* The line buffer is reused for the definition, so the name is copied */
+  CopySubstring(macro_name_start, macro_name_end, macro_name);
   /* Remove \n if it exists */
-  macro_name = strtok(macro_name, "\n");
+  if (NULL == TokenizeString(macro_name, "\n", &save_ptr)) {
+    macro_name[0] = '\0';
+  }
   
   /*
    * SYNTAX CHECK:
@@ -329,7 +449,6 @@ static result_t ParseMacro(FILE *file,
    * e.g.: "macr mov" 
    */
   if (IsReservedName(macro_name, cfg)) {
-    free(macro_name);
     was_error = TRUE;
   }
   
@@ -339,140 +458,130 @@ static result_t ParseMacro(FILE *file,
    */
 
   if (MacroDefinedMoreThanOnce(macro_name, table, cfg)) {
-    free(macro_name);
     was_error = TRUE;
   }
 
   /*
-   * Reading macro definition 
+   * Reading macro definition, straight into the table
    */
 
-  macro_definition = ReadMacroDefinition(file, line, cfg);
-  if (NULL == macro_definition) {
-    was_error = TRUE; /* Either syntax or memory */
-
+  res = ReadMacroDefinition(source, line_index, table, line, cfg);
+  if (MEM_ALLOCATION_ERROR == res) {
+    DiscardDefinition(table);
+    return MEM_ALLOCATION_ERROR;
   }
-  if (TRUE == was_error){
+  if (SUCCESS != res || TRUE == was_error){
+    DiscardDefinition(table);
     return FAILURE;
   }
 
-  res = AddMacro(table, macro_name, macro_definition);
-  free(macro_name);
-  free(macro_definition);
-
-  return res;
+  return AddDefinedMacro(table, macro_name);
 }
 
 /*
- * @brief Reads a macro definition from file into a string.
+ * @brief Reads a macro definition from the source, appending each of its
+ *        lines (cleaned, see CleanLine) to the definition being written into
+ *        the macro table (see AppendToDefinition). Blank lines are skipped.
  *
- * @param file - File pointer at the start of the macro definition.
+ * @param source - The source file, loaded into memory.
+ *        line_index - Index of the macro's header line ("macr m_name").
+ *                     Upon return, it's the index of the 'endmacr' line (or
+ *                     of the last line, if there's no 'endmacr').
+ *        table - The macro table into which the definition is written.
  *        line - Buffer into which each line of the macro definition will
- *               be read.
+ *               be copied.
  *        cfg - A pointer to a syntax error analysis configurations object for verbose
  *              error printing.
  *
- * @return A pointer to a newly allocated string with the macro's
- *         definition, or NULL if such pointer couldn't be allocated.
+ * @return SUCCESS, FAILURE if there are extra characters after 'endmacr',
+ *         or MEM_ALLOCATION_ERROR. The definition is left to the caller to
+ *         add or discard.
  */
 
-static char *ReadMacroDefinition(FILE *file,
-                                 char *line,
-                                 syntax_check_config_t *cfg) {
-  size_t definition_size = 0;
-  char *definition = NULL;
-  long starting_pos = 0;
-  char *current_position = NULL;
-
-  starting_pos = ftell(file);
-  if (-1 == starting_pos) {
-    perror("Couldn't save file starting_position");
-    return NULL;
-  }
+static result_t ReadMacroDefinition(const source_buffer_t *source,
+                                    size_t *line_index,
+                                    macro_table_t *table,
+                                    char *line,
+                                    syntax_check_config_t *cfg) {
+  size_t end_line = *line_index + 1;
+  result_t res = SUCCESS;
+
   cfg->line_number++;
-  /* Sum up definition size */
-  while (fgets(line, MAX_LINE_LENGTH, file) && 
-    FALSE == IsPrefix(CleanLine(line), "endmacr")) {
-    if (!IsBlankLine(line)) {
-      definition_size += strlen(line);
+  /* Each line is copied once, into the table's definitions */
+  while (end_line < GetLineCount(source) && 
+    FALSE == IsPrefix(CleanLine(CopyLine(source, end_line, line)), "endmacr")) {
+    if (!IsBlankLine(line) && SUCCESS == res) {
+      res = AppendToDefinition(table, line, strlen(line));
     }
     cfg->line_number++;
+    end_line++;
   }
+
+  /* No endmacr, the definition spans until the end of the source */
+  *line_index = (end_line < GetLineCount(source)) ? end_line : end_line - 1;
+
   /*
    * SYNTAX CHECK: 
    * extra characters after endmacr 
    */
   if (DetectExtraCharacters(line + strlen("endmacr") + 1, cfg)) {
-    return NULL;
+    return FAILURE;
   }
 
-  definition = (char *)malloc(definition_size + 1);
-  if (NULL == definition) {
+  if (SUCCESS != res) {
     perror("Error allocating string for macro definition\n");
-    return NULL;
-  }
-
-  /* Go back to the start of the definition & write to definition */
-  if (0 != fseek(file, starting_pos, SEEK_SET)) { 
-    perror("Failed to go back to the start of the macro definition");
-    free(definition);
-    return NULL;
   }
-
-  current_position = definition;
-  while (fgets(line, MAX_LINE_LENGTH, file) && 
-         FALSE == IsPrefix(CleanLine(line), "endmacr")) {
-    if (!IsBlankLine(line)) {
-      size_t line_length = strlen(line);
-
-      /* Copy the stripped line into the definition */
-      strncpy(current_position, line, line_length);
-      current_position += line_length;
-    }
-  }
-
-  /* Null-terminate the definition string */
-  *current_position = '\0';
-
-  return definition;
+  return res;
 }
 
 /**
- * @brief Performs preprocessing on the input file and writes the result to the output file.
+ * @brief Performs preprocessing on the input source and writes the result to the output buffer.
  *
- * This function processes the input file by removing blank lines, removing comments, 
+ * This function processes the source by removing blank lines, removing comments, 
  * and expanding any macros based on their definitions in the provided macro table. 
- * The processed output is written to the specified output file.
+ * The processed output is appended to the specified output buffer.
  *
- * @param input_file - A pointer to the file to be preprocessed.
- * @param output_file - A pointer to the file where the preprocessed output will be written.
+ * @param source - The source to be preprocessed, loaded into memory.
+ * @param line_index - Index of the first line to preprocess. Upon return, the
+ *                     index of the line after the last one preprocessed.
+ * @param max_lines - Preprocessing stops once at least this many lines were
+ *                    appended to the output, or 0 to preprocess the rest of
+ *                    the source.
+ * @param output - The source buffer where the preprocessed output will be written.
  * @param table - A pointer to the macro table containing macro definitions for expansion.
- * @param line - A pointer to a buffer used for reading and processing lines.
+ * @param line - A pointer to a buffer (of at least MAX_LINE_LENGTH characters)
+ *               used for processing lines.
  *
- * @return Returns SUCCESS if preprocessing and writing to the output file were successful. 
- *         Returns ERROR_WRITING_TO_FILE if an error occurred while writing to the output file.
+ * @return Returns SUCCESS if preprocessing and writing to the output buffer were successful. 
+ *         Returns MEM_ALLOCATION_ERROR if the output buffer couldn't grow.
  */
 
-static result_t PerformPreprocessing(FILE *input_file,
-                                   FILE *output_file,
-                                   macro_table_t *table,
-                                   char *line) {
-
-  while (NULL != fgets(line, MAX_LINE_LENGTH, input_file)) {
+static result_t PerformPreprocessing(const source_buffer_t *source,
+                                     size_t *line_index,
+                                     size_t max_lines,
+                                     source_buffer_t *output,
+                                     macro_table_t *table,
+                                     char *line) {
+  size_t first_output_line = GetLineCount(output);
+  size_t i = 0;
+
+  for (i = *line_index; i < GetLineCount(source) &&
+       (0 == max_lines ||
+        GetLineCount(output) - first_output_line < max_lines); ++i) {
     bool_t should_write_line = TRUE;
     const char *str_to_write = NULL;
+    size_t length_to_write = 0;
 
     /* Remove leading and trailing whitespaces & collapse extra whitespaces 
      * into one.
      */
-    line = CleanLine(line);
+    line = CleanLine(CopyLine(source, i, line));
 
     /* Skip macro definitions */
     if (IsNewMacro(line)) {
-      while(FALSE == IsPrefix(line, "endmacr")) {
-        /* Assuming every macro has endmacr! */
-        fgets(line, MAX_LINE_LENGTH, input_file); 
-        line = (char *)StripLeadingWhitespaces(line);
+      while(FALSE == IsPrefix(line, "endmacr") && i + 1 < GetLineCount(source)) {
+        ++i;
+        line = (char *)StripLeadingWhitespaces(CopyLine(source, i, line));
       }
       should_write_line = FALSE;
     }
@@ -498,22 +607,65 @@ static result_t PerformPreprocessing(FILE *input_file,
       }
 
       if (NULL != macro) { /* Macro usage */
-        str_to_write = GetMacroDefinition(macro);
+        str_to_write = GetMacroDefinition(table, macro, &length_to_write);
       } 
       else {
         str_to_write = line;
+        length_to_write = strlen(line);
       }
     }
 
-    /* Write to output file */
+    /* Write to output buffer */
     if (should_write_line) {
-      if (EOF == fputs(str_to_write, output_file)) {
-        perror("Error writing to file");
-        return ERROR_WRITING_TO_FILE;
+      if (SUCCESS != AppendSourceText(output, str_to_write, length_to_write)) {
+        perror("Error writing to output buffer");
+        return MEM_ALLOCATION_ERROR;
       }
     }
   }
 
+  *line_index = i;
   return SUCCESS;
 }
 
+/*
+ * @brief Reads the next window of a source: STREAM_WINDOW_LINES lines, and
+ *        if a macro definition starts among them, the rest of it, so a
+ *        definition is never split between windows.
+ *
+ * @param input - The source file.
+ *        window - Source buffer into which the lines are read. Its previous
+ *                 lines are discarded.
+ *        line - A buffer of at least MAX_LINE_LENGTH characters.
+ *
+ * @return SUCCESS (the window is empty at the end of the source),
+ *         MEM_ALLOCATION_ERROR or FILE_HANDLING_ERROR.
+ */
+
+static result_t ReadSourceWindow(FILE *input,
+                                 source_buffer_t *window,
+                                 char *line) {
+  bool_t in_macro = FALSE;
+  result_t res = SUCCESS;
+
+  ClearSourceBuffer(window);
+
+  while (in_macro || GetLineCount(window) < STREAM_WINDOW_LINES) {
+    size_t lines_num = GetLineCount(window);
+
+    res = ReadSourceLines(window, input, 1);
+    if (SUCCESS != res || lines_num == GetLineCount(window)) {
+      break; /* End of the source */
+    }
+
+    line = CleanLine(CopyLine(window, lines_num, line));
+    if (IsNewMacro(line)) {
+      in_macro = TRUE;
+    }
+    else if (IsPrefix(line, "endmacr")) {
+      in_macro = FALSE;
+    }
+  }
+
+  return res;
+}
@@ -0,0 +1,385 @@
+/* server.c
+ *
+ * This module implements the server mode (see server.h): it parses requests
+ * from a stream, hands them to the assembler, and writes back responses.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* fdopen, sockets */
+
+#include <stdio.h> /* fgets, fread, fprintf, tmpfile */
+#include <stdlib.h> /* realloc, free, strtoul */
+#include <string.h> /* strcmp, strlen, memset */
+#include <errno.h>
+#include <signal.h> /* signal, SIGPIPE */
+#include <unistd.h> /* close, dup, unlink */
+#include <sys/stat.h> /* lstat, S_ISSOCK */
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "libassembler.h"
+#include "string_utils.h"
+
+/* Longest request line (a batch of file names) */
+#define MAX_REQUEST_LENGTH (4096)
+#define REQUEST_DELIMITERS " \t\r\n"
+
+/* Streams & buffers of a session, reused by all of its requests. The
+ * messages & object of a response are collected in temporary files, since
+ * their lengths are sent before them. */
+typedef struct {
+  FILE *requests;
+  FILE *responses;
+  FILE *messages;
+  FILE *object;
+  char *source;
+  size_t source_capacity;
+  const server_config_t *config;
+} session_t;
+
+static result_t ServeFile(session_t *session, const char *file_name);
+
+static result_t ServeSource(session_t *session, const char *name,
+                            const char *length_str);
+
+static result_t WriteProgramText(FILE *stream,
+                                 const assembled_program_t *program);
+
+static result_t WriteResponse(session_t *session, bool_t ok,
+                              const char *name);
+
+static result_t CopyStream(FILE *from, long length, FILE *to);
+
+bool_t RunServer(FILE *requests, FILE *responses,
+                 const server_config_t *config) {
+  session_t session;
+  char line[MAX_REQUEST_LENGTH];
+  bool_t shutdown = FALSE;
+  result_t res = SUCCESS;
+
+  session.requests = requests;
+  session.responses = responses;
+  session.messages = tmpfile();
+  session.object = tmpfile();
+  session.source = NULL;
+  session.source_capacity = 0;
+  session.config = config;
+
+  if (NULL == session.messages || NULL == session.object) {
+    perror("Couldn't create a buffer for responses");
+    res = FAILURE;
+  }
+
+  while (SUCCESS == res && NULL != fgets(line, sizeof(line), requests)) {
+    char *save_ptr = NULL;
+    char *command = NULL;
+    char *name = NULL;
+
+    /* The whole line must fit in the buffer */
+    if (NULL == strchr(line, '\n') && !feof(requests)) {
+      fprintf(session.messages, "Request is too long\n");
+      WriteResponse(&session, FALSE, "-");
+      break;
+    }
+
+    command = TokenizeString(line, REQUEST_DELIMITERS, &save_ptr);
+    if (NULL == command) {
+      continue;
+    }
+
+    if (0 == strcmp(command, "quit")) {
+      break;
+    }
+
+    else if (0 == strcmp(command, "shutdown")) {
+      shutdown = TRUE;
+      break;
+    }
+
+    else if (0 == strcmp(command, "file")) {
+      name = TokenizeString(NULL, REQUEST_DELIMITERS, &save_ptr);
+      while (SUCCESS == res && NULL != name) {
+        res = ServeFile(&session, name);
+        name = TokenizeString(NULL, REQUEST_DELIMITERS, &save_ptr);
+      }
+    }
+
+    else if (0 == strcmp(command, "source")) {
+      name = TokenizeString(NULL, REQUEST_DELIMITERS, &save_ptr);
+      res = ServeSource(&session, name,
+                        TokenizeString(NULL, REQUEST_DELIMITERS, &save_ptr));
+    }
+
+    else {
+      fprintf(session.messages, "Unknown request '%s'\n", command);
+      res = WriteResponse(&session, FALSE, "-");
+    }
+
+    /* A batch is done, the client may be waiting for it */
+    if (EOF == fflush(responses)) {
+      res = ERROR_WRITING_TO_FILE;
+    }
+  }
+
+  fflush(responses);
+  if (NULL != session.messages) {
+    fclose(session.messages);
+  }
+  if (NULL != session.object) {
+    fclose(session.object);
+  }
+  free(session.source);
+  return shutdown;
+}
+
+result_t RunSocketServer(const char *socket_path,
+                         const server_config_t *config) {
+  struct sockaddr_un address;
+  struct stat status;
+  int listener = -1;
+  bool_t shutdown = FALSE;
+
+  if (strlen(socket_path) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket path '%s' is too long\n", socket_path);
+    return FAILURE;
+  }
+
+  /* Only a stale socket may be replaced, never another file */
+  if (0 == lstat(socket_path, &status)) {
+    if (!S_ISSOCK(status.st_mode)) {
+      fprintf(stderr, "'%s' exists and isn't a socket\n", socket_path);
+      return FAILURE;
+    }
+
+    if (0 != unlink(socket_path)) {
+      perror("Couldn't remove the old socket");
+      return FAILURE;
+    }
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, socket_path);
+
+  listener = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (0 > listener) {
+    perror("Couldn't create a socket");
+    return FAILURE;
+  }
+
+  if (0 != bind(listener, (struct sockaddr *)&address, sizeof(address)) ||
+      0 != listen(listener, 16)) {
+    perror("Couldn't listen on the socket");
+    close(listener);
+    return FAILURE;
+  }
+
+  /* A client which disconnects early mustn't kill the server */
+  signal(SIGPIPE, SIG_IGN);
+
+  while (FALSE == shutdown) {
+    FILE *requests = NULL;
+    FILE *responses = NULL;
+    int connection = accept(listener, NULL, NULL);
+
+    if (0 > connection) {
+      if (EINTR == errno) {
+        continue;
+      }
+      perror("Couldn't accept a connection");
+      break;
+    }
+
+    requests = fdopen(connection, "r");
+    responses = fdopen(dup(connection), "w");
+    if (NULL == requests || NULL == responses) {
+      perror("Couldn't open a stream for the connection");
+      if (NULL != requests) {
+        fclose(requests);
+      } else {
+        close(connection);
+      }
+      if (NULL != responses) {
+        fclose(responses);
+      }
+      continue;
+    }
+
+    shutdown = RunServer(requests, responses, config);
+    fclose(responses);
+    fclose(requests);
+  }
+
+  close(listener);
+  unlink(socket_path);
+  return SUCCESS;
+}
+
+/*
+ * @brief Handles a single file of a 'file' request.
+ *
+ * @return SUCCESS, or an error code if the response couldn't be written.
+ */
+
+static result_t ServeFile(session_t *session, const char *file_name) {
+  const server_config_t *config = session->config;
+  assembler_options_t options = config->options;
+  bool_t ok = FALSE;
+
+  options.diagnostics = session->messages;
+  ok = config->assemble_file(config->directory, file_name, &options,
+                             config->assemble_arg);
+  return WriteResponse(session, ok, file_name);
+}
+
+/*
+ * @brief Handles a 'source' request: reads its text & assembles it in
+ *        memory.
+ *
+ * @param name - Name of the source, or NULL if it's missing.
+ *        length_str - Length of the text, or NULL if it's missing.
+ *
+ * @return SUCCESS, or an error code if the request is malformed, or the text
+ *         or the response couldn't be read or written (after which the
+ *         session can't go on).
+ */
+
+static result_t ServeSource(session_t *session, const char *name,
+                            const char *length_str) {
+  assembler_options_t options = session->config->options;
+  assembled_program_t program;
+  unsigned long length = 0;
+  char *end = NULL;
+  result_t res = SUCCESS;
+
+  /* Without a length, the text can't be told apart from the requests
+   * following it, so the session ends */
+  if (NULL == name || NULL == length_str) {
+    fprintf(session->messages, "Usage: source <name> <length>\n");
+    WriteResponse(session, FALSE, "-");
+    return FAILURE;
+  }
+
+  length = strtoul(length_str, &end, 10);
+  if (end == length_str || '\0' != *end) {
+    fprintf(session->messages, "Invalid length '%s'\n", length_str);
+    WriteResponse(session, FALSE, name);
+    return FAILURE;
+  }
+
+  /* The buffer grows to the longest source seen, and is kept */
+  if (length > session->source_capacity) {
+    char *source = (char *)realloc(session->source, length);
+    if (NULL == source) {
+      perror("Couldn't allocate a buffer for the source");
+      return MEM_ALLOCATION_ERROR;
+    }
+    session->source = source;
+    session->source_capacity = length;
+  }
+
+  if (length != fread(session->source, 1, length, session->requests)) {
+    fprintf(session->messages, "Source '%s' ended early\n", name);
+    WriteResponse(session, FALSE, name);
+    return FILE_HANDLING_ERROR;
+  }
+
+  options.diagnostics = session->messages;
+  res = AssembleText(name, session->source, length, &options, &program);
+  if (SUCCESS != res) {
+    return WriteResponse(session, FALSE, name);
+  }
+
+  res = WriteProgramText(session->object, &program);
+  DestroyAssembledProgram(&program);
+  if (SUCCESS != res) {
+    return res;
+  }
+
+  return WriteResponse(session, TRUE, name);
+}
+
+/*
+ * @brief Writes an assembled program in the textual format of the output
+ *        files (see server.h).
+ */
+
+static result_t WriteProgramText(FILE *stream,
+                                 const assembled_program_t *program) {
+  size_t i = 0;
+
+  fprintf(stream, "%lu %lu\n", (unsigned long)program->code_size,
+          (unsigned long)program->data_size);
+
+  for (i = 0; i < program->code_size; ++i) {
+    fprintf(stream, "%04lu %05o\n", (unsigned long)(INITIAL_IC_VALUE + i),
+            (unsigned int)program->code[i]);
+  }
+
+  for (i = 0; i < program->data_size; ++i) {
+    fprintf(stream, "%04lu %05o\n",
+            (unsigned long)(INITIAL_IC_VALUE + program->code_size + i),
+            (unsigned int)program->data[i]);
+  }
+
+  fprintf(stream, "entries %lu\n", (unsigned long)program->entries_num);
+  for (i = 0; i < program->entries_num; ++i) {
+    fprintf(stream, "%s %u\n", program->entries[i].name,
+            program->entries[i].address);
+  }
+
+  fprintf(stream, "externals %lu\n", (unsigned long)program->externals_num);
+  for (i = 0; i < program->externals_num; ++i) {
+    fprintf(stream, "%s %04u\n", program->externals[i].name,
+            program->externals[i].address);
+  }
+
+  return ferror(stream) ? ERROR_WRITING_TO_FILE : SUCCESS;
+}
+
+/*
+ * @brief Writes a response, with whatever was written to the session's
+ *        messages & object since they were last rewound.
+ */
+
+static result_t WriteResponse(session_t *session, bool_t ok,
+                              const char *name) {
+  long messages_length = ftell(session->messages);
+  long object_length = ftell(session->object);
+
+  fprintf(session->responses, "%s %s %ld %ld\n", ok ? "ok" : "error", name,
+          messages_length, object_length);
+
+  if (SUCCESS != CopyStream(session->messages, messages_length,
+                            session->responses) ||
+      SUCCESS != CopyStream(session->object, object_length,
+                            session->responses)) {
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  /* The next response starts from empty buffers */
+  rewind(session->messages);
+  rewind(session->object);
+  return ferror(session->responses) ? ERROR_WRITING_TO_FILE : SUCCESS;
+}
+
+/*
+ * @brief Copies the first 'length' bytes of a stream to another stream.
+ */
+
+static result_t CopyStream(FILE *from, long length, FILE *to) {
+  char buffer[4096];
+
+  rewind(from);
+  while (0 < length) {
+    size_t chunk = (size_t)length < sizeof(buffer) ? (size_t)length
+                                                   : sizeof(buffer);
+
+    if (chunk != fread(buffer, 1, chunk, from) ||
+        chunk != fwrite(buffer, 1, chunk, to)) {
+      return ERROR_WRITING_TO_FILE;
+    }
+    length -= (long)chunk;
+  }
+
+  return SUCCESS;
+}
@@ -0,0 +1,295 @@
+/* source_buffer.c
+ *
+ * This module implements the source buffer, which holds a whole source file
+ * in memory along with the index of its lines.
+ */
+
+#include <stdio.h> /* fopen, fread, fgets, perror */
+#include <stdlib.h> /* malloc, realloc, free */
+#include <string.h> /* memcpy, strlen */
+#include "source_buffer.h"
+#include "language_definitions.h"
+#include "vector.h"
+
+#define INITIAL_TEXT_CAPACITY (4096)
+#define INITIAL_LINES_CAPACITY (64)
+
+typedef struct {
+  size_t offset;
+  size_t length;
+} line_span_t;
+
+struct source_buffer {
+  char *text;
+  size_t text_size;
+  size_t text_capacity;
+  vector_t *lines;
+};
+
+static result_t ReserveText(source_buffer_t *buffer, size_t new_capacity);
+static result_t ReadWholeFile(FILE *file, source_buffer_t *buffer);
+static result_t IndexLines(source_buffer_t *buffer, size_t from);
+
+source_buffer_t *CreateSourceBuffer(void) {
+  source_buffer_t *buffer = (source_buffer_t *)malloc(sizeof(source_buffer_t));
+
+  if (NULL == buffer) {
+    perror("Couldn't allocate memory for source buffer");
+    return NULL;
+  }
+
+  buffer->text = (char *)malloc(INITIAL_TEXT_CAPACITY);
+  if (NULL == buffer->text) {
+    perror("Couldn't allocate memory for source buffer");
+    free(buffer);
+    return NULL;
+  }
+  buffer->text_size = 0;
+  buffer->text_capacity = INITIAL_TEXT_CAPACITY;
+
+  buffer->lines = CreateVector(INITIAL_LINES_CAPACITY, sizeof(line_span_t));
+  if (NULL == buffer->lines) {
+    free(buffer->text);
+    free(buffer);
+    return NULL;
+  }
+
+  return buffer;
+}
+
+source_buffer_t *LoadSourceFile(const char *path) {
+  FILE *file = NULL;
+  source_buffer_t *buffer = CreateSourceBuffer();
+
+  if (NULL == buffer) {
+    return NULL;
+  }
+
+  file = fopen(path, "r");
+  if (NULL == file) {
+    perror("Couldn't open input file");
+    DestroySourceBuffer(buffer);
+    return NULL;
+  }
+
+  if (SUCCESS != ReadWholeFile(file, buffer)) {
+    fclose(file);
+    DestroySourceBuffer(buffer);
+    return NULL;
+  }
+  fclose(file);
+
+  if (SUCCESS != IndexLines(buffer, 0)) {
+    perror("Couldn't allocate memory for source buffer");
+    DestroySourceBuffer(buffer);
+    return NULL;
+  }
+
+  return buffer;
+}
+
+result_t AppendSourceText(source_buffer_t *buffer,
+                          const char *text,
+                          size_t length) {
+  size_t index_from = buffer->text_size;
+  size_t required_capacity = buffer->text_capacity;
+
+  while (buffer->text_size + length > required_capacity) {
+    required_capacity *= 2;
+  }
+  if (SUCCESS != ReserveText(buffer, required_capacity)) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  memcpy(buffer->text + buffer->text_size, text, length);
+  buffer->text_size += length;
+
+  /* If the last line wasn't complete, the new text continues it */
+  if (!IsEmptyVector(buffer->lines)) {
+    line_span_t *last_line = (line_span_t *)GetElementVector(
+        buffer->lines, GetSizeVector(buffer->lines) - 1);
+    const char *last_char = buffer->text + index_from - 1;
+
+    if ('\n' != *last_char && MAX_LINE_LENGTH - 1 != last_line->length) {
+      index_from = last_line->offset;
+      RemoveLastVector(buffer->lines);
+    }
+  }
+
+  return IndexLines(buffer, index_from);
+}
+
+result_t ReadSourceLines(source_buffer_t *buffer, FILE *file,
+                         size_t max_lines) {
+  char line[MAX_LINE_LENGTH];
+  size_t lines_read = 0;
+
+  for (lines_read = 0; lines_read < max_lines; ++lines_read) {
+    if (NULL == fgets(line, sizeof(line), file)) {
+      break;
+    }
+
+    /* fgets splits lines exactly like IndexLines does */
+    if (SUCCESS != AppendSourceText(buffer, line, strlen(line))) {
+      perror("Couldn't allocate memory for source buffer");
+      return MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  if (ferror(file)) {
+    perror("Error reading from file");
+    return FILE_HANDLING_ERROR;
+  }
+
+  return SUCCESS;
+}
+
+void ClearSourceBuffer(source_buffer_t *buffer) {
+  buffer->text_size = 0;
+  while (!IsEmptyVector(buffer->lines)) {
+    RemoveLastVector(buffer->lines);
+  }
+}
+
+result_t WriteSourceFile(const source_buffer_t *buffer, const char *path) {
+  FILE *file = fopen(path, "w");
+
+  if (NULL == file) {
+    perror("Couldn't open output file");
+    return ERROR_OPENING_FILE;
+  }
+
+  if (buffer->text_size != fwrite(buffer->text, 1, buffer->text_size, file)) {
+    perror("Error writing to file");
+    fclose(file);
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  if (0 != fclose(file)) {
+    perror("Error writing to file");
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  return SUCCESS;
+}
+
+void DestroySourceBuffer(source_buffer_t *buffer) {
+  free(buffer->text);
+  DestroyVector(buffer->lines);
+  free(buffer);
+}
+
+size_t GetLineCount(const source_buffer_t *buffer) {
+  return GetSizeVector(buffer->lines);
+}
+
+const char *GetSourceText(const source_buffer_t *buffer, size_t *size) {
+  *size = buffer->text_size;
+  return buffer->text;
+}
+
+const char *GetLine(const source_buffer_t *buffer, size_t index, size_t *length) {
+  line_span_t *span = (line_span_t *)GetElementVector(buffer->lines, index);
+
+  *length = span->length;
+  return buffer->text + span->offset;
+}
+
+char *CopyLine(const source_buffer_t *buffer, size_t index, char *dest) {
+  size_t length = 0;
+  const char *line = GetLine(buffer, index, &length);
+
+  memcpy(dest, line, length);
+  dest[length] = '\0';
+  return dest;
+}
+
+/*
+ * @brief Reads the contents of a file into the buffer's text, growing it as
+ *        needed.
+ *
+ * @return SUCCESS, MEM_ALLOCATION_ERROR or FILE_HANDLING_ERROR (an
+ *         appropriate error is printed for the latter two).
+ */
+
+static result_t ReadWholeFile(FILE *file, source_buffer_t *buffer) {
+  size_t bytes_read = 0;
+
+  while (0 < (bytes_read = fread(buffer->text + buffer->text_size,
+                                 1,
+                                 buffer->text_capacity - buffer->text_size,
+                                 file))) {
+    buffer->text_size += bytes_read;
+
+    if (buffer->text_size == buffer->text_capacity &&
+        SUCCESS != ReserveText(buffer, buffer->text_capacity * 2)) {
+      perror("Couldn't allocate memory for source buffer");
+      return MEM_ALLOCATION_ERROR;
+    }
+  }
+
+  if (ferror(file)) {
+    perror("Error reading from file");
+    return FILE_HANDLING_ERROR;
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Grows the capacity of the buffer's text.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t ReserveText(source_buffer_t *buffer, size_t new_capacity) {
+  char *tmp = NULL;
+
+  if (new_capacity <= buffer->text_capacity) {
+    return SUCCESS;
+  }
+
+  tmp = (char *)realloc(buffer->text, new_capacity);
+  if (NULL == tmp) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  buffer->text = tmp;
+  buffer->text_capacity = new_capacity;
+  return SUCCESS;
+}
+
+/*
+ * @brief Splits the buffer's text into lines, the same way fgets would.
+ *
+ * @param buffer - The source buffer.
+ *        from - Offset in the text from which lines are indexed. Must be the
+ *               start of a line.
+ *
+ * @return SUCCESS, or MEM_ALLOCATION_ERROR.
+ */
+
+static result_t IndexLines(source_buffer_t *buffer, size_t from) {
+  line_span_t span = {0, 0};
+  size_t i = 0;
+
+  span.offset = from;
+  for (i = from; i < buffer->text_size; ++i) {
+    ++span.length;
+
+    if ('\n' == buffer->text[i] || MAX_LINE_LENGTH - 1 == span.length) {
+      if (SUCCESS != AppendVector(buffer->lines, &span)) {
+        return MEM_ALLOCATION_ERROR;
+      }
+      span.offset = i + 1;
+      span.length = 0;
+    }
+  }
+
+  /* Last line, without a terminating '\n' */
+  if (0 != span.length) {
+    return AppendVector(buffer->lines, &span);
+  }
+
+  return SUCCESS;
+}
@@ -0,0 +1,97 @@
+/* spsc_queue.c
+ *
+ * This module implements the single producer, single consumer queue.
+ *
+ * head & tail count the elements popped & pushed so far; the element at
+ * position i lives in slot i % capacity. They're kept on cache lines of
+ * their own, so the producer & the consumer don't invalidate each other's
+ * line on every element.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* sched_yield */
+
+#include <stdlib.h> /* malloc, free */
+#include <sched.h> /* sched_yield */
+#include "spsc_queue.h"
+
+#define CACHE_LINE_SIZE (64)
+
+struct spsc_queue {
+  void **slots;
+  size_t mask; /* capacity - 1 */
+  char head_padding[CACHE_LINE_SIZE];
+  size_t head; /* Written by the consumer */
+  char tail_padding[CACHE_LINE_SIZE];
+  size_t tail; /* Written by the producer */
+  char end_padding[CACHE_LINE_SIZE];
+};
+
+spsc_queue_t *CreateSpscQueue(size_t capacity) {
+  spsc_queue_t *queue = (spsc_queue_t *)malloc(sizeof(spsc_queue_t));
+  size_t rounded_capacity = 1;
+
+  if (NULL == queue) {
+    return NULL;
+  }
+
+  while (rounded_capacity < capacity) {
+    rounded_capacity *= 2;
+  }
+
+  queue->slots = (void **)malloc(rounded_capacity * sizeof(void *));
+  if (NULL == queue->slots) {
+    free(queue);
+    return NULL;
+  }
+
+  queue->mask = rounded_capacity - 1;
+  queue->head = 0;
+  queue->tail = 0;
+
+  return queue;
+}
+
+void DestroySpscQueue(spsc_queue_t *queue) {
+  free(queue->slots);
+  free(queue);
+}
+
+bool_t TryPushSpscQueue(spsc_queue_t *queue, void *element) {
+  size_t tail = queue->tail; /* Only the producer writes it */
+
+  if (tail - __atomic_load_n(&queue->head, __ATOMIC_ACQUIRE) > queue->mask) {
+    return FALSE;
+  }
+
+  queue->slots[tail & queue->mask] = element;
+  __atomic_store_n(&queue->tail, tail + 1, __ATOMIC_RELEASE);
+  return TRUE;
+}
+
+bool_t TryPopSpscQueue(spsc_queue_t *queue, void **element) {
+  size_t head = queue->head; /* Only the consumer writes it */
+
+  if (head == __atomic_load_n(&queue->tail, __ATOMIC_ACQUIRE)) {
+    return FALSE;
+  }
+
+  *element = queue->slots[head & queue->mask];
+  __atomic_store_n(&queue->head, head + 1, __ATOMIC_RELEASE);
+  return TRUE;
+}
+
+void PushSpscQueue(spsc_queue_t *queue, void *element) {
+  while (!TryPushSpscQueue(queue, element)) {
+    sched_yield();
+  }
+}
+
+void *PopSpscQueue(spsc_queue_t *queue) {
+  void *element = NULL;
+
+  while (!TryPopSpscQueue(queue, &element)) {
+    sched_yield();
+  }
+
+  return element;
+}
@@ -0,0 +1,129 @@
+/* string_pool.c
+ *
+ * This module implements a pool of interned strings.
+ *
+ * Each string is stored once, right after a header holding its hash &
+ * length, and indexed by a name index (see name_index.h) in which each
+ * string is its own value. Everything is allocated from an arena, so the
+ * strings are never freed one by one.
+ */
+
+#include <stddef.h> /* offsetof */
+#include <string.h> /* memcpy */
+#include <assert.h> /* assert */
+#include "string_pool.h"
+#include "name_index.h"
+#include "string_utils.h"
+#include "utils.h"
+
+#define INITIAL_INDEX_CAPACITY (64)
+
+typedef struct {
+  unsigned long hash;
+  size_t length;
+  char text[1]; /* Actually length + 1 characters */
+} interned_string_t;
+
+#define TO_INTERNED(str) \
+  ((const interned_string_t *)((str) - offsetof(interned_string_t, text)))
+
+struct string_pool {
+  name_index_t *index;
+  arena_t *arena;
+  arena_t *own_arena; /* The arena created by the pool, if any */
+};
+
+string_pool_t *CreateStringPool(arena_t *arena) {
+  arena_t *own_arena = NULL;
+  string_pool_t *pool = NULL;
+
+  if (NULL == arena) {
+    own_arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+    if (NULL == own_arena) {
+      return NULL;
+    }
+    arena = own_arena;
+  }
+
+  pool = (string_pool_t *)ArenaAlloc(arena, sizeof(string_pool_t));
+  if (NULL == pool) {
+    DestroyArena(own_arena);
+    return NULL;
+  }
+
+  pool->index = CreateNameIndex(arena, INITIAL_INDEX_CAPACITY);
+  if (NULL == pool->index) {
+    DestroyArena(own_arena);
+    return NULL;
+  }
+
+  pool->arena = arena;
+  pool->own_arena = own_arena;
+
+  return pool;
+}
+
+void DestroyStringPool(string_pool_t *pool) {
+  if (NULL != pool) {
+    /* The pool itself lives in that arena as well */
+    DestroyArena(pool->own_arena);
+  }
+}
+
+const char *InternString(string_pool_t *pool, const char *str) {
+  size_t length = 0;
+  unsigned long hash = 0;
+  const char *found = NULL;
+  interned_string_t *interned = NULL;
+
+  assert(pool); assert(str);
+
+  hash = HashString(str, &length);
+  found = FindIndexedString(pool->index, str, hash, length);
+  if (NULL != found) {
+    return found;
+  }
+
+  if (SUCCESS != ReserveName(pool->index)) {
+    return NULL;
+  }
+
+  interned = (interned_string_t *)ArenaAlloc(
+    pool->arena, offsetof(interned_string_t, text) + length + 1);
+  if (NULL == interned) {
+    return NULL;
+  }
+
+  interned->hash = hash;
+  interned->length = length;
+  memcpy(interned->text, str, length + 1);
+
+  IndexName(pool->index, interned->text, interned->text);
+
+  return interned->text;
+}
+
+const char *FindInternedString(string_pool_t *pool, const char *str) {
+  size_t length = 0;
+  unsigned long hash = 0;
+
+  assert(pool); assert(str);
+
+  hash = HashString(str, &length);
+  return FindIndexedString(pool->index, str, hash, length);
+}
+
+unsigned long GetInternedHash(const char *interned) {
+  assert(interned);
+  return TO_INTERNED(interned)->hash;
+}
+
+size_t GetInternedLength(const char *interned) {
+  assert(interned);
+  return TO_INTERNED(interned)->length;
+}
+
+size_t GetStringPoolSize(const string_pool_t *pool) {
+  assert(pool);
+  return GetNameIndexSize(pool->index);
+}
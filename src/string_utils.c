@@ -6,10 +6,14 @@
 
 
 
-#include <string.h> /* strncmp, strlen */
+#include <string.h> /* strncmp, strlen, memcpy, strspn, strcspn */
 #include <stdlib.h> /* malloc, free */
 #include "string_utils.h"
 
+#define FNV_OFFSET_BASIS (2166136261UL)
+#define FNV_PRIME (16777619UL)
+#define HASH_MASK (0xFFFFFFFFUL)
+
 bool_t IsPrefix(const char *str, const char *prefix) {
   return (0 == strncmp(str, prefix, strlen(prefix)));
 }
@@ -60,7 +64,7 @@ const char *EndOfString(const char *str) {
 char *CopySubstring(const char *from, const char *to, char *dest) {
   size_t length = to - from;
 
-  strncpy(dest, from, length);
+  memcpy(dest, from, length);
   dest[length] = '\0';
   return dest;
 }
@@ -79,3 +83,60 @@ char *StrDup(const char *str) {
 int IsBlank(int c) {
   return ((' ' == c) || ('\t' == c));
 }
+
+char *TokenizeString(char *str, const char *delimiters, char **save_ptr) {
+  char *token = NULL;
+
+  if (NULL == str) {
+    str = *save_ptr;
+  }
+
+  /* Skip leading delimiters */
+  str += strspn(str, delimiters);
+  if ('\0' == *str) {
+    *save_ptr = str;
+    return NULL;
+  }
+
+  /* Terminate the token, and continue after it next time */
+  token = str;
+  str += strcspn(str, delimiters);
+  if ('\0' != *str) {
+    *str = '\0';
+    ++str;
+  }
+
+  *save_ptr = str;
+  return token;
+}
+
+unsigned long HashString(const char *str, size_t *length) {
+  const char *ptr = str;
+  unsigned long hash = FNV_OFFSET_BASIS;
+
+  while ('\0' != *ptr) {
+    hash ^= (unsigned char)*ptr;
+    hash = (hash * FNV_PRIME) & HASH_MASK;
+    ++ptr;
+  }
+
+  if (NULL != length) {
+    *length = ptr - str;
+  }
+
+  return hash;
+}
+
+unsigned long HashBytes(const void *data, size_t size, unsigned long seed) {
+  const unsigned char *ptr = (const unsigned char *)data;
+  const unsigned char *end = ptr + size;
+  unsigned long hash = (0 == seed) ? FNV_OFFSET_BASIS : seed;
+
+  while (ptr < end) {
+    hash ^= *ptr;
+    hash = (hash * FNV_PRIME) & HASH_MASK;
+    ++ptr;
+  }
+
+  return hash;
+}
@@ -2,20 +2,29 @@
  *
  * This module implements the 'symbol' and 'symbol_table' structures. It provides essential utilities 
  * for managing the symbol table, such as adding and finding symbols, converting to a list, retrieving symbol data, and more.
+ *
+ * Symbols are kept in a list (in order of definition, which is the order
+ * AsList returns), and indexed by their names (see name_index.h), so that
+ * looking a symbol up by name doesn't walk the list.
+ *
+ * Symbol names are interned in a string pool, so the index compares names
+ * by address, and reuses the hash stored by the pool.
  */
 
 
 
-#include <stdlib.h> /* malloc */
+#include <stdlib.h> /* free */
 #include <stdio.h> /* perror */
 #include <assert.h> /* assert */
 #include "symbol_table.h"
 #include "utils.h"
-#include "string.h"
-#include "string_utils.h"
+#include "string_pool.h"
+#include "name_index.h"
+
+#define INITIAL_INDEX_CAPACITY (64)
 
 struct symbol_struct {
-  const char *symbol_name;
+  const char *symbol_name; /* Interned in the table's pool */
   symbol_type_t type;
   address_t address;
   symbol_memory_area_t area;
@@ -23,6 +32,10 @@ struct symbol_struct {
 
 struct symbol_table {
   list_t *list;
+  name_index_t *index;
+  arena_t *arena; /* NULL when the table is allocated on the heap */
+  string_pool_t *names;
+  bool_t owns_names; /* Whether the pool was created by the table */
 };
 
 
@@ -32,43 +45,81 @@ static result_t AddSymbolWithType(symbol_table_t *table,
                                  symbol_type_t type,
                                  symbol_memory_area_t area);
 
-static symbol_t *CreateSymbol(const char *symbol_name,
+static symbol_t *CreateSymbol(arena_t *arena,
+                              const char *symbol_name,
                               address_t address,
                               symbol_type_t type,
                               symbol_memory_area_t area);
 
-static int SymbolCompare(void *symbol_ptr, void *key);
-
 
 symbol_table_t *CreateSymbolTable(void) {
-  symbol_table_t *new_symbol_table = (symbol_table_t *)malloc(sizeof(symbol_table_t));
+  return CreateSymbolTableInArena(NULL, NULL);
+}
+
+symbol_table_t *CreateSymbolTableInArena(arena_t *arena,
+                                         string_pool_t *names) {
+  symbol_table_t *new_symbol_table =
+    (symbol_table_t *)ArenaAlloc(arena, sizeof(symbol_table_t));
   if (NULL == new_symbol_table) {
     perror("Error allocating memory for a symbol table");
     return NULL;
   }
 
-  new_symbol_table->list = CreateList();
+  new_symbol_table->list = CreateListInArena(arena);
   if (NULL == new_symbol_table->list) {
     perror("Error allocating memory for a symbol table");
-    free(new_symbol_table);
+    ArenaFree(arena, new_symbol_table);
+    return NULL;
+  }
+
+  new_symbol_table->index = CreateNameIndex(arena, INITIAL_INDEX_CAPACITY);
+  if (NULL == new_symbol_table->index) {
+    perror("Error allocating memory for a symbol table");
+    DestroyList(new_symbol_table->list);
+    ArenaFree(arena, new_symbol_table);
     return NULL;
   }
 
+  new_symbol_table->owns_names = FALSE;
+  if (NULL == names) {
+    names = CreateStringPool(arena);
+    if (NULL == names) {
+      perror("Error allocating memory for a symbol table");
+      DestroyList(new_symbol_table->list);
+      DestroyNameIndex(new_symbol_table->index);
+      ArenaFree(arena, new_symbol_table);
+      return NULL;
+    }
+    new_symbol_table->owns_names = TRUE;
+  }
+
+  new_symbol_table->arena = arena;
+  new_symbol_table->names = names;
+
   return new_symbol_table;
 }
 
 void DestroySymbolTable(symbol_table_t *table){
-  node_t *node = GetHead(table->list);
+  node_t *node = NULL;
   assert(table); 
-  
+
+  if (table->owns_names) {
+    DestroyStringPool(table->names);
+  }
+
+  /* Everything else is released along with the arena */
+  if (NULL != table->arena) {
+    return;
+  }
+
+  node = GetHead(table->list);
   while (NULL != node) {
-    symbol_t *symbol = GetValue(node);
-    free((void *)symbol->symbol_name);
-    free(symbol);
+    free(GetValue(node));
     node = GetNext(node);
   }
 
   DestroyList(table->list);
+  DestroyNameIndex(table->index);
   free(table);
 }
 
@@ -115,16 +166,17 @@ void UpdateSymbolAddress (symbol_t *symbol ,address_t new_address) {
 
 symbol_t *FindSymbol(symbol_table_t *table,
                     const char *symbol_name) {
+  const char *interned_name = NULL;
 
-  node_t *node = NULL; 
   assert(table); assert(symbol_name);
 
-  node = Find(table->list, SymbolCompare, (void *)symbol_name);
-  if (NULL == node) {
+  /* A name which isn't in the pool was never added */
+  interned_name = FindInternedString(table->names, symbol_name);
+  if (NULL == interned_name) {
     return NULL;
   }
 
-  return (symbol_t *)GetValue(node);
+  return (symbol_t *)FindIndexedName(table->index, interned_name);
 }
 
 const char *GetSymbolName(symbol_t *symbol) {
@@ -132,6 +184,11 @@ const char *GetSymbolName(symbol_t *symbol) {
   return symbol->symbol_name;
 }
 
+string_pool_t *GetSymbolNames(symbol_table_t *table) {
+  assert(table);
+  return table->names;
+}
+
 symbol_type_t GetSymbolType(symbol_t *symbol) {
   assert(symbol);
   return symbol->type;
@@ -152,18 +209,12 @@ list_t *AsList(symbol_table_t *table) {
   return table->list;
 }
 
-static int SymbolCompare(void *symbol_ptr, void *key) {
-  symbol_t *symbol = (symbol_t *)symbol_ptr;
-  const char *symbol_name = symbol->symbol_name;
-
-  return (0 == strcmp (symbol_name, (char *) key));
-}
-
-static symbol_t *CreateSymbol(const char *symbol_name,
+static symbol_t *CreateSymbol(arena_t *arena,
+                              const char *symbol_name,
                               address_t address,
                               symbol_type_t type,
                               symbol_memory_area_t area) {
-  symbol_t *symbol = (symbol_t *)malloc(sizeof(symbol_t));
+  symbol_t *symbol = (symbol_t *)ArenaAlloc(arena, sizeof(symbol_t));
   if (NULL == symbol) {
     perror("Error allocating memory for a new symbol\n");
     return NULL;
@@ -181,8 +232,23 @@ static result_t AddSymbolWithType(symbol_table_t *table,
                          address_t address,
                          symbol_type_t type,
                          symbol_memory_area_t area) {
-  symbol_t *symbol = CreateSymbol(StrDup(symbol_name), address, type, area);
-  
+  symbol_t *symbol = NULL;
+  const char *interned_name = NULL;
+
+  if (SUCCESS != ReserveName(table->index)) {
+    fprintf(stderr, 
+            "Error adding new symbol %s to symbol table\n",
+            symbol_name);
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  interned_name = InternString(table->names, symbol_name);
+  if (NULL == interned_name) {
+    perror("Error allocating memory for a new symbol\n");
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  symbol = CreateSymbol(table->arena, interned_name, address, type, area);
   if (NULL == symbol) {
     return MEM_ALLOCATION_ERROR;
   }
@@ -191,10 +257,13 @@ static result_t AddSymbolWithType(symbol_table_t *table,
     fprintf(stderr, 
             "Error adding new symbol %s to symbol table\n",
             symbol_name);
-    free(symbol);
+    ArenaFree(table->arena, symbol);
     return MEM_ALLOCATION_ERROR;
   }
 
+  /* If the name is already indexed, the earlier definition is kept */
+  IndexName(table->index, interned_name, symbol);
+
   return SUCCESS;
 }
 
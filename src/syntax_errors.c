@@ -6,7 +6,7 @@
 
 #include <string.h> /* strchr */
 #include <ctype.h> /* isalpha */
-#include <stdio.h> /* printf */
+#include <stdio.h> /* fprintf */
 #include <stdlib.h> /* malloc, free */
 #include <limits.h> /*max_int*/
 #include "syntax_errors.h"
@@ -39,9 +39,6 @@ static bool_t IsDataParameterTooBig(const char *parameter);
 static bool_t StringIsNotPrintable (const char *str,
                                     syntax_check_config_t *config);
 
-/* This config is used for calling other syntax checks internally silently */
-syntax_check_config_t silent_syntax_cfg = {NULL, 0, FALSE};
-
 bool_t DetectExtraCharacters(const char *starting_from,
                              syntax_check_config_t *config) {
   char *ptr = (char *)starting_from;
@@ -57,11 +54,12 @@ bool_t DetectExtraCharacters(const char *starting_from,
   else if (config->verbose) {
     char *extra_chars = (char *)starting_from;
     char *dup = StrDup(starting_from);
+    char *save_ptr = NULL;
     if (NULL != dup) {
       extra_chars = dup;
-      strtok(extra_chars, "\n");
+      TokenizeString(extra_chars, "\n", &save_ptr);
     }
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Extraneous characters detected ('%s')\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Extraneous characters detected ('%s')\n\n",
             config->file_name,
             config->line_number,
             extra_chars);
@@ -73,9 +71,11 @@ bool_t DetectExtraCharacters(const char *starting_from,
 }
 
 bool_t IsReservedName(const char *name, syntax_check_config_t *config) {
-  if (FALSE == InstructionDoesntExist(name, &silent_syntax_cfg)) {
+  reserved_word_kind_t kind = IdentifyReservedWord(name).kind;
+
+  if (INSTRUCTION_WORD == kind) {
     if (config->verbose) {
-      printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved instruction name '%s' \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved instruction name '%s' \n\n",
               config->file_name,
               config->line_number,
               name);
@@ -83,9 +83,9 @@ bool_t IsReservedName(const char *name, syntax_check_config_t *config) {
     return TRUE;
   }
 
-  if (INVALID_DIRECTIVE != IdentifyDirective(name, &silent_syntax_cfg)) {
+  if (DIRECTIVE_WORD == kind) {
     if (config->verbose) {
-      printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved directive name '%s' \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved directive name '%s' \n\n",
               config->file_name,
               config->line_number,
               name);
@@ -93,9 +93,9 @@ bool_t IsReservedName(const char *name, syntax_check_config_t *config) {
     return TRUE;
   }
 
-  if (FALSE == RegisterNameDoesntExist(name, &silent_syntax_cfg)) {
+  if (REGISTER_WORD == kind) {
     if (config->verbose) {
-      printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved register name '%s' \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to make use of a reserved register name '%s' \n\n",
               config->file_name,
               config->line_number, 
               name);
@@ -115,7 +115,7 @@ bool_t MacroDefinedMoreThanOnce(const char *macro_name,
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to redefine macro with the name '%s'.\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to redefine macro with the name '%s'.\n\n",
             config->file_name,
             config->line_number, 
             macro_name);
@@ -126,16 +126,12 @@ bool_t MacroDefinedMoreThanOnce(const char *macro_name,
 
 bool_t InstructionDoesntExist(const char *instruction,
                               syntax_check_config_t *config) {
-  int i = 0;
-
-  for (i = 0; i < NUM_OF_INSTRUCTIONS; i++) {
-    if (0 == strcmp(instruction, reserved_instructions[i].name)) {
-      return FALSE;
-    }
+  if (INSTRUCTION_WORD == IdentifyReservedWord(instruction).kind) {
+    return FALSE;
   }
-  
+
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Unknown instruction '%s' \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Unknown instruction '%s' \n\n",
             config->file_name,
             config->line_number,
             instruction);
@@ -146,13 +142,9 @@ bool_t InstructionDoesntExist(const char *instruction,
 bool_t WrongNumberOfOperands(const char *instruction,
                           int num_of_operands,
                           syntax_check_config_t *config) {
-  int i = 0;
+  int i = IdentifyReservedWord(instruction).index;
   int required_operands = 1;
 
-  while (0 != strcmp(reserved_instructions[i].name, instruction)) {
-    ++i;
-  }
-
   required_operands = (TakesOperand(reserved_instructions[i], SOURCE_OPERAND) 
                       + TakesOperand(reserved_instructions[i], DESTINATION_OPERAND));
 
@@ -161,7 +153,7 @@ bool_t WrongNumberOfOperands(const char *instruction,
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n For instruction '%s' expected %d operands, but given %d \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n For instruction '%s' expected %d operands, but given %d \n\n",
             config->file_name,
             config->line_number,
             instruction,
@@ -178,7 +170,7 @@ bool_t IsOperandInvalid(const operand_t *operand,
   }
 
   if (config->verbose) {
-    printf(BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n invalid operand '%s'.",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n invalid operand '%s'.",
            config->file_name,
            config->line_number,
            operand->name
@@ -191,20 +183,16 @@ bool_t IsOperandInvalid(const operand_t *operand,
 bool_t IncorrectAddressingMethod(const char *instruction,
                                  const operand_t *operand,
                                  syntax_check_config_t *config) {
-  int i = 0;
+  int i = IdentifyReservedWord(instruction).index;
   addressing_method_t method = operand->addressing_method;
   operand_type_t type = operand->type;
 
-  while (0 != strcmp(reserved_instructions[i].name, instruction)) {
-    ++i;
-  }
-
   if (TRUE == AddressingMethodIsLegal(reserved_instructions[i], type, method)) {
     return FALSE;
   }
 
   if (config->verbose) {
-    const char *method_str;
+    const char *method_str = "";
 
     switch (method) {
       case IMMEDIATE:
@@ -224,18 +212,18 @@ bool_t IncorrectAddressingMethod(const char *instruction,
         break;
     }
 
-    printf(BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n ",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n ",
             config->file_name,
             config->line_number
       );
 
-    printf("operand '%s' can't be used as %s operand in the instruction '%s' ",
+    fprintf (config->stream, "operand '%s' can't be used as %s operand in the instruction '%s' ",
             operand->name, 
             (operand->type ? "source" : "target"),
             instruction
       );
 
-    printf("(%s addressing isn't supported for %s operands)\n\n",
+    fprintf (config->stream, "(%s addressing isn't supported for %s operands)\n\n",
             method_str,
             (operand->type ? "source" : "target")
       );
@@ -260,7 +248,7 @@ bool_t DefinitionStartsImmediatelyAfterColon(const char *line,
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n No space after symbol name definition '%s'.\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n No space after symbol name definition '%s'.\n\n",
             config->file_name,
             config->line_number,
             line);
@@ -272,13 +260,15 @@ bool_t DefinitionStartsImmediatelyAfterColon(const char *line,
 bool_t SymbolDefinedMoreThanOnce(const char *symbol,
                                  symbol_table_t *table,
                                  syntax_check_config_t *config) {
+  /* Used for calling other syntax checks internally silently */
+  syntax_check_config_t silent_cfg = CreateSyntaxCheckConfig(NULL, 0, FALSE);
 
-  if (TRUE == SymbolWasntDefined(symbol, table, &silent_syntax_cfg)) {
+  if (TRUE == SymbolWasntDefined(symbol, table, &silent_cfg)) {
     return FALSE;
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n The symbol '%s' was already defined.\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n The symbol '%s' was already defined.\n\n",
             config->file_name,
             config->line_number,
             symbol);
@@ -294,7 +284,7 @@ bool_t SymbolWasntDefined(const char *symbol,
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempted to call a symbol '%s' that wasn't defined \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempted to call a symbol '%s' that wasn't defined \n\n",
             config->file_name,
             config->line_number,
             symbol);
@@ -302,7 +292,7 @@ bool_t SymbolWasntDefined(const char *symbol,
   return TRUE;
 }
 
-bool_t SymbolAlreadyDefinedAsExtern(char *symbol_name,
+bool_t SymbolAlreadyDefinedAsExtern(const char *symbol_name,
                                     symbol_table_t *table,
                                     syntax_check_config_t *config) {
 
@@ -312,7 +302,7 @@ bool_t SymbolAlreadyDefinedAsExtern(char *symbol_name,
   }
 
   if (config->verbose){
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to define '%s' as entry, but it was already defined as extern\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to define '%s' as entry, but it was already defined as extern\n\n",
             config->file_name,
             config->line_number,
             symbol_name);
@@ -345,7 +335,7 @@ bool_t SymbolNameIsIllegal(const char *symbol, syntax_check_config_t *config) {
 
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Use of illegal characters in the symbol name '%s'\n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Use of illegal characters in the symbol name '%s'\n\n",
             config->file_name,
             config->line_number,
             symbol);
@@ -364,7 +354,7 @@ bool_t SymbolUsedAsAMacro(const char *symbol,
   }
 
 	if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to define a symbol '%s', but it was already defined as a macro \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Attempt to define a symbol '%s', but it was already defined as a macro \n\n",
             config->file_name,
             config->line_number,
             symbol);
@@ -374,16 +364,18 @@ bool_t SymbolUsedAsAMacro(const char *symbol,
 }
 
 bool_t NoDefinitionForSymbol(const char *after_symbol, syntax_check_config_t *config) {
+  syntax_check_config_t silent_cfg = CreateSyntaxCheckConfig(NULL, 0, FALSE);
+
   if (NULL == after_symbol) {
     return TRUE;
   }
 
-  if (TRUE == DetectExtraCharacters(after_symbol, &silent_syntax_cfg)) {
+  if (TRUE == DetectExtraCharacters(after_symbol, &silent_cfg)) {
     return FALSE;
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n No definition after symbol label \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n No definition after symbol label \n\n",
             config->file_name,
             config->line_number);
   }
@@ -397,7 +389,7 @@ bool_t ImmediateOperandTooBig (operand_t *operand,
   value = strtol(operand->name + 1, NULL, BASE_10); /* skip the # */
   if (value > MAX_IMMEDIATE_OPERAND || value < MIN_IMMEDIATE_OPERAND) {
         if (config->verbose) {
-            printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n immediate operand '%s' exceeds limit (max: %d, min :%d) \n\n",
+            fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n immediate operand '%s' exceeds limit (max: %d, min :%d) \n\n",
             config->file_name,
             config->line_number,
             operand->name,
@@ -412,12 +404,13 @@ bool_t ImmediateOperandTooBig (operand_t *operand,
 static bool_t DataParametersTooBig(const char *params,
                                    syntax_check_config_t *config) {
     char *duplicate_line = StrDup(params); 
-    char *ptr = strtok(duplicate_line, " ,/t/n/r");
+    char *save_ptr = NULL;
+    char *ptr = TokenizeString(duplicate_line, " ,/t/n/r", &save_ptr);
 
     while (ptr != NULL) {
     if (TRUE == IsDataParameterTooBig(ptr)) {
       if (config->verbose) {
-        printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n data parameter '%s' is exceeds limit \n\n",
+        fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n data parameter '%s' is exceeds limit \n\n",
         config->file_name,
           config->line_number,
           ptr);
@@ -426,7 +419,7 @@ static bool_t DataParametersTooBig(const char *params,
       return TRUE;
     }
 
-    ptr = strtok(NULL, " ,/t/n/r");
+    ptr = TokenizeString(NULL, " ,/t/n/r", &save_ptr);
   }
 
   free(duplicate_line);
@@ -435,17 +428,14 @@ static bool_t DataParametersTooBig(const char *params,
 
 
 directive_t IdentifyDirective(const char *directive, syntax_check_config_t *config) {
-  directive_t d = 0;
-  while (d < NUM_OF_DIRECTIVES && strcmp(directive, reserved_directives[d])) {
-    ++d;
-  }
-  
-  if (d != INVALID_DIRECTIVE) {
-    return d;
+  reserved_word_t reserved_word = IdentifyReservedWord(directive);
+
+  if (DIRECTIVE_WORD == reserved_word.kind) {
+    return (directive_t)reserved_word.index;
   }
   
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n The directive name '%s' doesn't exist \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n The directive name '%s' doesn't exist \n\n",
             config->file_name,
             config->line_number,
             directive);
@@ -472,7 +462,7 @@ bool_t IsIllegalDataParameter(const char *data, syntax_check_config_t *config) {
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n .data definition '%s' is invalid \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n .data definition '%s' is invalid \n\n",
             config->file_name,
             config->line_number,
             data);
@@ -501,7 +491,7 @@ bool_t IsIllegalString(const char *str, syntax_check_config_t *config) {
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n .string definition '%s' is invalid \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n .string definition '%s' is invalid \n\n",
             config->file_name,
             config->line_number,
             start);
@@ -554,7 +544,7 @@ bool_t AreCommasMisplaced(const char *param, syntax_check_config_t *config) {
   }
 
   if (config->verbose) {
-      printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Commas placed in parameters '%s' are misplaced \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Commas placed in parameters '%s' are misplaced \n\n",
               config->file_name,
               config->line_number,
               param);
@@ -575,7 +565,7 @@ static bool_t StringIsNotPrintable (const char *str,
   /* Non-printable char detected */
   if ('\0' != *ptr) {
     if (config->verbose) {
-      printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n string '%s' is unprintable \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n string '%s' is unprintable \n\n",
               config->file_name,
               config->line_number,
               str);
@@ -588,17 +578,12 @@ static bool_t StringIsNotPrintable (const char *str,
 }
 
 bool_t RegisterNameDoesntExist(const char *register_name, syntax_check_config_t *config){
-  int i = 0;
-  while (i < NUM_OF_REGISTERS && strcmp(register_name, register_names[i])) {
-    ++i;
-  }
-  
-  if (i < NUM_OF_REGISTERS) {
+  if (REGISTER_WORD == IdentifyReservedWord(register_name).kind) {
     return FALSE;
   }
   
   if (config->verbose) {
-      printf(BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Register name '%s' doesn't exist \n\n",
+      fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Register name '%s' doesn't exist \n\n",
             config->file_name,
             config->line_number,
             register_name);
@@ -613,12 +598,14 @@ syntax_check_config_t CreateSyntaxCheckConfig(const char *file_name,
   info.file_name = file_name;
   info.line_number = line_number;
   info.verbose = verbose;
+  info.stream = stdout;
 
   return info;
 }
 
 addressing_method_t DetectAddressingMethod(const char *operand_name) {
   char *ptr = (char *)operand_name;
+  syntax_check_config_t silent_cfg = CreateSyntaxCheckConfig(NULL, 0, FALSE);
 
   if ('#' == *ptr) {
     bool_t digit_occurred = FALSE;
@@ -645,17 +632,17 @@ addressing_method_t DetectAddressingMethod(const char *operand_name) {
 
   else if ('*' == *ptr) {
     ++ptr;
-    if (RegisterNameDoesntExist(ptr, &silent_syntax_cfg)) {
+    if (RegisterNameDoesntExist(ptr, &silent_cfg)) {
       return INVALID;
     }
     return INDIRECT_REGISTER;
   }
 
-  else if (!RegisterNameDoesntExist(ptr, &silent_syntax_cfg)) {
+  else if (!RegisterNameDoesntExist(ptr, &silent_cfg)) {
     return DIRECT_REGISTER;
   }
 
-  else if (SymbolNameIsIllegal(ptr, &silent_syntax_cfg)) {
+  else if (SymbolNameIsIllegal(ptr, &silent_cfg)) {
     return INVALID;
   }
 
@@ -756,7 +743,7 @@ static bool_t SymbolPrefixIllegal(const char *symbol, syntax_check_config_t *con
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Symbols '%s' doesn't start with an alphabetical character \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Symbols '%s' doesn't start with an alphabetical character \n\n",
             config->file_name,
             config->line_number,
             symbol);
@@ -789,7 +776,7 @@ static bool_t SymbolExceedCharacterLimit(const char *symbol,
   }
 
   if (config->verbose) {
-    printf (BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Symbol name '%s' exceeded the character limit \n\n",
+    fprintf (config->stream, BOLD_RED "ERROR " COLOR_RESET "(file %s, line %u):\n Symbol name '%s' exceeded the character limit \n\n",
             config->file_name,
             config->line_number,
             symbol);
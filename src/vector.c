@@ -83,7 +83,7 @@ void *GetElementVector(vector_t *vector, size_t index) {
 
 bool_t IsEmptyVector(const vector_t *vector) {
   assert(vector);
-  return (vector->size ? TRUE : FALSE);
+  return (vector->size ? FALSE : TRUE);
 }                    
 
 size_t GetCapacityVector(const vector_t *vector) {
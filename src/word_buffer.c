@@ -0,0 +1,92 @@
+/* word_buffer.c
+ *
+ * This module implements a growable buffer of 16-bit machine words.
+ */
+
+#include <stdlib.h> /* malloc, realloc, free */
+#include <stdio.h> /* perror */
+#include <assert.h> /* assert */
+#include "word_buffer.h"
+
+#define GROWTH_FACTOR 2
+#define MIN_CAPACITY 16
+
+word_buffer_t *CreateWordBuffer(size_t capacity_hint) {
+  word_buffer_t *buffer = (word_buffer_t *)malloc(sizeof(word_buffer_t));
+
+  if (NULL == buffer) {
+    perror("Couldn't allocate memory for word buffer");
+    return NULL;
+  }
+
+  if (MIN_CAPACITY > capacity_hint) {
+    capacity_hint = MIN_CAPACITY;
+  }
+
+  buffer->words = (machine_word_t *)malloc(capacity_hint *
+                                           sizeof(machine_word_t));
+  if (NULL == buffer->words) {
+    perror("Couldn't allocate memory for word buffer");
+    free(buffer);
+    return NULL;
+  }
+
+  buffer->size = 0;
+  buffer->capacity = capacity_hint;
+  buffer->spilled = 0;
+
+  return buffer;
+}
+
+void DestroyWordBuffer(word_buffer_t *buffer) {
+  assert(buffer);
+  free(buffer->words);
+  free(buffer);
+}
+
+result_t GrowWordBuffer(word_buffer_t *buffer) {
+  size_t new_capacity = buffer->capacity * GROWTH_FACTOR;
+  machine_word_t *words = NULL;
+
+  assert(buffer);
+
+  words = (machine_word_t *)realloc(buffer->words,
+                                    new_capacity * sizeof(machine_word_t));
+  if (NULL == words) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  buffer->words = words;
+  buffer->capacity = new_capacity;
+
+  return SUCCESS;
+}
+
+size_t GetWordsNum(const word_buffer_t *buffer) {
+  assert(buffer);
+  return buffer->size;
+}
+
+machine_word_t *GetWords(word_buffer_t *buffer) {
+  assert(buffer);
+  return buffer->words;
+}
+
+result_t SpillWords(word_buffer_t *buffer, FILE *stream) {
+  assert(buffer);
+
+  if (buffer->size != fwrite(buffer->words, sizeof(machine_word_t),
+                             buffer->size, stream)) {
+    perror("Error writing to file");
+    return ERROR_WRITING_TO_FILE;
+  }
+
+  buffer->spilled += buffer->size;
+  buffer->size = 0;
+  return SUCCESS;
+}
+
+size_t GetTotalWordsNum(const word_buffer_t *buffer) {
+  assert(buffer);
+  return buffer->spilled + buffer->size;
+}
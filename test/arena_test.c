@@ -0,0 +1,159 @@
+#include <stdio.h> /* printf */
+#include <string.h> /* strcmp */
+#include "arena.h"
+#include "symbol_table.h"
+#include "macro_table.h"
+#include "test_utils.h"
+
+test_info_t AllocationsTest(void) {
+  /* Allocations are aligned, don't overlap, and may exceed the block size */
+  test_info_t test_info = InitTestInfo("Allocations");
+  arena_t *arena = CreateArena(64);
+  char *small = NULL;
+  char *large = NULL;
+  double *numbers = NULL;
+  size_t i = 0;
+
+  if (NULL == arena) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  small = (char *)ArenaAlloc(arena, 3);
+  numbers = (double *)ArenaAlloc(arena, 4 * sizeof(double));
+  large = (char *)ArenaCalloc(arena, 1000);
+  if (NULL == small || NULL == numbers || NULL == large) {
+    DestroyArena(arena);
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (0 != (size_t)numbers % sizeof(double)) {
+    DestroyArena(arena);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  memset(small, 'a', 3);
+  for (i = 0; i < 4; ++i) {
+    numbers[i] = (double)i;
+  }
+
+  for (i = 0; i < 1000; ++i) {
+    if (0 != large[i]) {
+      DestroyArena(arena);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  if ('a' != small[2] || 3.0 != numbers[3]) {
+    DestroyArena(arena);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyArena(arena);
+  return test_info;
+}
+
+test_info_t ResetTest(void) {
+  /* After a reset, memory is handed out again from the kept block */
+  test_info_t test_info = InitTestInfo("Reset");
+  arena_t *arena = CreateArena(256);
+  char *first = NULL;
+  char *copy = NULL;
+  int i = 0;
+
+  if (NULL == arena) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  first = ArenaStrDup(arena, "hello");
+  for (i = 0; i < 100; ++i) {
+    if (NULL == ArenaAlloc(arena, 100)) {
+      DestroyArena(arena);
+      RETURN_ERROR(TECHNICAL_ERROR);
+    }
+  }
+
+  ResetArena(arena);
+  copy = ArenaStrDup(arena, "world");
+  if (NULL == first || NULL == copy || 0 != strcmp("world", copy)) {
+    DestroyArena(arena);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyArena(arena);
+  return test_info;
+}
+
+test_info_t TablesInArenaTest(void) {
+  /* Tables created in an arena work as usual, and are released by it */
+  test_info_t test_info = InitTestInfo("TablesInArena");
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+  symbol_table_t *symbols = NULL;
+  macro_table_t *macros = NULL;
+  char name[16];
+  int i = 0;
+
+  if (NULL == arena) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  symbols = CreateSymbolTableInArena(arena, NULL);
+  macros = CreateMacroTableInArena(arena);
+  if (NULL == symbols || NULL == macros) {
+    DestroyArena(arena);
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* Enough names for the indexes to grow */
+  for (i = 0; i < 500; ++i) {
+    sprintf(name, "name%d", i);
+    if (SUCCESS != AddSymbol(symbols, name, i, CODE) ||
+        SUCCESS != AddMacro(macros, name, "inc r1")) {
+      DestroyArena(arena);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  for (i = 0; i < 500; ++i) {
+    sprintf(name, "name%d", i);
+    if (NULL == FindSymbol(symbols, name) ||
+        i != GetSymbolAddress(FindSymbol(symbols, name)) ||
+        NULL == FindMacro(macros, name)) {
+      DestroyArena(arena);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  DestroySymbolTable(symbols);
+  DestroyMacroTable(macros);
+  DestroyArena(arena);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = AllocationsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = ResetTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = TablesInArenaTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "arena\n");
+  }
+
+  return total_failures;
+}
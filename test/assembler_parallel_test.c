@@ -0,0 +1,207 @@
+/* assembler_parallel_test.c
+ *
+ * Tests assembling a single file on several threads (see threads_num in
+ * assembler_options_t): its output & messages must be identical to those
+ * of assembling it on one thread.
+ */
+
+#include <stdio.h> /* FILE */
+#include "assembler.h"
+#include "preprocessing.h"
+#include "test_utils.h"
+
+#define BASE_PATH "./parallel_test"
+
+/* Enough lines for several chunks, whatever the number of threads */
+#define SOURCE_LINES (40000)
+
+static source_config_t SourceConfig(source_flaws_t flaws);
+
+static result_t Assemble(char *source_path, char *am_path,
+                         FILE *diagnostics, void *threads_num);
+
+static result_t SameMessages(source_flaws_t flaws, result_t expected_res);
+
+/*
+ * TESTS
+ */
+
+test_info_t SameOutputTest(void) {
+  test_info_t test_info = InitTestInfo("SameOutput");
+  unsigned int threads_nums[] = {1, 2, 3, 8};
+  source_config_t config = SourceConfig(NO_FLAWS);
+  assembling_way_t serial = {Assemble, NULL};
+  assembling_way_t parallel = {Assemble, NULL};
+  size_t i = 0;
+
+  serial.arg = &threads_nums[0];
+
+  /* Symbols are defined & used across chunks, and the .ob file is big
+   * enough to be formatted in chunks too, with addresses of 4 & 5 digits */
+  for (i = 1; i < sizeof(threads_nums) / sizeof(threads_nums[0]); ++i) {
+    parallel.arg = &threads_nums[i];
+    if (SUCCESS != CompareAssemblings(BASE_PATH, &config, &serial,
+                                      &parallel, SUCCESS)) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  return test_info;
+}
+
+test_info_t SameWarningsTest(void) {
+  /* Warnings of all chunks are printed, in the order of their lines */
+  test_info_t test_info = InitTestInfo("SameWarnings");
+
+  if (SUCCESS != SameMessages(NO_FLAWS, SUCCESS)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t SameErrorsTest(void) {
+  /* Errors within a chunk are reported as usual */
+  test_info_t test_info = InitTestInfo("SameErrors");
+
+  if (SUCCESS != SameMessages(SYNTAX_ERRORS, FAILURE)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t UndefinedSymbolsTest(void) {
+  /* And so are references the second pass can't resolve */
+  test_info_t test_info = InitTestInfo("UndefinedSymbols");
+
+  if (SUCCESS != SameMessages(UNDEFINED_OPERANDS, FAILURE) ||
+      SUCCESS != SameMessages(UNDEFINED_ENTRIES, FAILURE)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t ClashingSymbolsTest(void) {
+  /* So are symbols defined in several chunks, each valid on its own */
+  test_info_t test_info = InitTestInfo("ClashingSymbols");
+
+  if (SUCCESS != SameMessages(CLASHING_SYMBOLS, FAILURE)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = SameOutputTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SameWarningsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SameErrorsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = UndefinedSymbolsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = ClashingSymbolsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Assembler parallel\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Returns the shape of the test source, whose labels are defined &
+ *        used across chunks, and some of whose entries have a label before
+ *        them, which warrants a warning. Its flaws, if any, are far apart.
+ */
+
+static source_config_t SourceConfig(source_flaws_t flaws) {
+  source_config_t config = CreateSourceConfig();
+
+  config.lines_num = SOURCE_LINES;
+  config.labeled_entries = TRUE;
+  config.comments = TRUE;
+  config.flaws = flaws;
+  config.flaws_interval = 9000;
+  return config;
+}
+
+/*
+ * @brief Assembles a source on up to *threads_num threads (see
+ *        assemble_func_t).
+ */
+
+static result_t Assemble(char *source_path, char *am_path,
+                         FILE *diagnostics, void *threads_num) {
+  assembler_options_t options = CreateAssemblerOptions();
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = NULL;
+  result_t res = SUCCESS;
+
+  if (NULL == source) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  options.diagnostics = diagnostics;
+  options.binary_object = TRUE;
+  options.threads_num = *(unsigned int *)threads_num;
+
+  macro_table = PreprocessSource(source_path, source, diagnostics, NULL);
+  if (NULL == macro_table) {
+    DestroySourceBuffer(source);
+    return FAILURE;
+  }
+
+  res = AssembleSource(am_path, source, macro_table, &options);
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+  return res;
+}
+
+/*
+ * @brief Checks that a source is assembled with the expected result & the
+ *        same messages & output on one thread & on several.
+ */
+
+static result_t SameMessages(source_flaws_t flaws, result_t expected_res) {
+  unsigned int serial_threads = 1;
+  unsigned int parallel_threads = 4;
+  source_config_t config = SourceConfig(flaws);
+  assembling_way_t serial = {Assemble, NULL};
+  assembling_way_t parallel = {Assemble, NULL};
+
+  serial.arg = &serial_threads;
+  parallel.arg = &parallel_threads;
+  return CompareAssemblings(BASE_PATH, &config, &serial, &parallel,
+                            expected_res);
+}
@@ -0,0 +1,243 @@
+/* assembler_stream_test.c
+ *
+ * Tests the streaming mode (see AssembleStream): its output must be
+ * identical to the output of assembling in memory, and its peak memory
+ * mustn't grow with the size of the source.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* getrusage */
+
+#include <stdio.h> /* tmpfile, remove */
+#include <sys/resource.h> /* getrusage */
+#include "assembler.h"
+#include "preprocessing.h"
+#include "test_utils.h"
+
+#define SOURCE_PATH "./stream_test.as"
+#define AM_PATH "./stream_test.am"
+#define BASE_PATH "./stream_test"
+
+/* Lines of the source whose assembling is measured (about 6MB of source,
+ * which takes about 40MB more to assemble in memory), and how much the
+ * peak memory may grow while it's streamed */
+#define LARGE_SOURCE_LINES (600000)
+#define MEMORY_BOUND_KB (4096)
+
+static source_config_t SourceConfig(long lines_num, source_flaws_t flaws);
+
+static result_t AssembleInMemory(char *source_path, char *am_path,
+                                 FILE *diagnostics, void *arg);
+
+static result_t AssembleStreaming(char *source_path, char *am_path,
+                                  FILE *diagnostics, void *arg);
+
+static long PeakMemoryKB(void);
+
+static void RemoveTestFiles(void);
+
+static const assembling_way_t in_memory = {AssembleInMemory, NULL};
+static const assembling_way_t streaming = {AssembleStreaming, NULL};
+
+/*
+ * TESTS
+ */
+
+test_info_t BoundedMemoryTest(void) {
+  test_info_t test_info = InitTestInfo("BoundedMemory");
+  source_config_t config;
+  FILE *diagnostics = tmpfile();
+  long peak_before = 0;
+  long peak_after = 0;
+
+  if (NULL == diagnostics) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* A small source first, so whatever is allocated once is accounted for */
+  config = SourceConfig(1000, NO_FLAWS);
+  if (0 > GenerateSource(SOURCE_PATH, &config) ||
+      SUCCESS != AssembleStreaming(SOURCE_PATH, AM_PATH, diagnostics, NULL)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+  peak_before = PeakMemoryKB();
+
+  config = SourceConfig(LARGE_SOURCE_LINES, NO_FLAWS);
+  if (0 > GenerateSource(SOURCE_PATH, &config) ||
+      SUCCESS != AssembleStreaming(SOURCE_PATH, AM_PATH, diagnostics, NULL)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+  peak_after = PeakMemoryKB();
+
+  if (peak_after - peak_before > MEMORY_BOUND_KB) {
+    printf("Peak memory grew by %ldKB\n", peak_after - peak_before);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  RemoveTestFiles();
+  fclose(diagnostics);
+  return test_info;
+}
+
+test_info_t SameOutputTest(void) {
+  test_info_t test_info = InitTestInfo("SameOutput");
+  source_config_t config = SourceConfig(20000, NO_FLAWS);
+
+  /* Several windows of lines, & chunks of words */
+  if (SUCCESS != CompareAssemblings(BASE_PATH, &config, &in_memory,
+                                    &streaming, SUCCESS)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t SameErrorsTest(void) {
+  test_info_t test_info = InitTestInfo("SameErrors");
+  source_config_t config = SourceConfig(20000, SYNTAX_ERRORS);
+
+  /* Errors are reported with the same line numbers, in the same order */
+  if (SUCCESS != CompareAssemblings(BASE_PATH, &config, &in_memory,
+                                    &streaming, FAILURE)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  /* First, before anything else raises the peak memory */
+  test_info = BoundedMemoryTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SameOutputTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SameErrorsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Assembler streaming\n");
+  }
+
+  RemoveTestFiles();
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Returns the shape of a test source of lines_num statements, with
+ *        every kind of statement: macros, comments, code & data, external
+ *        symbols & entries. Its flaws, if any, are far apart. It has as
+ *        many labels whatever its size, so its symbol table doesn't grow
+ *        with it.
+ */
+
+static source_config_t SourceConfig(long lines_num, source_flaws_t flaws) {
+  source_config_t config = CreateSourceConfig();
+
+  config.lines_num = lines_num;
+  config.symbols_num = 64;
+  config.comments = TRUE;
+  config.flaws = flaws;
+  config.flaws_interval = 5000;
+  return config;
+}
+
+/*
+ * @brief Assembles a source in memory (see assemble_func_t).
+ */
+
+static result_t AssembleInMemory(char *source_path, char *am_path,
+                                 FILE *diagnostics, void *arg) {
+  assembler_options_t options = CreateAssemblerOptions();
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = NULL;
+  result_t res = SUCCESS;
+
+  (void)arg;
+
+  if (NULL == source) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  options.diagnostics = diagnostics;
+  options.binary_object = TRUE;
+
+  macro_table = PreprocessSource(source_path, source, diagnostics, NULL);
+  if (NULL == macro_table) {
+    DestroySourceBuffer(source);
+    return FAILURE;
+  }
+
+  res = AssembleSource(am_path, source, macro_table, &options);
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+  return res;
+}
+
+/*
+ * @brief Same as AssembleInMemory, in streaming mode.
+ */
+
+static result_t AssembleStreaming(char *source_path, char *am_path,
+                                  FILE *diagnostics, void *arg) {
+  assembler_options_t options = CreateAssemblerOptions();
+  FILE *expanded_source = tmpfile();
+  macro_table_t *macro_table = NULL;
+  result_t res = SUCCESS;
+
+  (void)arg;
+
+  if (NULL == expanded_source) {
+    return ERROR_OPENING_FILE;
+  }
+
+  options.diagnostics = diagnostics;
+  options.binary_object = TRUE;
+
+  macro_table = PreprocessStream(source_path, expanded_source, diagnostics,
+                                 NULL);
+  if (NULL == macro_table) {
+    fclose(expanded_source);
+    return FAILURE;
+  }
+
+  rewind(expanded_source);
+  res = AssembleStream(am_path, expanded_source, macro_table, &options);
+  DestroyMacroTable(macro_table);
+  fclose(expanded_source);
+  return res;
+}
+
+/*
+ * @brief Returns the peak memory (resident set size) of the process so far.
+ */
+
+static long PeakMemoryKB(void) {
+  struct rusage usage;
+
+  if (0 != getrusage(RUSAGE_SELF, &usage)) {
+    return 0;
+  }
+  return usage.ru_maxrss;
+}
+
+static void RemoveTestFiles(void) {
+  remove(SOURCE_PATH);
+  RemoveAssemblerOutputs(BASE_PATH);
+}
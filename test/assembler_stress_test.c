@@ -0,0 +1,190 @@
+/* assembler_stress_test.c
+ *
+ * Assembles the valid test files on several threads at once, over and over,
+ * checking the output every time. Built with ThreadSanitizer
+ * (test_assembler_stress_tsan) it also reports any data race between them.
+ */
+
+#define _POSIX_C_SOURCE 200112L /* pthreads */
+
+#include <stdio.h> /* sprintf, tmpfile */
+#include <unistd.h> /* access */
+#include <pthread.h>
+#include "assembler.h"
+#include "preprocessing.h"
+#include "test_utils.h"
+#include "arena.h"
+
+#define THREADS_NUM (4)
+#define ROUNDS_NUM (25)
+
+/* The files a single thread assembles. No two threads share a file, since
+ * the output files are written next to the input. */
+typedef struct {
+  const char **file_names;
+  size_t files_num;
+  int first_file;
+  int failures;
+} stress_worker_t;
+
+static void *StressWorker(void *worker);
+
+static result_t AssembleAndCompare(const char *file_name, arena_t *arena,
+                                   FILE *diagnostics);
+
+static const char *input_dir = "./test/assembler_test_files/input";
+static const char *expected_dir = "./test/assembler_test_files/expected";
+
+static const char *valid_names[] = {
+  "valid_1_only_data_definition",
+  "valid_2_with_string_definition",
+  "valid_3_with_instruction_0operand",
+  "valid_4_with_instruction_1operand",
+  "valid_5_with_instruction_2operands",
+  "valid_6_with_symbol_data",
+  "valid_7_with_symbol_instruction",
+  "valid_8_with_external_symbol",
+  "valid_9_with_entry",
+  "valid_10_with_ignore_symbol_before_extern",
+  "valid_11_two_registers"
+};
+
+/*
+ * TESTS
+ */
+
+test_info_t ConcurrentAssemblingTest(void) {
+  test_info_t test_info = InitTestInfo("ConcurrentAssembling");
+  stress_worker_t workers[THREADS_NUM];
+  pthread_t threads[THREADS_NUM];
+  int i = 0;
+
+  for (i = 0; i < THREADS_NUM; ++i) {
+    workers[i].file_names = valid_names;
+    workers[i].files_num = sizeof(valid_names) / sizeof(valid_names[0]);
+    workers[i].first_file = i;
+    workers[i].failures = 0;
+
+    if (0 != pthread_create(&threads[i], NULL, StressWorker, &workers[i])) {
+      RETURN_ERROR(TECHNICAL_ERROR);
+    }
+  }
+
+  for (i = 0; i < THREADS_NUM; ++i) {
+    pthread_join(threads[i], NULL);
+  }
+
+  for (i = 0; i < THREADS_NUM; ++i) {
+    if (0 != workers[i].failures) {
+      printf("Thread %d failed %d times\n", i, workers[i].failures);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info = ConcurrentAssemblingTest();
+
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Assembler stress\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Thread: assembles every THREADS_NUM'th file, starting from its
+ *        first_file, ROUNDS_NUM times, with its own arena & diagnostics.
+ */
+
+static void *StressWorker(void *worker) {
+  stress_worker_t *files = (stress_worker_t *)worker;
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+  FILE *diagnostics = tmpfile();
+  size_t i = 0;
+  int round = 0;
+
+  if (NULL == arena || NULL == diagnostics) {
+    ++files->failures;
+  }
+
+  for (round = 0; 0 == files->failures && round < ROUNDS_NUM; ++round) {
+    for (i = files->first_file; i < files->files_num; i += THREADS_NUM) {
+      if (SUCCESS != AssembleAndCompare(files->file_names[i], arena,
+                                        diagnostics)) {
+        printf("%s failed in round %d\n", files->file_names[i], round);
+        ++files->failures;
+      }
+      ResetArena(arena);
+    }
+  }
+
+  if (NULL != diagnostics) {
+    fclose(diagnostics);
+  }
+  DestroyArena(arena);
+  return NULL;
+}
+
+/*
+ * @brief Preprocesses & assembles a file in memory, as main does, and
+ *        compares its output files with the expected ones.
+ */
+
+static result_t AssembleAndCompare(const char *file_name, arena_t *arena,
+                                   FILE *diagnostics) {
+  const char *extensions[] = {".ob", ".ext", ".ent"};
+  char input_path[256];
+  char output_path[256];
+  char expected_path[256];
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = NULL;
+  assembler_options_t options = CreateAssemblerOptions();
+  result_t res = SUCCESS;
+  size_t i = 0;
+
+  if (NULL == source) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  options.diagnostics = diagnostics;
+  options.arena = arena;
+  sprintf(input_path, "%s/%s.am", input_dir, file_name);
+
+  macro_table = PreprocessSource(input_path, source, diagnostics, arena);
+  if (NULL == macro_table) {
+    DestroySourceBuffer(source);
+    return FAILURE;
+  }
+
+  res = AssembleSource(input_path, source, macro_table, &options);
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+
+  for (i = 0; SUCCESS == res && i < sizeof(extensions) / sizeof(char *); ++i) {
+    sprintf(output_path, "%s/%s%s", input_dir, file_name, extensions[i]);
+    sprintf(expected_path, "%s/%s%s", expected_dir, file_name, extensions[i]);
+
+    /* If the expected file doesn't exist, neither should the output file */
+    if (0 != access(expected_path, F_OK)) {
+      res = 0 == access(output_path, F_OK) ? FAILURE : SUCCESS;
+    } else {
+      res = CompareFileBytes(output_path, expected_path);
+    }
+  }
+
+  return res;
+}
+
@@ -1,5 +1,5 @@
-#include <stdio.h> /* fopen, close */
-#include <string.h> /* strcmp */
+#include <stdio.h> /* fopen, close, tmpfile */
+#include <string.h> /* strcmp, strstr */
 #include <unistd.h> /* access */
 #include "assembler.h"
 #include "preprocessing.h"
@@ -17,6 +17,17 @@ static const char *ProduceFilePath(const char *dir_path,
 
 static bool_t FileDoesntExist(const char *path);
 
+static unsigned long ReadUint(const unsigned char *bytes, int size);
+
+static result_t AssembleVersion(const char *file_path,
+                                const char *text,
+                                const assembler_options_t *options,
+                                assembled_program_t *program,
+                                char *messages, size_t messages_size);
+
+static bool_t SamePrograms(const assembled_program_t *program1,
+                           const assembled_program_t *program2);
+
 static result_t RunComparisonOb(const char *file_name);
 static result_t RunComparisonExt(const char *file_name);
 static result_t RunComparisonEnt(const char *file_name);
@@ -67,6 +78,139 @@ test_info_t ValidAssemblingingTest(const char *file_name) {
   return test_info;
 }
 
+test_info_t InMemoryAssemblingTest(const char *file_name) {
+  test_info_t test_info = InitTestInfo("InMemoryAssembling");
+  char input_path[256];
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = NULL;
+  assembler_options_t options = CreateAssemblerOptions();
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+
+  if (NULL == source || NULL == arena) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* The file's tables are allocated from an arena, as in main */
+  options.arena = arena;
+  ProduceFilePath(input_dir, file_name, ".am", input_path);
+
+  /* The expanded source is handed to the assembler without touching disk */
+  macro_table = PreprocessSource(input_path, source, stdout, arena);
+  if (NULL == macro_table) {
+    printf("Preprocessing failed for '%s'\n", input_path);
+    DestroySourceBuffer(source);
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (SUCCESS != AssembleSource(input_path, source, macro_table, &options)) {
+    printf("%s failed to assemble \n", file_name);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (SUCCESS != RunComparisonOb(file_name) ||
+      SUCCESS != RunComparisonExt(file_name) ||
+      SUCCESS != RunComparisonEnt(file_name)) {
+    printf("%s failed in output comparison\n", file_name);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+  DestroyArena(arena);
+  return test_info;
+}
+
+test_info_t BinaryObjectTest(const char *file_name) {
+  test_info_t test_info = InitTestInfo("BinaryObject");
+  char input_path[256];
+  char path[256];
+  unsigned char image[8192];
+  char line[128];
+  size_t image_size = 0;
+  unsigned long code_words = 0;
+  unsigned long data_words = 0;
+  unsigned long address = 0;
+  unsigned int word = 0;
+  unsigned long i = 0;
+  const unsigned char *words = image + BINARY_OBJECT_HEADER_SIZE;
+  source_buffer_t *source = NULL;
+  macro_table_t *macro_table = CreateMacroTable();
+  assembler_options_t options = CreateAssemblerOptions();
+  FILE *file = NULL;
+
+  options.binary_object = TRUE;
+  ProduceFilePath(input_dir, file_name, ".am", input_path);
+  source = LoadSourceFile(input_path);
+  if (NULL == source || NULL == macro_table) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (SUCCESS != AssembleSource(input_path, source, macro_table, &options)) {
+    printf("%s failed to assemble \n", file_name);
+    RETURN_ERROR(TEST_FAILED);
+  }
+  DestroySourceBuffer(source);
+  DestroyMacroTable(macro_table);
+
+  ProduceFilePath(input_dir, file_name, ".obj", path);
+  file = fopen(path, "rb");
+  if (NULL == file) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+  image_size = fread(image, 1, sizeof(image), file);
+  fclose(file);
+
+  if (BINARY_OBJECT_HEADER_SIZE > image_size ||
+      0 != memcmp(image, BINARY_OBJECT_MAGIC, 4) ||
+      BINARY_OBJECT_VERSION != ReadUint(image + 4, 4) ||
+      INITIAL_IC_VALUE != ReadUint(image + 8, 4)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* The words must match the textual .ob file */
+  ProduceFilePath(expected_dir, file_name, ".ob", path);
+  file = fopen(path, "r");
+  if (NULL == file) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (2 != fscanf(file, "%lu %lu", &code_words, &data_words) ||
+      code_words != ReadUint(image + 12, 4) ||
+      data_words != ReadUint(image + 16, 4) ||
+      image_size < BINARY_OBJECT_HEADER_SIZE + (code_words + data_words) * 2) {
+    fclose(file);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  for (i = 0; i < code_words + data_words; ++i) {
+    if (2 != fscanf(file, "%lu %o", &address, &word) ||
+        INITIAL_IC_VALUE + i != address ||
+        word != ReadUint(words + i * 2, 2)) {
+      printf("%s: word %lu differs\n", file_name, i);
+      fclose(file);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+  fclose(file);
+
+  /* As many external references as lines in the .ext file */
+  i = 0;
+  ProduceFilePath(expected_dir, file_name, ".ext", path);
+  file = fopen(path, "r");
+  if (NULL != file) {
+    while (NULL != fgets(line, sizeof(line), file)) {
+      ++i;
+    }
+    fclose(file);
+  }
+
+  if (i != ReadUint(image + 24, 4)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
 test_info_t InvalidAssemblingTest(const char *file_name) {
   test_info_t test_info = InitTestInfo("InvalidAssembling");
   char preprocessing_path[256];
@@ -98,6 +242,235 @@ test_info_t InvalidAssemblingTest(const char *file_name) {
   return test_info;
 }
 
+test_info_t IncrementalReassemblyTest(void) {
+  /* Each version is reassembled from the previous one, and must give the
+   * same result & messages as assembling it from scratch */
+  test_info_t test_info = InitTestInfo("IncrementalReassembly");
+  const char *versions[] = {
+    /* Initial */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "jmp EXT\nLBL: .extern W\nprn STR\nbne LOOP\nDATA1: .data 5, -7\n"
+    "STR: .string \"ab\"\nstop\n",
+    /* A line inserted, so the code after it moves */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r3\njmp EXT\nLBL: .extern W\nprn STR\nbne LOOP\n"
+    "DATA1: .data 5, -7\nSTR: .string \"ab\"\nstop\n",
+    /* Data grows, and a reference is added */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r3\njmp EXT\nLBL: .extern W\nprn STR\nbne LOOP\n"
+    "DATA1: .data 5, -7, 9\nSTR: .string \"ab\"\ncmp STR, EXT\nstop\n",
+    /* An undefined symbol */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r3\njmp NOWHERE\nLBL: .extern W\nprn STR\nbne LOOP\n"
+    "DATA1: .data 5, -7, 9\nSTR: .string \"ab\"\ncmp STR, EXT\nstop\n",
+    /* Fixed, but a symbol is defined twice */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r3\njmp EXT\nLBL: .extern W\nprn STR\nbne LOOP\n"
+    "DATA1: .data 5, -7, 9\nSTR: .string \"ab\"\ncmp STR, EXT\n"
+    "MAIN: stop\n",
+    /* Fixed, and lines removed */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r3\nprn STR\nbne LOOP\nDATA1: .data 5, -7, 9\n"
+    "STR: .string \"ab\"\nstop\n",
+    /* A line changed in place */
+    ".extern EXT\n.entry MAIN\nMAIN: mov #3, r1\nLOOP: add DATA1, r2\n"
+    "inc r4\nprn STR\nbne LOOP\nDATA1: .data 5, -7, 9\n"
+    "STR: .string \"ab\"\nstop\n"
+  };
+  /* Lines encoded by each version, after the first. Whatever is between
+   * the first & last changed lines is encoded again. */
+  const unsigned long expected_encoded[] = {0, 1, 3, 0, 0, 0, 1};
+  assembler_options_t options = CreateAssemblerOptions();
+  assembler_options_t full_options = CreateAssemblerOptions();
+  assembled_program_t program;
+  assembled_program_t full_program;
+  char messages[1024];
+  char full_messages[1024];
+  unsigned long encoded = 0;
+  unsigned long reused = 0;
+  unsigned long previous_encoded = 0;
+  result_t res = SUCCESS;
+  size_t i = 0;
+
+  options.incremental = CreateIncrementalState(4);
+  if (NULL == options.incremental) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < sizeof(versions) / sizeof(versions[0]); ++i) {
+    res = AssembleVersion("version.am", versions[i], &options, &program,
+                          messages, sizeof(messages));
+    if (res != AssembleVersion("version.am", versions[i], &full_options,
+                               &full_program, full_messages,
+                               sizeof(full_messages)) ||
+        0 != strcmp(messages, full_messages) ||
+        !SamePrograms(&program, &full_program)) {
+      printf("Version %lu differs from assembling it from scratch\n",
+             (unsigned long)i);
+      RETURN_ERROR(TEST_FAILED);
+    }
+
+    /* Lines are only encoded again after a version with errors */
+    GetIncrementalStats(options.incremental, &encoded, &reused);
+    if (0 != expected_encoded[i] &&
+        expected_encoded[i] != encoded - previous_encoded) {
+      printf("Version %lu encoded %lu lines\n", (unsigned long)i,
+             encoded - previous_encoded);
+      RETURN_ERROR(TEST_FAILED);
+    }
+    previous_encoded = encoded;
+
+    DestroyAssembledProgram(&program);
+    DestroyAssembledProgram(&full_program);
+  }
+
+  if (0 == reused) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyIncrementalState(options.incremental);
+  return test_info;
+}
+
+test_info_t IncrementalEvictionTest(void) {
+  /* A state keeps as many files as it's given, forgetting the one
+   * assembled least recently */
+  test_info_t test_info = InitTestInfo("IncrementalEviction");
+  const char *text = "MAIN: mov #3, r1\nLOOP: inc r1\nbne LOOP\nstop\n";
+  /* Files assembled in turn, & whether each is encoded from scratch */
+  const char *paths[] = {"a.am", "b.am", "a.am", "c.am", "a.am", "b.am"};
+  const bool_t from_scratch[] = {TRUE, TRUE, FALSE, TRUE, FALSE, TRUE};
+  assembler_options_t options = CreateAssemblerOptions();
+  assembled_program_t program;
+  char messages[256];
+  unsigned long encoded = 0;
+  unsigned long reused = 0;
+  unsigned long previous_encoded = 0;
+  size_t i = 0;
+
+  options.incremental = CreateIncrementalState(2);
+  if (NULL == options.incremental) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < sizeof(paths) / sizeof(paths[0]); ++i) {
+    if (SUCCESS != AssembleVersion(paths[i], text, &options, &program,
+                                   messages, sizeof(messages))) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+    DestroyAssembledProgram(&program);
+
+    GetIncrementalStats(options.incremental, &encoded, &reused);
+    if (from_scratch[i] != (encoded != previous_encoded)) {
+      printf("Assembling %lu of %s wasn't as expected\n", (unsigned long)i,
+             paths[i]);
+      RETURN_ERROR(TEST_FAILED);
+    }
+    previous_encoded = encoded;
+  }
+
+  DestroyIncrementalState(options.incremental);
+  return test_info;
+}
+
+test_info_t IncrementalNameChurnTest(void) {
+  /* Each version defines & uses symbols of its own, so most names of the
+   * file's pool are soon no longer used; reassembling stays identical to
+   * assembling from scratch as the pool is compacted */
+  test_info_t test_info = InitTestInfo("IncrementalNameChurn");
+  assembler_options_t options = CreateAssemblerOptions();
+  assembler_options_t full_options = CreateAssemblerOptions();
+  assembled_program_t program;
+  assembled_program_t full_program;
+  char text[1024];
+  char messages[256];
+  char full_messages[256];
+  size_t length = 0;
+  unsigned long i = 0;
+  unsigned long j = 0;
+
+  options.incremental = CreateIncrementalState(1);
+  if (NULL == options.incremental) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < 60; ++i) {
+    length = (size_t)sprintf(text, "MAIN: mov #1, r1\n");
+    for (j = 0; j < 8; ++j) {
+      length += (size_t)sprintf(text + length, "V%luA%lu: inc r1\n"
+                                "jmp V%luA%lu\n", i, j, i, (j + 1) % 8);
+    }
+    sprintf(text + length, "stop\n");
+
+    if (SUCCESS != AssembleVersion("churn.am", text, &options, &program,
+                                   messages, sizeof(messages)) ||
+        SUCCESS != AssembleVersion("churn.am", text, &full_options,
+                                   &full_program, full_messages,
+                                   sizeof(full_messages)) ||
+        0 != strcmp(messages, full_messages) ||
+        !SamePrograms(&program, &full_program)) {
+      printf("Version %lu differs from assembling it from scratch\n", i);
+      RETURN_ERROR(TEST_FAILED);
+    }
+
+    DestroyAssembledProgram(&program);
+    DestroyAssembledProgram(&full_program);
+  }
+
+  DestroyIncrementalState(options.incremental);
+  return test_info;
+}
+
+test_info_t UndefinedOperandsOfInvalidLinesTest(void) {
+  /* Undefined symbols are reported on lines with syntax errors as well, in
+   * the order of their lines */
+  test_info_t test_info = InitTestInfo("UndefinedOperandsOfInvalidLines");
+  const char *text = "MAIN: mov UNDEF, #5\nadd r1, r2\njmp NOWHERE\n"
+                     "prn OTHER, r3\nfoo MISSING\nstop\n";
+  const char *undefined[] = {"'UNDEF'", "'NOWHERE'", "'OTHER'", "'MISSING'"};
+  char input_path[256];
+  char messages[2048];
+  const char *cursor = messages;
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = CreateMacroTable();
+  FILE *messages_file = tmpfile();
+  assembler_options_t options = CreateAssemblerOptions();
+  result_t res = SUCCESS;
+  size_t length = 0;
+  size_t i = 0;
+
+  if (NULL == source || NULL == macro_table || NULL == messages_file ||
+      SUCCESS != AppendSourceText(source, text, strlen(text))) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  ProduceFilePath(input_dir, "undefined_operands", ".am", input_path);
+
+  options.diagnostics = messages_file;
+  res = AssembleSource(input_path, source, macro_table, &options);
+
+  if (FAILURE != res) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  rewind(messages_file);
+  length = fread(messages, 1, sizeof(messages) - 1, messages_file);
+  messages[length] = '\0';
+
+  for (i = 0; i < sizeof(undefined) / sizeof(undefined[0]); ++i) {
+    cursor = strstr(cursor, undefined[i]);
+    if (NULL == cursor) {
+      printf("Symbol %s wasn't reported as undefined\n", undefined[i]);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  fclose(messages_file);
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+  return test_info;
+}
+
 int main(void) {
   int total_failures = 0;
   size_t i = 0;
@@ -137,6 +510,18 @@ int main(void) {
       PrintTestInfo(test_info);
       ++total_failures;
     }
+
+    test_info = InMemoryAssemblingTest(valid_names[i]);
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+
+    test_info = BinaryObjectTest(valid_names[i]);
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
   }
 
   for (i = 0; run_invalid && i < sizeof(invalid_names) / sizeof(invalid_names[0]); ++i) {
@@ -147,6 +532,38 @@ int main(void) {
     }
   }
 
+  {
+    test_info_t test_info = IncrementalReassemblyTest();
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+  }
+
+  {
+    test_info_t test_info = IncrementalEvictionTest();
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+  }
+
+  {
+    test_info_t test_info = IncrementalNameChurnTest();
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+  }
+
+  {
+    test_info_t test_info = UndefinedOperandsOfInvalidLinesTest();
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+  }
+
   if (0 == total_failures) {
     printf(BOLD_GREEN "Test successful: " COLOR_RESET "Assembler\n");
   }
@@ -207,6 +624,81 @@ static result_t CompareFiles(const char *output_file_path, const char *expected_
   return test_res;
 }
 
+/*
+ * Assembles source text (without macros) in memory, collecting its messages.
+ */
+static result_t AssembleVersion(const char *file_path,
+                                const char *text,
+                                const assembler_options_t *options,
+                                assembled_program_t *program,
+                                char *messages, size_t messages_size) {
+  assembler_options_t file_options = *options;
+  source_buffer_t *source = CreateSourceBuffer();
+  macro_table_t *macro_table = CreateMacroTable();
+  size_t length = 0;
+  result_t res = SUCCESS;
+
+  file_options.diagnostics = tmpfile();
+  if (NULL == source || NULL == macro_table ||
+      NULL == file_options.diagnostics ||
+      SUCCESS != AppendSourceText(source, text, strlen(text))) {
+    return MEM_ALLOCATION_ERROR;
+  }
+
+  res = AssembleSourceToProgram(file_path, source, macro_table,
+                                &file_options, program);
+
+  rewind(file_options.diagnostics);
+  length = fread(messages, 1, messages_size - 1, file_options.diagnostics);
+  messages[length] = '\0';
+
+  fclose(file_options.diagnostics);
+  DestroyMacroTable(macro_table);
+  DestroySourceBuffer(source);
+  return res;
+}
+
+static bool_t SamePrograms(const assembled_program_t *program1,
+                           const assembled_program_t *program2) {
+  size_t i = 0;
+
+  if (program1->code_size != program2->code_size ||
+      program1->data_size != program2->data_size ||
+      program1->entries_num != program2->entries_num ||
+      program1->externals_num != program2->externals_num) {
+    return FALSE;
+  }
+
+  for (i = 0; i < program1->code_size; ++i) {
+    if (program1->code[i] != program2->code[i]) {
+      return FALSE;
+    }
+  }
+
+  for (i = 0; i < program1->data_size; ++i) {
+    if (program1->data[i] != program2->data[i]) {
+      return FALSE;
+    }
+  }
+
+  for (i = 0; i < program1->entries_num; ++i) {
+    if (0 != strcmp(program1->entries[i].name, program2->entries[i].name) ||
+        program1->entries[i].address != program2->entries[i].address) {
+      return FALSE;
+    }
+  }
+
+  for (i = 0; i < program1->externals_num; ++i) {
+    if (0 != strcmp(program1->externals[i].name,
+                    program2->externals[i].name) ||
+        program1->externals[i].address != program2->externals[i].address) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
 static result_t RunComparisonOb(const char *file_name) {
   char output_file_path_ob[256];
   char expected_file_path_ob[256];
@@ -245,3 +737,14 @@ static const char *ProduceFilePath(const char *dir_path,
 static bool_t FileDoesntExist(const char *path) {
   return (0 != access(path, F_OK));
 }
+
+/* Reads a little-endian unsigned number of 'size' bytes */
+static unsigned long ReadUint(const unsigned char *bytes, int size) {
+  unsigned long value = 0;
+
+  while (0 < size--) {
+    value = (value << 8) | bytes[size];
+  }
+
+  return value;
+}
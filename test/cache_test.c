@@ -0,0 +1,247 @@
+#include <stdio.h> /* fopen, fread, tmpfile, remove */
+#include <stdlib.h> /* system */
+#include <string.h> /* strlen, strcmp */
+#include "cache.h"
+#include "test_utils.h"
+
+#define CACHE_DIR "./cache_test_dir"
+#define OUTPUT_BASE "./cache_test_output"
+#define OTHER_OUTPUT_BASE "./cache_test_other"
+
+static const char *source_text = "MAIN: mov #3, r1\nstop\n";
+static const char *object_text = "2 0\n0100 00304\n0101 00034\n";
+static const char *entries_text = "MAIN 100\n";
+
+static result_t WriteFile(const char *path, const char *text);
+
+static size_t ReadFile(const char *path, char *buffer, size_t size);
+
+static void RemoveTestOutputs(void);
+
+/*
+ * TESTS
+ */
+
+test_info_t StoreAndRestoreTest(void) {
+  test_info_t test_info = InitTestInfo("StoreAndRestore");
+  cache_t *cache = OpenCache(CACHE_DIR);
+  FILE *messages = tmpfile();
+  FILE *diagnostics = tmpfile();
+  size_t size = strlen(source_text);
+  char buffer[256];
+
+  if (NULL == cache || NULL == messages || NULL == diagnostics) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* Nothing is cached yet */
+  if (RestoreFromCache(cache, source_text, size, 0, OUTPUT_BASE,
+                       diagnostics)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Outputs of an assembling, with a leftover .ext that isn't its own */
+  if (SUCCESS != WriteFile(OUTPUT_BASE ".ob", object_text) ||
+      SUCCESS != WriteFile(OUTPUT_BASE ".ent", entries_text)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  fprintf(messages, "assembled\n");
+
+  if (SUCCESS != StoreInCache(cache, source_text, size, 0, OUTPUT_BASE,
+                              messages)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  RemoveTestOutputs();
+  if (SUCCESS != WriteFile(OUTPUT_BASE ".ext", "X 0101\n")) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* A hit writes back the same outputs & messages */
+  if (!RestoreFromCache(cache, source_text, size, 0, OUTPUT_BASE,
+                        diagnostics)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (strlen(object_text) != ReadFile(OUTPUT_BASE ".ob", buffer,
+                                      sizeof(buffer)) ||
+      0 != strcmp(object_text, buffer) ||
+      strlen(entries_text) != ReadFile(OUTPUT_BASE ".ent", buffer,
+                                       sizeof(buffer)) ||
+      0 != strcmp(entries_text, buffer)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Outputs the source didn't produce are removed */
+  if (0 != ReadFile(OUTPUT_BASE ".ext", buffer, sizeof(buffer))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  rewind(diagnostics);
+  buffer[fread(buffer, 1, sizeof(buffer) - 1, diagnostics)] = '\0';
+  if (0 != strcmp("assembled\n", buffer)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  RemoveTestOutputs();
+  fclose(messages);
+  fclose(diagnostics);
+  CloseCache(cache);
+  return test_info;
+}
+
+test_info_t KeyMismatchTest(void) {
+  test_info_t test_info = InitTestInfo("KeyMismatch");
+  cache_t *cache = OpenCache(CACHE_DIR);
+  FILE *messages = tmpfile();
+  const char *edited_text = "MAIN: mov #4, r1\nstop\n"; /* Same size */
+  size_t size = strlen(source_text);
+  unsigned long hits = 0;
+  unsigned long misses = 0;
+
+  if (NULL == cache || NULL == messages) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (SUCCESS != WriteFile(OUTPUT_BASE ".ob", object_text) ||
+      SUCCESS != StoreInCache(cache, source_text, size, 1, OUTPUT_BASE,
+                              messages)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  RemoveTestOutputs();
+
+  /* Edited text, or other options, miss */
+  if (RestoreFromCache(cache, edited_text, size, 1, OUTPUT_BASE, messages) ||
+      RestoreFromCache(cache, source_text, size, 2, OUTPUT_BASE, messages) ||
+      RestoreFromCache(cache, source_text, size - 1, 1, OUTPUT_BASE,
+                       messages)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (!RestoreFromCache(cache, source_text, size, 1, OUTPUT_BASE,
+                        messages)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  GetCacheStats(cache, &hits, &misses);
+  if (1 != hits || 3 != misses) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  RemoveTestOutputs();
+  fclose(messages);
+  CloseCache(cache);
+  return test_info;
+}
+
+test_info_t OtherPathTest(void) {
+  /* The same source elsewhere is a hit, and its messages name it */
+  test_info_t test_info = InitTestInfo("OtherPath");
+  cache_t *cache = OpenCache(CACHE_DIR);
+  FILE *messages = tmpfile();
+  FILE *diagnostics = tmpfile();
+  const char *text = "LOOP: jmp LOOP\nstop\n";
+  const char *expected = "warning (file " OTHER_OUTPUT_BASE ".am) \001\n";
+  char buffer[256];
+
+  if (NULL == cache || NULL == messages || NULL == diagnostics) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  fprintf(messages, "warning (file " OUTPUT_BASE ".am) \001\n");
+  if (SUCCESS != WriteFile(OUTPUT_BASE ".ob", object_text) ||
+      SUCCESS != StoreInCache(cache, text, strlen(text), 0, OUTPUT_BASE,
+                              messages)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (!RestoreFromCache(cache, text, strlen(text), 0, OTHER_OUTPUT_BASE,
+                        diagnostics) ||
+      strlen(object_text) != ReadFile(OTHER_OUTPUT_BASE ".ob", buffer,
+                                      sizeof(buffer))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  rewind(diagnostics);
+  buffer[fread(buffer, 1, sizeof(buffer) - 1, diagnostics)] = '\0';
+  if (0 != strcmp(expected, buffer)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  RemoveTestOutputs();
+  fclose(messages);
+  fclose(diagnostics);
+  CloseCache(cache);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  if (0 != system("rm -rf " CACHE_DIR)) {
+    return 1;
+  }
+
+  test_info = StoreAndRestoreTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = KeyMismatchTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = OtherPathTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Cache\n");
+  }
+
+  RemoveTestOutputs();
+  system("rm -rf " CACHE_DIR);
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+static result_t WriteFile(const char *path, const char *text) {
+  FILE *file = fopen(path, "w");
+
+  if (NULL == file) {
+    return FILE_HANDLING_ERROR;
+  }
+
+  fputs(text, file);
+  fclose(file);
+  return SUCCESS;
+}
+
+/* Returns the size read (0 if the file doesn't exist), null-terminated */
+static size_t ReadFile(const char *path, char *buffer, size_t size) {
+  size_t length = 0;
+  FILE *file = fopen(path, "r");
+
+  if (NULL == file) {
+    return 0;
+  }
+
+  length = fread(buffer, 1, size - 1, file);
+  buffer[length] = '\0';
+  fclose(file);
+  return length;
+}
+
+static void RemoveTestOutputs(void) {
+  RemoveOutputFiles(OUTPUT_BASE);
+  RemoveOutputFiles(OTHER_OUTPUT_BASE);
+}
@@ -0,0 +1,79 @@
+#include <stdio.h> /* printf */
+#include "language_definitions.h"
+#include "test_utils.h"
+
+test_info_t IdentifyReservedWordsTest(void) {
+  /* Every word of the tables is classified as itself */
+  test_info_t test_info = InitTestInfo("IdentifyReservedWords");
+  reserved_word_t reserved_word;
+  int i = 0;
+
+  for (i = 0; i < NUM_OF_INSTRUCTIONS; ++i) {
+    reserved_word = IdentifyReservedWord(reserved_instructions[i].name);
+    if (INSTRUCTION_WORD != reserved_word.kind || i != reserved_word.index) {
+      printf("Instruction '%s' misidentified\n", reserved_instructions[i].name);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  for (i = 0; i < NUM_OF_DIRECTIVES; ++i) {
+    reserved_word = IdentifyReservedWord(reserved_directives[i]);
+    if (DIRECTIVE_WORD != reserved_word.kind || i != reserved_word.index) {
+      printf("Directive '%s' misidentified\n", reserved_directives[i]);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  for (i = 0; i < NUM_OF_REGISTERS; ++i) {
+    reserved_word = IdentifyReservedWord(register_names[i]);
+    if (REGISTER_WORD != reserved_word.kind || i != reserved_word.index) {
+      printf("Register '%s' misidentified\n", register_names[i]);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  return test_info;
+}
+
+test_info_t IdentifyOtherWordsTest(void) {
+  /* Words close to reserved words aren't reserved */
+  test_info_t test_info = InitTestInfo("IdentifyOtherWords");
+  const char *words[] = {
+    "", "r", "r8", "r9", "R1", "rr", "mov1", "mo", "Mov", "cmr", "clp",
+    "jms", "rtd", "ree", "stap", "stops", "data", ".dat", ".datas",
+    ".entr", ".strin", ".extrn", ".stringg", "x", "LOOP", "movmovmov"
+  };
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(words) / sizeof(words[0]); ++i) {
+    if (NOT_RESERVED != IdentifyReservedWord(words[i]).kind) {
+      printf("'%s' identified as a reserved word\n", words[i]);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = IdentifyReservedWordsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = IdentifyOtherWordsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "language definitions\n");
+  }
+
+  return total_failures;
+}
@@ -0,0 +1,141 @@
+#include <stdio.h> /* printf */
+#include <string.h> /* strlen, strcmp */
+#include "lexer.h"
+#include "test_utils.h"
+
+static bool_t TokenIs(const token_t *token, token_kind_t kind,
+                      const char *text) {
+  return (kind == token->kind &&
+          strlen(text) == token->length &&
+          0 == strncmp(text, token->start, token->length)) ? TRUE : FALSE;
+}
+
+test_info_t InstructionLineTest(void) {
+  /* Tokens point into the line, which ends at the newline */
+  test_info_t test_info = InitTestInfo("InstructionLine");
+  const char line[] = "LOOP: mov\t#-3 ,r2,\r\nnext line";
+  lexer_t lexer;
+  token_t token;
+
+  InitLexer(&lexer, line, strlen(line));
+
+  if (FALSE == ReadLabel(&lexer, &token) ||
+      FALSE == TokenIs(&token, LABEL_TOKEN, "LOOP") ||
+      line != token.start) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* There's only one label */
+  if (TRUE == ReadLabel(&lexer, &token)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  token = NextToken(&lexer);
+  if (FALSE == TokenIs(&token, WORD_TOKEN, "mov")) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  token = NextToken(&lexer);
+  if (FALSE == TokenIs(&token, WORD_TOKEN, "#-3")) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  token = NextToken(&lexer);
+  if (FALSE == TokenIs(&token, COMMA_TOKEN, ",")) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  token = NextWord(&lexer);
+  if (FALSE == TokenIs(&token, WORD_TOKEN, "r2")) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  token = NextWord(&lexer);
+  if (END_TOKEN != token.kind || END_TOKEN != NextToken(&lexer).kind) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t RestOfLineTest(void) {
+  /* The rest of the line is copied without leading blanks & newline */
+  test_info_t test_info = InitTestInfo("RestOfLine");
+  const char line[] = "STR: .string  \"a, b\"\n";
+  char rest[sizeof(line)];
+  char word[sizeof(line)];
+  lexer_t lexer;
+  token_t token;
+
+  InitLexer(&lexer, line, strlen(line));
+  ReadLabel(&lexer, &token);
+  token = NextToken(&lexer);
+
+  if (0 != strcmp(".string", CopyToken(&token, word)) ||
+      FALSE == TokenStartsWith(&token, '.')) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (0 != strcmp("\"a, b\"", CopyRestOfLine(&lexer, rest)) ||
+      END_TOKEN != NextToken(&lexer).kind) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Nothing is left */
+  if (0 != strcmp("", CopyRestOfLine(&lexer, rest))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t NotALabelTest(void) {
+  /* A colon which doesn't end the first word doesn't make a label */
+  test_info_t test_info = InitTestInfo("NotALabel");
+  const char *lines[] = {"mov A:B, r1", "stop", "", "   ", "A:B c"};
+  lexer_t lexer;
+  token_t token;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(lines) / sizeof(lines[0]); ++i) {
+    InitLexer(&lexer, lines[i], strlen(lines[i]));
+    if (TRUE == ReadLabel(&lexer, &token) || lines[i] != lexer.cursor) {
+      /* ReadLabel may skip leading blanks only */
+      if (0 != strcmp("   ", lines[i]) || TRUE == ReadLabel(&lexer, &token)) {
+        printf("'%s' was read as a label\n", lines[i]);
+        RETURN_ERROR(TEST_FAILED);
+      }
+    }
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = InstructionLineTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = RestOfLineTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = NotALabelTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "lexer\n");
+  }
+
+  return total_failures;
+}
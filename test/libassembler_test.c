@@ -0,0 +1,242 @@
+#include <stdio.h> /* fopen, fread, tmpfile */
+#include <string.h> /* strlen, strcmp, memcmp */
+#include <unistd.h> /* access */
+#include "libassembler.h"
+#include "language_definitions.h"
+#include "test_utils.h"
+
+static size_t ReadFile(const char *path, char *buffer, size_t size);
+
+const char *expected_dir = "./test/assembler_test_files/expected";
+const char *input_dir = "./test/assembler_test_files/input";
+
+/*
+ * TESTS
+ */
+
+test_info_t ProgramMatchesOutputFilesTest(const char *file_name) {
+  /* The program holds the same content as the .ob, .ent & .ext files */
+  test_info_t test_info = InitTestInfo("ProgramMatchesOutputFiles");
+  char path[256];
+  char text[4096];
+  char name[MAX_LINE_LENGTH];
+  size_t length = 0;
+  size_t i = 0;
+  unsigned long code_size = 0;
+  unsigned long data_size = 0;
+  unsigned long address = 0;
+  unsigned int word = 0;
+  assembled_program_t program;
+  assembler_options_t options = CreateAssemblerOptions();
+  FILE *file = NULL;
+
+  sprintf(path, "%s/%s.am", input_dir, file_name);
+  length = ReadFile(path, text, sizeof(text));
+  if (0 == length) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (SUCCESS != AssembleText(file_name, text, length, &options, &program)) {
+    printf("%s failed to assemble\n", file_name);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Words */
+  sprintf(path, "%s/%s.ob", expected_dir, file_name);
+  file = fopen(path, "r");
+  if (NULL == file) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (2 != fscanf(file, "%lu %lu", &code_size, &data_size) ||
+      code_size != program.code_size || data_size != program.data_size) {
+    fclose(file);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  for (i = 0; i < code_size + data_size; ++i) {
+    machine_word_t program_word = (i < code_size)
+                                   ? program.code[i]
+                                   : program.data[i - code_size];
+
+    if (2 != fscanf(file, "%lu %o", &address, &word) ||
+        INITIAL_IC_VALUE + i != address || word != program_word) {
+      printf("%s: word %lu differs\n", file_name, (unsigned long)i);
+      fclose(file);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+  fclose(file);
+
+  /* Entries */
+  i = 0;
+  sprintf(path, "%s/%s.ent", expected_dir, file_name);
+  file = fopen(path, "r");
+  if (NULL != file) {
+    for (i = 0; 2 == fscanf(file, "%s %lu", name, &address); ++i) {
+      if (i >= program.entries_num ||
+          0 != strcmp(name, program.entries[i].name) ||
+          address != program.entries[i].address) {
+        fclose(file);
+        RETURN_ERROR(TEST_FAILED);
+      }
+    }
+    fclose(file);
+  }
+
+  if (i != program.entries_num) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* External references */
+  i = 0;
+  sprintf(path, "%s/%s.ext", expected_dir, file_name);
+  file = fopen(path, "r");
+  if (NULL != file) {
+    for (i = 0; 2 == fscanf(file, "%s %lu", name, &address); ++i) {
+      if (i >= program.externals_num ||
+          0 != strcmp(name, program.externals[i].name) ||
+          address != program.externals[i].address) {
+        fclose(file);
+        RETURN_ERROR(TEST_FAILED);
+      }
+    }
+    fclose(file);
+  }
+
+  if (i != program.externals_num) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyAssembledProgram(&program);
+  return test_info;
+}
+
+test_info_t MacroExpansionTest(void) {
+  /* Macros are expanded, and nothing is written to disk */
+  test_info_t test_info = InitTestInfo("MacroExpansion");
+  const char *with_macro = "macr twice\n inc r1\n inc r1\nendmacr\n"
+                           "twice\nstop\n";
+  const char *expanded = "inc r1\ninc r1\nstop"; /* No newline at the end */
+  assembled_program_t program1;
+  assembled_program_t program2;
+  assembler_options_t options = CreateAssemblerOptions();
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+
+  /* The arena is reset by each call, so it can be reused */
+  options.arena = arena;
+
+  if (SUCCESS != AssembleText("snippet.as", with_macro, strlen(with_macro),
+                              &options, &program1)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (SUCCESS != AssembleText("snippet.as", expanded, strlen(expanded),
+                              &options, &program2)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (5 != program1.code_size || 0 != program1.data_size ||
+      program1.code_size != program2.code_size ||
+      0 != memcmp(program1.code, program2.code,
+                  program1.code_size * sizeof(machine_word_t))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (0 == access("snippet.am", F_OK) || 0 == access("snippet.ob", F_OK)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyAssembledProgram(&program1);
+  DestroyAssembledProgram(&program2);
+  DestroyArena(arena);
+  return test_info;
+}
+
+test_info_t SyntaxErrorTest(void) {
+  /* Errors are printed to the diagnostics stream, and no program is given */
+  test_info_t test_info = InitTestInfo("SyntaxError");
+  const char *text = "mov r1\nstop\n";
+  assembled_program_t program;
+  assembler_options_t options = CreateAssemblerOptions();
+
+  options.diagnostics = tmpfile();
+  if (NULL == options.diagnostics) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (FAILURE != AssembleText("bad", text, strlen(text), &options,
+                              &program)) {
+    fclose(options.diagnostics);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (0 == ftell(options.diagnostics) || NULL != program.memory ||
+      0 != program.code_size) {
+    fclose(options.diagnostics);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  fclose(options.diagnostics);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  size_t i = 0;
+  test_info_t test_info;
+
+  char *valid_names[] = {
+    "valid_1_only_data_definition",
+    "valid_2_with_string_definition",
+    "valid_5_with_instruction_2operands",
+    "valid_8_with_external_symbol",
+    "valid_9_with_entry",
+    "valid_10_with_ignore_symbol_before_extern",
+    "valid_11_two_registers"
+  };
+
+  for (i = 0; i < sizeof(valid_names) / sizeof(valid_names[0]); ++i) {
+    test_info = ProgramMatchesOutputFilesTest(valid_names[i]);
+    if (!WasTestSuccessful(test_info)) {
+      PrintTestInfo(test_info);
+      ++total_failures;
+    }
+  }
+
+  test_info = MacroExpansionTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SyntaxErrorTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "libassembler\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+static size_t ReadFile(const char *path, char *buffer, size_t size) {
+  size_t length = 0;
+  FILE *file = fopen(path, "r");
+
+  if (NULL == file) {
+    perror("Error opening file");
+    return 0;
+  }
+
+  length = fread(buffer, 1, size, file);
+  fclose(file);
+  return length;
+}
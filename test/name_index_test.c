@@ -0,0 +1,162 @@
+#include <stdio.h> /* printf, sprintf */
+#include <string.h> /* strlen */
+#include "name_index.h"
+#include "string_pool.h"
+#include "string_utils.h"
+#include "test_utils.h"
+
+#define NAMES_NUM (1000)
+
+test_info_t IndexNamesTest(void) {
+  /* Every name keeps its value as the index grows, on the heap & in an
+   * arena alike */
+  test_info_t test_info = InitTestInfo("IndexNames");
+  arena_t *arena = CreateArena(DEFAULT_ARENA_BLOCK_SIZE);
+  string_pool_t *pool = CreateStringPool(NULL);
+  name_index_t *indexes[2];
+  const char *names[NAMES_NUM];
+  int values[NAMES_NUM];
+  char name[16];
+  int i = 0;
+  int j = 0;
+
+  if (NULL == arena || NULL == pool) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  indexes[0] = CreateNameIndex(NULL, 2);
+  indexes[1] = CreateNameIndex(arena, 2);
+  if (NULL == indexes[0] || NULL == indexes[1]) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < NAMES_NUM; ++i) {
+    sprintf(name, "name%d", i);
+    names[i] = InternString(pool, name);
+    if (NULL == names[i]) {
+      RETURN_ERROR(TECHNICAL_ERROR);
+    }
+
+    for (j = 0; j < 2; ++j) {
+      if (SUCCESS != ReserveName(indexes[j])) {
+        RETURN_ERROR(TECHNICAL_ERROR);
+      }
+      IndexName(indexes[j], names[i], &values[i]);
+    }
+  }
+
+  for (j = 0; j < 2; ++j) {
+    if (NAMES_NUM != GetNameIndexSize(indexes[j])) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+
+    for (i = 0; i < NAMES_NUM; ++i) {
+      if (&values[i] != FindIndexedName(indexes[j], names[i])) {
+        RETURN_ERROR(TEST_FAILED);
+      }
+    }
+  }
+
+  DestroyNameIndex(indexes[0]);
+  DestroyArena(arena);
+  DestroyStringPool(pool);
+  return test_info;
+}
+
+test_info_t EarlierValueKeptTest(void) {
+  /* Indexing a name again keeps its first value */
+  test_info_t test_info = InitTestInfo("EarlierValueKept");
+  string_pool_t *pool = CreateStringPool(NULL);
+  name_index_t *index = CreateNameIndex(NULL, 4);
+  const char *loop = NULL;
+  int first = 0;
+  int second = 0;
+
+  if (NULL == pool || NULL == index) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  loop = InternString(pool, "LOOP");
+  if (NULL == loop || NULL == InternString(pool, "END") ||
+      SUCCESS != ReserveName(index)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  IndexName(index, loop, &first);
+  if (SUCCESS != ReserveName(index)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  IndexName(index, loop, &second);
+
+  if (&first != FindIndexedName(index, loop) ||
+      1 != GetNameIndexSize(index) ||
+      NULL != FindIndexedName(index, FindInternedString(pool, "END"))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyNameIndex(index);
+  DestroyStringPool(pool);
+  return test_info;
+}
+
+test_info_t FindIndexedStringTest(void) {
+  /* A name is found by its characters, whether the string is interned or
+   * not */
+  test_info_t test_info = InitTestInfo("FindIndexedString");
+  string_pool_t *pool = CreateStringPool(NULL);
+  name_index_t *index = CreateNameIndex(NULL, 4);
+  char buffer[] = "LOOP";
+  const char *loop = NULL;
+  size_t length = 0;
+  unsigned long hash = 0;
+
+  if (NULL == pool || NULL == index) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  loop = InternString(pool, "LOOP");
+  if (NULL == loop || SUCCESS != ReserveName(index)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  IndexName(index, loop, (void *)loop);
+
+  hash = HashString(buffer, &length);
+  if (loop != FindIndexedString(index, buffer, hash, length) ||
+      loop != FindIndexedString(index, loop, hash, length) ||
+      NULL != FindIndexedString(index, "LOO", HashString("LOO", NULL),
+                                strlen("LOO"))) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyNameIndex(index);
+  DestroyStringPool(pool);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = IndexNamesTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = EarlierValueKeptTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = FindIndexedStringTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "name index\n");
+  }
+
+  return total_failures;
+}
@@ -0,0 +1,192 @@
+/* pipeline_test.c
+ *
+ * Tests the pipelined mode (see AssemblePipelined): its output, expanded
+ * source & messages must be identical to those of preprocessing & then
+ * assembling.
+ */
+
+#include <stdio.h> /* FILE */
+#include <string.h> /* memcmp */
+#include "pipeline.h"
+#include "preprocessing.h"
+#include "test_utils.h"
+
+#define BASE_PATH "./pipeline_test"
+
+static source_config_t SourceConfig(source_flaws_t flaws);
+
+static result_t AssembleSerially(char *source_path, char *am_path,
+                                 FILE *diagnostics, void *expanded_source);
+
+static result_t AssembleWithPipeline(char *source_path, char *am_path,
+                                     FILE *diagnostics,
+                                     void *expanded_source);
+
+/*
+ * TESTS
+ */
+
+test_info_t SameOutputTest(void) {
+  test_info_t test_info = InitTestInfo("SameOutput");
+  source_buffer_t *serial_source = CreateSourceBuffer();
+  source_buffer_t *pipelined_source = CreateSourceBuffer();
+  assembling_way_t serial = {AssembleSerially, NULL};
+  assembling_way_t pipelined = {AssembleWithPipeline, NULL};
+  source_config_t config = SourceConfig(NO_FLAWS);
+  const char *text1 = NULL;
+  const char *text2 = NULL;
+  size_t size1 = 0;
+  size_t size2 = 0;
+
+  if (NULL == serial_source || NULL == pipelined_source) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  serial.arg = serial_source;
+  pipelined.arg = pipelined_source;
+
+  /* Many chunks, with macros expanded across their boundaries */
+  if (SUCCESS != CompareAssemblings(BASE_PATH, &config, &serial, &pipelined,
+                                    SUCCESS)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* The expanded source is the same as well */
+  text1 = GetSourceText(serial_source, &size1);
+  text2 = GetSourceText(pipelined_source, &size2);
+  if (size1 != size2 || 0 != memcmp(text1, text2, size1) ||
+      GetLineCount(serial_source) != GetLineCount(pipelined_source)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroySourceBuffer(serial_source);
+  DestroySourceBuffer(pipelined_source);
+  return test_info;
+}
+
+test_info_t SameErrorsTest(void) {
+  test_info_t test_info = InitTestInfo("SameErrors");
+  const assembling_way_t serial = {AssembleSerially, NULL};
+  const assembling_way_t pipelined = {AssembleWithPipeline, NULL};
+  source_config_t config = SourceConfig(SYNTAX_ERRORS);
+
+  /* Errors are reported with the same line numbers, in the same order */
+  if (SUCCESS != CompareAssemblings(BASE_PATH, &config, &serial, &pipelined,
+                                    FAILURE)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = SameOutputTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SameErrorsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Pipeline\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Returns the shape of the test source, which has every kind of
+ *        statement: macros (half of them used before they're defined),
+ *        comments & empty lines, code & data, external symbols & entries.
+ *        Its flaws, if any, are far apart.
+ */
+
+static source_config_t SourceConfig(source_flaws_t flaws) {
+  source_config_t config = CreateSourceConfig();
+
+  config.lines_num = 30000;
+  config.late_macros_num = config.macros_num / 2;
+  config.comments = TRUE;
+  config.flaws = flaws;
+  config.flaws_interval = 7000;
+  return config;
+}
+
+/*
+ * @brief Preprocesses a source, then assembles the expanded source (as main
+ *        does without --pipeline). See assemble_func_t.
+ *
+ * @param expanded_source - If not NULL, the source buffer the expanded
+ *                          source is written to.
+ */
+
+static result_t AssembleSerially(char *source_path, char *am_path,
+                                 FILE *diagnostics, void *expanded_source) {
+  assembler_options_t options = CreateAssemblerOptions();
+  source_buffer_t *source = LoadSourceFile(source_path);
+  source_buffer_t *output = (source_buffer_t *)expanded_source;
+  macro_table_t *macro_table = NULL;
+  result_t res = FAILURE;
+
+  options.diagnostics = diagnostics;
+  if (NULL == output) {
+    output = CreateSourceBuffer();
+  }
+
+  if (NULL != source && NULL != output) {
+    macro_table = PreprocessBuffer(source_path, source, output, diagnostics,
+                                   NULL);
+  }
+  if (NULL != macro_table) {
+    res = AssembleSource(am_path, output, macro_table, &options);
+    DestroyMacroTable(macro_table);
+  }
+
+  if (NULL != output && output != expanded_source) {
+    DestroySourceBuffer(output);
+  }
+  if (NULL != source) {
+    DestroySourceBuffer(source);
+  }
+  return res;
+}
+
+/*
+ * @brief Same as AssembleSerially, with the pipeline.
+ */
+
+static result_t AssembleWithPipeline(char *source_path, char *am_path,
+                                     FILE *diagnostics,
+                                     void *expanded_source) {
+  assembler_options_t options = CreateAssemblerOptions();
+  source_buffer_t *source = LoadSourceFile(source_path);
+  macro_table_t *macro_table = NULL;
+  result_t res = FAILURE;
+
+  options.diagnostics = diagnostics;
+
+  if (NULL != source) {
+    macro_table = ReadMacros(source_path, source, diagnostics, NULL);
+  }
+  if (NULL != macro_table) {
+    res = AssemblePipelined(am_path, source, macro_table,
+                            (source_buffer_t *)expanded_source, &options);
+    DestroyMacroTable(macro_table);
+  }
+
+  if (NULL != source) {
+    DestroySourceBuffer(source);
+  }
+  return res;
+}
@@ -0,0 +1,310 @@
+#define _POSIX_C_SOURCE 200112L /* fdopen, sockets, pthreads */
+
+#include <stdio.h> /* tmpfile, fopen, fprintf, fscanf */
+#include <string.h> /* strcmp, strlen */
+#include <time.h> /* nanosleep */
+#include <unistd.h> /* access, close, dup, unlink */
+#include <pthread.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "server.h"
+#include "test_utils.h"
+
+#define SOCKET_PATH "./server_test.sock"
+
+static const char *source_text = "MAIN: mov #3, r1\n.entry MAIN\n"
+                                 ".extern X\njmp X\nstop\n";
+
+static const char *expected_object =
+  "6 0\n0100 00304\n0101 00034\n0102 00014\n0103 44024\n0104 00001\n"
+  "0105 74004\nentries 1\nMAIN 100\nexternals 1\nX 0104\n";
+
+static bool_t StubAssembleFile(const char *directory, const char *file_name,
+                               const assembler_options_t *options,
+                               void *arg);
+
+static server_config_t CreateTestConfig(void);
+
+static result_t ReadResponse(FILE *responses, char *status, char *name,
+                             char *messages, char *object);
+
+static void *SocketServerThread(void *config);
+
+/*
+ * TESTS
+ */
+
+test_info_t StreamRequestsTest(void) {
+  test_info_t test_info = InitTestInfo("StreamRequests");
+  server_config_t config = CreateTestConfig();
+  FILE *requests = tmpfile();
+  FILE *responses = tmpfile();
+  char status[16];
+  char name[64];
+  char messages[256];
+  char object[512];
+
+  if (NULL == requests || NULL == responses) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  fprintf(requests, "file good bad\n\nsource snippet %lu\n%s",
+          (unsigned long)strlen(source_text), source_text);
+  fprintf(requests, "nonsense\nquit\nfile never_read\n");
+  rewind(requests);
+
+  /* 'quit' isn't a shutdown */
+  if (TRUE == RunServer(requests, responses, &config)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+  rewind(responses);
+
+  /* A batch of files gets a response per file */
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("ok", status) || 0 != strcmp("good", name) ||
+      0 != strcmp("assembled good\n", messages) || '\0' != object[0]) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("error", status) || 0 != strcmp("bad", name)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Inline source comes back as an object */
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("ok", status) || 0 != strcmp("snippet", name) ||
+      0 != strcmp(expected_object, object)) {
+    printf("Unexpected object:\n%s", object);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("error", status) || 0 != strcmp("-", name)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Nothing after 'quit' */
+  if (SUCCESS == ReadResponse(responses, status, name, messages, object)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  fclose(requests);
+  fclose(responses);
+  return test_info;
+}
+
+test_info_t SourceSyntaxErrorTest(void) {
+  test_info_t test_info = InitTestInfo("SourceSyntaxError");
+  server_config_t config = CreateTestConfig();
+  FILE *requests = tmpfile();
+  FILE *responses = tmpfile();
+  char status[16];
+  char name[64];
+  char messages[256];
+  char object[512];
+
+  if (NULL == requests || NULL == responses) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* The session goes on after a source with errors */
+  fprintf(requests, "source broken 7\nmov r1\nsource fine %lu\n%s",
+          (unsigned long)strlen(source_text), source_text);
+  rewind(requests);
+
+  RunServer(requests, responses, &config);
+  rewind(responses);
+
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("error", status) || 0 != strcmp("broken", name) ||
+      '\0' == messages[0] || '\0' != object[0]) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("ok", status) || 0 != strcmp(expected_object, object)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  fclose(requests);
+  fclose(responses);
+  return test_info;
+}
+
+test_info_t SocketServerTest(void) {
+  test_info_t test_info = InitTestInfo("SocketServer");
+  server_config_t config = CreateTestConfig();
+  struct sockaddr_un address;
+  pthread_t server;
+  FILE *requests = NULL;
+  FILE *responses = NULL;
+  char status[16];
+  char name[64];
+  char messages[256];
+  char object[512];
+  int connection = -1;
+  int attempt = 0;
+  struct timespec delay = {0, 10000000}; /* 10ms */
+
+  unlink(SOCKET_PATH);
+  if (0 != pthread_create(&server, NULL, SocketServerThread, &config)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strcpy(address.sun_path, SOCKET_PATH);
+
+  /* Wait for the server to listen */
+  for (attempt = 0; 0 > connection && attempt < 100; ++attempt) {
+    connection = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (0 != connect(connection, (struct sockaddr *)&address,
+                     sizeof(address))) {
+      close(connection);
+      connection = -1;
+      nanosleep(&delay, NULL);
+    }
+  }
+
+  if (0 > connection) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  requests = fdopen(connection, "w");
+  responses = fdopen(dup(connection), "r");
+
+  fprintf(requests, "source snippet %lu\n%sshutdown\n",
+          (unsigned long)strlen(source_text), source_text);
+  fflush(requests);
+
+  if (SUCCESS != ReadResponse(responses, status, name, messages, object) ||
+      0 != strcmp("ok", status) || 0 != strcmp(expected_object, object)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  fclose(requests);
+  fclose(responses);
+  pthread_join(server, NULL);
+
+  /* The socket is removed once the server shuts down */
+  if (0 == access(SOCKET_PATH, F_OK)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t SocketPathTakenTest(void) {
+  /* A file which isn't a socket is neither replaced nor removed */
+  test_info_t test_info = InitTestInfo("SocketPathTaken");
+  server_config_t config = CreateTestConfig();
+  FILE *file = fopen(SOCKET_PATH, "w");
+
+  if (NULL == file) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+  fclose(file);
+
+  if (FAILURE != RunSocketServer(SOCKET_PATH, &config) ||
+      0 != access(SOCKET_PATH, F_OK)) {
+    unlink(SOCKET_PATH);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  unlink(SOCKET_PATH);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = StreamRequestsTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SourceSyntaxErrorTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SocketServerTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = SocketPathTakenTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "Server\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/* Files named "good" are assembled successfully, others fail */
+static bool_t StubAssembleFile(const char *directory, const char *file_name,
+                               const assembler_options_t *options,
+                               void *arg) {
+  (void)directory;
+  (void)arg;
+
+  if (0 != strcmp("good", file_name)) {
+    return FALSE;
+  }
+
+  fprintf(options->diagnostics, "assembled %s\n", file_name);
+  return TRUE;
+}
+
+static server_config_t CreateTestConfig(void) {
+  server_config_t config;
+
+  config.directory = ".";
+  config.options = CreateAssemblerOptions();
+  config.assemble_file = StubAssembleFile;
+  config.assemble_arg = NULL;
+  return config;
+}
+
+/* Reads a response, null-terminating its messages & object */
+static result_t ReadResponse(FILE *responses, char *status, char *name,
+                             char *messages, char *object) {
+  long messages_length = 0;
+  long object_length = 0;
+
+  if (4 != fscanf(responses, "%15s %63s %ld %ld", status, name,
+                  &messages_length, &object_length) ||
+      '\n' != fgetc(responses) ||
+      255 < messages_length || 511 < object_length) {
+    return FAILURE;
+  }
+
+  if ((size_t)messages_length !=
+          fread(messages, 1, messages_length, responses) ||
+      (size_t)object_length != fread(object, 1, object_length, responses)) {
+    return FAILURE;
+  }
+
+  messages[messages_length] = '\0';
+  object[object_length] = '\0';
+  return SUCCESS;
+}
+
+static void *SocketServerThread(void *config) {
+  RunSocketServer(SOCKET_PATH, (server_config_t *)config);
+  return NULL;
+}
@@ -0,0 +1,83 @@
+#include <stdio.h> /* fopen, fgets */
+#include <string.h> /* strcmp */
+#include "source_buffer.h"
+#include "language_definitions.h"
+#include "test_utils.h"
+
+const char *lines_file = "./test/source_buffer_test_files/lines.as";
+
+test_info_t LoadMissingFileTest(void) {
+  test_info_t test_info = InitTestInfo("LoadMissingFile");
+
+  if (NULL != LoadSourceFile("./test/source_buffer_test_files/missing.as")) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  return test_info;
+}
+
+test_info_t LinesMatchFgetsTest(void) {
+  /*
+   * The file has blank lines, a line longer than MAX_LINE_LENGTH and a last
+   * line without '\n'. Lines should be split exactly like fgets splits them.
+   */
+  test_info_t test_info = InitTestInfo("LinesMatchFgets");
+  char expected[MAX_LINE_LENGTH];
+  char actual[MAX_LINE_LENGTH];
+  size_t i = 0;
+  FILE *file = NULL;
+  source_buffer_t *source = LoadSourceFile(lines_file);
+
+  if (NULL == source) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  file = fopen(lines_file, "r");
+  if (NULL == file) {
+    DestroySourceBuffer(source);
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  while (NULL != fgets(expected, MAX_LINE_LENGTH, file)) {
+    if (i >= GetLineCount(source) ||
+        0 != strcmp(expected, CopyLine(source, i, actual))) {
+      fclose(file);
+      DestroySourceBuffer(source);
+      RETURN_ERROR(TEST_FAILED);
+    }
+    ++i;
+  }
+
+  if (i != GetLineCount(source)) {
+    fclose(file);
+    DestroySourceBuffer(source);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  fclose(file);
+  DestroySourceBuffer(source);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = LoadMissingFileTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = LinesMatchFgetsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "source buffer\n");
+  }
+
+  return total_failures;
+}
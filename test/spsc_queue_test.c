@@ -0,0 +1,114 @@
+#define _POSIX_C_SOURCE 200112L /* pthreads */
+
+#include <stdio.h> /* printf */
+#include <pthread.h>
+#include "spsc_queue.h"
+#include "test_utils.h"
+
+#define ELEMENTS_NUM (1000000L)
+
+static void *ProduceNumbers(void *queue);
+
+/*
+ * TESTS
+ */
+
+test_info_t BoundedTest(void) {
+  /* Pushing fails once the (rounded up) capacity is reached */
+  test_info_t test_info = InitTestInfo("Bounded");
+  spsc_queue_t *queue = CreateSpscQueue(3);
+  void *element = NULL;
+  long i = 0;
+
+  if (NULL == queue) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  if (TryPopSpscQueue(queue, &element)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  for (i = 1; i <= 4; ++i) {
+    if (!TryPushSpscQueue(queue, (void *)i)) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+  if (TryPushSpscQueue(queue, (void *)i)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  /* Popping makes room, and elements come out in order */
+  if (!TryPopSpscQueue(queue, &element) || (void *)1 != element ||
+      !TryPushSpscQueue(queue, (void *)5)) {
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  for (i = 2; i <= 5; ++i) {
+    if (!TryPopSpscQueue(queue, &element) || (void *)i != element) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  DestroySpscQueue(queue);
+  return test_info;
+}
+
+test_info_t ConcurrentOrderTest(void) {
+  /* Every element pushed by a producer thread is popped once, in order */
+  test_info_t test_info = InitTestInfo("ConcurrentOrder");
+  spsc_queue_t *queue = CreateSpscQueue(64);
+  pthread_t producer;
+  long i = 0;
+
+  if (NULL == queue ||
+      0 != pthread_create(&producer, NULL, ProduceNumbers, queue)) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 1; i <= ELEMENTS_NUM; ++i) {
+    if ((void *)i != PopSpscQueue(queue)) {
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  pthread_join(producer, NULL);
+  DestroySpscQueue(queue);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = BoundedTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = ConcurrentOrderTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "SPSC queue\n");
+  }
+
+  return total_failures;
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+static void *ProduceNumbers(void *queue) {
+  long i = 0;
+
+  for (i = 1; i <= ELEMENTS_NUM; ++i) {
+    PushSpscQueue((spsc_queue_t *)queue, (void *)i);
+  }
+
+  return NULL;
+}
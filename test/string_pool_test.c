@@ -0,0 +1,103 @@
+#include <stdio.h> /* printf, sprintf */
+#include <string.h> /* strcmp, strlen */
+#include "string_pool.h"
+#include "string_utils.h"
+#include "test_utils.h"
+
+test_info_t InternSameStringTest(void) {
+  /* Equal strings are interned to the same address, others aren't */
+  test_info_t test_info = InitTestInfo("InternSameString");
+  string_pool_t *pool = CreateStringPool(NULL);
+  char buffer[] = "LOOP";
+  const char *first = NULL;
+  const char *second = NULL;
+  const char *other = NULL;
+
+  if (NULL == pool) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  first = InternString(pool, "LOOP");
+  second = InternString(pool, buffer);
+  other = InternString(pool, "LOOP2");
+
+  if (NULL == first || first != second || first == buffer ||
+      first == other || 0 != strcmp("LOOP", first) ||
+      first != InternString(pool, first) || 2 != GetStringPoolSize(pool)) {
+    DestroyStringPool(pool);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  if (HashString("LOOP", NULL) != GetInternedHash(first) ||
+      4 != GetInternedLength(first)) {
+    DestroyStringPool(pool);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyStringPool(pool);
+  return test_info;
+}
+
+test_info_t FindInternedTest(void) {
+  /* Looking a string up doesn't add it, also after the index grows */
+  test_info_t test_info = InitTestInfo("FindInterned");
+  string_pool_t *pool = CreateStringPool(NULL);
+  char name[16];
+  int i = 0;
+
+  if (NULL == pool) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < 1000; ++i) {
+    sprintf(name, "symbol%d", i);
+    if (NULL == InternString(pool, name)) {
+      DestroyStringPool(pool);
+      RETURN_ERROR(TECHNICAL_ERROR);
+    }
+  }
+
+  for (i = 0; i < 1000; ++i) {
+    const char *interned = NULL;
+
+    sprintf(name, "symbol%d", i);
+    interned = FindInternedString(pool, name);
+    if (NULL == interned || 0 != strcmp(name, interned) ||
+        strlen(name) != GetInternedLength(interned)) {
+      DestroyStringPool(pool);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  if (NULL != FindInternedString(pool, "symbol1000") ||
+      1000 != GetStringPoolSize(pool)) {
+    DestroyStringPool(pool);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyStringPool(pool);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = InternSameStringTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = FindInternedTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "string pool\n");
+  }
+
+  return total_failures;
+}
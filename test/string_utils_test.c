@@ -35,6 +35,51 @@ test_info_t StripLeadingWhitespacesTest(void) {
     return test_info;
 }
 
+test_info_t TokenizeStringTest(void) {
+    test_info_t test_info = InitTestInfo("TokenizeStringTest");
+    char outer[] = "mov r1, r2";
+    char inner[] = ",,a b,";
+    char *outer_save = NULL;
+    char *inner_save = NULL;
+    char *result;
+
+    /* Interleaving two tokenizations mustn't mix their state */
+    result = TokenizeString(outer, " ,", &outer_save);
+    if (NULL == result || 0 != strcmp(result, "mov")) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    result = TokenizeString(inner, " ,", &inner_save);
+    if (NULL == result || 0 != strcmp(result, "a")) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    result = TokenizeString(NULL, " ,", &outer_save);
+    if (NULL == result || 0 != strcmp(result, "r1")) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    result = TokenizeString(NULL, " ,", &inner_save);
+    if (NULL == result || 0 != strcmp(result, "b")) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    if (NULL != TokenizeString(NULL, " ,", &inner_save)) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    result = TokenizeString(NULL, " ,", &outer_save);
+    if (NULL == result || 0 != strcmp(result, "r2")) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    if (NULL != TokenizeString(NULL, " ,", &outer_save)) {
+        RETURN_ERROR(TEST_FAILED);
+    }
+
+    return test_info;
+}
+
 int main() {
   int total_failures = 0;
   test_info_t test_info;
@@ -44,6 +89,12 @@ int main() {
     ++total_failures;
   }
 
+  test_info = TokenizeStringTest();
+  if (!WasTestSuccessful(test_info)) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
   if (0 == total_failures) {
     printf(BOLD_GREEN "Test successful: " COLOR_RESET "string_utils\n");
   }
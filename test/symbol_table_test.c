@@ -103,6 +103,60 @@ test_info_t FindSymbolTest(void) {
   return test_info;
 }
 
+test_info_t FindManySymbolsTest(void) {
+  test_info_t test_info = InitTestInfo("FindManySymbols");
+  int n = 1000;
+  int i = 0;
+  char name[32];
+  symbol_table_t *table = CreateSymbolTable();
+  symbol_t *symbol = NULL;
+  node_t *node = NULL;
+
+  if(NULL == table) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  /* Enough symbols to make the table grow several times */
+  for (i = 0; i < n; ++i) {
+    sprintf(name, "SYMBOL%d", i);
+    if (SUCCESS != AddSymbol(table, name, 100 + i, CODE)) {
+      DestroySymbolTable(table);
+      RETURN_ERROR(TECHNICAL_ERROR);
+    }
+  }
+
+  /* A redefinition doesn't hide the first definition */
+  AddSymbol(table, "SYMBOL7", 5, DATA);
+
+  for (i = 0; i < n; ++i) {
+    sprintf(name, "SYMBOL%d", i);
+    symbol = FindSymbol(table, name);
+    if (NULL == symbol || 100 + i != GetSymbolAddress(symbol)) {
+      DestroySymbolTable(table);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  /* Symbols are listed in order of definition */
+  node = GetHead(AsList(table));
+  for (i = 0; i < n; ++i) {
+    sprintf(name, "SYMBOL%d", i);
+    if (NULL == node || 0 != strcmp(name, GetSymbolName(GetValue(node)))) {
+      DestroySymbolTable(table);
+      RETURN_ERROR(TEST_FAILED);
+    }
+    node = GetNext(node);
+  }
+
+  if (NULL != FindSymbol(table, "SYMBOL1000")) {
+    DestroySymbolTable(table);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroySymbolTable(table);
+  return test_info;
+}
+
 int main(void) {
   int total_failures = 0;
   test_info_t test_info;
@@ -125,6 +179,12 @@ int main(void) {
     ++total_failures;
   }
 
+  test_info = FindManySymbolsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
   if (0 == total_failures) {
     printf(BOLD_GREEN "Test successful: " COLOR_RESET "symbol table\n");
   }
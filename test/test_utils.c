@@ -1,6 +1,46 @@
-#include <stdio.h> /* printf */
+#include <stdio.h> /* printf, fprintf, fopen, fgetc, tmpfile, rename, remove */
+#include <string.h> /* strlen */
 #include "test_utils.h"
 
+/* Longest path of a file a comparison of assemblings works with, and
+ * longest name its files are named after, leaving room for extensions */
+#define MAX_TEST_PATH_LENGTH (256)
+#define MAX_TEST_BASE_LENGTH (200)
+
+static const char *output_extensions[] = {"ob", "obj", "ext", "ent"};
+
+/*
+ * State of the generator, while a source is written.
+ */
+
+typedef struct {
+  FILE *file;
+  const source_config_t *config;
+  unsigned long random;
+  long symbols_num;
+  long externs_num;
+} generator_t;
+
+static result_t CompareOutputFiles(const char *base1, const char *base2);
+
+static result_t MoveAssemblerOutputs(const char *from_base,
+                                     const char *to_base);
+
+static long WriteMacros(generator_t *generator, long first, long last);
+
+static void WriteFlaw(generator_t *generator, long statement);
+
+static void WriteStatement(generator_t *generator);
+
+static void WriteOperand(generator_t *generator, operand_kind_t kind);
+
+static operand_kind_t PickOperandKind(generator_t *generator,
+                                      bool_t destination);
+
+static unsigned long Random(generator_t *generator, unsigned long limit);
+
+static double RandomFraction(generator_t *generator);
+
 void PrintTestInfo(test_info_t info) {
   switch (info.result) {
     case TEST_SUCCESSFUL:
@@ -29,3 +69,496 @@ test_info_t InitTestInfo(const char *test_name) {
 bool_t WasTestSuccessful(test_info_t info) {
   return (TEST_SUCCESSFUL == info.result);
 }
+
+source_config_t CreateSourceConfig(void) {
+  source_config_t config;
+
+  config.lines_num = 0;
+  config.symbols_num = -1;
+  config.macros_num = 16;
+  config.late_macros_num = 0;
+  config.extern_ratio = 0.1;
+  config.entry_ratio = 0.1;
+  config.labeled_entries = FALSE;
+  config.comments = FALSE;
+  config.operand_weights[IMMEDIATE_OPERAND] = 1;
+  config.operand_weights[DIRECT_OPERAND] = 2;
+  config.operand_weights[INDIRECT_OPERAND] = 1;
+  config.operand_weights[REGISTER_OPERAND] = 2;
+  config.flaws = NO_FLAWS;
+  config.flaws_interval = 0;
+  config.seed = 1;
+  return config;
+}
+
+long GenerateSource(const char *path, const source_config_t *config) {
+  generator_t generator;
+  long early_macros_num = config->macros_num - config->late_macros_num;
+  long lines_written = 0;
+  long next_symbol = 0;
+  long i = 0;
+
+  generator.file = fopen(path, "w");
+  if (NULL == generator.file) {
+    return -1;
+  }
+
+  generator.config = config;
+  generator.random = config->seed;
+  generator.symbols_num = (0 <= config->symbols_num) ? config->symbols_num
+                                                      : config->lines_num / 16;
+  if (generator.symbols_num > config->lines_num) {
+    generator.symbols_num = config->lines_num;
+  }
+  generator.externs_num = 0;
+  if (0 < config->extern_ratio) {
+    generator.externs_num = (long)(generator.symbols_num *
+                                   config->extern_ratio) + 1;
+  }
+
+  for (i = 0; i < generator.externs_num; ++i) {
+    fprintf(generator.file, ".extern X%ld\n", i);
+    ++lines_written;
+  }
+
+  lines_written += WriteMacros(&generator, 0, early_macros_num);
+
+  /* Labels are spread evenly over the statements */
+  for (i = 0; i < config->lines_num; ++i) {
+    unsigned long kind = Random(&generator, 16);
+
+    if (NO_FLAWS != config->flaws && 0 < config->flaws_interval &&
+        config->flaws_interval - 1 == i % config->flaws_interval) {
+      WriteFlaw(&generator, i);
+      ++lines_written;
+      continue;
+    }
+
+    if (next_symbol < generator.symbols_num &&
+        next_symbol * config->lines_num <= i * generator.symbols_num) {
+      fprintf(generator.file, "L%ld: ", next_symbol++);
+    }
+    else if (0 == kind && 0 < config->macros_num) {
+      fprintf(generator.file, "m_%lu\n",
+              Random(&generator, config->macros_num));
+      ++lines_written;
+      continue;
+    }
+    else if (4 == kind && config->labeled_entries && 0 < next_symbol) {
+      fprintf(generator.file, "E%ld: .entry L%lu\n", i,
+              Random(&generator, next_symbol));
+      ++lines_written;
+      continue;
+    }
+    else if (5 == kind && config->comments) {
+      fprintf(generator.file, (0 == i % 2) ? "; comment\n" : "\n");
+      ++lines_written;
+      continue;
+    }
+
+    if (1 == kind || 2 == kind) {
+      fprintf(generator.file, ".data %ld, %ld, -%ld\n", i % 1000,
+              (long)Random(&generator, 100), (long)Random(&generator, 100));
+    }
+    else if (3 == kind) {
+      fprintf(generator.file, ".string \"line %ld\"\n", i);
+    }
+    else {
+      WriteStatement(&generator);
+    }
+    ++lines_written;
+  }
+
+  lines_written += WriteMacros(&generator, early_macros_num,
+                               config->macros_num);
+
+  for (i = 0; i < generator.symbols_num; ++i) {
+    if (RandomFraction(&generator) < config->entry_ratio) {
+      fprintf(generator.file, ".entry L%ld\n", i);
+      ++lines_written;
+    }
+  }
+
+  if (UNDEFINED_OPERANDS == config->flaws) {
+    fprintf(generator.file, ".entry NOWHERE\n");
+    ++lines_written;
+  }
+
+  fprintf(generator.file, "stop\n");
+  ++lines_written;
+
+  if (0 != fclose(generator.file)) {
+    return -1;
+  }
+  return lines_written;
+}
+
+result_t CompareFileBytes(const char *path1, const char *path2) {
+  FILE *file1 = fopen(path1, "rb");
+  FILE *file2 = fopen(path2, "rb");
+  result_t res = FAILURE;
+
+  if (NULL != file1 && NULL != file2) {
+    res = CompareStreamBytes(file1, file2);
+  }
+
+  if (NULL != file1) {
+    fclose(file1);
+  }
+  if (NULL != file2) {
+    fclose(file2);
+  }
+  return res;
+}
+
+result_t CompareStreamBytes(FILE *stream1, FILE *stream2) {
+  int c1 = 0;
+  int c2 = 0;
+
+  fflush(stream1);
+  fflush(stream2);
+  rewind(stream1);
+  rewind(stream2);
+
+  do {
+    c1 = fgetc(stream1);
+    c2 = fgetc(stream2);
+  } while (c1 == c2 && EOF != c1);
+
+  return c1 == c2 ? SUCCESS : FAILURE;
+}
+
+result_t CompareAssemblings(const char *base,
+                            const source_config_t *config,
+                            const assembling_way_t *expected,
+                            const assembling_way_t *tested,
+                            result_t expected_res) {
+  FILE *expected_diagnostics = NULL;
+  FILE *tested_diagnostics = NULL;
+  char source_path[MAX_TEST_PATH_LENGTH];
+  char am_path[MAX_TEST_PATH_LENGTH];
+  char expected_base[MAX_TEST_BASE_LENGTH];
+  result_t res = FAILURE;
+
+  if (strlen(base) + sizeof("_expected") > sizeof(expected_base)) {
+    return FAILURE;
+  }
+
+  sprintf(source_path, "%s.as", base);
+  sprintf(am_path, "%s.am", base);
+  sprintf(expected_base, "%s_expected", base);
+  expected_diagnostics = tmpfile();
+  tested_diagnostics = tmpfile();
+
+  /* The expected way's output files are moved aside before the tested way
+   * writes its own */
+  if (NULL != expected_diagnostics && NULL != tested_diagnostics &&
+      0 <= GenerateSource(source_path, config) &&
+      expected_res == expected->assemble(source_path, am_path,
+                                         expected_diagnostics,
+                                         expected->arg) &&
+      SUCCESS == MoveAssemblerOutputs(base, expected_base) &&
+      expected_res == tested->assemble(source_path, am_path,
+                                       tested_diagnostics, tested->arg) &&
+      SUCCESS == CompareStreamBytes(expected_diagnostics,
+                                    tested_diagnostics)) {
+    res = CompareOutputFiles(expected_base, base);
+  }
+
+  if (NULL != expected_diagnostics) {
+    fclose(expected_diagnostics);
+  }
+  if (NULL != tested_diagnostics) {
+    fclose(tested_diagnostics);
+  }
+  remove(source_path);
+  RemoveAssemblerOutputs(expected_base);
+  RemoveAssemblerOutputs(base);
+  return res;
+}
+
+void RemoveAssemblerOutputs(const char *base) {
+  char path[MAX_TEST_PATH_LENGTH];
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(output_extensions) / sizeof(output_extensions[0]);
+       ++i) {
+    sprintf(path, "%s.%s", base, output_extensions[i]);
+    remove(path);
+  }
+}
+
+/*
+ * STATIC FUNCTIONS
+ */
+
+/*
+ * @brief Compares the output files of two assemblings, named after base1 &
+ *        base2. Each must exist for both or for neither.
+ */
+
+static result_t CompareOutputFiles(const char *base1, const char *base2) {
+  char path1[MAX_TEST_PATH_LENGTH];
+  char path2[MAX_TEST_PATH_LENGTH];
+  FILE *file1 = NULL;
+  FILE *file2 = NULL;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(output_extensions) / sizeof(output_extensions[0]);
+       ++i) {
+    sprintf(path1, "%s.%s", base1, output_extensions[i]);
+    sprintf(path2, "%s.%s", base2, output_extensions[i]);
+    file1 = fopen(path1, "rb");
+    file2 = fopen(path2, "rb");
+
+    if ((NULL == file1) != (NULL == file2) ||
+        (NULL != file1 && SUCCESS != CompareStreamBytes(file1, file2))) {
+      if (NULL != file1) {
+        fclose(file1);
+      }
+      if (NULL != file2) {
+        fclose(file2);
+      }
+      return FAILURE;
+    }
+
+    if (NULL != file1) {
+      fclose(file1);
+      fclose(file2);
+    }
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Renames the output files named after from_base, those which exist,
+ *        after to_base.
+ */
+
+static result_t MoveAssemblerOutputs(const char *from_base,
+                                     const char *to_base) {
+  char from_path[MAX_TEST_PATH_LENGTH];
+  char to_path[MAX_TEST_PATH_LENGTH];
+  FILE *file = NULL;
+  size_t i = 0;
+
+  for (i = 0; i < sizeof(output_extensions) / sizeof(output_extensions[0]);
+       ++i) {
+    sprintf(from_path, "%s.%s", from_base, output_extensions[i]);
+    sprintf(to_path, "%s.%s", to_base, output_extensions[i]);
+
+    file = fopen(from_path, "rb");
+    if (NULL == file) {
+      continue;
+    }
+    fclose(file);
+
+    if (0 != rename(from_path, to_path)) {
+      return FAILURE;
+    }
+  }
+
+  return SUCCESS;
+}
+
+/*
+ * @brief Writes the definitions of the macros numbered [first, last). Each
+ *        has 2 to 4 statements.
+ *
+ * @return The number of lines written.
+ */
+
+static long WriteMacros(generator_t *generator, long first, long last) {
+  long lines_written = 0;
+  long i = 0;
+
+  for (i = first; i < last; ++i) {
+    long body_lines = 2 + Random(generator, 3);
+
+    fprintf(generator->file, "macr m_%ld\n", i);
+    while (0 < body_lines--) {
+      fputc(' ', generator->file);
+      WriteStatement(generator);
+      ++lines_written;
+    }
+    fprintf(generator->file, "endmacr\n");
+    lines_written += 2;
+  }
+
+  return lines_written;
+}
+
+/*
+ * @brief Writes a flawed statement (& the end of its line), of the kind of
+ *        flaws of the source.
+ */
+
+static void WriteFlaw(generator_t *generator, long statement) {
+  static const char *const invalid_lines[] = {"mov r1", "add #5", "jmp"};
+  long flaw = statement / generator->config->flaws_interval;
+
+  switch (generator->config->flaws) {
+    case SYNTAX_ERRORS:
+      fprintf(generator->file, "%s\n", invalid_lines[flaw % 3]);
+      break;
+    case CLASHING_SYMBOLS:
+      if (0 < generator->externs_num &&
+          (0 == generator->symbols_num || 0 == flaw % 2)) {
+        fprintf(generator->file, "X%lu: inc r1\n",
+                Random(generator, generator->externs_num));
+      }
+      else if (0 < generator->symbols_num) {
+        fprintf(generator->file, "L%lu: stop\n",
+                Random(generator, generator->symbols_num));
+      }
+      else {
+        fprintf(generator->file, "C0: stop\n");
+      }
+      break;
+    case UNDEFINED_OPERANDS:
+      fprintf(generator->file, "jmp NOWHERE%ld\n", statement);
+      break;
+    default:
+      if (0 < generator->externs_num && 0 == flaw % 2) {
+        fprintf(generator->file, ".entry X%lu\n",
+                Random(generator, generator->externs_num));
+      }
+      else {
+        fprintf(generator->file, ".entry NOWHERE%ld\n", statement);
+      }
+      break;
+  }
+}
+
+/*
+ * @brief Writes an instruction statement (& the end of its line), whose
+ *        operands are picked by their weights.
+ */
+
+static void WriteStatement(generator_t *generator) {
+  static const char *const two_operands[] = {"mov", "cmp", "add", "sub"};
+  static const char *const single_operand[] = {"clr", "not", "inc", "dec",
+                                               "red", "prn"};
+  static const char *const jumps[] = {"jmp", "bne", "jsr"};
+  unsigned long arity = Random(generator, 10);
+
+  if (5 > arity) {
+    operand_kind_t source = PickOperandKind(generator, FALSE);
+
+    fprintf(generator->file, "%s ", two_operands[Random(generator, 4)]);
+    WriteOperand(generator, source);
+    fprintf(generator->file, ", ");
+    WriteOperand(generator, PickOperandKind(generator, TRUE));
+  }
+  else if (9 > arity) {
+    operand_kind_t kind = PickOperandKind(generator, FALSE);
+
+    /* Only prn takes an immediate operand, & only registers can't be
+     * jumped to */
+    if (IMMEDIATE_OPERAND == kind) {
+      fprintf(generator->file, "prn ");
+    }
+    else if (REGISTER_OPERAND != kind && 0 == Random(generator, 3)) {
+      fprintf(generator->file, "%s ", jumps[Random(generator, 3)]);
+    }
+    else {
+      fprintf(generator->file, "%s ", single_operand[Random(generator, 6)]);
+    }
+    WriteOperand(generator, kind);
+  }
+  else {
+    fprintf(generator->file, "rts");
+  }
+
+  fputc('\n', generator->file);
+}
+
+static void WriteOperand(generator_t *generator, operand_kind_t kind) {
+  const source_config_t *config = generator->config;
+
+  switch (kind) {
+    case IMMEDIATE_OPERAND:
+      fprintf(generator->file, "#%ld", (long)Random(generator, 200) - 100);
+      break;
+    case DIRECT_OPERAND:
+      if (0 < generator->externs_num &&
+          (0 == generator->symbols_num ||
+           RandomFraction(generator) < config->extern_ratio)) {
+        fprintf(generator->file, "X%lu",
+                Random(generator, generator->externs_num));
+      }
+      else {
+        fprintf(generator->file, "L%lu",
+                Random(generator, generator->symbols_num));
+      }
+      break;
+    case INDIRECT_OPERAND:
+      fprintf(generator->file, "*r%lu", Random(generator, 8));
+      break;
+    default:
+      fprintf(generator->file, "r%lu", Random(generator, 8));
+      break;
+  }
+}
+
+/*
+ * @brief Picks the kind of an operand by the weights. A destination can't
+ *        be immediate, and direct operands are only picked if there's a
+ *        symbol to refer to. Registers are picked if nothing else can be.
+ */
+
+static operand_kind_t PickOperandKind(generator_t *generator,
+                                      bool_t destination) {
+  long weights[NUM_OF_OPERAND_KINDS];
+  long total = 0;
+  long pick = 0;
+  int kind = 0;
+
+  for (kind = 0; kind < NUM_OF_OPERAND_KINDS; ++kind) {
+    weights[kind] = generator->config->operand_weights[kind];
+    if (0 > weights[kind]) {
+      weights[kind] = 0;
+    }
+  }
+
+  if (destination) {
+    weights[IMMEDIATE_OPERAND] = 0;
+  }
+  if (0 == generator->symbols_num && 0 == generator->externs_num) {
+    weights[DIRECT_OPERAND] = 0;
+  }
+
+  for (kind = 0; kind < NUM_OF_OPERAND_KINDS; ++kind) {
+    total += weights[kind];
+  }
+  if (0 == total) {
+    return REGISTER_OPERAND;
+  }
+
+  pick = (long)Random(generator, total);
+  for (kind = 0; pick >= weights[kind]; ++kind) {
+    pick -= weights[kind];
+  }
+
+  return (operand_kind_t)kind;
+}
+
+/*
+ * @brief Returns a pseudo-random number below limit (a linear congruential
+ *        generator, so sources are the same on every platform).
+ */
+
+static unsigned long Random(generator_t *generator, unsigned long limit) {
+  generator->random = (generator->random * 1103515245UL + 12345UL) &
+                      0xFFFFFFFFUL;
+  return (generator->random >> 8) % limit;
+}
+
+/*
+ * @brief Returns a pseudo-random number in [0, 1).
+ */
+
+static double RandomFraction(generator_t *generator) {
+  return Random(generator, 1UL << 24) / (double)(1UL << 24);
+}
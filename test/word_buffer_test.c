@@ -0,0 +1,87 @@
+#include <stdio.h> /* printf */
+#include "word_buffer.h"
+#include "test_utils.h"
+
+test_info_t AppendManyWordsTest(void) {
+  /* Appending past the initial capacity keeps all words, in order */
+  test_info_t test_info = InitTestInfo("AppendManyWords");
+  word_buffer_t *buffer = CreateWordBuffer(0);
+  size_t i = 0;
+
+  if (NULL == buffer) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  for (i = 0; i < 10000; ++i) {
+    if (SUCCESS != APPEND_WORD(buffer, i * 7)) {
+      DestroyWordBuffer(buffer);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  if (10000 != GetWordsNum(buffer)) {
+    DestroyWordBuffer(buffer);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  for (i = 0; i < 10000; ++i) {
+    if ((machine_word_t)(i * 7) != GetWords(buffer)[i]) {
+      DestroyWordBuffer(buffer);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  DestroyWordBuffer(buffer);
+  return test_info;
+}
+
+test_info_t CapacityHintTest(void) {
+  /* Words within the hinted capacity don't move the buffer */
+  test_info_t test_info = InitTestInfo("CapacityHint");
+  word_buffer_t *buffer = CreateWordBuffer(1000);
+  machine_word_t *words = NULL;
+  size_t i = 0;
+
+  if (NULL == buffer) {
+    RETURN_ERROR(TECHNICAL_ERROR);
+  }
+
+  words = GetWords(buffer);
+  for (i = 0; i < 1000; ++i) {
+    if (SUCCESS != APPEND_WORD(buffer, 0x7FFF)) {
+      DestroyWordBuffer(buffer);
+      RETURN_ERROR(TEST_FAILED);
+    }
+  }
+
+  if (words != GetWords(buffer) || 0x7FFF != words[999]) {
+    DestroyWordBuffer(buffer);
+    RETURN_ERROR(TEST_FAILED);
+  }
+
+  DestroyWordBuffer(buffer);
+  return test_info;
+}
+
+int main(void) {
+  int total_failures = 0;
+  test_info_t test_info;
+
+  test_info = AppendManyWordsTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  test_info = CapacityHintTest();
+  if (TEST_SUCCESSFUL != test_info.result) {
+    PrintTestInfo(test_info);
+    ++total_failures;
+  }
+
+  if (0 == total_failures) {
+    printf(BOLD_GREEN "Test successful: " COLOR_RESET "word buffer\n");
+  }
+
+  return total_failures;
+}